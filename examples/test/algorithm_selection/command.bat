@@ -0,0 +1,23 @@
+rem The algorithm of every query is selected automatically, first with the
+rem estimated cost and then with a model learned from the runtimes of the
+rem training queries. The answers must be the same as with the
+rem materialization.
+
+set CurrDirName=algorithm_selection
+set TestDir=..\examples\test\%CurrDirName%
+set DataDir=..\examples\test\data
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+call %TestDir%\..\queries.bat %DataDir%\tc_queries.txt %DataDir%\tc.dlog %DataDir%\graph.conf %OutDir%\base --reasoningAlgo mat || exit /b 1
+call %TestDir%\..\queries.bat %DataDir%\tc_queries.txt %DataDir%\tc.dlog %DataDir%\graph.conf %OutDir%\test --reasoningAlgo auto || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\test || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\test %OutDir%\base || exit /b 1
+
+vlog.exe runtq --rules %DataDir%\tc.dlog --edb %DataDir%\graph.conf --logLevel warning --query %TestDir%\training_queries.txt --trainingLog %OutDir%\training.log || exit /b 1
+vlog.exe learnalgo --logLevel warning --trainingLog %OutDir%\training.log --algoModel %OutDir%\model.txt || exit /b 1
+call %TestDir%\..\queries.bat %DataDir%\tc_queries.txt %DataDir%\tc.dlog %DataDir%\graph.conf %OutDir%\learned --reasoningAlgo auto --selectionStrategy learned --algoModel %OutDir%\model.txt || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\learned || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\learned %OutDir%\base || exit /b 1
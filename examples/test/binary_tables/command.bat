@@ -0,0 +1,15 @@
+rem The tables are converted in a binary database. The relation has
+rem several zones, and is queried with constants in both columns. The
+rem materialization must be the same as on the CSV files.
+
+set CurrDirName=binary_tables
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe binarize --edb %TestDir%\conf.conf -o %OutDir%\binary || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %OutDir%\binary\edb.conf --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\test || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\test %OutDir%\base || exit /b 1
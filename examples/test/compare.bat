@@ -0,0 +1,19 @@
+@echo off
+rem Usage: compare.bat <dir1> <dir2>
+rem Checks that every file of dir1 (e.g., a relation stored with
+rem --storemat_format csv) is also in dir2, with the same rows in any order.
+rem Call it twice, swapping the directories, to check that they are equal.
+setlocal
+for %%f in (%1\*) do (
+    if not exist %2\%%~nxf (
+        echo Missing %2\%%~nxf
+        exit /b 1
+    )
+    sort %%f /o %TEMP%\vlog_compare_1
+    sort %2\%%~nxf /o %TEMP%\vlog_compare_2
+    fc %TEMP%\vlog_compare_1 %TEMP%\vlog_compare_2 >nul || (
+        echo Different rows in %%~nxf
+        exit /b 1
+    )
+)
+exit /b 0
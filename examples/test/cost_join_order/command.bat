@@ -0,0 +1,14 @@
+rem The atoms of the bodies have very different sizes, so the cost
+rem based order differs from the heuristic one. The result must not
+rem depend on the order.
+
+set CurrDirName=cost_join_order
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --joinOrder cost --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\test || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\test %OutDir%\base || exit /b 1
@@ -0,0 +1,14 @@
+rem The CSV file contains quoted fields with commas, quotes and spaces.
+rem It is loaded by one and by several tasks, and must be read back
+rem unchanged.
+
+set CurrDirName=csv_loader
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\single --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --multithreaded 1 --nthreads 4 --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %TestDir%\expected %OutDir%\single || exit /b 1
+call %TestDir%\..\compare.bat %TestDir%\expected %OutDir%\test || exit /b 1
@@ -0,0 +1,12 @@
+rem The files share their terms and are loaded by several threads.
+rem A term must get the same number in all the files, or the joins
+rem lose rows.
+
+set CurrDirName=dictionary
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --multithreaded 1 --nthreads 4 --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %TestDir%\expected %OutDir%\test || exit /b 1
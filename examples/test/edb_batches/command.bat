@@ -0,0 +1,12 @@
+rem The EDB relation has more rows than a batch of the column
+rem readers (COLUMN_BATCH_SIZE), so it is read in several batches.
+rem Every row must be read once.
+
+set CurrDirName=edb_batches
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %TestDir%\expected %OutDir%\test || exit /b 1
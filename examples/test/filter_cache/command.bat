@@ -0,0 +1,17 @@
+rem The derived relations are filtered with constants and repeated
+rem variables. Without a budget the cache evicts every filtered table, so
+rem they are computed again. The result must not depend on the cache.
+
+set CurrDirName=filter_cache
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --filterCacheBudget 0 --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --filterCacheBudget 0 --multithreaded 1 --nthreads 4 --storemat_path %OutDir%\threads --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\test || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\test %OutDir%\base || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\threads || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\threads %OutDir%\base || exit /b 1
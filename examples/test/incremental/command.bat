@@ -0,0 +1,14 @@
+rem The materialization is updated after removing and adding some
+rem edges. It must be the same as the materialization of the updated
+rem edges.
+
+set CurrDirName=incremental
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf_updated.conf --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --deletions %TestDir%\deletions.csv --insertions %TestDir%\insertions.csv --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\test || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\test %OutDir%\base || exit /b 1
@@ -0,0 +1,13 @@
+rem The bodies of the rules are joined through intermediate results,
+rem which are allocated in the arena of the iteration. Their columns are
+rem filled together, so most of them grow in more than one piece.
+
+set CurrDirName=intermediate_results
+set TestDir=..\examples\test\%CurrDirName%
+set DataDir=..\examples\test\data
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %DataDir%\graph.conf --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %TestDir%\expected %OutDir%\test || exit /b 1
@@ -0,0 +1,17 @@
+rem The joins are executed with every join algorithm. The joins
+rem where the hash join does not apply fall back to the merge join. The
+rem result must not depend on the algorithm.
+
+set CurrDirName=join_algorithms
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --joinAlgorithm hash --storemat_path %OutDir%\hash --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --joinAlgorithm radix --storemat_path %OutDir%\radix --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\hash || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\hash %OutDir%\base || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\radix || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\radix %OutDir%\base || exit /b 1
@@ -0,0 +1,17 @@
+rem The cyclic bodies are joined with the leapfrog triejoin by default. The
+rem result must be the same as with the binary joins, also when running
+rem with several threads.
+
+set CurrDirName=multiway_join
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --multiwayJoin 0 --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --multithreaded 1 --nthreads 4 --storemat_path %OutDir%\threads --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\test || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\test %OutDir%\base || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\threads || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\threads %OutDir%\base || exit /b 1
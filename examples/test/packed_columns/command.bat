@@ -0,0 +1,17 @@
+rem The derived columns have more than PACKED_COLUMN_MIN_SIZE rows. The
+rem first one has long runs, so it is compressed with deltas, and the
+rem second one has close values in no order, so it is packed. Their rows
+rem must be read back unchanged: P and S are copies of the input.
+
+set CurrDirName=packed_columns
+set TestDir=..\examples\test\%CurrDirName%
+set DataDir=..\examples\test\data
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+mkdir %OutDir%\expected
+copy %DataDir%\input_runs.csv %OutDir%\expected\P >nul
+copy %DataDir%\input_runs.csv %OutDir%\expected\S >nul
+call %TestDir%\..\compare.bat %OutDir%\expected %OutDir%\test || exit /b 1
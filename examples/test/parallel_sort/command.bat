@@ -0,0 +1,12 @@
+rem The derived relations have more rows than RADIX_SORT_MIN_ROWS and
+rem contain duplicates, so they are sorted and deduplicated with the
+rem parallel radix sort.
+
+set CurrDirName=parallel_sort
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --multithreaded 1 --nthreads 4 --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %TestDir%\expected %OutDir%\test || exit /b 1
@@ -0,0 +1,18 @@
+rem The rule executions are profiled in both formats. The profile
+rem must be written, and must not change the materialization.
+
+set CurrDirName=profile
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --profile %OutDir%\profile.json --storemat_path %OutDir%\json --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --profile %OutDir%\profile.csv --profileFormat csv --storemat_path %OutDir%\csv --storemat_format csv || exit /b 1
+if not exist %OutDir%\profile.json exit /b 1
+if not exist %OutDir%\profile.csv exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\json || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\json %OutDir%\base || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\csv || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\csv %OutDir%\base || exit /b 1
@@ -0,0 +1,15 @@
+rem The queries are answered top-down with QSQ-R, whose bindings are
+rem kept in hash-based tables. The answers must be the same as with the
+rem materialization.
+
+set CurrDirName=qsqr
+set TestDir=..\examples\test\%CurrDirName%
+set DataDir=..\examples\test\data
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+call %TestDir%\..\queries.bat %DataDir%\tc_queries.txt %DataDir%\tc.dlog %DataDir%\graph.conf %OutDir%\base --reasoningAlgo mat || exit /b 1
+call %TestDir%\..\queries.bat %DataDir%\tc_queries.txt %DataDir%\tc.dlog %DataDir%\graph.conf %OutDir%\test --reasoningAlgo qsqr || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\test || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\test %OutDir%\base || exit /b 1
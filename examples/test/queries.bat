@@ -0,0 +1,22 @@
+@echo off
+rem Usage: queries.bat <queries> <rules> <edb> <dir> [options of vlog.exe]
+rem Answers the queries with queryLiteral and the given options. Every
+rem line of the file <queries> is "<name> <query>": the answers of the
+rem query are written in <dir>\<name>, to be checked with compare.bat.
+setlocal
+set Queries=%1
+set Rules=%2
+set Edb=%3
+set OutDir=%4
+set Options=
+:options
+if "%~5"=="" goto run
+set Options=%Options% %5
+shift /5
+goto options
+:run
+mkdir %OutDir%
+for /f "tokens=1,2" %%a in (%Queries%) do (
+    vlog.exe queryLiteral --rules %Rules% --edb %Edb% --logLevel warning %Options% --query "%%b" > %OutDir%\%%a || exit /b 1
+)
+exit /b 0
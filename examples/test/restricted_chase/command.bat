@@ -0,0 +1,18 @@
+rem Half of the rows of EA already have a value in EB, so the restricted
+rem chase creates a null only for the others. The existential rule is applied
+rem after B is copied from EB, since its body is two rules away from EA.
+rem S must contain 1500 constants and 1500 nulls.
+
+set CurrDirName=restricted_chase
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+set Rows=0
+for /f %%n in ('find /c /v "" ^< %OutDir%\test\S') do set Rows=%%n
+if not "%Rows%"=="3000" (
+    echo S has %Rows% rows instead of 3000
+    exit /b 1
+)
@@ -0,0 +1,25 @@
+rem The Skolem chase creates a null for every row, with several threads,
+rem since the rule has more than ROWS_PARALLEL_THRESHOLD rows. The nulls
+rem of different rows must be different, so D, which contains the pairs
+rem of equal values, has as many rows as the input. C and D must be the
+rem same as on a single thread (the nulls in B are numbered differently).
+
+set CurrDirName=skolem_threads
+set TestDir=..\examples\test\%CurrDirName%
+set DataDir=..\examples\test\data
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --restrictedChase 0 --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --restrictedChase 0 --multithreaded 1 --nthreads 4 --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+mkdir %OutDir%\expected
+copy %DataDir%\input_nodes.csv %OutDir%\expected\C >nul
+copy %OutDir%\base\D %OutDir%\expected\D >nul
+call %TestDir%\..\compare.bat %OutDir%\expected %OutDir%\test || exit /b 1
+for /f %%n in ('find /c /v "" ^< %DataDir%\input_nodes.csv') do set ExpectedRows=%%n
+for /f %%n in ('find /c /v "" ^< %OutDir%\test\D') do set TestRows=%%n
+if not "%ExpectedRows%"=="%TestRows%" (
+    echo D has %TestRows% rows instead of %ExpectedRows%
+    exit /b 1
+)
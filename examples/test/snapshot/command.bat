@@ -0,0 +1,26 @@
+rem The materialization is stored in a snapshot and loaded back.
+rem It must be the same as the computed one, also when the queries load it.
+rem A snapshot of another EDB must be rejected.
+
+set CurrDirName=snapshot
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\snapshot --storemat_format snapshot || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --loadmat %OutDir%\snapshot --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf_other.conf --loadmat %OutDir%\snapshot --storemat_path %OutDir%\other --storemat_format csv && exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\test || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\test %OutDir%\base || exit /b 1
+
+mkdir %OutDir%\querybase
+vlog.exe queryLiteral --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --logLevel warning --reasoningAlgo mat --query "TC(n0,X)" > %OutDir%\querybase\TC || exit /b 1
+vlog.exe queryLiteral --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --logLevel warning --reasoningAlgo mat --query "L(X)" > %OutDir%\querybase\L || exit /b 1
+mkdir %OutDir%\querytest
+vlog.exe queryLiteral --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --logLevel warning --loadmat %OutDir%\snapshot --query "TC(n0,X)" > %OutDir%\querytest\TC || exit /b 1
+vlog.exe queryLiteral --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --logLevel warning --loadmat %OutDir%\snapshot --query "L(X)" > %OutDir%\querytest\L || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\querybase %OutDir%\querytest || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\querytest %OutDir%\querybase || exit /b 1
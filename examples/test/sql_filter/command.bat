@@ -0,0 +1,33 @@
+rem The EDB is loaded in SQLite and read through ODBC. The literals with
+rem the same constants are answered from the result cache, and the joins
+rem with Q bind more than TEMP_TABLE_THRESHOLD values of EE, so they are
+rem filtered with a temporary table. The results must be the ones of the
+rem in-memory EDB. It needs vlog.exe built with ODBC, sqlite3.exe and the
+rem SQLite3 ODBC driver, otherwise it is skipped.
+
+set CurrDirName=sql_filter
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+where sqlite3.exe >nul 2>nul || (echo sqlite3.exe not found, skipping & exit /b 0)
+if exist %OutDir% rmdir /s /q %OutDir%
+mkdir %OutDir%
+sqlite3.exe %OutDir%\edb.db "CREATE TABLE ee(a TEXT, b TEXT, c TEXT);" ".mode csv" ".import %TestDir:\=/%/input_e.csv ee" || exit /b 1
+for %%I in (%OutDir%\edb.db) do set DbFile=%%~fI
+odbcconf.exe configdsn "SQLite3 ODBC Driver" "DSN=vlog_sql_filter|Database=%DbFile%" || (echo SQLite3 ODBC driver not found, skipping & exit /b 0)
+
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\base --storemat_format csv || exit /b 1
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf_sql.conf --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\base %OutDir%\test || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\test %OutDir%\base || exit /b 1
+
+mkdir %OutDir%\querybase
+vlog.exe queryLiteral --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --logLevel warning --reasoningAlgo qsqr --query "R(X,Y)" > %OutDir%\querybase\R || exit /b 1
+vlog.exe queryLiteral --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --logLevel warning --reasoningAlgo qsqr --query "U(X)" > %OutDir%\querybase\U || exit /b 1
+mkdir %OutDir%\querytest
+vlog.exe queryLiteral --rules %TestDir%\rules.dlog --edb %TestDir%\conf_sql.conf --logLevel warning --reasoningAlgo qsqr --query "R(X,Y)" > %OutDir%\querytest\R || exit /b 1
+vlog.exe queryLiteral --rules %TestDir%\rules.dlog --edb %TestDir%\conf_sql.conf --logLevel warning --reasoningAlgo qsqr --query "U(X)" > %OutDir%\querytest\U || exit /b 1
+
+call %TestDir%\..\compare.bat %OutDir%\querybase %OutDir%\querytest || exit /b 1
+call %TestDir%\..\compare.bat %OutDir%\querytest %OutDir%\querybase || exit /b 1
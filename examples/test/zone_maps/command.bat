@@ -0,0 +1,12 @@
+rem The derived relation has enough rows for zone maps, and is
+rem filtered with constants in both columns. The blocks skipped by the
+rem zone maps must not contain matching rows.
+
+set CurrDirName=zone_maps
+set TestDir=..\examples\test\%CurrDirName%
+set OutDir=..\output\%CurrDirName%
+
+if exist %OutDir% rmdir /s /q %OutDir%
+vlog.exe mat --rules %TestDir%\rules.dlog --edb %TestDir%\conf.conf --storemat_path %OutDir%\test --storemat_format csv || exit /b 1
+
+call %TestDir%\..\compare.bat %TestDir%\expected %OutDir%\test || exit /b 1
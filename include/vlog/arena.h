@@ -0,0 +1,84 @@
+#ifndef _ARENA_H
+#define _ARENA_H
+
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+#include <inttypes.h>
+
+#include <vlog/term.h>
+
+//Number of terms in a chunk of the arena (8MB)
+#define ARENA_CHUNK_TERMS (1 << 20)
+//Number of unused chunks that an arena keeps for the next rules
+#define ARENA_MAX_FREE_CHUNKS 8
+
+//Chunk of memory of an Arena. The columns allocated in a chunk keep a
+//reference to it, so that the chunk is not reused while they are alive.
+struct ArenaChunk {
+    std::unique_ptr<Term_t[]> data;
+    const size_t capacity;
+
+    ArenaChunk(const size_t capacity) : data(new Term_t[capacity]),
+    capacity(capacity) {
+    }
+};
+
+//Values of a column stored in an Arena. A column that cannot be extended
+//in place continues in a new piece, so its values are never moved (see
+//ColumnWriter(Arena*))
+struct ArenaPiece {
+    std::shared_ptr<ArenaChunk> chunk;
+    const Term_t *values;
+    size_t len;
+
+    ArenaPiece(std::shared_ptr<ArenaChunk> chunk, const Term_t *values,
+            const size_t len) : chunk(chunk), values(values), len(len) {
+    }
+};
+
+//Bump-pointer allocator for the intermediate results of a rule execution.
+//The memory is not released piece by piece: reset() releases all the
+//allocations at once, and keeps the chunks that are no longer referenced to
+//serve the next rule. Every thread has its own arena (see getThreadArena()),
+//but allocations are synchronized, since the threads that help with a join
+//write into the intermediate results of the thread that executes the rule.
+class Arena {
+    private:
+        std::mutex mutex;
+
+        std::vector<std::shared_ptr<ArenaChunk>> chunks;
+        std::vector<std::shared_ptr<ArenaChunk>> freeChunks;
+        //Position of the first free term in the last chunk
+        size_t used;
+
+        uint64_t allocatedTerms;
+
+        void newChunk(const size_t minCapacity);
+
+    public:
+        Arena() : used(0), allocatedTerms(0) {
+        }
+
+        //Returns space for n terms. chunk is set to the chunk that contains
+        //it
+        Term_t *allocate(const size_t n, std::shared_ptr<ArenaChunk> &chunk);
+
+        //Grows the space returned by the last allocation from oldn to newn
+        //terms without moving it. Returns false if it is not possible.
+        bool extend(const Term_t *ptr, const size_t oldn, const size_t newn);
+
+        //Releases all allocations. The memory of the chunks that are still
+        //referenced by some column is released when the columns are destroyed
+        void reset();
+
+        //Terms allocated since the last reset
+        uint64_t getAllocatedTerms() const {
+            return allocatedTerms;
+        }
+
+        static Arena *getThreadArena();
+};
+
+#endif
@@ -4,30 +4,52 @@
 #include <vlog/concepts.h>
 #include <trident/model/table.h>
 
-#include <unordered_set>
-#include <functional>
+#include <vlog/columnkernels.h>
 
-struct BindingsRow {
-    uint8_t size;
-    Term_t const * row;
+#include <vector>
+#include <utility>
 
-    BindingsRow() : size(0), row(NULL) {}
+//Rows of a BindingsTable, seen through a subset of their columns. The view
+//points to the rows stored in the table, so it remains valid as long as the
+//table is neither cleared nor deleted.
+class BindingsView {
+    private:
+        std::vector<const Term_t*> rows;
+        std::vector<uint8_t> columns;
+
+    public:
+        BindingsView() {}
 
-    BindingsRow(const uint8_t s, Term_t const * const r) : size(s), row(r) {}
+        BindingsView(std::vector<const Term_t*> &&rows,
+                std::vector<uint8_t> &&columns) : rows(std::move(rows)),
+        columns(std::move(columns)) {}
 
-    bool operator==(const BindingsRow &other) const;
-};
+        size_t getNRows() const {
+            return rows.size();
+        }
+
+        uint8_t getSizeRow() const {
+            return (uint8_t) columns.size();
+        }
+
+        Term_t get(const size_t row, const uint8_t column) const {
+            return rows[row][columns[column]];
+        }
 
-struct hash_BindingsRow {
-    size_t operator()(const BindingsRow &x) const {
-        size_t hash = 0;
-        for (int i = 0; i < x.size; ++i) {
-            hash = (hash + (324723947 + x.row[i])) ^93485734985;
+        void copyRow(const size_t row, uint64_t *out) const {
+            const Term_t *r = rows[row];
+            for (size_t i = 0; i < columns.size(); ++i) {
+                out[i] = r[columns[i]];
+            }
         }
-        return hash;
-     }
+
+        //Sorts the rows by the given columns of the view
+        void sortBy(const std::vector<uint8_t> &fields);
 };
 
+//Number of rows in every array of RawBindings
+#define BINDINGS_FRAG_ROWS 1000
+
 class RawBindings {
     private:
         const uint8_t sizeArray;
@@ -37,7 +59,7 @@ class RawBindings {
         Term_t *array;
         size_t currentOffset;
     public:
-        RawBindings(uint8_t sizeArray) : sizeArray(sizeArray), sizeFrag(sizeArray * 1000) {
+        RawBindings(uint8_t sizeArray) : sizeArray(sizeArray), sizeFrag(sizeArray * BINDINGS_FRAG_ROWS) {
             array = new Term_t[sizeFrag];
             arrays.push_back(array);
             currentOffset = 0;
@@ -62,8 +84,8 @@ class RawBindings {
         }
 
         Term_t *getOffset(size_t idx) {
-            int seg = idx / sizeFrag;
-            int mod = idx % sizeFrag;
+            size_t seg = idx / sizeFrag;
+            size_t mod = idx % sizeFrag;
             return arrays[seg] + mod;
         }
 
@@ -80,37 +102,60 @@ class RawBindings {
         }
 };
 
+//Set of tuples used by QSQ-R. The tuples are stored one after the other in
+//rawBindings, in the order in which they were added, so that they can be
+//accessed by index and their pointers do not change. Duplicates are detected
+//with an open-addressing table on the hashes of the tuples.
 class BindingsTable {
     private:
-        std::unordered_set<BindingsRow, hash_BindingsRow> uniqueElements;
         RawBindings *rawBindings;
         Term_t *currentRow;
 
         size_t nPosToCopy;
         size_t *posToCopy;
 
-        struct FieldsSorter {
+        //Number of unique tuples
+        size_t nTuples;
+        //Indices of the tuples plus one (0 marks an empty slot). The size
+        //is a power of two, and at most half of the slots are used
+        std::vector<size_t> slots;
+        //Hash of every tuple, so that the table can grow without reading
+        //the tuples again
+        std::vector<uint64_t> hashes;
 
-            uint8_t fields[256];
-            const uint8_t nfields;
+        void init();
 
-            FieldsSorter(std::vector<uint8_t> &f) : nfields((uint8_t) f.size()) {
-                int i = 0;
-                for (std::vector<uint8_t>::iterator itr = f.begin(); itr != f.end();
-                        ++itr) {
-                    this->fields[i++] = *itr;
-                }
-            }
-            bool operator ()(const BindingsRow &i1, const BindingsRow &i2) const {
-                for (int i = 0; i < nfields; ++i) {
-                    if (i1.row[fields[i]] != i2.row[fields[i]])
-                        return i1.row[fields[i]] < i2.row[fields[i]];
-                }
-                return false;
-            }
-        };
+        Term_t *getRow(const size_t idx) {
+            return rawBindings->getOffset(idx * nPosToCopy);
+        }
+
+        //Returns the slot that contains row, or the empty slot where it
+        //should be inserted
+        size_t findSlot(const Term_t *row, const uint64_t h);
+
+        void grow();
+
+        bool contains(const Term_t *row) {
+            return slots[findSlot(row, ColumnKernels::hashRow(row,
+                        (uint8_t) nPosToCopy))] != 0;
+        }
+
+        //Adds currentRow, with hash h, if it is not in the table yet
+        void insertIfNotExists(const uint64_t h);
+
+        void insertIfNotExists() {
+            insertIfNotExists(ColumnKernels::hashRow(currentRow,
+                        (uint8_t) nPosToCopy));
+        }
+
+        void addEmptyTuple() {
+            nTuples = 1;
+        }
+
+        //Adds n rows of nPosToCopy values, stored one after the other.
+        //The hashes are computed in batches.
+        void addRows(const Term_t *rows, const size_t n);
 
-        void insertIfNotExists(Term_t const * const cr);
     public:
         BindingsTable(uint8_t sizeAdornment, uint8_t adornment);
 
@@ -126,6 +171,8 @@ class BindingsTable {
 
         void addTuple(const Term_t *t);
 
+        //The positions to copy that are not in t1 are read from t2. The
+        //size of t2 is not used
         void addTuple(const uint64_t *t1, const uint8_t sizeT1,
                 const uint64_t *t2, const uint8_t sizeT2);
 
@@ -133,6 +180,15 @@ class BindingsTable {
 
         void addRawTuple(Term_t *row);
 
+        //Adds all the rows of the view, or of the table. Both are treated as
+        //tuples passed to addTuple
+        void addTuples(const BindingsView &view);
+
+        void addTuples(const TupleTable *table);
+
+        //Adds all the tuples of other, which must have the same size
+        void addTuples(BindingsTable &other);
+
         std::vector<Term_t> getProjection(std::vector<uint8_t> pos);
 
         std::vector<Term_t> getUniqueSortedProjection(std::vector<uint8_t> pos);
@@ -141,6 +197,12 @@ class BindingsTable {
 
         TupleTable *sortBy(std::vector<uint8_t> &fields);
 
+        //As sortBy, but without copying the tuples
+        BindingsView sortedView(const std::vector<uint8_t> &fields);
+
+        //As projectAndFilter(l, NULL, NULL), but without copying the tuples
+        BindingsView projectionView(const Literal &l);
+
         TupleTable *projectAndFilter(const Literal &l, const std::vector<uint8_t> *posToFilter,
                 const std::vector<Term_t> *valuesToFilter);
 
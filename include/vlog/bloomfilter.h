@@ -0,0 +1,77 @@
+#ifndef _BLOOMFILTER_H
+#define _BLOOMFILTER_H
+
+#include <vlog/concepts.h>
+
+#include <vector>
+#include <inttypes.h>
+
+//Minimum bits of the filter per inserted value (the size is rounded up to a
+//power of two). With 4 hash functions, the rate of false positives is at
+//most about 2.4%
+#define BLOOM_BITS_PER_VALUE 8
+#define BLOOM_NHASHES 4
+
+//Bloom filter on the values of a variable. It is used to pass the values
+//that a selective atom allows to the earlier atoms of the body (sideways
+//information passing): a row of an intermediate result whose value is not
+//in the filter cannot join with the atom, and can be dropped before the
+//following joins. Lookups may return false positives, never false
+//negatives.
+class BloomFilter {
+    private:
+        std::vector<uint64_t> bits;
+        uint64_t mask;
+        uint64_t nvalues;
+
+        static uint64_t mix(uint64_t h) {
+            h ^= h >> 33;
+            h *= UINT64_C(0xff51afd7ed558ccd);
+            h ^= h >> 33;
+            h *= UINT64_C(0xc4ceb9fe1a85ec53);
+            h ^= h >> 33;
+            return h;
+        }
+
+    public:
+        //expectedValues is used to size the filter
+        BloomFilter(const uint64_t expectedValues) : nvalues(0) {
+            uint64_t nbits = 64;
+            while (nbits < expectedValues * BLOOM_BITS_PER_VALUE) {
+                nbits *= 2;
+            }
+            bits.resize(nbits / 64, 0);
+            mask = nbits - 1;
+        }
+
+        void add(const Term_t value) {
+            //Double hashing: the i-th position is h1 + i * h2
+            const uint64_t h = mix(value);
+            const uint64_t h2 = (h >> 32) | 1;
+            uint64_t pos = h;
+            for (int i = 0; i < BLOOM_NHASHES; ++i) {
+                bits[(pos & mask) >> 6] |= UINT64_C(1) << (pos & 63);
+                pos += h2;
+            }
+            nvalues++;
+        }
+
+        bool mayContain(const Term_t value) const {
+            const uint64_t h = mix(value);
+            const uint64_t h2 = (h >> 32) | 1;
+            uint64_t pos = h;
+            for (int i = 0; i < BLOOM_NHASHES; ++i) {
+                if (!(bits[(pos & mask) >> 6] & (UINT64_C(1) << (pos & 63)))) {
+                    return false;
+                }
+                pos += h2;
+            }
+            return true;
+        }
+
+        uint64_t getNValues() const {
+            return nvalues;
+        }
+};
+
+#endif
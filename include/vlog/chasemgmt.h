@@ -3,13 +3,20 @@
 
 #include <vlog/column.h>
 #include <vlog/ruleexecdetails.h>
+#include <vlog/hash.h>
 
 #include <vector>
 #include <map>
 #include <set>
 #include <unordered_map>
+#include <atomic>
+#include <mutex>
 
+//Rows in the first block of a Rows. Every following block is twice as large
 #define SIZE_BLOCK 1000
+#define ROWS_MAX_BLOCKS 32
+//Batches larger than this are processed by several threads
+#define ROWS_PARALLEL_THRESHOLD 16384
 
 #define RULE_MASK INT64_C(0xffffff0000000000)
 #define RULE_SHIFT(x) (((uint64_t) ((x) + 1)) << 40)
@@ -41,40 +48,57 @@ struct ChaseRow {
     }
 };
 
+//Mixes every term of the row, so that rows that differ in a single bit are
+//spread over the whole table
 struct hash_ChaseRow {
     size_t operator() (const ChaseRow &x) const {
-        uint64_t result = 0;
-        for (int i = 0; i < x.sz; i++) {
-            result = (result + (324723947 + x.row[i])) ^93485734985;
-        }
-        return (size_t) result;
+        return (size_t) VLogHash::mixTerms(x.row, x.sz);
     }
 };
 
 class ChaseMgmt {
     private:
+        //Associates every row of arguments of an existential variable with
+        //a fresh ID. The rows are stored one after the other in blocks that
+        //double in size, so that a row never moves once it is written. The
+        //index is an open-addressing table where every slot contains a part
+        //of the hash of the row and its position in the blocks. A row is
+        //added by claiming an empty slot with a compare-and-swap, so that
+        //the rows of a batch can be looked up and added by several threads
+        //at the same time. The table is resized only between batches.
         class Rows {
             private:
                 const uint64_t startCounter;
                 const uint8_t sizerow;
                 std::vector<Var_t> nameArgVars;
-                uint64_t currentcounter;
-                std::vector<std::unique_ptr<uint64_t[]>> blocks;
-                uint32_t blockCounter;
-                uint64_t *currentblock;
-                std::unordered_map<ChaseRow, uint64_t, hash_ChaseRow> rows;
+                std::unique_ptr<uint64_t[]> blocks[ROWS_MAX_BLOCKS];
+                uint8_t nblocks;
+                uint64_t capacityRows;
+                std::atomic<uint64_t> nrows;
+                std::unique_ptr<std::atomic<uint64_t>[]> slots;
+                uint64_t nslots;
                 TypeChase typeChase;
                 std::set<uint64_t> deps;    // For SUM chases.
+                //Only one batch at a time
+                std::mutex mutex;
+
+                uint64_t hashRow(const uint64_t *row) const;
+
+                //Makes room for n more rows, without exceeding half of the
+                //slots
+                void reserve(const uint64_t n);
+
+                //Returns the position of the row, adding it if it is new.
+                //Thread-safe, as long as reserve() made room for it
+                uint64_t getOrAdd(const uint64_t *row);
 
             public:
                 Rows(uint64_t startCounter, uint8_t sizerow,
                         std::vector<Var_t> nameArgVars,
                         TypeChase typeChase) :
                     startCounter(startCounter), sizerow(sizerow),
-                    nameArgVars(nameArgVars) {
-                        blockCounter = 0;
-                        currentblock = NULL;
-                        currentcounter = startCounter;
+                    nameArgVars(nameArgVars), nblocks(0), capacityRows(0),
+                    nrows(0), nslots(0) {
                         this->typeChase = typeChase;
                     }
 
@@ -88,8 +112,13 @@ class ChaseMgmt {
                     return nameArgVars;
                 }
 
-                uint64_t addRow(uint64_t* row);
+                //Sets values[i] to the ID of the i-th row of the batch
+                //(stored one after the other in rows), assigning fresh IDs
+                //to the rows that were not seen before
+                void addRows(const uint64_t *rows, const uint64_t n,
+                        Term_t *values, const int nthreads);
 
+                //Looks up the ID of the row without adding it
                 bool existingRow(uint64_t *row, uint64_t &value);
 
                 bool checkRecursive(uint64_t target, uint64_t value,
@@ -99,7 +128,8 @@ class ChaseMgmt {
         class RuleContainer {
             private:
                 std::map<Var_t, std::vector<Var_t>> dependencies;
-                std::map<Var_t, ChaseMgmt::Rows> vars2rows;
+                std::map<Var_t, std::unique_ptr<ChaseMgmt::Rows>> vars2rows;
+                std::mutex mutex;
                 uint64_t ruleBaseCounter;
                 Rule const * rule;
                 TypeChase chase;
@@ -144,7 +174,8 @@ class ChaseMgmt {
                 uint32_t ruleid,
                 Var_t var,
                 std::vector<std::shared_ptr<Column>> &columns,
-                uint64_t size);
+                uint64_t size,
+                const int nthreads = -1);
 
         bool checkCyclicTerms(uint32_t ruleid);
 
@@ -3,6 +3,8 @@
 
 #include <vlog/concepts.h>
 #include <vlog/edb.h>
+#include <vlog/columnkernels.h>
+#include <vlog/arena.h>
 
 #include <trident/utils/parallel.h>
 
@@ -11,6 +13,7 @@
 #include <algorithm>
 
 #include <memory>
+#include <mutex>
 #include <cstring>
 #include <vector>
 
@@ -25,6 +28,29 @@ class ColumnReader {
 
         virtual Term_t next() = 0;
 
+        //Copies at most n of the next values in buffer. Returns the number
+        //of copied values, zero when the reader is exhausted. Subclasses
+        //should override it to avoid one virtual call per value.
+        virtual size_t nextBatch(Term_t *buffer, const size_t n) {
+            size_t i = 0;
+            while (i < n && hasNext()) {
+                buffer[i++] = next();
+            }
+            return i;
+        }
+
+        //Moves past at most n of the next values without reading them.
+        //Returns the number of skipped values. Subclasses should override it
+        //when they can do it without decoding the values.
+        virtual size_t skip(const size_t n) {
+            size_t i = 0;
+            while (i < n && hasNext()) {
+                next();
+                i++;
+            }
+            return i;
+        }
+
         virtual void clear() = 0;
 
         virtual std::vector<Term_t> asVector() = 0;
@@ -33,9 +59,83 @@ class ColumnReader {
 };
 
 class ColumnWriter;
+class Column;
+
+//Number of rows of the blocks of the zone maps
+#define ZONEMAP_BLOCK_ROWS COLUMN_BATCH_SIZE
+//Columns with fewer rows do not get a zone map: scanning them costs less
+//than keeping it
+#define ZONEMAP_MIN_ROWS (4 * ZONEMAP_BLOCK_ROWS)
+
+//Minimum and maximum of a column, and of every block of ZONEMAP_BLOCK_ROWS
+//rows of it. It is computed once, the first time it is used after the
+//writer of the column is sealed, and is used to skip the blocks (or the whole column) that cannot contain a
+//constant.
+struct ZoneMap {
+    Term_t min;
+    Term_t max;
+    std::vector<Term_t> mins;
+    std::vector<Term_t> maxs;
+
+    bool mayContain(const Term_t v) const {
+        return v >= min && v <= max;
+    }
+
+    bool mayContain(const size_t block, const Term_t v) const {
+        return v >= mins[block] && v <= maxs[block];
+    }
+
+    size_t getNBlocks() const {
+        return mins.size();
+    }
+
+    static std::shared_ptr<const ZoneMap> compute(const Column &column);
+};
 
 class Column {
+    private:
+        //Set only on the columns with at least ZONEMAP_MIN_ROWS rows
+        mutable std::shared_ptr<const ZoneMap> zoneMap;
+        //If true, the zone map is computed on the first request
+        bool lazyZoneMap;
+        mutable std::once_flag zoneMapComputed;
+
     public:
+        Column() : lazyZoneMap(false) {
+        }
+
+        //A lazy zone map is computed again by the copy, if needed
+        Column(const Column &o) : zoneMap(o.lazyZoneMap ? NULL : o.zoneMap),
+        lazyZoneMap(o.lazyZoneMap) {
+        }
+
+        const ZoneMap *getZoneMap() const {
+            if (lazyZoneMap) {
+                std::call_once(zoneMapComputed, [this]() {
+                        if (size() >= ZONEMAP_MIN_ROWS && !isConstant()) {
+                        zoneMap = ZoneMap::compute(*this);
+                        }
+                        });
+            }
+            return zoneMap.get();
+        }
+
+        void setZoneMap(std::shared_ptr<const ZoneMap> zm) {
+            zoneMap = zm;
+        }
+
+        //Called on the sealed columns: their zone map is computed only
+        //if it is used
+        void setLazyZoneMap() {
+            lazyZoneMap = true;
+        }
+
+        //False only if the zone map shows that the column does not contain v
+        bool mayContain(const Term_t v) const {
+            const ZoneMap *zm = getZoneMap();
+            return zm == NULL || zm->mayContain(v);
+        }
+
         virtual bool isEmpty() const = 0;
 
         virtual bool isEDB() const = 0;
@@ -194,6 +294,160 @@ class CompressedColumn final : public Column {
 };
 //----- END COMPRESSED COLUMN ----------
 
+//----- PACKED COLUMN ----------
+
+//Number of values that share the same reference value in a PackedColumn
+#define PACKED_FRAME_SIZE 128
+//Columns smaller than this are never packed: the gain does not compensate
+//for the loss of direct access to the underlying vector
+#define PACKED_COLUMN_MIN_SIZE 65536
+
+struct PackedColumnFrame {
+    Term_t base; //Smallest value in the frame
+    size_t offset; //Position of the first word in the packed array
+    uint8_t bits; //Number of bits used for each value
+
+    PackedColumnFrame(const Term_t base, const size_t offset,
+            const uint8_t bits) : base(base), offset(offset), bits(bits) {}
+};
+
+//Frame-of-reference encoding: every frame of PACKED_FRAME_SIZE values
+//stores its minimum and the differences from it with the minimum number
+//of bits. On sorted columns the differences are small, so this is much
+//more compact than a vector, and it still allows random access.
+class PackedColumn final : public Column {
+    private:
+        std::vector<PackedColumnFrame> frames;
+        std::vector<uint64_t> words;
+        size_t _size;
+        bool sorted;
+
+        static uint8_t bitsFrame(const Term_t *values, const size_t n,
+                Term_t &base);
+
+    public:
+        PackedColumn(const std::vector<Term_t> &values, const bool sorted);
+
+        //Returns the number of bytes needed to pack the values
+        static size_t getPackedSize(const std::vector<Term_t> &values);
+
+        static inline Term_t unpack(const uint64_t *words, const uint8_t bits,
+                const size_t idx) {
+            if (bits == 0) {
+                return 0;
+            }
+            const size_t bitpos = idx * bits;
+            const uint64_t *w = words + (bitpos >> 6);
+            const uint8_t shift = bitpos & 63;
+            uint64_t v = w[0] >> shift;
+            if (shift + bits > 64) {
+                v |= w[1] << (64 - shift);
+            }
+            return bits == 64 ? v : v & ((((uint64_t) 1) << bits) - 1);
+        }
+
+        const std::vector<PackedColumnFrame> &getFrames() const {
+            return frames;
+        }
+
+        const std::vector<uint64_t> &getWords() const {
+            return words;
+        }
+
+        size_t size() const {
+            return _size;
+        }
+
+        size_t getRepresentationSize() const {
+            return words.size() + frames.size();
+        }
+
+        size_t estimateSize() const {
+            return _size;
+        }
+
+        bool isEmpty() const {
+            return _size == 0;
+        }
+
+        Term_t getValue(const size_t pos) const {
+            const PackedColumnFrame &f = frames[pos / PACKED_FRAME_SIZE];
+            return f.base + unpack(&words[f.offset], f.bits,
+                    pos % PACKED_FRAME_SIZE);
+        }
+
+        bool supportsDirectAccess() const {
+            return true;
+        }
+
+        bool isEDB() const {
+            return false;
+        }
+
+        std::unique_ptr<ColumnReader> getReader() const;
+
+        std::shared_ptr<Column> sort() const;
+
+        std::shared_ptr<Column> sort(const int nthreads) const;
+
+        std::shared_ptr<Column> unique() const;
+
+        bool isIn(const Term_t t) const;
+
+        bool isConstant() const;
+
+        Term_t first() const {
+            assert(_size > 0);
+            return getValue(0);
+        }
+};
+
+class PackedColumnReader final : public ColumnReader {
+    private:
+        const PackedColumn &col;
+        const std::vector<PackedColumnFrame> &frames;
+        const uint64_t *words;
+        const size_t _size;
+        size_t position;
+
+    public:
+        PackedColumnReader(const PackedColumn &col) : col(col),
+        frames(col.getFrames()),
+        words(col.getWords().empty() ? NULL : &col.getWords()[0]),
+        _size(col.size()), position(0) {
+        }
+
+        Term_t first() {
+            return col.getValue(0);
+        }
+
+        Term_t last() {
+            return col.getValue(_size - 1);
+        }
+
+        std::vector<Term_t> asVector();
+
+        bool hasNext() {
+            return position < _size;
+        }
+
+        Term_t next() {
+            return col.getValue(position++);
+        }
+
+        size_t nextBatch(Term_t *buffer, const size_t n);
+
+        size_t skip(const size_t n) {
+            const size_t toSkip = std::min(n, _size - position);
+            position += toSkip;
+            return toSkip;
+        }
+
+        void clear() {
+        }
+};
+//----- END PACKED COLUMN ----------
+
 class ColumnWriter {
     private:
         bool cached;
@@ -204,49 +458,84 @@ class ColumnWriter {
         size_t _size;
         Term_t lastv;
         bool compressed;
+        bool sorted;
+
+        //Only used if the values are stored in an arena. The values are
+        //written in arenaValues, after the ones in arenaPieces
+        Arena *arena;
+        std::vector<ArenaPiece> arenaPieces;
+        std::shared_ptr<ArenaChunk> arenaChunk;
+        Term_t *arenaValues;
+        size_t arenaCapacity;
+        //Number of values in arenaPieces
+        size_t arenaOffset;
+
+        //Chooses between an InmemoryColumn and a PackedColumn, depending
+        //on which one is smaller. Swaps the content of values.
+        static std::shared_ptr<Column> getVectorColumn(
+                std::vector<Term_t> &values, const bool isSorted);
+
+        void growArena();
 
     public:
-        ColumnWriter(bool compressed = true) : cached(false), _size(0), lastv((Term_t) - 1), compressed(compressed) {}
+        ColumnWriter(bool compressed = true) : cached(false), _size(0), lastv((Term_t) - 1), compressed(compressed), sorted(true),
+        arena(NULL), arenaValues(NULL), arenaCapacity(0), arenaOffset(0) {}
 
-        ColumnWriter(std::vector<Term_t> &values) : cached(false), _size(values.size()), compressed(false) {
+        ColumnWriter(std::vector<Term_t> &values) : cached(false), _size(values.size()), compressed(false), sorted(false),
+        arena(NULL), arenaValues(NULL), arenaCapacity(0), arenaOffset(0) {
             this->values.swap(values);
             lastv = _size > 0 ? this->values[this->values.size()-1] : (Term_t) -1;
         }
 
+        //The values are stored uncompressed in arena. The column returned
+        //by getColumn() is an ArenaColumn
+        ColumnWriter(Arena *arena) : cached(false), _size(0), lastv((Term_t) - 1), compressed(false), sorted(true),
+        arena(arena), arenaValues(NULL), arenaCapacity(0), arenaOffset(0) {}
+
         void add(const uint64_t v) {
 #ifdef DEBUG
             if (cached)
                 throw 10;
 #endif
 
-#ifdef USE_COMPRESSED_COLUMNS
-            if (! compressed) {
-                values.push_back((Term_t) v);
+            if (arena != NULL) {
+                if (_size - arenaOffset == arenaCapacity) {
+                    growArena();
+                }
+                arenaValues[_size - arenaOffset] = (Term_t) v;
             } else {
-                if (isEmpty()) {
-                    blocks.push_back(CompressedColumnBlock((Term_t) v, 0, 0));
+#ifdef USE_COMPRESSED_COLUMNS
+                if (! compressed) {
+                    values.push_back((Term_t) v);
                 } else {
-                    CompressedColumnBlock *b = &blocks.back();
-                    if (v == lastv + b->delta) {
-                        b->size++;
-                    } else if (b->size == 0) {
-                        b->delta = v - lastv;
-                        b->size++;
-                    } else {
+                    if (isEmpty()) {
                         blocks.push_back(CompressedColumnBlock((Term_t) v, 0, 0));
-                        if (_size > 256 && blocks.size() > _size / 4) {
-                            // Compression not very effective; convert to uncompressed
-                            compressed = false;
-                            CompressedColumn col(blocks, /*offsetsize, deltas,*/ _size + 1);
-                            values = col.getReader()->asVector();
-                            blocks.clear();
+                    } else {
+                        CompressedColumnBlock *b = &blocks.back();
+                        if (v == lastv + b->delta) {
+                            b->size++;
+                        } else if (b->size == 0) {
+                            b->delta = v - lastv;
+                            b->size++;
+                        } else {
+                            blocks.push_back(CompressedColumnBlock((Term_t) v, 0, 0));
+                            if (_size > 256 && blocks.size() > _size / 4) {
+                                // Compression not very effective; convert to uncompressed
+                                compressed = false;
+                                CompressedColumn col(blocks, /*offsetsize, deltas,*/ _size + 1);
+                                values = col.getReader()->asVector();
+                                blocks.clear();
+                            }
                         }
                     }
                 }
-            }
 #else
-            values.push_back((Term_t) v);
+                values.push_back((Term_t) v);
 #endif
+            }
+            if (_size > 0 && v < lastv) {
+                sorted = false;
+            }
             _size++;
             lastv = v;
         }
@@ -303,6 +592,10 @@ class ColumnReaderImpl final : public ColumnReader {
 
         Term_t next();
 
+        size_t nextBatch(Term_t *buffer, const size_t n);
+
+        size_t skip(const size_t n);
+
         void clear() {
         }
 };
@@ -349,6 +642,21 @@ class InmemColumnReader final : public ColumnReader {
             return col[currentPos++];
         }
 
+        size_t nextBatch(Term_t *buffer, const size_t n) {
+            const size_t toCopy = std::min(n, end - currentPos);
+            if (toCopy > 0) {
+                memcpy(buffer, &col[currentPos], sizeof(Term_t) * toCopy);
+                currentPos += toCopy;
+            }
+            return toCopy;
+        }
+
+        size_t skip(const size_t n) {
+            const size_t toSkip = std::min(n, end - currentPos);
+            currentPos += toSkip;
+            return toSkip;
+        }
+
         void clear() {
         }
 };
@@ -630,6 +938,335 @@ class SubColumn final : public Column {
 //----- END SUBCOLUMN ----------
 
 
+//----- MMAP COLUMN ----------
+//Read-only memory mapping of a file. The mapping is released when the last
+//column that uses it is destroyed.
+class MappedFile {
+    private:
+        const char *data;
+        size_t length;
+
+    public:
+        MappedFile(std::string path, const bool removeFile);
+
+        const char *getData() const {
+            return data;
+        }
+
+        size_t getLength() const {
+            return length;
+        }
+
+        ~MappedFile();
+};
+
+class ArrayColumnReader final : public ColumnReader {
+    private:
+        const Term_t *values;
+        const size_t len;
+        size_t currentPos;
+
+    public:
+        ArrayColumnReader(const Term_t *values, const size_t len) :
+            values(values), len(len), currentPos(0) {
+            }
+
+        Term_t first() {
+            return values[0];
+        }
+
+        Term_t last() {
+            return values[len - 1];
+        }
+
+        std::vector<Term_t> asVector() {
+            return std::vector<Term_t>(values, values + len);
+        }
+
+        bool hasNext() {
+            return currentPos < len;
+        }
+
+        Term_t next() {
+            return values[currentPos++];
+        }
+
+        size_t nextBatch(Term_t *buffer, const size_t n) {
+            const size_t toCopy = std::min(n, len - currentPos);
+            if (toCopy > 0) {
+                memcpy(buffer, values + currentPos, sizeof(Term_t) * toCopy);
+                currentPos += toCopy;
+            }
+            return toCopy;
+        }
+
+        size_t skip(const size_t n) {
+            const size_t toSkip = std::min(n, len - currentPos);
+            currentPos += toSkip;
+            return toSkip;
+        }
+
+        void clear() {
+        }
+};
+
+//Column whose values are stored in a memory-mapped file (see SegmentSpiller)
+class MmapColumn final : public Column {
+    private:
+        std::shared_ptr<MappedFile> file;
+        const Term_t *values;
+        const size_t len;
+
+    public:
+        MmapColumn(std::shared_ptr<MappedFile> file, const size_t offset,
+                const size_t len) : file(file),
+        values((const Term_t*)(file->getData() + offset)), len(len) {
+            assert(offset + len * sizeof(Term_t) <= file->getLength());
+        }
+
+        size_t size() const {
+            return len;
+        }
+
+        size_t getRepresentationSize() const {
+            //The values are not in main memory
+            return 0;
+        }
+
+        size_t estimateSize() const {
+            return len;
+        }
+
+        bool isEmpty() const {
+            return len == 0;
+        }
+
+        Term_t getValue(const size_t pos) const {
+            return values[pos];
+        }
+
+        bool supportsDirectAccess() const {
+            return true;
+        }
+
+        bool isEDB() const {
+            return false;
+        }
+
+        bool containsDuplicates() const {
+            return len > 1;
+        }
+
+        std::unique_ptr<ColumnReader> getReader() const {
+            return std::unique_ptr<ColumnReader>(new ArrayColumnReader(
+                        values, len));
+        }
+
+        std::shared_ptr<Column> sort() const;
+
+        std::shared_ptr<Column> sort(const int nthreads) const;
+
+        std::shared_ptr<Column> unique() const;
+
+        bool isConstant() const {
+            return len < 2;
+        }
+
+        Term_t first() const {
+            assert(len > 0);
+            return values[0];
+        }
+
+        bool isIn(const Term_t t) const {
+            return std::binary_search(values, values + len, t);
+        }
+};
+//----- END MMAP COLUMN ----------
+
+//----- ARENA COLUMN ----------
+class ArenaColumnReader final : public ColumnReader {
+    private:
+        const std::vector<ArenaPiece> &pieces;
+        size_t currentPiece;
+        size_t currentPos;
+
+        void skipFullPieces() {
+            while (currentPiece < pieces.size() &&
+                    currentPos == pieces[currentPiece].len) {
+                currentPiece++;
+                currentPos = 0;
+            }
+        }
+
+    public:
+        ArenaColumnReader(const std::vector<ArenaPiece> &pieces) :
+            pieces(pieces), currentPiece(0), currentPos(0) {
+            }
+
+        Term_t first() {
+            return pieces.front().values[0];
+        }
+
+        Term_t last() {
+            return pieces.back().values[pieces.back().len - 1];
+        }
+
+        std::vector<Term_t> asVector() {
+            std::vector<Term_t> out;
+            for (const auto &piece : pieces) {
+                out.insert(out.end(), piece.values, piece.values + piece.len);
+            }
+            return out;
+        }
+
+        bool hasNext() {
+            skipFullPieces();
+            return currentPiece < pieces.size();
+        }
+
+        Term_t next() {
+            skipFullPieces();
+            return pieces[currentPiece].values[currentPos++];
+        }
+
+        size_t nextBatch(Term_t *buffer, const size_t n) {
+            size_t copied = 0;
+            while (copied < n && hasNext()) {
+                const ArenaPiece &piece = pieces[currentPiece];
+                const size_t toCopy = std::min(n - copied,
+                        piece.len - currentPos);
+                memcpy(buffer + copied, piece.values + currentPos,
+                        sizeof(Term_t) * toCopy);
+                currentPos += toCopy;
+                copied += toCopy;
+            }
+            return copied;
+        }
+
+        size_t skip(const size_t n) {
+            size_t skipped = 0;
+            while (skipped < n && hasNext()) {
+                const size_t toSkip = std::min(n - skipped,
+                        pieces[currentPiece].len - currentPos);
+                currentPos += toSkip;
+                skipped += toSkip;
+            }
+            return skipped;
+        }
+
+        void clear() {
+        }
+};
+
+//Column whose values are allocated in an Arena (see ColumnWriter(Arena*)).
+//It keeps the chunks alive if it outlives the rule execution. The values
+//are in one or more pieces: the common case of a single piece is read
+//as an array.
+class ArenaColumn final : public Column {
+    private:
+        std::vector<ArenaPiece> pieces;
+        //Position in the column of the first value of every piece
+        std::vector<size_t> starts;
+        const Term_t *values;
+        size_t len;
+        bool sorted;
+
+    public:
+        ArenaColumn(std::shared_ptr<ArenaChunk> chunk, const Term_t *values,
+                const size_t len, const bool sorted) : values(values),
+        len(len), sorted(sorted) {
+            pieces.push_back(ArenaPiece(chunk, values, len));
+            starts.push_back(0);
+        }
+
+        ArenaColumn(const std::vector<ArenaPiece> &pieces, const bool sorted) :
+            pieces(pieces), values(NULL), len(0), sorted(sorted) {
+            for (const auto &piece : pieces) {
+                starts.push_back(len);
+                len += piece.len;
+            }
+            if (pieces.size() == 1) {
+                values = pieces[0].values;
+            }
+        }
+
+        size_t size() const {
+            return len;
+        }
+
+        size_t getRepresentationSize() const {
+            return len;
+        }
+
+        size_t estimateSize() const {
+            return len;
+        }
+
+        bool isEmpty() const {
+            return len == 0;
+        }
+
+        Term_t getValue(const size_t pos) const {
+            if (values != NULL) {
+                return values[pos];
+            }
+            const size_t i = std::upper_bound(starts.begin(), starts.end(),
+                    pos) - starts.begin() - 1;
+            return pieces[i].values[pos - starts[i]];
+        }
+
+        bool supportsDirectAccess() const {
+            return true;
+        }
+
+        bool isEDB() const {
+            return false;
+        }
+
+        bool containsDuplicates() const {
+            return len > 1;
+        }
+
+        std::unique_ptr<ColumnReader> getReader() const {
+            if (values != NULL) {
+                return std::unique_ptr<ColumnReader>(new ArrayColumnReader(
+                            values, len));
+            }
+            return std::unique_ptr<ColumnReader>(new ArenaColumnReader(
+                        pieces));
+        }
+
+        std::shared_ptr<Column> sort() const;
+
+        std::shared_ptr<Column> sort(const int nthreads) const;
+
+        std::shared_ptr<Column> unique() const;
+
+        bool isConstant() const {
+            return len < 2 || (sorted && first() == getValue(len - 1));
+        }
+
+        Term_t first() const {
+            assert(len > 0);
+            return pieces[0].values[0];
+        }
+
+        bool isIn(const Term_t t) const {
+            for (const auto &piece : pieces) {
+                const Term_t *end = piece.values + piece.len;
+                if (sorted) {
+                    if (piece.len > 0 && t <= end[-1]) {
+                        return std::binary_search(piece.values, end, t);
+                    }
+                } else if (std::find(piece.values, end, t) != end) {
+                    return true;
+                }
+            }
+            return false;
+        }
+};
+//----- END ARENA COLUMN ----------
+
 //----- EDB COLUMN ----------
 class EDBColumnReader final : public ColumnReader {
     private:
@@ -642,6 +1279,9 @@ class EDBColumnReader final : public ColumnReader {
         const uint8_t posInItr;
 
         EDBIterator *itr;
+        //Set once the iterator has returned all its rows, so that hasNext
+        //and nextBatch do not restart it from the first row
+        bool exhausted;
 
         //Cached values
         Term_t firstCached;
@@ -670,6 +1310,8 @@ class EDBColumnReader final : public ColumnReader {
 
         Term_t next();
 
+        size_t nextBatch(Term_t *buffer, const size_t n);
+
         const char *getUnderlyingArray();
         std::pair<uint8_t, std::pair<uint8_t, uint8_t>> getSizeElemUnderlyingArray();
 
@@ -0,0 +1,67 @@
+#ifndef _COLUMNKERNELS_H
+#define _COLUMNKERNELS_H
+
+#include <inttypes.h>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include <vlog/term.h>
+
+//Number of values that are moved at once through ColumnReader::nextBatch
+#define COLUMN_BATCH_SIZE 1024
+
+//Constants of the hash of the rows (see ColumnKernels::hashRow)
+#define HASHROW_SEED 0x9E3779B97F4A7C15ull
+#define HASHROW_MUL 0xFF51AFD7ED558CCDull
+
+//Bulk operations on arrays of Term_t. If the compiler targets AVX2 or
+//AVX-512 (see the SIMD cmake option) the kernels use vector instructions,
+//otherwise they fall back to plain loops with identical semantics.
+class ColumnKernels {
+    public:
+        //Writes in outPos the positions i in [0, n) such that in[i] == v.
+        //Returns the number of positions written.
+        static size_t filterEqual(const Term_t *in, const size_t n,
+                const Term_t v, uint32_t *outPos);
+
+        //Keeps only the positions in pos[0..npos) such that in[pos[i]] == v.
+        //Returns the number of positions retained.
+        static size_t refineEqual(const Term_t *in, uint32_t *pos,
+                const size_t npos, const Term_t v);
+
+        //out[i] = value + delta * (start + i) for i in [0, count)
+        static void decodeRange(const Term_t value, const int64_t delta,
+                const size_t start, const size_t count, Term_t *out);
+
+        //Returns the first position i >= 0 such that in[i] >= v, or n if
+        //no such position exists. in must be sorted.
+        static size_t skipLower(const Term_t *in, const size_t n,
+                const Term_t v);
+
+        //Merges the two sorted arrays and writes the matching values in out
+        //(which must have space for min(na, nb) values). The semantics
+        //are the one of a merge join where every match consumes one
+        //element from each side. Stops as soon as one of the two inputs
+        //is exhausted and sets consumedA and consumedB accordingly, so that
+        //the caller can refill the buffers and continue.
+        static size_t intersectSorted(const Term_t *a, const size_t na,
+                const Term_t *b, const size_t nb, Term_t *out,
+                size_t &consumedA, size_t &consumedB);
+
+        //Hash of a row of arity values
+        static uint64_t hashRow(const Term_t *row, const uint8_t arity) {
+            uint64_t h = HASHROW_SEED + arity;
+            for (uint8_t i = 0; i < arity; ++i) {
+                h = (h ^ (uint64_t) row[i]) * HASHROW_MUL;
+            }
+            return h ^ (h >> 32);
+        }
+
+        //out[i] = hashRow(rows + i * arity, arity) for i in [0, nrows).
+        //The rows must be stored one after the other.
+        static void hashRows(const Term_t *rows, const size_t nrows,
+                const uint8_t arity, uint64_t *out);
+};
+
+#endif
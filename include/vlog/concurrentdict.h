@@ -0,0 +1,141 @@
+#ifndef _CONCURRENTDICT_H
+#define _CONCURRENTDICT_H
+
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <string>
+#include <vector>
+#include <utility>
+#include <functional>
+#include <cstring>
+#include <inttypes.h>
+
+#include <vlog/term.h>
+
+//Number of shards of the dictionary (must be a power of two)
+#define CDICT_NSHARDS 64
+//Maximum size of the blocks of the arenas that contain the strings
+#define CDICT_ARENA_BLOCK (1024 * 1024)
+//The table from the IDs to the strings is split in blocks of
+//2^CDICT_DIR_BITS entries, allocated when they are first needed
+#define CDICT_DIR_BITS 16
+#define CDICT_DIR_BLOCKS (1 << 16)
+
+//Dictionary of strings that can be used by several threads at the same time.
+//The strings are distributed over CDICT_NSHARDS shards according to their
+//hash, and every shard has its own lock, so threads that add different
+//strings rarely wait for each other. The bytes of the strings are copied in
+//arenas (no std::string per entry); the arenas are never moved, so the
+//pointers returned by the lookups remain valid as long as the dictionary
+//exists. Decoding an ID does not take any lock.
+//
+//The IDs are consecutive, starting from startingCounter. If only one thread
+//adds strings, they get the IDs in the order in which they are added.
+class ConcurrentDictionary {
+    public:
+        typedef std::pair<const char*, size_t> Text;
+
+    private:
+        struct Shard {
+            std::mutex mutex;
+            //Blocks of records. Every record contains the ID (8 bytes), the
+            //length (4 bytes) and the bytes of a string
+            std::vector<std::unique_ptr<char[]>> blocks;
+            size_t blockUsed;
+            size_t blockSize;
+            uint64_t arenaBytes;
+            //Open-addressing table with the records and (part of) the hash
+            //of their strings
+            std::vector<const char*> slots;
+            std::vector<uint32_t> hashes;
+            size_t nentries;
+            //Keeps the locks of different shards on different cache lines
+            char padding[64];
+
+            Shard() : blockUsed(0), blockSize(0), arenaBytes(0),
+            slots(256, NULL), hashes(256, 0), nentries(0) {
+            }
+        };
+
+        const uint64_t startingCounter;
+        std::atomic<uint64_t> counter;
+        Shard shards[CDICT_NSHARDS];
+        //From the IDs (minus startingCounter) to the records
+        std::unique_ptr<std::atomic<std::atomic<const char*>*>[]> directory;
+        std::atomic<uint64_t> nDirBlocks;
+
+        static uint64_t hash(const char *text, const size_t len);
+
+        static uint64_t getRecordID(const char *record) {
+            uint64_t id;
+            memcpy(&id, record, 8);
+            return id;
+        }
+
+        static uint32_t getRecordLen(const char *record) {
+            uint32_t len;
+            memcpy(&len, record + 8, 4);
+            return len;
+        }
+
+        //The low bits of the hash are used for the slots
+        Shard &getShard(const uint64_t h) {
+            return shards[(h >> 40) & (CDICT_NSHARDS - 1)];
+        }
+
+        //Must be called with the lock of the shard
+        const char *find(const Shard &shard, const char *text, const size_t len,
+                const uint64_t h) const;
+
+        //Must be called with the lock of the shard
+        const char *insert(Shard &shard, const char *text, const size_t len,
+                const uint64_t h);
+
+        void setRecord(const uint64_t idx, const char *record);
+
+        const char *getRecord(const Term_t id) const;
+
+    public:
+        ConcurrentDictionary(const uint64_t startingCounter = 0);
+
+        ConcurrentDictionary(const ConcurrentDictionary&) = delete;
+
+        ~ConcurrentDictionary();
+
+        bool get(const char *text, const size_t len, Term_t &id);
+
+        Term_t getOrAdd(const char *text, const size_t len);
+
+        //Looks up all the terms, locking every shard once. Returns the
+        //number of terms that were found
+        size_t get(const std::vector<Text> &terms, std::vector<Term_t> &ids,
+                std::vector<bool> &found);
+
+        //The terms that are already in the dictionary are looked up as in
+        //get. The others are added in the order of terms
+        void getOrAdd(const std::vector<Text> &terms, std::vector<Term_t> &ids);
+
+        //Points text to the bytes of the string (not terminated)
+        bool getText(const Term_t id, const char *&text, size_t &len) const;
+
+        //Texts of the IDs. The IDs that are not in the dictionary get
+        //(NULL, 0)
+        void getTexts(const std::vector<Term_t> &ids,
+                std::vector<Text> &texts) const;
+
+        std::string getRawValue(const Term_t id) const;
+
+        uint64_t getCounter() const {
+            return counter.load();
+        }
+
+        uint64_t size() const {
+            return counter.load() - startingCounter;
+        }
+
+        //Bytes used by the arenas and by the tables
+        uint64_t getMemoryUsage();
+};
+
+#endif
@@ -5,6 +5,7 @@
 #include <vlog/concepts.h>
 #include <vlog/qsqquery.h>
 #include <vlog/support.h>
+#include <vlog/concurrentdict.h>
 #include <vlog/idxtupletable.h>
 
 #include <vlog/edbtable.h>
@@ -15,6 +16,8 @@
 
 #include <vector>
 #include <map>
+#include <mutex>
+#include <atomic>
 
 class Column;
 class EDBMemIterator final : public EDBIterator {
@@ -122,7 +125,13 @@ class EDBLayer {
         Factory<EDBMemIterator> memItrFactory;
         std::vector<IndexedTupleTable *>tmpRelations;
 
-        std::shared_ptr<Dictionary> termsDictionary;//std::string, Term_t
+        //Terms that are not in the EDB tables. It is created by the first
+        //call to getOrAddDictNumber, and can be used by several threads
+        std::shared_ptr<ConcurrentDictionary> termsDictionary;
+        std::atomic<ConcurrentDictionary*> termsDictionaryPtr;
+        std::mutex termsDictionaryMutex;
+
+        ConcurrentDictionary *getTermsDictionary(const bool create);
 
         VLIBEXP void addTridentTable(const EDBConf::Table &tableConf, bool multithreaded);
 
@@ -139,6 +148,7 @@ class EDBLayer {
         void addMDLiteTable(const EDBConf::Table &tableConf);
 #endif
         VLIBEXP void addInmemoryTable(const EDBConf::Table &tableConf);
+        VLIBEXP void addBinaryTable(const EDBConf::Table &tableConf);
         VLIBEXP void addSparqlTable(const EDBConf::Table &tableConf);
 
     public:
@@ -148,6 +158,7 @@ class EDBLayer {
             const std::vector<EDBConf::Table> tables = conf.getTables();
 
             predDictionary = std::shared_ptr<Dictionary>(new Dictionary());
+            termsDictionaryPtr = NULL;
 
             for (const auto &table : tables) {
                 if (table.type == "Trident") {
@@ -170,6 +181,8 @@ class EDBLayer {
 #endif
                 } else if (table.type == "INMEMORY") {
                     addInmemoryTable(table);
+                } else if (table.type == "Binary") {
+                    addBinaryTable(table);
 #ifdef SPARQL
                 } else if (table.type == "SPARQL") {
                     addSparqlTable(table);
@@ -274,6 +287,10 @@ class EDBLayer {
         bool isEmpty(const Literal &query, std::vector<uint8_t> *posToFilter,
                 std::vector<Term_t> *valuesToFilter);
 
+        // Returns false only if the table certainly does not contain any
+        // row that matches the constants of query.
+        bool mayContain(const Literal &query);
+
         size_t estimateCardinality(const Literal &query);
 
         size_t getCardinality(const Literal &query);
@@ -285,9 +302,21 @@ class EDBLayer {
         VLIBEXP bool getDictNumber(const char *text,
                 const size_t sizeText, uint64_t &id);
 
+        //Looks up all the terms. Returns the number of terms that were found
+        VLIBEXP size_t getDictNumbers(
+                const std::vector<ConcurrentDictionary::Text> &terms,
+                std::vector<uint64_t> &ids, std::vector<bool> &found);
+
         VLIBEXP bool getOrAddDictNumber(const char *text,
                 const size_t sizeText, uint64_t &id);
 
+        //Same as calling getOrAddDictNumber on every term, but the terms
+        //that are not in the EDB tables are looked up all together. Can be
+        //called by several threads
+        VLIBEXP void getOrAddDictNumbers(
+                const std::vector<ConcurrentDictionary::Text> &terms,
+                std::vector<uint64_t> &ids);
+
         VLIBEXP bool getDictText(const uint64_t id, char *text);
 
         VLIBEXP std::string getDictText(const uint64_t id);
@@ -319,6 +348,10 @@ class EDBLayer {
 
         VLIBEXP uint64_t getNTerms();
 
+        //Bytes used by the dictionary of the terms that are not in the EDB
+        //tables
+        VLIBEXP uint64_t getTermsDictionaryMemory();
+
         void releaseIterator(EDBIterator *itr);
 
         // For JNI interface ...
@@ -11,6 +11,19 @@ class EDBIterator {
 
         virtual Term_t getElementAt(const uint8_t p) = 0;
 
+        //Moves over at most n rows and copies their element at p in buffer.
+        //Returns the number of rows, less than n only at the end. Subclasses
+        //should override it to avoid the virtual calls of every row.
+        virtual size_t nextBatch(const uint8_t p, Term_t *buffer,
+                const size_t n) {
+            size_t i = 0;
+            while (i < n && hasNext()) {
+                next();
+                buffer[i++] = getElementAt(p);
+            }
+            return i;
+        }
+
         virtual PredId_t getPredicateID() = 0;
 
         virtual void moveTo(const uint8_t field, const Term_t t) {
@@ -38,6 +38,12 @@ public:
     virtual bool isEmpty(const Literal &query, std::vector<uint8_t> *posToFilter,
                          std::vector<Term_t> *valuesToFilter) = 0;
 
+    //Cheap check: returns false only if no row can match the constants of
+    //query. The tables that keep zone maps override it
+    virtual bool mayContain(const Literal &query) {
+        return true;
+    }
+
     virtual EDBIterator *getIterator(const Literal &query) = 0;
 
     virtual EDBIterator *getSortedIterator(const Literal &query,
@@ -10,6 +10,7 @@
 #include <string>
 #include <unordered_map>
 #include <set>
+#include <mutex>
 
 // Enable(1) or disable(0) a cache for sorted InmemoryFCInternalTable.
 #define INMEMINTERNALCACHE 1
@@ -207,6 +208,14 @@ class FCInternalTable {
                 const Term_t *valuesConstantsToFilter, const uint8_t nRepeatedVars,
                 const std::pair<uint8_t, uint8_t> *repeatedVars, int nthreads) const = 0;
 
+        //Returns false only if no row can contain the constants (e.g.,
+        //because the zone maps of the columns exclude them). Used to skip
+        //the tables without calling filter
+        virtual bool mayContain(const uint8_t nConstants, const uint8_t *posConstants,
+                const Term_t *valuesConstants) const {
+            return true;
+        }
+
         virtual bool isSorted() const = 0;
 
         virtual std::shared_ptr<Column> getColumn(const uint8_t columnIdx) const = 0;
@@ -299,6 +308,16 @@ class VectorFCInternalTableItr final : public FCInternalTableItr {
             currentIndex = beginIndex - 1;
         }
 
+        //Reader of the values of column pos in the rows that the iterator
+        //did not return yet, to read them in batches
+        std::unique_ptr<ColumnReader> getColumnReader(const uint8_t pos) const {
+            const int end = std::max(currentIndex + 1,
+                    std::min(endIndex, (int) vectors[pos]->size()));
+            return std::unique_ptr<ColumnReader>(new InmemColumnReader(
+                        *vectors[pos], currentIndex + 1,
+                        end - currentIndex - 1));
+        }
+
         ~VectorFCInternalTableItr() {
             clear();
         }
@@ -498,6 +517,9 @@ class InmemoryFCInternalTable final : public FCInternalTable {
         mutable std::vector<InmemoryFCInternalTableUnmergedSegment> unmergedSegments;
 #if INMEMINTERNALCACHE
         mutable std::map<uint32_t, std::shared_ptr<const Segment>> cachedSorted;
+        //The rules that read the same predicate can run at the same time
+        //(SemiNaiverThreaded), and sort the same table
+        mutable std::mutex cachedSortedMutex;
 #endif
 
         //size_t nrows;
@@ -553,6 +575,16 @@ class InmemoryFCInternalTable final : public FCInternalTable {
                 const Term_t *valuesConstantsToFilter, const uint8_t nRepeatedVars,
                 const std::pair<uint8_t, uint8_t> *repeatedVars, int nthreads);
 
+        //Column-at-a-time version of filter_row, used when there are
+        //constants to check. Skips the blocks excluded by the zone maps
+        static std::shared_ptr<const Segment> filter_columns(
+                std::shared_ptr<const Segment> seg,
+                const uint8_t nConstantsToFilter,
+                const uint8_t *posConstantsToFilter,
+                const Term_t *valuesConstantsToFilter,
+                const uint8_t nRepeatedVars,
+                const std::pair<uint8_t, uint8_t> *repeatedVars);
+
     public:
         static std::shared_ptr<const Segment> filter_row(SegmentIterator *itr,
                 const uint8_t nConstantsToFilter, const uint8_t *posConstantsToFilter,
@@ -625,6 +657,9 @@ class InmemoryFCInternalTable final : public FCInternalTable {
                 const Term_t *valuesConstantsToFilter, const uint8_t nRepeatedVars,
                 const std::pair<uint8_t, uint8_t> *repeatedVars, int nthreads) const;
 
+        bool mayContain(const uint8_t nConstants, const uint8_t *posConstants,
+                const Term_t *valuesConstants) const;
+
         FCInternalTableItr *sortBy(const std::vector<uint8_t> &fields) const;
 
         FCInternalTableItr *sortBy(const std::vector<uint8_t> &fields,
@@ -727,6 +762,9 @@ class EDBFCInternalTable final : public FCInternalTable {
                 const Term_t *valuesConstantsToFilter, const uint8_t nRepeatedVars,
                 const std::pair<uint8_t, uint8_t> *repeatedVars, int nthreads) const;
 
+        bool mayContain(const uint8_t nConstants, const uint8_t *posConstants,
+                const Term_t *valuesConstants) const;
+
         FCInternalTableItr *sortBy(const std::vector<uint8_t> &fields) const;
 
         FCInternalTableItr *sortBy(const std::vector<uint8_t> &fields,
@@ -4,15 +4,20 @@
 #include <trident/model/table.h>
 #include <vlog/concepts.h>
 #include <vlog/fcinttable.h>
+#include <vlog/fctableindex.h>
 
 #include <inttypes.h>
 #include <string>
+#include <map>
+#include <list>
 #include <unordered_map>
 #include <mutex>
+#include <atomic>
 
 struct RuleExecutionDetails;
 class FCTable;
 class TableFilterer;
+class SegmentSpiller;
 
 struct FCRow {
     const Term_t *row;
@@ -40,9 +45,79 @@ struct FCBlock {
     }
 };
 
+//Number of stripes of the cache of the filtered tables. Every stripe has
+//its own lock, so threads filtering the same table with different literals
+//do not wait for each other
+#define FCCACHE_NSTRIPES 8
+//Default memory budget (in bytes) of the caches of all the tables
+#define FCCACHE_DEFAULT_BUDGET (1024ul * 1024 * 1024)
+
+//Key of the cache: for every position of the literal, the constant or the
+//number of the variable, followed by the bitmaps of the positions that
+//contain variables
+struct FCCacheKey {
+    std::vector<uint64_t> terms;
+    uint64_t hash;
+
+    bool operator ==(const FCCacheKey &other) const {
+        return hash == other.hash && terms == other.terms;
+    }
+};
+
+struct FCCacheKeyHasher {
+    size_t operator()(const FCCacheKey &key) const {
+        return key.hash;
+    }
+};
+
+//Entry of the cache of a table, in the LRU list of FCCacheManager
+struct FCCacheRef {
+    FCTable *table;
+    int stripe;
+    FCCacheKey key;
+};
+
 struct FCCacheBlock {
     std::shared_ptr<FCTable> table;
     size_t begin, end;
+    //Estimated memory of the rows of table
+    uint64_t bytes;
+    std::list<FCCacheRef>::iterator lru;
+};
+
+typedef std::unordered_map<FCCacheKey, FCCacheBlock, FCCacheKeyHasher> FCCache;
+
+struct FCCacheStripe {
+    std::mutex mutex;
+    FCCache entries;
+};
+
+//Counters of the caches of all the tables
+struct FCCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t evictions;
+    uint64_t bytes;
+};
+
+//Budget and counters of the caches of all the tables of a materialization.
+//When the caches use more than the budget, the least recently used entries
+//are evicted, whatever their table
+struct FCCacheManager {
+    std::mutex mutex;
+    uint64_t budget;
+    uint64_t bytes;
+    //Entries of all the caches, the most recently used first
+    std::list<FCCacheRef> lru;
+    std::atomic<uint64_t> hits;
+    std::atomic<uint64_t> misses;
+    uint64_t evictions;
+
+    FCCacheManager(const uint64_t budget) : budget(budget), bytes(0),
+    hits(0), misses(0), evictions(0) {
+    }
+
+    FCCacheStats getStats();
 };
 
 class FCIterator {
@@ -77,25 +152,54 @@ class FCIterator {
         VLIBEXP void moveNextCount();
 };
 
-typedef std::unordered_map<std::string, FCCacheBlock, std::hash<std::string>, std::equal_to<std::string>> FCCache;
-
 class FCTable {
     private:
         const uint8_t sizeRow;
 
         std::vector<FCBlock> blocks;
 
-        FCCache cache;
-        std::string getSignature(const Literal &literal);
+        //Filtered versions of the table, see filter()
+        FCCacheStripe cacheStripes[FCCACHE_NSTRIPES];
+        static FCCacheKey getCacheKey(const Literal &literal);
+
+        //If NULL, the filtered versions are not cached
+        std::shared_ptr<FCCacheManager> cacheManager;
+
+        //Must be called with the locks of the stripe and of the manager.
+        //Evicts the least recently used entries of all the tables, except
+        //keep, while the caches use more than the budget
+        void evict(FCCacheStripe &stripe, const FCCacheKey &keep);
+
+        //Discards all the filtered versions of the table
+        void clearCache();
 
         std::mutex *mutex;
-        std::mutex cache_mutex;
+
+        std::shared_ptr<SegmentSpiller> spiller;
+
+        //Indices used by the restricted chase, identified by the indexed
+        //columns and the columns that must be equal
+        std::map<std::vector<uint8_t>, std::unique_ptr<FCTableIndex>> indices;
+        std::mutex index_mutex;
 
         void removeBlock(const size_t iteration);
 
     public:
         FCTable(std::mutex *mutex, const uint8_t sizeRow);
 
+        void setSpiller(std::shared_ptr<SegmentSpiller> spiller) {
+            this->spiller = spiller;
+        }
+
+        SegmentSpiller *getSpiller() const {
+            return spiller.get();
+        }
+
+        //Must be called before the table is filtered
+        void setCacheManager(std::shared_ptr<FCCacheManager> manager) {
+            cacheManager = manager;
+        }
+
         std::shared_ptr<const FCTable> filter(const Literal &literal, int nthreads) {
             return filter(literal, 0, NULL, nthreads);
         }
@@ -129,6 +233,10 @@ class FCTable {
 
         size_t getNAllRows() const;
 
+        //Estimated memory used by the rows of the table, excluding the
+        //rows read from the EDB layer
+        uint64_t getMemoryEstimate() const;
+
         size_t getNRows(const size_t iteration) const;
 
         bool isEmpty() const;
@@ -152,6 +260,23 @@ class FCTable {
 
         void addBlock(FCBlock block);
 
+        //Replaces the table of every block with the table at the same
+        //position in tables. The blocks whose new table is NULL or empty are
+        //removed. Since rows can disappear, the filtered versions of the
+        //table and the indices are discarded.
+        void replaceBlockTables(
+                const std::vector<std::shared_ptr<const FCInternalTable>> &tables);
+
+        //Adds to output the positions of the rows of values that exist in
+        //the table, considering only the columns in columnsToCheck. A row
+        //of the table matches only if the pairs of columns in equalColumns
+        //have the same value. The rows are looked up in an index that is
+        //kept for the following calls.
+        void findInIndex(const std::vector<std::shared_ptr<Column>> &values,
+                const std::vector<uint8_t> &columnsToCheck,
+                const std::vector<std::pair<int, int>> &equalColumns,
+                std::vector<uint64_t> &output);
+
         bool add(std::shared_ptr<const FCInternalTable> t, const Literal &literal,
                 const unsigned posLiteralInRule, const RuleExecutionDetails *detailsRule,
                 const unsigned ruleExecOrder,
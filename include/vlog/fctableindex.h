@@ -0,0 +1,64 @@
+#ifndef _FCTABLEINDEX_H
+#define _FCTABLEINDEX_H
+
+#include <vlog/concepts.h>
+#include <vlog/fcinttable.h>
+
+#include <vector>
+#include <memory>
+#include <inttypes.h>
+
+struct FCBlock;
+
+//Hash index on some columns of an FCTable. It is used by the restricted
+//chase to check whether the head of a rule is already satisfied: a row of
+//the table matches if its projection on the indexed columns is a key of the
+//index and, for every pair in equalColumns, the two columns have the same
+//value. The index is brought up to date with the blocks of the table before
+//it is used (see FCTable::findInIndex), indexing only the blocks that
+//changed since the previous time.
+class FCTableIndex {
+    private:
+        const std::vector<uint8_t> columns;
+        const std::vector<std::pair<int, int>> equalColumns;
+
+        //The keys, one after the other
+        std::vector<Term_t> keys;
+        uint64_t nkeys;
+        //Open-addressing table. Every slot contains the position of a key
+        //+ 1, or 0 if it is empty
+        std::vector<uint64_t> slots;
+
+        //Tables of the blocks that are indexed, in the order of the blocks
+        std::vector<std::shared_ptr<const FCInternalTable>> indexedTables;
+
+        uint64_t hashKey(const Term_t *key) const;
+
+        bool equalKey(const Term_t *key, const uint64_t pos) const;
+
+        void insert(const Term_t *key);
+
+        void indexTable(const FCInternalTable *table);
+
+    public:
+        FCTableIndex(const std::vector<uint8_t> &columns,
+                const std::vector<std::pair<int, int>> &equalColumns) :
+            columns(columns), equalColumns(equalColumns), nkeys(0) {
+            }
+
+        //Indexes the rows of the blocks that were added or changed
+        void update(const std::vector<FCBlock> &blocks);
+
+        //key contains the values of the indexed columns
+        bool contains(const Term_t *key) const;
+
+        const std::vector<uint8_t> &getColumns() const {
+            return columns;
+        }
+
+        uint64_t getNKeys() const {
+            return nkeys;
+        }
+};
+
+#endif
@@ -54,6 +54,11 @@ public:
     static bool intersection(const Literal &currentQuery,
                              const FCBlock & block);
 
+    //False if the zone maps of the table of the block show that none of
+    //its rows can match the constants of currentQuery
+    static bool mayContainConstants(const Literal &currentQuery,
+                                    const FCBlock &block);
+
     static void setOptIntersect(bool v) {
         opt_intersection = v;
     }
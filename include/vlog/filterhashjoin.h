@@ -5,6 +5,7 @@
 #include <vlog/joinprocessor.h>
 
 #include <vector>
+#include <mutex>
 
 struct FilterHashJoinBlock {
     const FCInternalTable *table;
@@ -92,11 +93,15 @@ public:
                    std::vector<DuplicateContainers> *existingTuples, const uint8_t nLastLiteralPosConstsInHead,
                    const Term_t *lastLiteralValueConstsInHead, const uint8_t *lastLiteralPosConstsInHead);
 
+    //If tablesMutex is not NULL, the tables are sorted (which fills their
+    //caches) and their iterators released while holding it, so that
+    //several threads can join on the same tables
     void run(const std::vector<FilterHashJoinBlock> &tables, const bool cartprod,
              const size_t startCarprod, const size_t endCartprod,
              const std::vector<uint8_t> posToSort, int &processedTables,
              const std::vector<std::pair<uint8_t, Term_t>> *valueColumnsToFilter,
-             const std::vector<std::pair<uint8_t, uint8_t>> *columnsToFilterOut);
+             const std::vector<std::pair<uint8_t, uint8_t>> *columnsToFilterOut,
+             std::mutex *tablesMutex = NULL);
 
     size_t getProcessedElements() {
         return processedElements;
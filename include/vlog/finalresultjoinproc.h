@@ -31,6 +31,9 @@ class SingleHeadFinalRuleProcessor: public ResultJoinProcessor {
 
         void enlargeBuffers(const int newsize);
 
+        //Moves seg to disk if the table has exhausted its memory budget
+        std::shared_ptr<const Segment> seal(std::shared_ptr<const Segment> seg);
+
     public:
         SingleHeadFinalRuleProcessor(
                 std::vector<std::pair<uint8_t, uint8_t>> &posFromFirst,
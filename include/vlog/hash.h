@@ -0,0 +1,65 @@
+#ifndef _HASH_H
+#define _HASH_H
+
+#include <inttypes.h>
+#include <cstddef>
+
+#include <vlog/term.h>
+
+//Constants of FNV-1a
+#define FNV_OFFSET UINT64_C(14695981039346656037)
+#define FNV_PRIME UINT64_C(1099511628211)
+//Initial value of the hashes computed with VLogHash::mixTerms
+#define MIXTERMS_SEED UINT64_C(0x9e3779b97f4a7c15)
+
+//Hash functions shared by the tables and the dictionaries. They do not
+//depend on the execution, unlike std::hash, so the hashes can also be
+//stored (see snapshot.cpp).
+class VLogHash {
+    public:
+        //Finalizer of MurmurHash3, so that values that differ in a single
+        //bit are spread over the whole table
+        static uint64_t mix(uint64_t h) {
+            h ^= h >> 33;
+            h *= UINT64_C(0xff51afd7ed558ccd);
+            h ^= h >> 33;
+            h *= UINT64_C(0xc4ceb9fe1a85ec53);
+            h ^= h >> 33;
+            return h;
+        }
+
+        //Adds v to the FNV-1a hash h
+        static uint64_t fnv(const uint64_t h, const uint64_t v) {
+            return (h ^ v) * FNV_PRIME;
+        }
+
+        //FNV-1a of the bytes of a string
+        static uint64_t fnvString(const char *text, const size_t len,
+                uint64_t h = FNV_OFFSET) {
+            for (size_t i = 0; i < len; ++i) {
+                h = fnv(h, (unsigned char) text[i]);
+            }
+            return h;
+        }
+
+        //FNV-1a of n terms, one term at a time
+        static uint64_t fnvTerms(const Term_t *values, const size_t n,
+                uint64_t h = FNV_OFFSET) {
+            for (size_t i = 0; i < n; ++i) {
+                h = fnv(h, values[i]);
+            }
+            return h;
+        }
+
+        //Hash of n terms, each one mixed with mix(). Slower than fnvTerms,
+        //but better for the tables with open addressing
+        static uint64_t mixTerms(const Term_t *values, const size_t n) {
+            uint64_t h = MIXTERMS_SEED;
+            for (size_t i = 0; i < n; ++i) {
+                h = mix(h ^ values[i]);
+            }
+            return h;
+        }
+};
+
+#endif
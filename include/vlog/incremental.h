@@ -0,0 +1,106 @@
+#ifndef _INCREMENTAL_H
+#define _INCREMENTAL_H
+
+#include <vlog/concepts.h>
+#include <vlog/edb.h>
+#include <vlog/seminaiver.h>
+#include <vlog/hash.h>
+
+#include <vector>
+#include <string>
+#include <map>
+#include <memory>
+#include <unordered_set>
+#include <unordered_map>
+
+//Flat row of term IDs. Used for the (small) sets of facts that are changed
+//by an update.
+typedef std::vector<Term_t> IncrTuple;
+
+struct IncrTupleHash {
+    size_t operator()(const IncrTuple &t) const {
+        return VLogHash::fnvTerms(t.data(), t.size());
+    }
+};
+
+typedef std::unordered_set<IncrTuple, IncrTupleHash> IncrTupleSet;
+
+struct IncrRelation;
+struct IncrRule;
+
+//Maintains a materialization computed by a SemiNaiver after a change of
+//the EDB, instead of recomputing it from scratch. It uses the DRed
+//algorithm:
+//1) Overdeletion: every IDB fact with a derivation that uses a removed
+//   fact (EDB or IDB) is removed;
+//2) Rederivation: the removed IDB facts that still have a derivation from
+//   the remaining facts are put back;
+//3) Insertion: the consequences of the added EDB facts and of the
+//   rederived facts are computed with a semi-naive evaluation.
+//The three phases only look at the facts that are reachable from the
+//update. The IDB facts are read block by block, skipping the blocks whose
+//zone maps exclude the searched values; the rows and the indexes of the
+//blocks that are read are kept for the following updates, as long as the
+//blocks do not change. Finally, the EDB tables of the updated predicates
+//are rewritten as in-memory tables and the FCTables of the IDB predicates
+//are updated: the added facts are appended as a new block, while the
+//removed facts are deleted in place from the blocks that contain them.
+//
+//The maintenance is only supported for programs without existential
+//variables and negation. isSupported() should be checked before
+//calling update(); otherwise the caller must recompute the
+//materialization.
+class IncrementalMaterializer {
+    private:
+        SemiNaiver &sn;
+        EDBLayer &layer;
+        Program &program;
+
+        std::vector<std::unique_ptr<IncrRule>> rules;
+        std::map<PredId_t, std::unique_ptr<IncrRelation>> relations;
+        std::map<PredId_t, IncrTupleSet> edbInsertions;
+        std::map<PredId_t, IncrTupleSet> edbDeletions;
+
+        IncrRelation &getRelation(const Predicate &pred);
+
+        void overdelete();
+
+        void rederive();
+
+        void insert();
+
+        void apply();
+
+    public:
+        VLIBEXP IncrementalMaterializer(SemiNaiver &sn, EDBLayer &layer,
+                Program &program);
+
+        //Returns false if the program cannot be maintained incrementally
+        VLIBEXP bool isSupported() const;
+
+        //Schedule the insertion/removal of the EDB facts in rows (arity
+        //values per fact).
+        VLIBEXP void addFacts(const PredId_t pred, const std::vector<Term_t> &rows);
+
+        VLIBEXP void removeFacts(const PredId_t pred, const std::vector<Term_t> &rows);
+
+        //Same as above, but with the textual terms. The terms are added
+        //to the dictionary if they do not exist.
+        VLIBEXP void addFacts(std::string pred,
+                std::vector<std::vector<std::string>> &rows);
+
+        VLIBEXP void removeFacts(std::string pred,
+                std::vector<std::vector<std::string>> &rows);
+
+        //Reads the updates from a CSV file where every line is a fact and
+        //the first field is the name of the predicate
+        VLIBEXP void readFacts(std::string file, bool remove);
+
+        //Applies all the scheduled updates to the EDB and to the
+        //materialization
+        VLIBEXP void update();
+
+        VLIBEXP ~IncrementalMaterializer();
+};
+
+#endif
@@ -0,0 +1,100 @@
+#ifndef _BINARYTABLE_H
+#define _BINARYTABLE_H
+
+#include <vlog/inmemory/inmemorytable.h>
+#include <vlog/column.h>
+
+#include <string>
+#include <vector>
+#include <memory>
+
+/*
+ * A binary database is a directory written by BinaryTable::convert (the
+ * command "binarize" of the launcher) with:
+ * - dict.bin: the strings of all the terms, sorted. The ID of a term is its
+ *   position, so lookups are binary searches on the memory-mapped file.
+ * - one file per relation, with the rows sorted and without duplicates. The
+ *   columns are stored one after the other as arrays of Term_t, preceded by
+ *   their zone maps: the minimum and maximum value of every block of
+ *   BINARY_ZONE_ROWS rows.
+ * - edb.conf, with one table of type "Binary" per relation.
+ * All the fields of the headers take 8 bytes, so that the columns can be
+ * used directly from the mapped files.
+ */
+#define BINARY_DICT_MAGIC "VLOGBDIC"
+#define BINARY_TABLE_MAGIC "VLOGBCOL"
+#define BINARY_VERSION 1
+#define BINARY_ZONE_ROWS 4096
+
+class EDBLayer;
+
+//Dictionary of a binary database
+class BinaryDictionary {
+    private:
+        const std::string dir;
+        std::shared_ptr<MappedFile> file;
+        uint64_t nterms;
+        const uint64_t *offsets;
+        const char *strings;
+
+    public:
+        BinaryDictionary(std::string dir);
+
+        const std::string &getDirectory() const {
+            return dir;
+        }
+
+        bool getNumber(const char *text, const size_t len, uint64_t &id) const;
+
+        bool getText(const uint64_t id, const char *&text, size_t &len) const;
+
+        uint64_t getNTerms() const {
+            return nterms;
+        }
+};
+
+//Relation of a binary database. The columns are MmapColumns on the file of
+//the relation, so loading it does not read the rows. The queries are
+//answered as in InmemoryTable, except the ones with constants: the rows
+//are sorted, so a constant in the first columns restricts the scan to a
+//range, and the zone maps allow to skip the blocks that cannot contain the
+//constants in the other columns.
+class BinaryTable : public InmemoryTable {
+    private:
+        std::shared_ptr<BinaryDictionary> dictionary;
+        std::shared_ptr<MappedFile> file;
+        uint64_t nrows;
+        uint64_t nzones;
+        //For every column, the minimum and maximum of every zone
+        std::vector<const Term_t*> zones;
+        std::vector<const Term_t*> columns;
+
+        //Scans the rows that match the constants and the repeated variables
+        //of q. If inserter is not NULL, they are added to it
+        uint64_t scan(const Literal &q, SegmentInserter *inserter);
+
+    public:
+        BinaryTable(std::string file, PredId_t predid,
+                std::shared_ptr<BinaryDictionary> dictionary, EDBLayer *layer);
+
+        std::shared_ptr<BinaryDictionary> getDictionary() {
+            return dictionary;
+        }
+
+        size_t getCardinality(const Literal &query);
+
+        EDBIterator *getIterator(const Literal &query);
+
+        bool getDictNumber(const char *text, const size_t sizeText, uint64_t &id);
+
+        bool getDictText(const uint64_t id, char *text);
+
+        bool getDictText(const uint64_t id, std::string &text);
+
+        uint64_t getNTerms();
+
+        //Writes all the tables of layer in a binary database in dir
+        VLIBEXP static void convert(EDBLayer &layer, std::string dir);
+};
+
+#endif
@@ -0,0 +1,108 @@
+#ifndef _INMEMORYLOADER_H
+#define _INMEMORYLOADER_H
+
+#include <vlog/concepts.h>
+#include <vlog/segment.h>
+
+#include <vector>
+#include <string>
+#include <memory>
+#include <istream>
+#include <inttypes.h>
+
+//Bytes of a CSV file parsed by every task. The file is read in blocks of
+//this size times the number of tasks
+#define INMEMORY_CHUNK_SIZE (16 * 1024 * 1024)
+
+class EDBLayer;
+
+//Loads the rows of a CSV or N-Triples file with several threads. The file
+//is split on row boundaries; every part is parsed by a different task,
+//which encodes the terms with a dictionary of its own. The dictionaries of
+//the parts are then added to the dictionary of the EDB layer in the order
+//of the parts, so the terms get the same IDs as when the file is read
+//sequentially. Finally, the rows are translated to the global IDs and added
+//to one SegmentInserter per task. CSV files (also gzipped) are streamed, one
+//block at the time.
+class InmemoryLoader {
+    private:
+        //Strings seen by a task, with consecutive IDs
+        class LocalDictionary {
+            private:
+                std::vector<char> strings;
+                //Start of every string in strings. The last element is the
+                //end of the last string
+                std::vector<uint64_t> offsets;
+                //Open-addressing table with the ID + 1 of the strings
+                std::vector<uint32_t> slots;
+
+                static uint64_t hash(const char *text, const size_t len);
+
+            public:
+                LocalDictionary() : offsets(1, 0), slots(1024, 0) {
+                }
+
+                uint32_t getOrAdd(const char *text, const size_t len);
+
+                uint32_t size() const {
+                    return offsets.size() - 1;
+                }
+
+                const char *get(const uint32_t id, size_t &len) const {
+                    len = offsets[id + 1] - offsets[id];
+                    return strings.data() + offsets[id];
+                }
+        };
+
+        struct Part {
+            LocalDictionary dict;
+            //The rows, one after the other, with the local IDs
+            std::vector<uint32_t> rows;
+            uint8_t arity;
+            std::string error;
+
+            Part() : arity(0) {
+            }
+        };
+
+        EDBLayer *layer;
+        const int ntasks;
+        uint8_t arity;
+        std::vector<std::unique_ptr<SegmentInserter>> inserters;
+
+        //Parses the CSV row that starts at pos, in the same way as readRow.
+        //The fields are copied in buffer, and fieldEnds contains the end of
+        //every field. Returns the position after the row. If the row does
+        //not end before end and eof is false, returns NULL
+        static const char *parseCSVRow(const char *pos, const char *end,
+                const bool eof, std::vector<char> &buffer,
+                std::vector<size_t> &fieldEnds);
+
+        //Splits [begin, end) in at most ntasks parts that contain complete
+        //rows. The last position is the end of the last complete row
+        std::vector<const char*> splitCSV(const char *begin, const char *end,
+                const bool eof) const;
+
+        static void parseCSV(const char *begin, const char *end, Part &part);
+
+        //Translates the local IDs of the parts to the global ones and adds
+        //the rows to the inserters
+        void addParts(std::vector<Part> &parts, const std::string &file);
+
+    public:
+        InmemoryLoader(EDBLayer *layer, const int ntasks);
+
+        void loadCSV(const std::string &file, const bool gzipped);
+
+        void loadNT(const std::string &file, const bool gzipped);
+
+        uint8_t getArity() const {
+            return arity;
+        }
+
+        //The rows that were loaded, sorted and without duplicates, or NULL
+        //if there are none
+        std::shared_ptr<const Segment> getSegment();
+};
+
+#endif
@@ -6,6 +6,11 @@
 #include <vlog/edbiterator.h>
 #include <vlog/segment.h>
 
+#include <istream>
+
+//Reads one line of a CSV file. The fields may be quoted.
+std::vector<std::string> readRow(std::istream &ifs);
+
 class InmemoryIterator : public EDBIterator {
     private:
         std::shared_ptr<const Segment> segment;
@@ -34,6 +39,8 @@ class InmemoryIterator : public EDBIterator {
 
         Term_t getElementAt(const uint8_t p);
 
+        size_t nextBatch(const uint8_t p, Term_t *buffer, const size_t n);
+
         PredId_t getPredicateID();
 
         void skipDuplicatedFirstColumn();
@@ -42,7 +49,7 @@ class InmemoryIterator : public EDBIterator {
 };
 
 class InmemoryTable : public EDBTable {
-    private:
+    protected:
         struct Coordinates {
             uint64_t offset;
             uint64_t len;
@@ -76,6 +83,12 @@ class InmemoryTable : public EDBTable {
         EDBIterator *getSortedIterator2(const Literal &query,
                 const std::vector<uint8_t> &fields);
 
+        //Used by the subclasses that read the segment from other sources
+        InmemoryTable(PredId_t predid, uint8_t arity,
+                std::shared_ptr<const Segment> segment, EDBLayer *layer) :
+            predid(predid), arity(arity), layer(layer), segment(segment) {
+            }
+
     public:
         InmemoryTable(std::string repository, std::string tablename, PredId_t predid, EDBLayer *layer);
 
@@ -101,6 +114,8 @@ class InmemoryTable : public EDBTable {
         bool isEmpty(const Literal &query, std::vector<uint8_t> *posToFilter,
                 std::vector<Term_t> *valuesToFilter);
 
+        bool mayContain(const Literal &query);
+
         EDBIterator *getIterator(const Literal &query);
 
         // This version has fields corresponding to the VARIABLES IN THE QUERY!!!!!
@@ -0,0 +1,93 @@
+#ifndef _JOINORDER_H
+#define _JOINORDER_H
+
+#include <vlog/concepts.h>
+#include <vlog/edb.h>
+#include <vlog/fctable.h>
+
+#include <vector>
+#include <map>
+#include <unordered_map>
+#include <string>
+#include <memory>
+#include <mutex>
+
+//Rules with at most this number of atoms are ordered by enumerating all
+//the orders (dynamic programming). Larger rules are ordered greedily.
+#define JOINORDER_MAX_DP 10
+//Number of values sampled from a column of an IDB block to estimate the
+//number of distinct values
+#define JOINORDER_SAMPLE_SIZE 1024
+
+//Chooses the order of the atoms of a rule body by estimating the size of
+//the intermediate results. The size of the join of an intermediate result R
+//with an atom A is estimated as |R| * |A| / prod(max(d_R(v), d_A(v))),
+//where v ranges over the variables shared by R and A, and d is the number
+//of distinct values of a variable. The cost of an order is the sum of the
+//sizes of the atoms and of the intermediate results.
+//
+//The number of distinct values of a column comes from the EDB layer
+//(getCardinalityColumn) for the EDB atoms, and from a sample of every block
+//of the FCTable for the IDB atoms. Both are cached, so that the statistics
+//of a block are computed only once.
+class JoinOrderOptimizer {
+    public:
+        struct Atom {
+            const Literal *literal;
+            double card;
+            //Distinct values of every variable of the atom
+            std::map<Var_t, double> distinct;
+        };
+
+    private:
+        std::mutex mutex;
+        //Distinct values of every column of the blocks of the IDB tables.
+        //The weak pointer tells whether the block is still the same
+        std::unordered_map<const FCInternalTable*,
+            std::pair<std::weak_ptr<const FCInternalTable>, std::vector<double>>> blockStats;
+        //Distinct values of every column of the EDB literals, together with
+        //the cardinality of the literal when they were computed
+        std::unordered_map<std::string,
+            std::pair<size_t, std::vector<double>>> edbStats;
+
+        static double sampleDistinct(const Column *column);
+
+        const std::vector<double> &getBlockStats(
+                std::shared_ptr<const FCInternalTable> table);
+
+        //Cost of joining the atoms in order. connected is set to false if an
+        //atom does not share variables with the previous ones
+        static double estimateCost(const std::vector<Atom> &atoms,
+                const std::vector<int> &order, bool &connected);
+
+        static std::vector<int> orderDP(const std::vector<Atom> &atoms);
+
+        static std::vector<int> orderGreedy(const std::vector<Atom> &atoms);
+
+    public:
+        //Distinct values of every position of an EDB literal
+        std::vector<double> getEDBDistinct(const Literal &literal,
+                EDBLayer &layer, const size_t card);
+
+        //Distinct values of every position of an IDB literal, in the blocks
+        //of itr
+        std::vector<double> getIDBDistinct(const Literal &literal,
+                FCIterator itr, const size_t card);
+
+        //Builds the description of an atom from the distinct values of its
+        //positions
+        static Atom getAtom(const Literal *literal, const size_t card,
+                const std::vector<double> &distinct);
+
+        //Returns the best order of the atoms, or an empty vector if every
+        //order contains a cartesian product
+        std::vector<int> getOrder(const std::vector<Atom> &atoms);
+
+        void clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            blockStats.clear();
+            edbStats.clear();
+        }
+};
+
+#endif
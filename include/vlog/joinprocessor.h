@@ -35,6 +35,15 @@ struct LessTwoTuples {
 
 #define FLUSH_SIZE (1 << 20)
 
+//Number of morsels per thread when the probe side of the hash join is
+//executed in parallel
+#define MORSELS_PER_THREAD 16
+
+//Target size (in bytes) of the build side of a partition in the radix
+//join, and maximum number of radix bits
+#define RADIX_PARTITION_BYTES (128 * 1024)
+#define RADIX_MAX_BITS 14
+
 class Output {
     private:
 
@@ -254,10 +263,10 @@ class JoinExecutor {
                 const bool literalSharesVarsWithHead,
                 const size_t min, const size_t max,
                 const std::vector<std::pair<uint8_t, uint8_t>> *filterValueVars,
-                int &processedTables);
+                int &processedTables, int nthreads);
 
-        static void do_merge_join_fasteralgo(FCInternalTableItr *sortedItr1,
-                FCInternalTableItr *sortedItr2,
+        static void do_merge_join_fasteralgo(VectorFCInternalTableItr *sortedItr1,
+                VectorFCInternalTableItr *sortedItr2,
                 const std::vector<uint8_t> &fields1,
                 const std::vector<uint8_t> &fields2,
                 const uint8_t posBlocks,
@@ -270,6 +279,15 @@ class JoinExecutor {
                 const std::vector<uint8_t> &fields1, const uint8_t *posOtherVars, const std::vector<Term_t> *valuesOtherVars,
                 const std::vector<uint8_t> &fields2, ResultJoinProcessor *output, int nthreads);
 
+        //Hash join that first partitions both sides on the hash of the
+        //join fields, so that the hash table of every partition fits in
+        //the L2 cache. The partitions are joined in parallel.
+        static void do_radixjoin(const FCInternalTable *t1,
+                std::vector<std::shared_ptr<const FCInternalTable>> &tables2,
+                const std::vector<uint8_t> &fields1,
+                const std::vector<uint8_t> &fields2,
+                ResultJoinProcessor *output, int nthreads);
+
     public:
         static void do_merge_join_classicalgo(FCInternalTableItr *sortedItr1,
                 FCInternalTableItr *sortedItr2,
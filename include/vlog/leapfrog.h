@@ -0,0 +1,102 @@
+#ifndef _LEAPFROG_H
+#define _LEAPFROG_H
+
+#include <vlog/concepts.h>
+
+#include <vector>
+#include <memory>
+#include <inttypes.h>
+
+class ResultJoinProcessor;
+class Column;
+
+//Multiway join of several relations with the leapfrog triejoin algorithm
+//(Veldhuizen, ICDT 2014). The variables are bound one at a time, in a
+//global order: the values of a variable are the intersection of the values
+//that the relations that contain it allow, given the variables bound so
+//far. Unlike a sequence of binary joins, no intermediate result is
+//materialized, so cyclic bodies (e.g., triangles) run in time proportional
+//to the worst-case size of the output.
+//
+//Every relation must be sorted with its columns in the global order of the
+//variables. The rows that match the variables bound so far are then a
+//contiguous range. A relation that is already sorted in that order (e.g.,
+//a derived table, whose columns are sorted from the first to the last) is
+//read in place; the others are copied and sorted once.
+class LeapfrogTrieJoin {
+    private:
+        struct Relation {
+            std::vector<Var_t> vars;
+            uint8_t width;
+            //Input columns, in the order of vars. Kept while the columns
+            //are read in place
+            std::vector<std::shared_ptr<Column>> input;
+            bool inputSorted;
+            //Columns copied from the input, when they are not backed by a
+            //vector or must be sorted again
+            std::vector<std::vector<Term_t>> copied;
+            //Columns in the global order of the variables
+            std::vector<const Term_t*> columns;
+            size_t nrows;
+            //Range of rows that match the variables bound so far
+            size_t begin, end;
+
+            Term_t get(const size_t row, const uint8_t col) const {
+                return columns[col][row];
+            }
+        };
+
+        std::vector<Relation> relations;
+        //Global order of the variables
+        std::vector<Var_t> variables;
+        //For every variable, the relations that contain it and its column
+        std::vector<std::vector<std::pair<int, uint8_t>>> participants;
+        std::vector<Term_t> bindings;
+        uint64_t nresults;
+
+        //First row in [from, to) whose column col is >= value
+        static size_t seek(const Relation &r, const uint8_t col,
+                size_t from, const size_t to, const Term_t value);
+
+        void search(const size_t depth, ResultJoinProcessor *output);
+
+    public:
+        LeapfrogTrieJoin() : nresults(0) {
+        }
+
+        //True if the hypergraph of the atoms (one hyperedge with the
+        //variables of every atom) is cyclic, according to the GYO reduction
+        static bool isCyclic(const std::vector<std::vector<Var_t>> &atoms);
+
+        //columns are the columns of the relation, and vars their variables
+        //(without repetitions). If sorted, the rows are sorted on the
+        //columns from the first to the last: the columns are then read in
+        //place when the global order of the variables agrees
+        void addRelation(const std::vector<Var_t> &vars,
+                const std::vector<std::shared_ptr<Column>> &columns,
+                const bool sorted);
+
+        //Same as above, for columns that were already copied. They are
+        //moved into the join
+        void addRelation(const std::vector<Var_t> &vars,
+                std::vector<std::vector<Term_t>> &columns);
+
+        //Chooses the order of the variables and sorts the relations that
+        //are not sorted in that order. Must be called after all the
+        //relations are added
+        void prepare();
+
+        //Order of the variables in the bindings passed to the output
+        const std::vector<Var_t> &getVariables() const {
+            return variables;
+        }
+
+        //Passes every binding of the variables to output (as "first" row)
+        void join(ResultJoinProcessor *output);
+
+        uint64_t getNResults() const {
+            return nresults;
+        }
+};
+
+#endif
@@ -21,6 +21,16 @@ public:
 
     uint64_t getSizeFromDB(const std::string &query);
 
+    bool executeUpdate(const std::string &query);
+
+    // Without this clause, MonetDB empties the temporary tables at the end
+    // of every statement
+    std::string createTempTableSQL(const std::string &name,
+            const std::string &query) {
+        return "CREATE TEMPORARY TABLE " + name + " AS " + query +
+            " WITH NO DATA ON COMMIT PRESERVE ROWS";
+    }
+
     ~MAPITable();
 };
 
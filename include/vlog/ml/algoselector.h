@@ -0,0 +1,97 @@
+#ifndef _ALGOSELECTOR_H
+#define _ALGOSELECTOR_H
+
+#include <vlog/concepts.h>
+#include <vlog/edb.h>
+
+#include <string>
+#include <vector>
+#include <ostream>
+
+//Number of features of a query (see AlgoSelector::getFeatures)
+#define ALGOSEL_NFEATURES 9
+//Default parameters of the training of the decision tree
+#define ALGOSEL_MAX_DEPTH 6
+#define ALGOSEL_MIN_LEAF 5
+//Number of folds of the cross-validation of AlgoSelector::benchmark
+#define ALGOSEL_FOLDS 5
+
+#define ALGOSEL_MAGIC "VLOG_ALGOSELECTOR"
+#define ALGOSEL_VERSION 1
+
+//Runtimes of a query with QSQ-R and magic sets, written by the command
+//"runtq" of the launcher in the training log
+struct TrainingRecord {
+    std::string query;
+    std::vector<double> features;
+    //Cost estimated by Reasoner::estimate, which is what
+    //Reasoner::chooseMostEfficientAlgo compares with its threshold
+    uint64_t estimatedCost;
+    //Milliseconds
+    double timeQSQR;
+    double timeMagic;
+};
+
+//Decision tree that chooses between QSQ-R and magic sets from the features
+//of a query. The tree is trained on the training log to minimize the total
+//runtime of the training queries rather than the number of wrong choices,
+//so the queries where the two algorithms differ most weigh the most.
+class AlgoSelector {
+    private:
+        struct Node {
+            //Feature tested by the node, or -1 for leaves. The records with
+            //a value <= threshold go to the left child
+            int feature;
+            double threshold;
+            int left, right;
+            //Choice of the leaves
+            bool qsqr;
+        };
+
+        std::vector<Node> nodes;
+
+        int build(std::vector<const TrainingRecord*> &records,
+                const size_t begin, const size_t end, const int depth,
+                const int maxDepth, const size_t minLeaf);
+
+    public:
+        static std::vector<std::string> getFeatureNames();
+
+        //estimatedCost is the output of Reasoner::estimate on query
+        VLIBEXP static std::vector<double> getFeatures(const Literal &query,
+                Program &program, EDBLayer &layer,
+                const uint64_t estimatedCost);
+
+        static void writeTrainingHeader(std::ostream &out);
+
+        static void writeTrainingRecord(std::ostream &out,
+                const TrainingRecord &record);
+
+        VLIBEXP static std::vector<TrainingRecord> readTrainingLog(
+                std::string file);
+
+        VLIBEXP void train(const std::vector<TrainingRecord> &records,
+                const int maxDepth = ALGOSEL_MAX_DEPTH,
+                const size_t minLeaf = ALGOSEL_MIN_LEAF);
+
+        bool isTrained() const {
+            return !nodes.empty();
+        }
+
+        //Returns true if the query should be evaluated with QSQ-R
+        VLIBEXP bool chooseQSQR(const std::vector<double> &features) const;
+
+        VLIBEXP void save(std::string file) const;
+
+        VLIBEXP void load(std::string file);
+
+        //Compares, with cross-validation on the records, the total runtime
+        //of the choices of the tree with the ones of the threshold on the
+        //estimated cost, of the two algorithms alone and of the best choice
+        VLIBEXP static void benchmark(const std::vector<TrainingRecord> &records,
+                const uint64_t threshold, const int folds = ALGOSEL_FOLDS,
+                const int maxDepth = ALGOSEL_MAX_DEPTH,
+                const size_t minLeaf = ALGOSEL_MIN_LEAF);
+};
+
+#endif
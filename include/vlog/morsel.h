@@ -0,0 +1,22 @@
+#ifndef _MORSEL_H
+#define _MORSEL_H
+
+#include <functional>
+#include <cstddef>
+
+//Executes a task over the range [0, nitems) with nthreads workers. Every
+//worker starts with a contiguous slice of the range and consumes it in
+//morsels of morselSize items. When a worker runs out of work, it steals
+//the second half of the largest remaining slice of another worker, so that
+//skewed morsels do not leave the other threads idle.
+class MorselScheduler {
+    public:
+        //task(worker, begin, end) is invoked once per morsel. worker is in
+        //[0, nthreads) and identifies the thread that executes the morsel,
+        //so that the caller can keep per-thread state.
+        static void run(const size_t nitems, const size_t morselSize,
+                const int nthreads,
+                std::function<void(const int, const size_t, const size_t)> task);
+};
+
+#endif
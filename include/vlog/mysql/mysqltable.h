@@ -36,6 +36,8 @@ class MySQLTable : public SQLTable {
 
 	uint64_t getSizeFromDB(const std::string &query);
 
+	bool executeUpdate(const std::string &query);
+
         ~MySQLTable() {
             if (con) {
                 con->close();
@@ -23,6 +23,8 @@ public:
 
     uint64_t getSizeFromDB(const std::string &query);
 
+    bool executeUpdate(const std::string &query);
+
     ~ODBCTable();
 };
 
@@ -0,0 +1,110 @@
+#ifndef _PROFILER_H
+#define _PROFILER_H
+
+#include <vlog/concepts.h>
+
+#include <vector>
+#include <string>
+#include <mutex>
+#include <chrono>
+#include <inttypes.h>
+
+//Phases of the execution of a rule. The time of a phase does not include
+//the time of the phases nested in it (e.g., the retrieval of a table
+//during a join is not counted as join time).
+typedef enum ProfilePhase {
+    PROFILE_RETRIEVAL, PROFILE_FILTERING, PROFILE_JOIN,
+    PROFILE_CONSOLIDATION, PROFILE_DEDUPLICATION, PROFILE_NPHASES
+} ProfilePhase;
+
+struct AtomProfile {
+    std::string literal;
+    //Position of the atom in the order of execution
+    int posInPlan;
+    //Physical operator used to join the atom with the previous results
+    std::string join;
+    //Estimated rows of the atom in the range of iterations
+    uint64_t rowsIn;
+    //Rows of the previous results
+    uint64_t rowsLeft;
+    //Rows produced after the atom is processed
+    uint64_t rowsOut;
+    double timeMs;
+};
+
+struct RuleProfile {
+    size_t ruleid;
+    size_t iteration;
+    int combinations;
+    double timeMs;
+    double phasesMs[PROFILE_NPHASES];
+    uint64_t derivations;
+    //Difference of resident memory (in KB) before and after the execution
+    int64_t memoryDelta;
+    std::vector<AtomProfile> atoms;
+
+    RuleProfile() : ruleid(0), iteration(0), combinations(0), timeMs(0),
+    derivations(0), memoryDelta(0) {
+        for (int i = 0; i < PROFILE_NPHASES; ++i) {
+            phasesMs[i] = 0;
+        }
+    }
+};
+
+//Collects a RuleProfile for every execution of a rule during the
+//materialization (see SemiNaiver::setProfiler). The profile of the rule
+//executed by a thread is reachable with current(), so that the operators
+//can report what they do without passing the profile around. If no
+//profiling is active, current() returns NULL and nothing is recorded.
+class RuleProfiler {
+    private:
+        std::mutex mutex;
+        std::vector<RuleProfile> profiles;
+
+        static std::string getRuleString(Program *program, EDBLayer &layer,
+                const size_t ruleid);
+
+    public:
+        static RuleProfile *current();
+
+        //Sets the profile of the rule executed by this thread
+        static void setCurrent(RuleProfile *profile);
+
+        //Records the join operator used for the atom being processed
+        static void setJoin(const char *join);
+
+        //Resident memory of the process in KB (0 if not available)
+        static int64_t getResidentMemory();
+
+        void add(const RuleProfile &profile);
+
+        const std::vector<RuleProfile> &getProfiles() const {
+            return profiles;
+        }
+
+        //Prints the rules that took most time
+        void printSummary(Program *program, EDBLayer &layer, const int n);
+
+        //One object per rule execution, with the details of every atom
+        VLIBEXP void exportJSON(std::string file, Program *program,
+                EDBLayer &layer);
+
+        //One line per rule execution
+        VLIBEXP void exportCSV(std::string file, Program *program,
+                EDBLayer &layer);
+};
+
+//Adds the time between its construction and destruction to a phase of the
+//current rule profile, if there is one
+class ProfilePhaseTimer {
+    private:
+        RuleProfile *profile;
+        int previousPhase;
+
+    public:
+        ProfilePhaseTimer(const ProfilePhase phase);
+
+        ~ProfilePhaseTimer();
+};
+
+#endif
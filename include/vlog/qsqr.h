@@ -14,6 +14,8 @@
 #include <trident/model/table.h>
 
 #include <vector>
+#include <memory>
+#include <mutex>
 
 class TupleTable;
 class RuleExecutor;
@@ -32,9 +34,14 @@ struct QSQR_Task {
     //To execute a query I need to know:
     Predicate pred;
     BindingsTable *inputTable;
+    //Range of the tuples of inputTable that are evaluated
     size_t offsetInput;
+    size_t endInput;
     bool repeat;
     int currentRuleIndex;
+    //Range of the rules of pred that are executed
+    int firstRuleIndex;
+    int lastRuleIndex;
     size_t totalAnswers;
 
     //To execute a rule I need to know:
@@ -56,6 +63,13 @@ private:
     EDBLayer &layer;
     Program *program;
 
+    //Owner of the tables, for the workers of evaluateParallel. NULL if the
+    //tables are the ones below
+    QSQR *shared;
+    //Locks the tables while they are shared by several workers. NULL
+    //otherwise
+    std::mutex *tablesMutex;
+
     //Store all the inputs used during the computation
     std::vector<uint8_t> sizePreds;
     std::vector<BindingsTable **>inputs;
@@ -64,18 +78,73 @@ private:
 
     //const Timeout * timeout;
 
+    //Number of workers used by evaluateQuery
+    int nthreads;
+
 #ifndef RECURSIVE_QSQR
     std::vector<QSQR_Task> tasks;
     void processTask(QSQR_Task &task);
+
+    void processAllTasks();
+
+    //Executes only the rules of pred in [firstRule, lastRule), on the
+    //tuples of inputTable in [offsetInput, endInput)
+    void evaluate(Predicate &pred, BindingsTable *inputTable,
+                  size_t offsetInput, size_t endInput, bool repeat,
+                  int firstRule, int lastRule);
+
+    //One round of the evaluation of the query by a worker. The query is
+    //added to the shared inputs, so that the subqueries do not evaluate it
+    //again, and the rules of its predicate in [firstRule, lastRule) are
+    //executed on a private copy of it
+    void evaluateRound(QSQQuery *query, std::vector<uint8_t> *posJoins,
+                       std::vector<Term_t> *possibleValuesJoins,
+                       int firstRule, int lastRule);
+
+    //Evaluates the query with several workers that share the tables of
+    //this object. Every worker executes a subset of the rules of the
+    //predicate of the query on a subset of the bindings, and the
+    //subqueries go through the shared input tables: a subquery is
+    //evaluated by the worker that adds it first, and the others read its
+    //answers. The rounds are repeated until one does not produce new
+    //answers. Returns false, without evaluating the query, if it cannot be
+    //split.
+    bool evaluateParallel(QSQQuery *query, std::vector<uint8_t> *posJoins,
+                          std::vector<Term_t> *possibleValuesJoins);
+
+    //Worker of evaluateParallel, which uses the tables of shared
+    QSQR(QSQR &shared) : layer(shared.layer), program(shared.program),
+    shared(&shared), tablesMutex(NULL), nthreads(1) {
+    }
 #endif
 
+    RuleExecutor *getRuleExecutor(const Predicate &pred, const int idx) {
+        QSQR &owner = shared != NULL ? *shared : *this;
+        return owner.rules[pred.getId()][pred.getAdorment()][idx];
+    }
+
+    //Predicate of the query, with the positions in posJoins bound
+    Predicate getInputPredicate(QSQQuery *query, std::vector<uint8_t> *posJoins);
+
+    //Adds the query to the input table of its predicate, once for every
+    //binding in possibleValuesJoins. Returns the predicate of the input
+    Predicate addQueryInput(QSQQuery *query, std::vector<uint8_t> *posJoins,
+                            std::vector<Term_t> *possibleValuesJoins,
+                            BindingsTable *&inputTable);
+
+    //Adds the query to inputTable, once for every binding in
+    //possibleValuesJoins
+    static void addQueryTuples(QSQQuery *query, std::vector<uint8_t> *posJoins,
+                               std::vector<Term_t> *possibleValuesJoins,
+                               BindingsTable *inputTable);
 
     size_t calculateAllAnswers();
 
     void createRules(Predicate &pred);
 
 public:
-    QSQR(EDBLayer &layer, Program *program) : layer(layer), program(program) {
+    QSQR(EDBLayer &layer, Program *program, int nthreads = 1) : layer(layer),
+    program(program), shared(NULL), tablesMutex(NULL), nthreads(nthreads) {
         int nPreds = program->getNPredicates();
         sizePreds.resize(nPreds);
         inputs.resize(nPreds);
@@ -83,6 +152,10 @@ public:
         rules.resize(nPreds);
     }
 
+    void setNThreads(int nthreads) {
+        this->nthreads = nthreads;
+    }
+
     /*void raiseIfExpired() {
         if (timeout != NULL)
             timeout->raiseIfExpired();
@@ -102,10 +175,16 @@ public:
 
     void cleanAllInputs();
 
-    //Get input for specific query
+    //Mutex that must be held to use the input and answer tables, or NULL if
+    //they are not shared by several threads
+    std::mutex *getTablesMutex() {
+        return shared != NULL ? shared->tablesMutex : tablesMutex;
+    }
+
+    //Get input for specific query. Called with getTablesMutex() locked
     BindingsTable *getInputTable(const Predicate pred);
 
-    //Get answers for specific query
+    //Get answers for specific query. Called with getTablesMutex() locked
     BindingsTable *getAnswerTable(const Predicate pred, uint8_t adornment);
 
     BindingsTable *getAnswerTable(const Literal *literal) {
@@ -137,7 +216,37 @@ public:
     void evaluate(Predicate &pred, BindingsTable *inputTable,
                   size_t offsetInput, bool repeat);
 
+#ifndef RECURSIVE_QSQR
+    //Evaluates the tuples of inputTable in [offsetInput, endInput), which
+    //were added by the caller. Other workers may add tuples after them
+    void evaluateRange(Predicate &pred, BindingsTable *inputTable,
+                  size_t offsetInput, size_t endInput) {
+        evaluate(pred, inputTable, offsetInput, endInput, true, 0,
+                program->getNRulesByPredicate(pred.getId()));
+    }
+#endif
+
     ~QSQR();
 };
 
+//Holds the mutex of the tables of a QSQR while they are shared by the
+//workers of evaluateParallel. Does nothing otherwise
+class QSQR_TablesLock {
+    private:
+        std::mutex *m;
+
+    public:
+        QSQR_TablesLock(QSQR *qsqr) : m(qsqr->getTablesMutex()) {
+            if (m != NULL) {
+                m->lock();
+            }
+        }
+
+        ~QSQR_TablesLock() {
+            if (m != NULL) {
+                m->unlock();
+            }
+        }
+};
+
 #endif
@@ -0,0 +1,38 @@
+#ifndef _RADIXSORT_H
+#define _RADIXSORT_H
+
+#include <vector>
+#include <cstddef>
+#include <functional>
+#include <utility>
+
+#include <vlog/term.h>
+
+//Below this number of rows the sorter falls back to std::sort
+#define RADIX_SORT_MIN_ROWS 4096
+
+//Number of bits sorted by every pass of the radix sort
+#define RADIX_SORT_BITS 11
+
+//Row-wise sorting of a set of columns of equal length. The rows are not
+//moved: the sorter permutes a vector of row indexes, like SegmentSorter
+//does with std::sort.
+class RadixSorter {
+    public:
+        //Reorders idxs so that the rows they point to are in lexicographic
+        //order (vectors[0] is the most significant column). The sort is a
+        //LSD radix sort on the Term_t values: the columns are processed
+        //from the last to the first, and every pass is a stable
+        //partitioning on RADIX_SORT_BITS bits. Bits that are the same in
+        //all the values of a column are skipped. Every pass is distributed
+        //over nthreads workers.
+        static void sort(const std::vector<const std::vector<Term_t> *> &vectors,
+                std::vector<size_t> &idxs, const int nthreads);
+
+        //Removes from idxs the rows that are equal to the previous one.
+        //idxs must be sorted.
+        static void unique(const std::vector<const std::vector<Term_t> *> &vectors,
+                std::vector<size_t> &idxs, const int nthreads);
+};
+
+#endif
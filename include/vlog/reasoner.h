@@ -18,11 +18,17 @@
 
 typedef enum {TOPDOWN, MAGIC} ReasoningMode;
 
+class AlgoSelector;
+
 class Reasoner {
     private:
 
         const uint64_t threshold;
 
+        //If set, chooseMostEfficientAlgo asks the model instead of comparing
+        //the estimated cost with the threshold
+        std::shared_ptr<AlgoSelector> selector;
+
         void cleanBindings(std::vector<Term_t> &bindings, std::vector<uint8_t> * posJoins,
                 TupleTable *input);
 
@@ -48,7 +54,11 @@ class Reasoner {
 
         Reasoner(const uint64_t threshold) : threshold(threshold) {}
 
-        size_t estimate(Literal &query, std::vector<uint8_t> *posBindings,
+        void setAlgoSelector(std::shared_ptr<AlgoSelector> selector) {
+            this->selector = selector;
+        }
+
+        VLIBEXP size_t estimate(Literal &query, std::vector<uint8_t> *posBindings,
                 std::vector<Term_t> *valueBindings, EDBLayer &layer,
                 Program &program);
 
@@ -64,19 +74,25 @@ class Reasoner {
                 bool returnOnlyVars,
                 std::vector<uint8_t> *sortByFields);
 
+        //If nthreads > 1, the subqueries are evaluated by several workers
+        //(see QSQR::evaluateParallel)
         VLIBEXP TupleIterator *getTopDownIterator(Literal &query,
                 std::vector<uint8_t> * posJoins,
                 std::vector<Term_t> *possibleValuesJoins,
                 EDBLayer &layer, Program &program,
                 bool returnOnlyVars,
-                std::vector<uint8_t> *sortByFields);
+                std::vector<uint8_t> *sortByFields,
+                int nthreads = 1);
 
+        //If snapshot is not empty, the materialization is loaded from the
+        //snapshot in that directory instead of being computed
         VLIBEXP TupleIterator *getMaterializationIterator(Literal &query,
                 std::vector<uint8_t> * posJoins,
                 std::vector<Term_t> *possibleValuesJoins,
                 EDBLayer &layer, Program &program,
                 bool returnOnlyVars,
-                std::vector<uint8_t> *sortByFields);
+                std::vector<uint8_t> *sortByFields,
+                std::string snapshot = "");
 
         VLIBEXP TupleIterator *getIteratorWithMaterialization(SemiNaiver *sn,
                 Literal &query,
@@ -196,6 +196,18 @@ class InterTableJoinProcessor: public ResultJoinProcessor {
         std::shared_ptr<SegmentInserter> *segments;
         std::shared_ptr<const FCInternalTable> table;
         bool nonEmptyZeroRowsize;
+        Arena *arena;
+        SegmentSpiller *spiller;
+
+        std::shared_ptr<SegmentInserter> newSegmentInserter() const {
+            if (arena != NULL) {
+                return std::shared_ptr<SegmentInserter>(
+                        new SegmentInserter(rowsize, arena));
+            } else {
+                return std::shared_ptr<SegmentInserter>(
+                        new SegmentInserter(rowsize));
+            }
+        }
 
         void enlargeArray(const uint32_t blockid) {
             if (blockid >= currentSegmentSize) {
@@ -205,8 +217,7 @@ class InterTableJoinProcessor: public ResultJoinProcessor {
                     newsegments[i] = segments[i];
                 }
                 for (int i = currentSegmentSize; i < blockid + 1; ++i)
-                    newsegments[i] = std::shared_ptr<SegmentInserter>
-                        (new SegmentInserter(rowsize));
+                    newsegments[i] = newSegmentInserter();
                 currentSegmentSize = blockid + 1;
                 delete[] segments;
                 segments = newsegments;
@@ -240,10 +251,18 @@ class InterTableJoinProcessor: public ResultJoinProcessor {
         }
 #endif
 
+        //If arena is not NULL, the intermediate results are allocated in
+        //it and must not be used after it is reset
         InterTableJoinProcessor(const uint8_t rowsize,
                 std::vector<std::pair<uint8_t, uint8_t>> &posFromFirst,
                 std::vector<std::pair<uint8_t, uint8_t>> &posFromSecond,
-                const int nthreads);
+                const int nthreads, Arena *arena = NULL);
+
+        //If set, the intermediate results count towards the memory budget
+        //and are spilled like the derived tables
+        void setSpiller(SegmentSpiller *spiller) {
+            this->spiller = spiller;
+        }
 
         void processResults(std::vector<int> &blockid, Term_t *p, std::vector<bool> &unique, std::mutex *m);
 
@@ -289,4 +308,82 @@ class InterTableJoinProcessor: public ResultJoinProcessor {
         ~InterTableJoinProcessor();
 };
 
+//Collects the output of a join in thread-local buffers. The buffered
+//derivations are passed to the wrapped processor with flush(), so that
+//several threads can join concurrently and share the same output.
+class BufferedJoinProcessor: public ResultJoinProcessor {
+    private:
+        ResultJoinProcessor *output;
+
+        std::vector<Term_t> rows;
+        std::vector<int> rowsBlockId;
+        std::vector<bool> rowsUnique;
+
+        struct ColumnsBlock {
+            int blockid;
+            std::vector<std::shared_ptr<Column>> columns;
+            bool unique;
+            bool sorted;
+        };
+        std::vector<ColumnsBlock> columnsBlocks;
+
+    protected:
+        void processResults(const int blockid, const bool unique, std::mutex *m);
+
+    public:
+        //The constants already set in the raw row of output are copied
+        BufferedJoinProcessor(ResultJoinProcessor *output);
+
+        void processResults(std::vector<int> &blockid, Term_t *p,
+                std::vector<bool> &unique, std::mutex *m);
+
+        void processResults(const int blockid, const Term_t *first,
+                FCInternalTableItr* second, const bool unique);
+
+        void processResults(const int blockid, FCInternalTableItr *first,
+                FCInternalTableItr* second, const bool unique);
+
+        void processResults(const int blockid,
+                const std::vector<const std::vector<Term_t> *> &vectors1, size_t i1,
+                const std::vector<const std::vector<Term_t> *> &vectors2, size_t i2,
+                const bool unique);
+
+        void processResultsAtPos(const int blockid, const uint8_t pos,
+                const Term_t v, const bool unique) {
+            //Not supported
+            throw 10;
+        }
+
+        void addColumns(const int blockid,
+                std::vector<std::shared_ptr<Column>> &columns,
+                const bool unique, const bool sorted);
+
+        void addColumn(const int blockid, const uint8_t pos,
+                std::shared_ptr<Column> column, const bool unique,
+                const bool sorted) {
+            //Not supported
+            throw 10;
+        }
+
+        void addColumns(const int blockid, FCInternalTableItr *itr,
+                const bool unique, const bool sorted,
+                const bool lastInsert) {
+            //Not supported
+            throw 10;
+        }
+
+        bool isBlockEmpty(const int blockId, const bool unique) const;
+
+        bool isEmpty() const;
+
+        size_t getNBufferedRows() const {
+            return rowsBlockId.size();
+        }
+
+        //Passes all the buffered derivations to the wrapped processor. They
+        //are passed as not unique: they were only checked against the tables
+        //and not against the other buffers, so they may contain duplicates
+        void flush();
+};
+
 #endif
@@ -27,6 +27,10 @@ struct RuleExecutionPlan {
     //for the computation of the RMFA
     std::vector<std::vector<std::pair<uint8_t, uint8_t>>> vars2pos;
 
+    //Variables of the columns of the intermediate result after each atom
+    //(empty for the last atom, whose results go to the head)
+    std::vector<std::vector<Var_t>> outputVariables;
+
     //This variable tells whether the last literal shares some values with the
     //head. This allows us to group the input to avoid duplicates.
     bool lastLiteralSharesWithHead;
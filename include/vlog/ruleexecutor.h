@@ -6,6 +6,7 @@
 #include <vlog/qsqr.h>
 
 class BindingsTable;
+class BindingsView;
 class QSQR;
 class DictMgmt;
 class TupleTable;
@@ -82,6 +83,10 @@ private:
 
     void join(TupleTable *r1, TupleTable *r2, std::pair<uint8_t, uint8_t> *joins, uint8_t njoins, BindingsTable *output);
 
+    void join(TupleTable *r1, const BindingsView &r2, std::pair<uint8_t, uint8_t> *joins, uint8_t njoins, BindingsTable *output);
+
+    void join(const BindingsView &r1, const BindingsView &r2, std::pair<uint8_t, uint8_t> *joins, uint8_t njoins, BindingsTable *output);
+
     void copyLastRelInAnswers(QSQR *qsqr,
                               size_t nTuples,
                               BindingsTable **supplRelations,
@@ -101,14 +106,20 @@ public:
     size_t estimate(const int depth, BindingsTable *input/*, size_t offsetInput*/, QSQR *qsqr,
                       EDBLayer &edbLayer);
 
-    void evaluate(BindingsTable *input, size_t offsetInput, QSQR *qsqr,
-                  EDBLayer &edbLayer
+    //Evaluates the rule on the tuples of input in [offsetInput, endInput)
+    void evaluate(BindingsTable *input, size_t offsetInput, size_t endInput,
+                  QSQR *qsqr, EDBLayer &edbLayer
 #ifdef LINEAGE
                   , std::vector<LineageInfo> &lineage
 #endif
 
                  );
 
+    void evaluate(BindingsTable *input, size_t offsetInput, QSQR *qsqr,
+                  EDBLayer &edbLayer) {
+        evaluate(input, offsetInput, input->getNTuples(), qsqr, edbLayer);
+    }
+
 #ifndef RECURSIVE_QSQR
     void processTask(QSQR_Task *task);
 #endif
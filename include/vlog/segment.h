@@ -96,6 +96,27 @@ class SegmentIterator {
             return values[pos];
         }
 
+        //Moves over at most n rows and copies their value at pos in buffer.
+        //Returns the number of rows. get() is not updated by it.
+        virtual size_t nextBatch(const uint8_t pos, Term_t *buffer,
+                const size_t n) {
+            if (readers == NULL) {
+                size_t i = 0;
+                while (i < n && hasNext()) {
+                    next();
+                    buffer[i++] = get(pos);
+                }
+                return i;
+            }
+            const size_t read = readers[pos]->nextBatch(buffer, n);
+            for (int i = 0; i < nfields; i++) {
+                if (i != pos) {
+                    readers[i]->skip(read);
+                }
+            }
+            return read;
+        }
+
         virtual ~SegmentIterator() {
             delete[] readers;
         }
@@ -127,6 +148,17 @@ class VectorSegmentIterator final : public SegmentIterator {
             }
         }
 
+        size_t nextBatch(const uint8_t pos, Term_t *buffer, const size_t n) {
+            const size_t read = std::min(n,
+                    (size_t) (endIndex - 1 - currentIndex));
+            if (read > 0) {
+                memcpy(buffer, &(*vectors[pos])[currentIndex + 1],
+                        sizeof(Term_t) * read);
+                currentIndex += read;
+            }
+            return read;
+        }
+
         void clear() {
             if (allocatedVectors != NULL) {
                 for (int i = 0; i < allocatedVectors->size(); i++) {
@@ -423,6 +455,15 @@ class SegmentInserter {
                 }
             }
         }
+
+        //The columns are written in arena (see ColumnWriter(Arena*))
+        SegmentInserter(const uint8_t nfields, Arena *arena) : nfields(nfields),
+        segmentSorted(true), duplicates(true) {
+            copyColumns.resize(nfields);
+            for (int i = 0; i < nfields; i++) {
+                columns.push_back(ColumnWriter(arena));
+            }
+        }
 #if DEBUG
         void checkSizes() const;
 #endif
@@ -7,12 +7,18 @@
 #include <vlog/ruleexecplan.h>
 #include <vlog/ruleexecdetails.h>
 #include <vlog/chasemgmt.h>
+#include <vlog/spill.h>
+#include <vlog/profiler.h>
+#include <vlog/joinorder.h>
+#include <vlog/bloomfilter.h>
 #include <vlog/consts.h>
 
 #include <trident/model/table.h>
 
 #include <vector>
 #include <unordered_map>
+#include <map>
+#include <atomic>
 
 struct StatIteration {
     size_t iteration;
@@ -41,6 +47,16 @@ struct StatsSizeIDB {
 };
 
 typedef std::unordered_map<std::string, FCTable*> EDBCache;
+
+//Physical operator used for the generic joins of the rule bodies
+typedef enum JoinAlgorithm { MERGE_JOIN, HASH_JOIN, RADIX_JOIN } JoinAlgorithm;
+typedef enum JoinOrder { HEURISTIC_ORDER, COST_ORDER } JoinOrder;
+
+//An atom filters an intermediate result with its values (see
+//SemiNaiver::applySidewaysFilters) only if the result has at least
+//SIP_MIN_RATIO times its rows, and if it has at most SIP_MAX_ROWS rows
+#define SIP_MIN_RATIO 4
+#define SIP_MAX_ROWS 10000000
 class ResultJoinProcessor;
 class SemiNaiver {
     protected: //changed from private
@@ -54,6 +70,13 @@ class SemiNaiver {
         PredId_t predIgnoreBlock; //RMSA
         bool ignoreExistentialRules;
         std::shared_ptr<ChaseMgmt> chaseMgmt;
+        JoinAlgorithm joinAlgorithm;
+        //Set once it was logged that joinAlgorithm could not be applied
+        std::atomic<bool> joinAlgorithmWarned;
+        JoinOrder joinOrder;
+        JoinOrderOptimizer joinOrderOptimizer;
+        bool multiwayJoin;
+        bool sidewaysFilters;
 
         std::chrono::system_clock::time_point startTime;
         bool running;
@@ -85,7 +108,8 @@ class SemiNaiver {
         bool checkIfAtomsAreEmpty(const RuleExecutionDetails &ruleDetails,
                 const RuleExecutionPlan &plan,
                 size_t limitView,
-                std::vector<size_t> &cards);
+                std::vector<size_t> &cards,
+                std::vector<std::pair<size_t, size_t>> *ranges = NULL);
 
         void processRuleFirstAtom(const int nBodyLiterals,
                 const Literal *bodyLiteral,
@@ -105,9 +129,44 @@ class SemiNaiver {
                 const std::vector<Literal> &headLiteral,
                 bool copyAllVars);
 
+        //Orders the atoms with JoinOrderOptimizer. Returns false if it
+        //could not find an order without cartesian products
+        bool reorderPlanByCost(RuleExecutionPlan &plan,
+                const std::vector<size_t> &cards,
+                const std::vector<std::pair<size_t, size_t>> &ranges,
+                const std::vector<Literal> &headLiteral,
+                bool copyAllVars);
+
         void reorderPlanForNegatedLiterals(RuleExecutionPlan &plan,
                 const std::vector<Literal> &heads);
 
+        //Drops the rows of the intermediate result after the atom at
+        //position pos that cannot join with a selective atom further in the
+        //plan. The Bloom filters are built when they are first needed, and
+        //kept in filters for the following atoms of the same combination
+        std::shared_ptr<const FCInternalTable> applySidewaysFilters(
+                const RuleExecutionPlan &plan,
+                const int pos,
+                const RuleExecutionDetails &ruleDetails,
+                std::shared_ptr<const FCInternalTable> results,
+                std::map<std::pair<int, Var_t>,
+                    std::unique_ptr<BloomFilter>> &filters);
+
+        //True if the body of the plan should be joined with
+        //executeMultiwayJoin rather than with a sequence of binary joins
+        bool useMultiwayJoin(const RuleExecutionDetails &ruleDetails,
+                const RuleExecutionPlan &plan);
+
+        //Joins all the atoms of the body at once, with a leapfrog triejoin,
+        //and sends the bindings to the head(s)
+        void executeMultiwayJoin(const RuleExecutionPlan &plan,
+                std::vector<Literal> &heads,
+                int &processedTables,
+                const size_t iteration,
+                RuleExecutionDetails &ruleDetails,
+                const int orderExecution,
+                std::vector<ResultJoinProcessor*> *finalResultContainer);
+
         void executeRules(
                 std::vector<RuleExecutionDetails> &EDBRules,
                 std::vector<RuleExecutionDetails> &ExtEDBRules,
@@ -130,6 +189,10 @@ class SemiNaiver {
 
     protected:
         std::vector<FCTable *>predicatesTables;
+        std::shared_ptr<SegmentSpiller> spiller;
+        //Budget and counters of the caches of the filtered tables
+        std::shared_ptr<FCCacheManager> cacheManager;
+        std::shared_ptr<RuleProfiler> profiler;
         EDBLayer &layer;
         Program *program;
         std::vector<std::vector<RuleExecutionDetails>> allIDBRules; // one entry for each stratification class
@@ -146,12 +209,27 @@ class SemiNaiver {
 
         virtual FCIterator getTableFromEDBLayer(const Literal & literal);
 
+        //Creates the table of a predicate, without storing it in
+        //predicatesTables
+        FCTable *newTable(const int card);
+
+        //Creates the table of an EDB predicate and fills it with the most
+        //generic literal of the EDB layer. The table is not stored in
+        //predicatesTables, so it can be filled before other threads see it
+        FCTable *newEDBTable(const Literal &literal);
+
+        //Reads the EDB table, filtered if literal repeats a variable
+        FCIterator readEDBTable(FCTable *table, const Literal &literal);
+
         virtual size_t getNLastDerivationsFromList();
 
         virtual void saveDerivationIntoDerivationList(FCTable *endTable);
 
         virtual void saveStatistics(StatsRule &stats);
 
+        //Adds a block of new derivations to listDerivations
+        virtual void registerDerivation(const FCBlock &block);
+
         virtual bool executeUntilSaturation(
                 std::vector<RuleExecutionDetails> &ruleset,
                 std::vector<StatIteration> &costRules,
@@ -205,8 +283,78 @@ class SemiNaiver {
             return chaseMgmt;
         }
 
+        void setJoinAlgorithm(JoinAlgorithm algo) {
+            joinAlgorithm = algo;
+        }
+
+        JoinAlgorithm getJoinAlgorithm() const {
+            return joinAlgorithm;
+        }
+
+        //Returns true only the first time it is called, so that the
+        //fallback from the selected join algorithm is logged once
+        bool shouldWarnJoinAlgorithm() {
+            return !joinAlgorithmWarned.exchange(true);
+        }
+
+        void setJoinOrder(JoinOrder order) {
+            joinOrder = order;
+        }
+
+        JoinOrder getJoinOrder() const {
+            return joinOrder;
+        }
+
+        //Cyclic bodies (e.g., triangles) are joined with a leapfrog triejoin.
+        //On by default; the acyclic bodies always use the binary joins
+        void setMultiwayJoin(bool flag) {
+            multiwayJoin = flag;
+        }
+
+        bool getMultiwayJoin() const {
+            return multiwayJoin;
+        }
+
+        //Prune the intermediate results with Bloom filters on the values of
+        //the selective atoms that are joined later
+        void setSidewaysFilters(bool flag) {
+            sidewaysFilters = flag;
+        }
+
+        bool getSidewaysFilters() const {
+            return sidewaysFilters;
+        }
+
+        //Every execution of a rule is recorded in profiler (NULL disables
+        //the profiling)
+        void setProfiler(std::shared_ptr<RuleProfiler> profiler) {
+            this->profiler = profiler;
+        }
+
+        std::shared_ptr<RuleProfiler> getProfiler() {
+            return profiler;
+        }
+
         virtual FCTable *getTable(const PredId_t pred, const int card);
 
+        //Derived segments that exceed the budget (in bytes) are moved to
+        //memory-mapped files in spillDir
+        VLIBEXP void setMemoryBudget(uint64_t bytes, std::string spillDir);
+
+        //Sets the memory budget of the caches of the filtered versions of
+        //all the tables
+        VLIBEXP void setFilterCacheBudget(uint64_t bytes);
+
+        //Replaces the table of pred with table (the old one is deleted).
+        //If table is NULL, it will be created again when needed. Used to
+        //install the relations updated by IncrementalMaterializer.
+        VLIBEXP void replaceTable(const PredId_t pred, FCTable *table);
+
+        //Reserves an iteration number for blocks added from outside
+        size_t nextIteration() {
+            return iteration++;
+        }
+
         VLIBEXP virtual void run(size_t lastIteration,
                 size_t iteration,
                 unsigned long *timeout = NULL,
@@ -220,6 +368,18 @@ class SemiNaiver {
         VLIBEXP void storeOnFiles(std::string path, const bool decompress,
                 const int minLevel, const bool csv);
 
+        //Stores the IDB tables in a binary snapshot in the directory path.
+        //The snapshot can be loaded by a SemiNaiver with the same rules
+        //and EDB, instead of running the materialization again. Programs
+        //with existential rules are not supported, since the state of the
+        //chase is not stored
+        VLIBEXP void storeSnapshot(std::string path);
+
+        //Replaces the IDB tables with the ones in the snapshot. The columns
+        //are memory-mapped, so loading takes time proportional to the
+        //number of blocks, not to the number of rows
+        VLIBEXP void loadSnapshot(std::string path);
+
         FCIterator getTable(const Literal &literal, const size_t minIteration,
                 const size_t maxIteration) {
             return getTable(literal, minIteration, maxIteration, NULL);
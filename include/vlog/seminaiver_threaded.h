@@ -4,7 +4,9 @@
 #include <vlog/seminaiver.h>
 
 #include <mutex>
+#include <condition_variable>
 #include <thread>
+#include <list>
 
 struct SemiNaiver_Threadlocal {
     std::vector<FCBlock> listDerivations;
@@ -12,37 +14,76 @@ struct SemiNaiver_Threadlocal {
     size_t iteration;
 };
 
+//Hands out the rules of a round to the threads. The predicates of a rule are
+//reserved like a readers-writer lock: the heads exclusively, the body
+//predicates (EDB ones included) shared with the other rules that read them,
+//since the tables are not safe for concurrent reads and writes. Instead of
+//blocking on the predicates of the next rule, a thread takes the first rule
+//whose predicates can all be reserved, in an order where the rules that derive a
+//predicate come before the rules that use it. In this way, the rules that
+//use a predicate often see the derivations of the same round.
 class StatusRuleExecution_ThreadSafe {
     private:
         //Internal data structures
 
         //Hold all rules to execution
         std::mutex mutexRules;
-        int rulecount;
-        const int nrules;
+        std::condition_variable ruleReleased;
+        //Rules still to execute, in order of priority
+        std::list<int> pending;
+        //Head predicates of every rule, sorted
+        std::vector<std::vector<PredId_t>> writes;
+        //Body predicates of every rule that are not in its head, sorted
+        std::vector<std::vector<PredId_t>> reads;
+        //Number of running rules that read a predicate
+        std::vector<int> readers;
+        //Whether a running rule writes a predicate
+        std::vector<bool> writing;
+        int running;
+        bool stopped;
 
         std::vector<ResultJoinProcessor*> tmpderivations;
 
+        //True if no running rule writes the predicates of ruleid and no
+        //running rule reads its heads. Called under mutexRules
+        bool canReserve(const int ruleid) const;
+
     public:
 
-        StatusRuleExecution_ThreadSafe(const int nrules);
+        StatusRuleExecution_ThreadSafe(
+                const std::vector<RuleExecutionDetails> &ruleset,
+                const std::vector<int> &order,
+                const size_t npredicates);
 
+        //Waits until a rule can be executed and reserves its predicates.
+        //Returns -1 if no rule is left
         int getRuleIDToExecute();
 
+        //Frees the predicates of a rule returned by getRuleIDToExecute
+        void releaseRule(const int ruleid);
+
+        //The rules not handed out yet are not executed
+        void stop();
+
         void registerDerivations(ResultJoinProcessor *res);
 
         std::vector<ResultJoinProcessor*> &getTmpDerivations() {
             return  tmpderivations;
         }
+
+        //Orders the rules so that the ones that derive a predicate come
+        //before the ones that use it. The rules in a cycle keep their order
+        static std::vector<int> sortByDependencies(
+                const std::vector<RuleExecutionDetails> &ruleset);
 };
 
 class SemiNaiverThreaded: public SemiNaiver {
 
     private:
         //const int nthreads;
-        //TODO This variable is only visible to the thread
-        std::shared_ptr<SemiNaiver_Threadlocal> thread_data;
 
+        //Predicates that received new derivations, written under
+        //mutexInsert
         std::vector<bool> marked;
         std::vector<bool> newMarked;
 
@@ -54,9 +95,6 @@ class SemiNaiverThreaded: public SemiNaiver {
         std::mutex mutexListDer;
         const int interRuleThreads;
 
-        //Create one mutex per table
-        std::mutex *mutexes;
-
         size_t getAtomicIteration() {
             std::lock_guard<std::mutex> lock(mutexIteration);
             return iteration++;
@@ -64,12 +102,6 @@ class SemiNaiverThreaded: public SemiNaiver {
 
         bool doGlobalConsolidation(StatusRuleExecution_ThreadSafe &data);
 
-        bool tryLock(std::vector<PredId_t> &predicates, PredId_t idHeadPredicate);
-
-        void lock(std::vector<PredId_t> &predicates, PredId_t idHeadPredicate);
-
-        void unlock(std::vector<PredId_t> &predicates, PredId_t idHeadPredicate);
-
     public:
         SemiNaiverThreaded(EDBLayer &layer,
                 Program *program,
@@ -86,13 +118,8 @@ class SemiNaiverThreaded: public SemiNaiver {
                         marked.push_back(true);
                         newMarked.push_back(false);
                     }
-                    mutexes = new std::mutex[program->getNPredicates()];
                 }
 
-        ~SemiNaiverThreaded() {
-            delete[] mutexes;
-        }
-
     protected:
         size_t getNLastDerivationsFromList();
 
@@ -100,7 +127,9 @@ class SemiNaiverThreaded: public SemiNaiver {
 
         void saveStatistics(StatsRule &stats);
 
-        FCTable *getTable(const PredId_t pred, const uint8_t card);
+        void registerDerivation(const FCBlock &block);
+
+        FCTable *getTable(const PredId_t pred, const int card);
 
         FCIterator getTableFromEDBLayer(const Literal & literal);
 
@@ -108,13 +137,14 @@ class SemiNaiverThreaded: public SemiNaiver {
                 std::vector<RuleExecutionDetails> &ruleset,
                 StatusRuleExecution_ThreadSafe *status,
                 std::vector<StatIteration> *costRules,
-                size_t lastExec);
+                size_t lastExec,
+                unsigned long *timeout);
 
         bool executeUntilSaturation(
                 std::vector<RuleExecutionDetails> &ruleset,
                 std::vector<StatIteration> &costRules,
-                uint32_t limitView,
-                bool fixpoint);
+                size_t limitView,
+                bool fixpoint, unsigned long *timeout = NULL);
 };
 
 #endif
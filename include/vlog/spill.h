@@ -0,0 +1,59 @@
+#ifndef _SPILL_H
+#define _SPILL_H
+
+#include <vlog/segment.h>
+
+#include <inttypes.h>
+#include <string>
+#include <mutex>
+#include <memory>
+
+//Keeps track of the memory taken by the derived segments. Once the budget
+//is exhausted, new segments are written column by column to a file in
+//spillDir and replaced by segments of MmapColumn, so that the
+//materialization can continue with the data on disk. The segments returned
+//by seal give their bytes back to the budget when they are freed, so the
+//spiller must be owned by a shared_ptr.
+class SegmentSpiller : public std::enable_shared_from_this<SegmentSpiller> {
+    private:
+        const uint64_t budget;
+        std::string spillDir;
+
+        std::mutex mutex;
+        uint64_t inMemoryBytes;
+        uint64_t spilledBytes;
+        uint64_t nFiles;
+
+        std::shared_ptr<const Segment> spill(
+                std::shared_ptr<const Segment> seg);
+
+        //Returns a segment that shares seg and releases bytes once it is
+        //freed
+        std::shared_ptr<const Segment> track(
+                std::shared_ptr<const Segment> seg, const uint64_t bytes);
+
+        void release(const uint64_t bytes);
+
+    public:
+        //budget is in bytes. If spillDir is empty, the system temporary
+        //directory is used.
+        SegmentSpiller(const uint64_t budget, std::string spillDir);
+
+        //Returns seg if it fits in the budget, otherwise a copy of seg
+        //backed by a memory-mapped file
+        std::shared_ptr<const Segment> seal(std::shared_ptr<const Segment> seg);
+
+        //Estimate of the bytes taken by the columns of seg in main memory
+        static uint64_t getMemorySize(const Segment &seg);
+
+        uint64_t getInMemoryBytes() {
+            std::lock_guard<std::mutex> lock(mutex);
+            return inMemoryBytes;
+        }
+
+        uint64_t getSpilledBytes() const {
+            return spilledBytes;
+        }
+};
+
+#endif
@@ -5,9 +5,72 @@
 #include <vlog/segment.h>
 #include <vlog/edbiterator.h>
 
+#include <map>
+#include <list>
+#include <mutex>
+#include <atomic>
+
+//Maximum number of terms (rows times arity) of the results kept in the
+//caches of all the tables together. The least recently used results are
+//evicted first, whatever their table
+#define SQL_CACHE_MAX_TERMS (16 * 1024 * 1024)
+
+// If there are more values to filter than this, they are loaded in a
+// temporary table that is joined with the table, instead of being written
+// in the query.
+#define TEMP_TABLE_THRESHOLD (2*3*4*5*7*11)
+
+//Number of rows written by every INSERT in a temporary table
+#define TEMP_TABLE_INSERT_ROWS 1000
+
 class SQLTable : public EDBTable {
 private:
-    SegmentInserter *getInserter(const Literal &query);
+    //Results of a query, with the versions sorted by the fields requested
+    //so far
+    struct CacheEntry {
+        std::shared_ptr<const Segment> segment;
+        std::map<std::vector<uint8_t>, std::shared_ptr<const Segment>> sorted;
+        std::list<std::pair<SQLTable*, std::string>>::iterator lru;
+        size_t nterms;
+    };
+
+    //The key is the WHERE clause of the query
+    std::map<std::string, CacheEntry> cache;
+    std::atomic<uint64_t> cacheHits;
+    std::atomic<uint64_t> cacheMisses;
+
+    //Shared by the caches of all the tables, and protected by cacheMutex
+    static std::list<std::pair<SQLTable*, std::string>> lru;
+    static size_t cachedTerms;
+    static std::mutex cacheMutex;
+    std::atomic<uint64_t> tempTableCounter;
+
+    std::string getConditions(const Literal &q);
+
+    //Returns the (possibly cached) rows that match q, sorted by fields
+    std::shared_ptr<const Segment> getSegment(const Literal &q,
+            const std::vector<uint8_t> &fields);
+
+    //Returns the cached rows of q, sorted by fields, or NULL
+    std::shared_ptr<const Segment> getCachedSegment(const std::string &key,
+            const std::vector<uint8_t> &fields);
+
+    void addToCache(const std::string &key, const std::vector<uint8_t> &fields,
+            std::shared_ptr<const Segment> segment);
+
+    //Restricts the query to the rows whose fields in pos are equal to one
+    //of the tuples in values. The values are either written in the
+    //condition or, if they are more than TEMP_TABLE_THRESHOLD, loaded in
+    //a temporary table, which is added to from and returned in tmpTable.
+    //Returns false if the temporary table cannot be created or loaded
+    bool filterToSQL(const std::vector<uint8_t> &pos,
+            const std::vector<Term_t> &values, std::string &from,
+            std::string &cond, std::string &tmpTable);
+
+    //Executes the query built by filterToSQL and drops its temporary table
+    std::shared_ptr<const Segment> executeFilter(const Literal &q,
+            const std::vector<uint8_t> &pos, const std::vector<Term_t> &values);
+
 public:
     PredId_t predid;
     std::string tablename;
@@ -39,6 +102,19 @@ public:
     EDBIterator *getSortedIterator(const Literal &query,
         const std::vector<uint8_t> &fields);
 
+    using EDBTable::checkNewIn;
+
+    std::vector<std::shared_ptr<Column>> checkNewIn(
+            std::vector<std::shared_ptr<Column>> &checkValues,
+            const Literal &l2,
+            std::vector<uint8_t> &posInL2);
+
+    std::shared_ptr<Column> checkIn(
+            std::vector<Term_t> &values,
+            const Literal &l2,
+            uint8_t posInL2,
+            size_t &sizeOutput);
+
     void query(QSQQuery *query, TupleTable *outputTable,
                        std::vector<uint8_t> *posToFilter,
                        std::vector<Term_t> *valuesToFilter);
@@ -69,6 +145,21 @@ public:
     virtual void executeQuery(const std::string &q, SegmentInserter *inserter) = 0;
 
     virtual uint64_t getSizeFromDB(const std::string &q) = 0;
+
+    virtual ~SQLTable();
+
+    //Executes a statement that does not return rows. Returns false if the
+    //connection does not support it, and then no temporary tables are used
+    virtual bool executeUpdate(const std::string &q) {
+        return false;
+    }
+
+    //Statement that creates a temporary table with the columns (and the
+    //types) of the result of query
+    virtual std::string createTempTableSQL(const std::string &name,
+            const std::string &query) {
+        return "CREATE TEMPORARY TABLE " + name + " AS " + query;
+    }
 };
 
 
@@ -0,0 +1,28 @@
+# Generates the inputs in examples/test/data that are shared by several
+# tests. They are large enough to reach the size thresholds of the
+# features under test.
+import sys
+import random
+
+outputdir = sys.argv[1]
+rnd = random.Random(42)
+
+# input_runs: more than PACKED_COLUMN_MIN_SIZE rows. The first column has
+# long runs, the second one a permutation of 30 close values in every run,
+# so it does not compress with deltas but it is packed.
+out = open(outputdir + '/input_runs.csv', 'wt')
+size = 72000
+for k in range(size // 30):
+    perm = list(range(30))
+    rnd.shuffle(perm)
+    for v in perm:
+        out.write('k' + str(k) + ',v' + str(v + k % 34) + '\n')
+out.close()
+
+# input_nodes: more than ROWS_PARALLEL_THRESHOLD distinct values, so that
+# the nulls of a rule are created by several threads.
+out = open(outputdir + '/input_nodes.csv', 'wt')
+size = 20000
+for i in range(size):
+    out.write('a' + str(i) + '\n')
+out.close()
@@ -6,10 +6,14 @@
 #include <vlog/edb.h>
 #include <vlog/webinterface.h>
 #include <vlog/fcinttable.h>
+#include <vlog/segment.h>
 #include <vlog/exporter.h>
+#include <vlog/incremental.h>
 #include <vlog/utils.h>
 #include <vlog/ml/ml.h>
+#include <vlog/ml/algoselector.h>
 #include <vlog/deps/detector.h>
+#include <vlog/inmemory/binarytable.h>
 
 #include <vlog/cycles/checker.h>
 
@@ -42,6 +46,7 @@
 #include <chrono>
 #include <thread>
 #include <cmath>
+#include <random>
 
 void printHelp(const char *programName, ProgramArgs &desc) {
     cout << "Usage: " << programName << " <command> [options]" << endl << endl;
@@ -57,6 +62,11 @@ void printHelp(const char *programName, ProgramArgs &desc) {
     cout << "lookup\t\t lookup for values in the dictionary." << endl << endl;
     cout << "cycles\t\t try and detect cycles in the rules." << endl << endl;
     cout << "deps\t\t detect dependencies in the database." << endl << endl;
+    cout << "benchsort\t\t measure the sorting of a random segment with 1 up to nthreads threads." << endl << endl;
+    cout << "binarize\t\t convert the EDB tables in a binary database (type 'Binary' in edb.conf)." << endl << endl;
+    cout << "runtq\t\t run the training queries with QSQ-R and magic sets and log their runtimes." << endl << endl;
+    cout << "learnalgo\t\t train the model that chooses between QSQ-R and magic sets on the log of <runtq>." << endl << endl;
+    cout << "benchalgo\t\t compare the choices of the model with the ones of the threshold on the log of <runtq>." << endl << endl;
 
     cout << desc.tostring() << endl;
 }
@@ -79,7 +89,8 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv) {
 
     if (cmd != "help" && cmd != "query" && cmd != "lookup" && cmd != "load" && cmd != "queryLiteral"
             && cmd != "mat" && cmd != "mat_tg" && cmd != "rulesgraph" && cmd != "server" && cmd != "gentq" &&
-            cmd != "cycles" && cmd !="deps") {
+            cmd != "cycles" && cmd !="deps" && cmd != "benchsort" && cmd != "binarize" &&
+            cmd != "runtq" && cmd != "learnalgo" && cmd != "benchalgo") {
         printErrorMsg("The command \"" + cmd + "\" is unknown.");
         return false;
     }
@@ -178,6 +189,22 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv) {
                 printErrorMsg("The rule file \"" + path + "\" does not exists");
                 return false;
             }
+            for (std::string opt : { "insertions", "deletions", "loadmat" }) {
+                std::string updates = vm[opt].as<string>();
+                if (!updates.empty() && !Utils::exists(updates)) {
+                    printErrorMsg("The file \"" + updates + "\" does not exists");
+                    return false;
+                }
+            }
+            std::string profileFormat = vm["profileFormat"].as<string>();
+            if (profileFormat != "json" && profileFormat != "csv") {
+                printErrorMsg("The format of the profile should be 'json' or 'csv'");
+                return false;
+            }
+            if (vm["filterCacheBudget"].as<int64_t>() < 0) {
+                printErrorMsg("The budget of the filter cache cannot be negative");
+                return false;
+            }
         } else if (cmd == "mat_tg") {
             std::string path = vm["trigger_paths"].as<string>();
             if (path.empty()) {
@@ -197,6 +224,58 @@ bool checkParams(ProgramArgs &vm, int argc, const char** argv) {
                 printErrorMsg("The rule file '" + path + "' does not exists");
                 return false;
             }
+        } else if (cmd == "benchsort") {
+            if (vm["benchRows"].as<int64_t>() < 1) {
+                printErrorMsg("The number of rows must be at least 1");
+                return false;
+            }
+            if (vm["benchColumns"].as<int>() < 1 || vm["benchColumns"].as<int>() > 255) {
+                printErrorMsg("The number of columns should be between 1 and 255");
+                return false;
+            }
+        } else if (cmd == "binarize") {
+            if (!vm.count("output")) {
+                printErrorMsg("The parameter -o (path to the binary database) is not set.");
+                return false;
+            }
+            std::string dir = vm["output"].as<string>();
+            if (Utils::exists(dir)) {
+                printErrorMsg("The path \"" + dir + "\" already exist. Please remove it or choose another path.");
+                return false;
+            }
+        } else if (cmd == "runtq") {
+            std::string path = vm["rules"].as<string>();
+            if (path.empty() || !Utils::exists(path)) {
+                printErrorMsg("The rule file \"" + path + "\" does not exists");
+                return false;
+            }
+            std::string queries = vm["query"].as<string>();
+            if (queries.empty() || !Utils::exists(queries)) {
+                printErrorMsg("The file with the training queries \"" + queries + "\" does not exists");
+                return false;
+            }
+            if (vm["trainingLog"].as<string>().empty()) {
+                printErrorMsg("You must set up the \"trainingLog\" parameter to store the runtimes");
+                return false;
+            }
+        } else if (cmd == "learnalgo" || cmd == "benchalgo") {
+            std::string path = vm["trainingLog"].as<string>();
+            if (path.empty() || !Utils::exists(path)) {
+                printErrorMsg("The training log \"" + path + "\" does not exists");
+                return false;
+            }
+            if (cmd == "learnalgo" && vm["algoModel"].as<string>().empty()) {
+                printErrorMsg("You must set up the \"algoModel\" parameter to store the model");
+                return false;
+            }
+            if (vm["modelDepth"].as<int>() < 0 || vm["modelMinLeaf"].as<int>() < 1) {
+                printErrorMsg("The depth of the model should be at least 0 and the size of its leaves at least 1");
+                return false;
+            }
+            if (cmd == "benchalgo" && vm["benchFolds"].as<int>() < 2) {
+                printErrorMsg("The number of folds should be at least 2");
+                return false;
+            }
         } else if (cmd == "deps") {
             std::string path = vm["rules"].as<string>();
             if (path.empty()) {
@@ -229,7 +308,9 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
             "Path to the file that contains trigger graph execution paths",
             false);
     query_options.add<string>("", "selectionStrategy", "",
-            "Determines the selection strategy (only for <queryLiteral>, when \"auto\" is specified for the reasoningAlgorithm). Possible values are \"cardEst\", ... (to be extended) .", false);
+            "Determines the selection strategy (only for <queryLiteral>, when \"auto\" is specified for the reasoningAlgorithm). Possible values are \"cardEst\" and \"learned\" (uses the model in --algoModel).", false);
+    query_options.add<string>("", "algoModel", "",
+            "Path of the model that chooses between QSQ-R and magic sets. It is written by <learnalgo> and read with the selection strategy \"learned\".", false);
     query_options.add<int64_t>("", "matThreshold", 10000000,
             "In case reasoning is activated, this parameter sets a threshold above which a full materialization is performed before we execute the query. Default is 10000000 (10M).", false);
     query_options.add<bool>("", "printResults", true,
@@ -243,7 +324,7 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     query_options.add<string>("", "premat", "",
             "Pre-materialize the atoms in the file passed as argument. Default is '' (disabled).", false);
     query_options.add<bool>("","multithreaded", false,
-            "Run multithreaded (currently only supported for <mat>).", false);
+            "Run multithreaded (currently only supported for <mat> and <qsqr>).", false);
     query_options.add<bool>("","restrictedChase", true,
             "Use the restricted chase if there are existential rules.", false);
     query_options.add<int>("", "nthreads", std::max((unsigned int)1, std::thread::hardware_concurrency() / 2),
@@ -259,8 +340,32 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
             "Repeat the query <arg> times. If the argument is not specified, then the query will not be repeated.", false);
     query_options.add<string>("","storemat_path", "",
             "Directory where to store all results of the materialization. Default is '' (disable).",false);
+    query_options.add<int64_t>("","memoryBudget", 0,
+            "Memory (in MB) that derived tables can take before they are spilled to disk (only for <mat>). Default is 0 (no limit).",false);
+    query_options.add<string>("","spillDir", "",
+            "Directory where to spill the derived tables that exceed memoryBudget. Default is '' (the system temporary directory).",false);
+    query_options.add<int64_t>("","filterCacheBudget", FCCACHE_DEFAULT_BUDGET / (1024 * 1024),
+            "Memory (in MB) that the cache of the filtered derived tables can take (only for <mat>). Default is 1024.",false);
+    query_options.add<string>("","joinAlgorithm", "merge",
+            "Algorithm used for the generic joins during the materialization: 'merge', 'hash' (only where the hash join applies, the other joins use 'merge') or 'radix' (partitioned hash join). Default is 'merge'.",false);
+    query_options.add<string>("","joinOrder", "heuristic",
+            "How the atoms of the rule bodies are ordered during the materialization: 'heuristic' (cardinality of the atoms) or 'cost' (estimated size of the intermediate results). Default is 'heuristic'.",false);
+    query_options.add<bool>("","multiwayJoin", true,
+            "Join the cyclic rule bodies (e.g., triangles) with a leapfrog triejoin instead of a sequence of binary joins. The acyclic bodies always use the binary joins. Default is true.",false);
+    query_options.add<bool>("","sidewaysFilters", false,
+            "Remove from the intermediate results of the rule bodies the rows that cannot join with the selective atoms joined later, using Bloom filters on their values. Default is false.",false);
+    query_options.add<string>("","insertions", "",
+            "CSV file with the facts to add to the EDB after the materialization (only for <mat>). Every line is a fact and the first field is the predicate. The materialization is updated incrementally. Default is '' (disable).",false);
+    query_options.add<string>("","deletions", "",
+            "CSV file with the facts to remove from the EDB after the materialization (only for <mat>). Same format as 'insertions'. Default is '' (disable).",false);
     query_options.add<string>("","storemat_format", "files",
-            "Format in which to dump the materialization. 'files' simply dumps the IDBs in files. 'csv' creates comma-separated files. 'db' creates a new RDF database. Default is 'files'.",false);
+            "Format in which to dump the materialization. 'files' simply dumps the IDBs in files. 'csv' creates comma-separated files. 'db' creates a new RDF database. 'snapshot' creates a binary snapshot that can be reloaded with 'loadmat'. Default is 'files'.",false);
+    query_options.add<string>("","loadmat", "",
+            "Directory of a snapshot created with '--storemat_format snapshot'. The materialization is loaded from it instead of being computed (only for <mat>, <queryLiteral> with the algorithm 'mat' or 'auto', and <server>). Default is '' (disable).",false);
+    query_options.add<string>("","profile", "",
+            "File where to write a profile of every rule execution of the materialization (only for <mat>). Default is '' (disable).",false);
+    query_options.add<string>("","profileFormat", "json",
+            "Format of the profile: 'json' or 'csv'. Default is 'json'.",false);
     query_options.add<bool>("","explain", false,
             "Explain the query instead of executing it. Default is false.",false);
     query_options.add<bool>("","decompressmat", false,
@@ -284,7 +389,7 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     load_options.add<string>("i","input", "",
             "Path to the files that contain the compressed triples. This parameter is REQUIRED if already compressed triples/dict are not provided.", false);
     load_options.add<string>("o","output", "",
-            "Path to the KB that should be created. This parameter is REQUIRED.", false);
+            "Path to the KB (or, for <binarize>, the binary database) that should be created. This parameter is REQUIRED.", false);
     load_options.add<int>("","maxThreads",
             Utils::getNumberPhysicalCores(),
             "Sets the maximum number of threads to use during the compression. Default is the number of physical cores",false);
@@ -313,6 +418,17 @@ bool initParams(int argc, const char** argv, ProgramArgs &vm) {
     ProgramArgs::GroupArgs& detectCycles_options = *vm.newGroup("Options for command <detectCycles>");
     detectCycles_options.add<string>("", "alg", "MFA", "Algorithm to use for cycle detection", false);
 
+    ProgramArgs::GroupArgs& benchSort_options = *vm.newGroup("Options for command <benchsort>");
+    benchSort_options.add<int64_t>("", "benchRows", 10000000, "Number of rows of the random segment", false);
+    benchSort_options.add<int>("", "benchColumns", 3, "Number of columns of the random segment", false);
+
+    ProgramArgs::GroupArgs& algoSelector_options = *vm.newGroup("Options for commands <runtq>, <learnalgo> and <benchalgo>");
+    algoSelector_options.add<string>("", "trainingLog", "",
+            "Path of the log with the runtimes of the training queries. It is written by <runtq> (which reads the queries generated by <gentq> from --query) and read by <learnalgo> and <benchalgo>", false);
+    algoSelector_options.add<int>("", "modelDepth", ALGOSEL_MAX_DEPTH, "Maximum depth of the decision tree", false);
+    algoSelector_options.add<int>("", "modelMinLeaf", ALGOSEL_MIN_LEAF, "Minimum number of training queries in a leaf of the decision tree", false);
+    algoSelector_options.add<int>("", "benchFolds", ALGOSEL_FOLDS, "Number of folds of the cross-validation of <benchalgo>", false);
+
     ProgramArgs::GroupArgs& cmdline_options = *vm.newGroup("Parameters");
     cmdline_options.add<string>("l","logLevel", "info",
             "Set the log level (accepted values: trace, debug, info, warning, error, fatal). Default is info.", false);
@@ -602,6 +718,35 @@ void launchFullMat(int argc,
                 vm["shufflerules"].as<bool>(),
                 NULL,
                 vm["ordered"].as<bool>());
+        std::string joinAlgorithm = vm["joinAlgorithm"].as<string>();
+        if (joinAlgorithm == "hash") {
+            sn->setJoinAlgorithm(HASH_JOIN);
+        } else if (joinAlgorithm == "radix") {
+            sn->setJoinAlgorithm(RADIX_JOIN);
+        } else if (joinAlgorithm != "merge") {
+            LOG(ERRORL) << "Unknown join algorithm " << joinAlgorithm;
+            return;
+        }
+        std::string joinOrder = vm["joinOrder"].as<string>();
+        if (joinOrder == "cost") {
+            sn->setJoinOrder(COST_ORDER);
+        } else if (joinOrder != "heuristic") {
+            LOG(ERRORL) << "Unknown join order " << joinOrder;
+            return;
+        }
+        if (p.areExistentialRules() && (!vm["loadmat"].as<string>().empty() ||
+                    (!vm["storemat_path"].as<string>().empty() &&
+                     vm["storemat_format"].as<string>() == "snapshot"))) {
+            LOG(ERRORL) << "Snapshots are not supported with existential rules";
+            return;
+        }
+        sn->setMultiwayJoin(vm["multiwayJoin"].as<bool>());
+        sn->setSidewaysFilters(vm["sidewaysFilters"].as<bool>());
+        if (vm["memoryBudget"].as<int64_t>() > 0) {
+            sn->setMemoryBudget(vm["memoryBudget"].as<int64_t>() * 1024 * 1024,
+                    vm["spillDir"].as<string>());
+        }
+        sn->setFilterCacheBudget(vm["filterCacheBudget"].as<int64_t>() * 1024 * 1024);
 
 #ifdef WEBINTERFACE
         //Start the web interface if requested
@@ -629,11 +774,31 @@ void launchFullMat(int argc,
         }
 #endif
 
-        LOG(INFOL) << "Starting full materialization";
         std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-        sn->run();
-        std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
-        LOG(INFOL) << "Runtime materialization = " << sec.count() * 1000 << " milliseconds";
+        if (!vm["loadmat"].as<string>().empty()) {
+            LOG(INFOL) << "Loading the materialization from a snapshot";
+            sn->loadSnapshot(vm["loadmat"].as<string>());
+            std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+            LOG(INFOL) << "Runtime loading snapshot = " << sec.count() * 1000 << " milliseconds";
+        } else {
+            LOG(INFOL) << "Starting full materialization";
+            if (!vm["profile"].as<string>().empty()) {
+                sn->setProfiler(std::shared_ptr<RuleProfiler>(new RuleProfiler()));
+            }
+            sn->run();
+            std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+            LOG(INFOL) << "Runtime materialization = " << sec.count() * 1000 << " milliseconds";
+            if (sn->getProfiler()) {
+                std::shared_ptr<RuleProfiler> profiler = sn->getProfiler();
+                profiler->printSummary(&p, db, 10);
+                if (vm["profileFormat"].as<string>() == "csv") {
+                    profiler->exportCSV(vm["profile"].as<string>(), &p, db);
+                } else {
+                    profiler->exportJSON(vm["profile"].as<string>(), &p, db);
+                }
+                LOG(INFOL) << "Profile written to " << vm["profile"].as<string>();
+            }
+        }
         sn->printCountAllIDBs("");
 
 #if defined(__linux__) || defined(__linux) || defined(linux) || defined(__gnu_linux__)
@@ -644,6 +809,23 @@ void launchFullMat(int argc,
         }
 #endif
 
+        if (!vm["insertions"].as<string>().empty() ||
+                !vm["deletions"].as<string>().empty()) {
+            IncrementalMaterializer incr(*sn, db, p);
+            if (!incr.isSupported()) {
+                LOG(ERRORL) << "The program contains existential rules or negation: the materialization cannot be updated incrementally";
+            } else {
+                if (!vm["deletions"].as<string>().empty()) {
+                    incr.readFacts(vm["deletions"].as<string>(), true);
+                }
+                if (!vm["insertions"].as<string>().empty()) {
+                    incr.readFacts(vm["insertions"].as<string>(), false);
+                }
+                incr.update();
+                sn->printCountAllIDBs("After update: ");
+            }
+        }
+
         if (vm["printRepresentationSize"].as<bool>()) {
             printRepresentationSize(sn);
         }
@@ -664,6 +846,8 @@ void launchFullMat(int argc,
                 exp.generateTridentDiffIndex(vm["storemat_path"].as<string>());
             } else if (storemat_format == "nt") {
                 exp.generateNTTriples(vm["storemat_path"].as<string>(), vm["decompressmat"].as<bool>());
+            } else if (storemat_format == "snapshot") {
+                sn->storeSnapshot(vm["storemat_path"].as<string>());
             } else {
                 LOG(ERRORL) << "Option 'storemat_format' not recognized";
                 throw 10;
@@ -769,6 +953,12 @@ std::string selectStrategy(EDBLayer &edb, Program &p, Literal &literal, Reasoner
         // Use the original cardinality estimation strategy
         ReasoningMode mode = reasoner.chooseMostEfficientAlgo(literal, edb, p, NULL, NULL);
         return mode == TOPDOWN ? "qsqr" : "magic";
+    } else if (strategy == "learned") {
+        std::shared_ptr<AlgoSelector> selector(new AlgoSelector());
+        selector->load(vm["algoModel"].as<string>());
+        reasoner.setAlgoSelector(selector);
+        ReasoningMode mode = reasoner.chooseMostEfficientAlgo(literal, edb, p, NULL, NULL);
+        return mode == TOPDOWN ? "qsqr" : "magic";
     }
     // Add strategies here ...
     LOG(ERRORL) << "Unrecognized selection strategy: " << strategy;
@@ -793,6 +983,12 @@ void runLiteralQuery(EDBLayer &edb, Program &p, Literal &literal, Reasoner &reas
         }
     }
 
+    //With a snapshot the materialization is already available
+    const std::string snapshot = vm["loadmat"].as<string>();
+    if ((algo == "auto" || algo.empty()) && !snapshot.empty()) {
+        algo = "mat";
+    }
+
     if (algo == "auto" || algo.empty()) {
         algo = selectStrategy(edb, p, literal, reasoner, vm);
         LOG(INFOL) << "Selection strategy determined that we go for " << algo;
@@ -805,9 +1001,15 @@ void runLiteralQuery(EDBLayer &edb, Program &p, Literal &literal, Reasoner &reas
     } else if (algo == "magic") {
         iter = reasoner.getMagicIterator(literal, NULL, NULL, edb, p, onlyVars, NULL);
     } else if (algo == "qsqr") {
-        iter = reasoner.getTopDownIterator(literal, NULL, NULL, edb, p, onlyVars, NULL);
+        int nthreads = 1;
+        if (vm["multithreaded"].as<bool>()) {
+            nthreads = std::max(1, vm["nthreads"].as<int>());
+        }
+        iter = reasoner.getTopDownIterator(literal, NULL, NULL, edb, p, onlyVars, NULL,
+                nthreads);
     } else if (algo == "mat") {
-        iter = reasoner.getMaterializationIterator(literal, NULL, NULL, edb, p, onlyVars, NULL);
+        iter = reasoner.getMaterializationIterator(literal, NULL, NULL, edb, p, onlyVars, NULL,
+                snapshot);
     } else {
         LOG(ERRORL) << "Unrecognized reasoning algorithm: " << algo;
         throw 10;
@@ -953,6 +1155,147 @@ void checkAcyclicity(std::string ruleFile, std::string alg, EDBLayer &db, bool r
                 sec.count() * 1000 << " milliseconds" << std::endl;
 }
 
+void benchmarkSort(ProgramArgs &vm) {
+    const size_t nrows = vm["benchRows"].as<int64_t>();
+    const uint8_t ncolumns = (uint8_t) vm["benchColumns"].as<int>();
+    const int maxThreads = std::max(1, vm["nthreads"].as<int>());
+
+    //Draw the values from a small domain so that there are duplicates to
+    //remove
+    std::mt19937_64 gen(42);
+    std::uniform_int_distribution<Term_t> dist(0, std::max((size_t) 1,
+                nrows / 4));
+    std::vector<std::shared_ptr<Column>> columns;
+    for (int i = 0; i < ncolumns; ++i) {
+        std::vector<Term_t> values(nrows);
+        for (size_t j = 0; j < nrows; ++j) {
+            values[j] = dist(gen);
+        }
+        columns.push_back(ColumnWriter::getColumn(values, false));
+    }
+    std::shared_ptr<const Segment> seg(new Segment(ncolumns, columns));
+    LOG(INFOL) << "Sorting " << nrows << " rows and " << (int) ncolumns
+        << " columns";
+
+    for (int nthreads = 1; ; nthreads *= 2) {
+        nthreads = std::min(nthreads, maxThreads);
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        std::shared_ptr<const Segment> sorted = seg->sortBy(NULL, nthreads, false);
+        std::chrono::duration<double> secSort = std::chrono::system_clock::now() - start;
+
+        start = std::chrono::system_clock::now();
+        std::shared_ptr<const Segment> unique;
+        if (nthreads > 1) {
+            unique = seg->sortBy(NULL, nthreads, true);
+        } else {
+            unique = SegmentInserter::unique(seg->sortBy(NULL));
+        }
+        std::chrono::duration<double> secUnique = std::chrono::system_clock::now() - start;
+
+        LOG(INFOL) << "Threads " << nthreads << ": sort "
+            << secSort.count() * 1000 << " ms, sort and unique "
+            << secUnique.count() * 1000 << " ms (" << unique->getNRows()
+            << " unique rows)";
+        if (nthreads == maxThreads) {
+            break;
+        }
+    }
+}
+
+//Returns the number of answers
+static uint64_t countAnswers(TupleIterator *itr) {
+    uint64_t count = 0;
+    while (itr->hasNext()) {
+        itr->next();
+        count++;
+    }
+    delete itr;
+    return count;
+}
+
+void runTrainingQueries(EDBLayer &edb, ProgramArgs &vm) {
+    Program p(&edb);
+    std::string s = p.readFromFile(vm["rules"].as<string>(),
+            vm["rewriteMultihead"].as<bool>());
+    if (!s.empty()) {
+        LOG(ERRORL) << s;
+        return;
+    }
+    p.sortRulesByIDBPredicates();
+    Reasoner reasoner(vm["reasoningThreshold"].as<int64_t>());
+
+    std::ifstream queries(vm["query"].as<string>());
+    std::ofstream log(vm["trainingLog"].as<string>());
+    AlgoSelector::writeTrainingHeader(log);
+    std::string line;
+    uint64_t nQueries = 0;
+    while (std::getline(queries, line)) {
+        //The lines written by <gentq> are "query:type"
+        size_t sep = line.rfind(':');
+        std::string query = sep == std::string::npos ? line : line.substr(0, sep);
+        if (query.empty()) {
+            continue;
+        }
+        Dictionary dictVariables;
+        Literal literal = p.parseLiteral(query, dictVariables);
+        if (literal.getPredicate().getType() != IDB) {
+            continue;
+        }
+        const bool onlyVars = literal.getNVars() > 0;
+
+        TrainingRecord record;
+        record.query = query;
+        record.estimatedCost = reasoner.estimate(literal, NULL, NULL, edb, p);
+        record.features = AlgoSelector::getFeatures(literal, p, edb,
+                record.estimatedCost);
+
+        std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+        uint64_t nQSQR = countAnswers(reasoner.getTopDownIterator(literal,
+                    NULL, NULL, edb, p, onlyVars, NULL));
+        std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+        record.timeQSQR = sec.count() * 1000;
+
+        start = std::chrono::system_clock::now();
+        uint64_t nMagic = countAnswers(reasoner.getMagicIterator(literal,
+                    NULL, NULL, edb, p, onlyVars, NULL));
+        sec = std::chrono::system_clock::now() - start;
+        record.timeMagic = sec.count() * 1000;
+
+        if (nQSQR != nMagic) {
+            LOG(WARNL) << "QSQ-R returns " << nQSQR << " answers and magic "
+                << nMagic << " for " << query;
+        }
+        LOG(DEBUGL) << query << ": QSQ-R " << record.timeQSQR << " msec, magic "
+            << record.timeMagic << " msec, estimated cost " << record.estimatedCost;
+        AlgoSelector::writeTrainingRecord(log, record);
+        nQueries++;
+    }
+    if (log.fail()) {
+        LOG(ERRORL) << "Error writing to the training log";
+    }
+    LOG(INFOL) << "Runtimes of " << nQueries << " queries written in "
+        << vm["trainingLog"].as<string>();
+}
+
+void learnAlgoSelector(ProgramArgs &vm) {
+    std::vector<TrainingRecord> records =
+        AlgoSelector::readTrainingLog(vm["trainingLog"].as<string>());
+    AlgoSelector selector;
+    selector.train(records, vm["modelDepth"].as<int>(),
+            vm["modelMinLeaf"].as<int>());
+    selector.save(vm["algoModel"].as<string>());
+    LOG(INFOL) << "Model trained on " << records.size() << " queries written in "
+        << vm["algoModel"].as<string>();
+}
+
+void benchAlgoSelector(ProgramArgs &vm) {
+    std::vector<TrainingRecord> records =
+        AlgoSelector::readTrainingLog(vm["trainingLog"].as<string>());
+    AlgoSelector::benchmark(records, vm["reasoningThreshold"].as<int64_t>(),
+            vm["benchFolds"].as<int>(), vm["modelDepth"].as<int>(),
+            vm["modelMinLeaf"].as<int>());
+}
+
 void detectDeps(std::string ruleFile, EDBLayer &db) {
     //Load the program
     Program p(&db);
@@ -993,7 +1336,8 @@ int main(int argc, const char** argv) {
         edbFile = dirExecFile + DIR_SEP + std::string("edb.conf");
     }
 
-    if (cmd != "load" && !Utils::exists(edbFile)) {
+    if (cmd != "load" && cmd != "benchsort" && cmd != "learnalgo" &&
+            cmd != "benchalgo" && !Utils::exists(edbFile)) {
         printErrorMsg("I could not find the EDB conf file " + edbFile);
         return EXIT_FAILURE;
     }
@@ -1202,6 +1546,22 @@ int main(int argc, const char** argv) {
         std::string alg = vm["alg"].as<string>();
         checkAcyclicity(rulesFile, alg, *layer, vm["rewriteMultihead"].as<bool>());
 	delete layer;
+    } else if (cmd == "benchsort") {
+        benchmarkSort(vm);
+    } else if (cmd == "binarize") {
+        EDBConf conf(edbFile);
+        EDBLayer *layer = new EDBLayer(conf, false);
+        BinaryTable::convert(*layer, vm["output"].as<string>());
+        delete layer;
+    } else if (cmd == "runtq") {
+        EDBConf conf(edbFile);
+        EDBLayer *layer = new EDBLayer(conf, false);
+        runTrainingQueries(*layer, vm);
+        delete layer;
+    } else if (cmd == "learnalgo") {
+        learnAlgoSelector(vm);
+    } else if (cmd == "benchalgo") {
+        benchAlgoSelector(vm);
     } else if (cmd == "deps") {
         EDBConf conf(edbFile);
         EDBLayer *layer = new EDBLayer(conf, false);
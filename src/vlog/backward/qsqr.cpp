@@ -4,13 +4,18 @@
 #include <vlog/ruleexecutor.h>
 #include <trident/model/table.h>
 #include <trident/iterators/arrayitr.h>
+#include <trident/utils/parallel.h>
 
 #include <cstring>
 #include <cmath>
+#include <memory>
 #include <unordered_map>
 
 BindingsTable *QSQR::getInputTable(const Predicate pred) {
     //raiseIfExpired();
+    if (shared != NULL) {
+        return shared->getInputTable(pred);
+    }
     BindingsTable **table = inputs[pred.getId()];
     if (table == NULL) {
         const uint8_t maxAdornments = (uint8_t)pow(2, pred.getCardinality());
@@ -27,6 +32,9 @@ BindingsTable *QSQR::getInputTable(const Predicate pred) {
 
 BindingsTable *QSQR::getAnswerTable(const Predicate pred, uint8_t adornment) {
     //raiseIfExpired();
+    if (shared != NULL) {
+        return shared->getAnswerTable(pred, adornment);
+    }
     BindingsTable **table = answers[pred.getId()];
     if (table == NULL) {
         const uint8_t maxAdornments = (uint8_t)pow(2, pred.getCardinality());
@@ -85,6 +93,10 @@ void QSQR::deallocateAllRules() {
 }
 
 size_t QSQR::calculateAllAnswers() {
+    if (shared != NULL) {
+        return shared->calculateAllAnswers();
+    }
+    QSQR_TablesLock lock(this);
     size_t total = 0;
     for (int i = 0; i < answers.size(); ++i) {
         if (answers[i] != NULL) {
@@ -99,6 +111,10 @@ size_t QSQR::calculateAllAnswers() {
 }
 
 void QSQR::cleanAllInputs() {
+    if (shared != NULL) {
+        shared->cleanAllInputs();
+        return;
+    }
     for (int i = 0; i < inputs.size(); ++i) {
         if (inputs[i] != NULL) {
             for (uint32_t j = 0; j < sizePreds[i]; ++j) {
@@ -111,6 +127,11 @@ void QSQR::cleanAllInputs() {
 }
 
 void QSQR::createRules(Predicate &pred) {
+    if (shared != NULL) {
+        shared->createRules(pred);
+        return;
+    }
+    QSQR_TablesLock lock(this);
     //check if the adorned rules are created. If not, then create them.
     if (rules[pred.getId()] == NULL) {
         const uint16_t maxAdornments = (uint16_t)pow(2, pred.getCardinality());
@@ -143,7 +164,7 @@ size_t QSQR::estimate(int depth, Predicate &pred, BindingsTable *inputTable/*, s
     std::vector<size_t> outputs;
     size_t output = 0;
     for (int i = 0; i < program->getNRulesByPredicate(pred.getId()); ++i) {
-        RuleExecutor *exec = rules[pred.getId()][pred.getAdorment()][i];
+        RuleExecutor *exec = getRuleExecutor(pred, i);
         size_t r = exec->estimate(depth + 1, inputTable/*, offsetInput*/, this, layer);
         if (r != 0) {
             // if (depth > 0 || r <= 10) {
@@ -183,7 +204,7 @@ void QSQR::evaluate(Predicate &pred, BindingsTable *inputTable,
         //Create rules
         createRules(pred);
         for (int i = 0; i < program->getAllRulesByPredicate(pred.getId()).size(); ++i) {
-            RuleExecutor *exec = rules[pred.getId()][pred.getAdorment()][i];
+            RuleExecutor *exec = getRuleExecutor(pred, i);
             exec->evaluate(inputTable, offsetInput, this, layer);
         }
 
@@ -196,56 +217,74 @@ void QSQR::evaluate(Predicate &pred, BindingsTable *inputTable,
     } while (repeat && shouldRepeat);
     // LOG(DEBUGL) << "QSQR: finished execution of query";
 #else
+    evaluate(pred, inputTable, offsetInput, inputTable->getNTuples(), repeat,
+            0, program->getNRulesByPredicate(pred.getId()));
+#endif
+}
+
+#ifndef RECURSIVE_QSQR
+void QSQR::evaluate(Predicate &pred, BindingsTable *inputTable,
+        size_t offsetInput, size_t endInput, bool repeat, int firstRule,
+        int lastRule) {
     createRules(pred);
-    size_t sz = program->getNRulesByPredicate(pred.getId());
-    if (sz > 0) {
+    if (firstRule < lastRule) {
         QSQR_Task task(QSQR_TaskType::QUERY, pred);
-        task.currentRuleIndex = 1;
+        task.currentRuleIndex = firstRule + 1;
+        task.firstRuleIndex = firstRule;
+        task.lastRuleIndex = lastRule;
         task.inputTable = inputTable;
         task.offsetInput = offsetInput;
+        task.endInput = endInput;
         task.repeat = repeat;
         task.totalAnswers = calculateAllAnswers();
         pushTask(task);
-        RuleExecutor *exec = rules[pred.getId()][pred.getAdorment()][0];
-        exec->evaluate(inputTable, offsetInput, this, layer);
+        RuleExecutor *exec = getRuleExecutor(pred, firstRule);
+        exec->evaluate(inputTable, offsetInput, endInput, this, layer);
     }
-#endif
 }
+#endif
 
 #ifndef RECURSIVE_QSQR
 void QSQR::processTask(QSQR_Task &task) {
     switch (task.type) {
         case QUERY: {
-                        size_t sz = program->getNRulesByPredicate(task.pred.getId());
-                        if (task.currentRuleIndex < sz) {
+                        if (task.currentRuleIndex < task.lastRuleIndex) {
                             //Execute the next rule
                             QSQR_Task newTask(QSQR_TaskType::QUERY, task.pred);
                             newTask.currentRuleIndex = task.currentRuleIndex + 1;
+                            newTask.firstRuleIndex = task.firstRuleIndex;
+                            newTask.lastRuleIndex = task.lastRuleIndex;
                             newTask.inputTable = task.inputTable;
                             newTask.offsetInput = task.offsetInput;
+                            newTask.endInput = task.endInput;
                             newTask.repeat = task.repeat;
                             newTask.totalAnswers = task.totalAnswers;
                             pushTask(newTask);
                             // LOG(DEBUGL) << "pushed new task QUERY, totalAnswers = " << newTask.totalAnswers;
-                            RuleExecutor *exec = rules[task.pred.getId()]
-                                [task.pred.getAdorment()][task.currentRuleIndex];
-                            exec->evaluate(task.inputTable, task.offsetInput, this, layer);
+                            RuleExecutor *exec = getRuleExecutor(task.pred,
+                                    task.currentRuleIndex);
+                            exec->evaluate(task.inputTable, task.offsetInput,
+                                    task.endInput, this, layer);
                         } else {
                             size_t newAnswers = calculateAllAnswers();
                             if (task.repeat && newAnswers > task.totalAnswers) {
                                 createRules(task.pred);
                                 QSQR_Task newTask(QSQR_TaskType::QUERY, task.pred);
-                                newTask.currentRuleIndex = 1;
+                                newTask.currentRuleIndex = task.firstRuleIndex + 1;
+                                newTask.firstRuleIndex = task.firstRuleIndex;
+                                newTask.lastRuleIndex = task.lastRuleIndex;
                                 newTask.inputTable = task.inputTable;
                                 newTask.offsetInput = task.offsetInput;
+                                newTask.endInput = task.endInput;
                                 newTask.repeat = task.repeat;
                                 //newTask.shouldRepeat = false;
                                 newTask.totalAnswers = newAnswers;
                                 pushTask(newTask);
                                 // LOG(DEBUGL) << "pushed new task QUERY(0), totalAnswers = " << newTask.totalAnswers;
-                                RuleExecutor *exec = rules[task.pred.getId()]
-                                    [task.pred.getAdorment()][0];
-                                exec->evaluate(task.inputTable, task.offsetInput, this, layer);
+                                RuleExecutor *exec = getRuleExecutor(task.pred,
+                                        task.firstRuleIndex);
+                                exec->evaluate(task.inputTable, task.offsetInput,
+                                        task.endInput, this, layer);
                             }
                         }
                         break;
@@ -259,6 +298,163 @@ void QSQR::processTask(QSQR_Task &task) {
 }
 #endif
 
+#ifndef RECURSIVE_QSQR
+void QSQR::processAllTasks() {
+    while (tasks.size() > 0) {
+        // LOG(DEBUGL) << "Task size=" << tasks.size();
+        QSQR_Task task = tasks.back();
+        tasks.pop_back();
+        processTask(task);
+    }
+}
+
+void QSQR::evaluateRound(QSQQuery *query, std::vector<uint8_t> *posJoins,
+        std::vector<Term_t> *possibleValuesJoins, int firstRule, int lastRule) {
+    Predicate pred = getInputPredicate(query, posJoins);
+    {
+        QSQR_TablesLock lock(this);
+        BindingsTable *inputTable;
+        addQueryInput(query, posJoins, possibleValuesJoins, inputTable);
+    }
+    //The shared input table also contains the bindings of the other
+    //workers, so the rules are executed on a copy of the own ones
+    BindingsTable input(pred.getCardinality(), pred.getAdorment());
+    addQueryTuples(query, posJoins, possibleValuesJoins, &input);
+    evaluate(pred, &input, 0, input.getNTuples(), false, firstRule, lastRule);
+    processAllTasks();
+}
+
+struct QSQR_Worker {
+    std::unique_ptr<QSQR> qsqr;
+    int firstRule;
+    int lastRule;
+    std::vector<Term_t> bindings;
+};
+
+bool QSQR::evaluateParallel(QSQQuery *query, std::vector<uint8_t> *posJoins,
+        std::vector<Term_t> *possibleValuesJoins) {
+    Predicate pred = getInputPredicate(query, posJoins);
+    const int nrules = program->getNRulesByPredicate(pred.getId());
+    size_t nbindings = 1;
+    if (posJoins != NULL) {
+        nbindings = possibleValuesJoins->size() / posJoins->size();
+    }
+
+    //Split the rules in groups and the bindings in parts, so that there is
+    //about one worker per thread
+    const int nGroups = std::min(nrules, nthreads);
+    if (nGroups == 0) {
+        return false;
+    }
+    const size_t nParts = std::min(nbindings,
+            (size_t) std::max(1, nthreads / nGroups));
+    if (nGroups * nParts <= 1) {
+        return false;
+    }
+    std::vector<QSQR_Worker> workers(nGroups * nParts);
+    size_t w = 0;
+    for (int g = 0; g < nGroups; ++g) {
+        for (size_t p = 0; p < nParts; ++p) {
+            QSQR_Worker &worker = workers[w++];
+            worker.qsqr = std::unique_ptr<QSQR>(new QSQR(*this));
+            worker.firstRule = nrules * g / nGroups;
+            worker.lastRule = nrules * (g + 1) / nGroups;
+            if (posJoins != NULL) {
+                const size_t sizeBinding = posJoins->size();
+                worker.bindings.assign(
+                        possibleValuesJoins->begin() + nbindings * p / nParts * sizeBinding,
+                        possibleValuesJoins->begin() + nbindings * (p + 1) / nParts * sizeBinding);
+            }
+        }
+    }
+    LOG(DEBUGL) << "QSQR: " << workers.size() << " workers, " << nGroups
+        << " groups of rules, " << nParts << " parts of the bindings";
+
+    std::mutex mutex;
+    tablesMutex = &mutex;
+    size_t totalAnswers = calculateAllAnswers();
+    bool shouldRepeat;
+    int rounds = 0;
+    do {
+        //The subqueries of the previous round must be evaluated again with
+        //the new answers
+        cleanAllInputs();
+        ParallelTasks::parallel_for(0, workers.size(), 1,
+                [&workers, query, posJoins](const ParallelRange &r) {
+                    for (size_t i = r.begin(); i != r.end(); ++i) {
+                        QSQR_Worker &worker = workers[i];
+                        worker.qsqr->evaluateRound(query, posJoins,
+                                posJoins != NULL ? &worker.bindings : NULL,
+                                worker.firstRule, worker.lastRule);
+                    }
+                });
+        rounds++;
+
+        //Fixpoint: stop when the round did not find answers that were not
+        //known at its beginning
+        size_t newTotalAnswers = calculateAllAnswers();
+        shouldRepeat = newTotalAnswers > totalAnswers;
+        totalAnswers = newTotalAnswers;
+    } while (shouldRepeat);
+    tablesMutex = NULL;
+    LOG(DEBUGL) << "QSQR: fixpoint reached after " << rounds << " rounds";
+    return true;
+}
+#endif
+
+Predicate QSQR::getInputPredicate(QSQQuery *query,
+        std::vector<uint8_t> *posJoins) {
+    Predicate pred = query->getLiteral()->getPredicate();
+    if (posJoins == NULL) {
+        return pred;
+    }
+    //Modify the adornment of the pred. Set constant values that were
+    //set as variables
+    uint8_t adornment = pred.getAdorment();
+    for (int i = 0; i < posJoins->size(); ++i) {
+        adornment = Predicate::changeVarToConstInAdornment(adornment,
+                posJoins->at(i));
+    }
+    return Predicate(pred.getId(), adornment, pred.getType(),
+            pred.getCardinality());
+}
+
+Predicate QSQR::addQueryInput(QSQQuery *query, std::vector<uint8_t> *posJoins,
+        std::vector<Term_t> *possibleValuesJoins, BindingsTable *&inputTable) {
+    Predicate pred = getInputPredicate(query, posJoins);
+    inputTable = getInputTable(pred);
+    addQueryTuples(query, posJoins, possibleValuesJoins, inputTable);
+    return pred;
+}
+
+void QSQR::addQueryTuples(QSQQuery *query, std::vector<uint8_t> *posJoins,
+        std::vector<Term_t> *possibleValuesJoins, BindingsTable *inputTable) {
+    if (posJoins == NULL) {
+        inputTable->addTuple(query->getLiteral());
+        return;
+    }
+
+    assert(possibleValuesJoins != NULL);
+    assert(query->getLiteral()->getTupleSize() <= 3);
+    Term_t tuple[3];
+    //Fill the tuple with the content of the query
+    VTuple t = query->getLiteral()->getTuple();
+    for (int i = 0; i < t.getSize(); ++i) {
+        tuple[i] = t.get(i).getValue();
+    }
+
+    //Add all possible literals
+    std::vector<Term_t>::iterator itr = possibleValuesJoins->begin();
+    while (itr != possibleValuesJoins->end()) {
+        //raiseIfExpired();
+        for (int j = 0; j < posJoins->size(); ++j) {
+            tuple[posJoins->at(j)] = *itr;
+            itr++;
+        }
+        inputTable->addTuple(tuple);
+    }
+}
+
 TupleTable *QSQR::evaluateQuery(int evaluateOrEstimate, QSQQuery *query,
         std::vector<uint8_t> *posJoins,
         std::vector<Term_t> *possibleValuesJoins,
@@ -279,100 +475,50 @@ TupleTable *QSQR::evaluateQuery(int evaluateOrEstimate, QSQQuery *query,
             return output;
         }
     } else {
-        cleanAllInputs();
-        size_t totalAnswers, newTotalAnswers;
-        bool shouldRepeat = false;
-        uint8_t adornment = pred.getAdorment();
-        do {
-            BindingsTable *inputTable;
-            if (posJoins != NULL) {
-                //Modify the adornment of the pred. Set constant values that were
-                //set as variables
-                for (int i = 0; i < posJoins->size(); ++i) {
-                    adornment = Predicate::changeVarToConstInAdornment(adornment,
-                            posJoins->at(i));
-                }
-                Predicate pred2 = Predicate(pred.getId(), adornment, pred.getType(),
-                        pred.getCardinality());
-                inputTable = getInputTable(pred2);
-
-                assert(possibleValuesJoins != NULL);
-                assert(query->getLiteral()->getTupleSize() <= 3);
-                Term_t tuple[3];
-                //Fill the tuple with the content of the query
-                VTuple t = query->getLiteral()->getTuple();
-                for (int i = 0; i < t.getSize(); ++i) {
-                    tuple[i] = t.get(i).getValue();
-                }
-
-                //Add all possible literals
-                std::vector<Term_t>::iterator itr = possibleValuesJoins->begin();
-                while (itr != possibleValuesJoins->end()) {
-                    //raiseIfExpired();
-                    for (int j = 0; j < posJoins->size(); ++j) {
-                        tuple[posJoins->at(j)] = *itr;
-                        itr++;
-                    }
-                    inputTable->addTuple(tuple);
-                }
-
-                //raiseIfExpired();
-                totalAnswers = calculateAllAnswers();
-
-                if (evaluateOrEstimate == QSQR_EVAL) {
-                    evaluate(pred2, inputTable, 0, false);
+        uint8_t adornment = getInputPredicate(query, posJoins).getAdorment();
+        bool evaluated = false;
 #ifndef RECURSIVE_QSQR
-                    //evaluate in this case is not recursive. Process the tasks
-                    //until the queue is empty
-                    while (tasks.size() > 0) {
-                        // LOG(DEBUGL) << "Task size=" << tasks.size();
-                        QSQR_Task task = tasks.back();
-                        tasks.pop_back();
-                        processTask(task);
-                    }
+        if (evaluateOrEstimate == QSQR_EVAL && nthreads > 1) {
+            evaluated = evaluateParallel(query, posJoins, possibleValuesJoins);
+        }
 #endif
-
-                } else {
-                    TupleTable *output = new TupleTable(1);
-                    uint64_t est = estimate(0, pred2, inputTable/*, 0*/);
-                    // Incorporate size of possible join values?
-                    // Useless, I think, because in the planning phase, we don't actually have more than
-                    // one possiblevaluesjoin. --Ceriel
-                    est = est + (est * (possibleValuesJoins->size() / posJoins->size() - 1)) / 10;
-                    output->addRow(&est);
-                    return output;
-                }
-            } else {
-                inputTable = getInputTable(pred);
-                inputTable->addTuple(query->getLiteral());
+        if (!evaluated) {
+            cleanAllInputs();
+            size_t totalAnswers, newTotalAnswers;
+            bool shouldRepeat = false;
+            do {
+                BindingsTable *inputTable;
+                Predicate inputPred = addQueryInput(query, posJoins,
+                        possibleValuesJoins, inputTable);
                 if (evaluateOrEstimate == QSQR_EVAL) {
+                    //raiseIfExpired();
                     totalAnswers = calculateAllAnswers();
-                    evaluate(pred, inputTable, 0, false);
+                    evaluate(inputPred, inputTable, 0, false);
 #ifndef RECURSIVE_QSQR
                     //evaluate in this case is not recursive. Process the tasks
                     //until the queue is empty
-                    while (tasks.size() > 0) {
-                        //LOG(DEBUGL) << "Task size=" << tasks.size();
-                        QSQR_Task task = tasks.back();
-                        tasks.pop_back();
-                        processTask(task);
-                    }
+                    processAllTasks();
 #endif
-
                 } else { //ESTIMATE
                     TupleTable *output = new TupleTable(1);
-                    uint64_t est = estimate(0, pred, inputTable/*, 0*/);
+                    uint64_t est = estimate(0, inputPred, inputTable/*, 0*/);
+                    if (posJoins != NULL) {
+                        // Incorporate size of possible join values?
+                        // Useless, I think, because in the planning phase, we don't actually have more than
+                        // one possiblevaluesjoin. --Ceriel
+                        est = est + (est * (possibleValuesJoins->size() / posJoins->size() - 1)) / 10;
+                    }
                     output->addRow(&est);
                     return output;
                 }
-            }
 
-            newTotalAnswers = calculateAllAnswers();
-            shouldRepeat = newTotalAnswers > totalAnswers;
-            if (shouldRepeat) {
-                cleanAllInputs();
-            }
-        } while (shouldRepeat);
+                newTotalAnswers = calculateAllAnswers();
+                shouldRepeat = newTotalAnswers > totalAnswers;
+                if (shouldRepeat) {
+                    cleanAllInputs();
+                }
+            } while (shouldRepeat);
+        }
 
         const Literal *l = query->getLiteral();
         BindingsTable *answer = getAnswerTable(l->getPredicate(), adornment);
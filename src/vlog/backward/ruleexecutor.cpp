@@ -338,7 +338,7 @@ size_t RuleExecutor::estimateRule(const int depth, const uint8_t bodyAtom,
     size_t card = retrievedBindings->getNRows();
     if (nCurrentJoins > 0) {
         //Sort the current TupleBindings to perform a merge sort with the just-retrieved tuples
-        TupleTable *sortedBindings2 = supplRelations[bodyAtom]->sortBy(posJoinsSupplRel);
+        BindingsView sortedBindings2 = supplRelations[bodyAtom]->sortedView(posJoinsSupplRel);
 
         //Sort also the retrieved tuples
         TupleTable *sortedBindings1 = retrievedBindings->sortBy(posJoinsLiteral);
@@ -348,13 +348,10 @@ size_t RuleExecutor::estimateRule(const int depth, const uint8_t bodyAtom,
                 nCurrentJoins, supplRelations[bodyAtom + 1]);
 
         delete sortedBindings1;
-        delete sortedBindings2;
     } else {
         if (supplRelations[bodyAtom]->getSizeTuples() == 0) {
             //Simply copy all retrieved elements in the following relation
-            for (size_t i = 0; i < retrievedBindings->getNRows(); ++i) {
-                supplRelations[bodyAtom + 1]->addTuple(retrievedBindings->getRow(i));
-            }
+            supplRelations[bodyAtom + 1]->addTuples(retrievedBindings);
         } else {
             LOG(ERRORL) << "Need to perform the cardinal product. Not yet supported";
             throw 10;
@@ -378,6 +375,7 @@ void RuleExecutor::evaluateRule(const uint8_t bodyAtom,
     //Do the computation to produce bindings for the next suppl. relation.
     uint8_t nCurrentJoins = this->njoins[bodyAtom];
     TupleTable *retrievedBindings = NULL;
+    BindingsView retrievedView;
 
     std::vector<uint8_t> posJoinsSupplRel;
     std::vector<uint8_t> posJoinsLiteral;
@@ -414,43 +412,51 @@ void RuleExecutor::evaluateRule(const uint8_t bodyAtom,
         //durationEDB += std::chrono::system_clock::now() - startEDB;
         // LOG(DEBUGL) << "EDB, query " << query.tostring() << ", retrieved " << retrievedBindings->getNRows();
     } else {
-        //Copy in input the query that we are about to launch
-        BindingsTable *table = qsqr->getInputTable(query.getLiteral()->getPredicate());
-        //LOG(DEBUGL) << "ENRICH TABLE " << table->getNTuples();
-        size_t offsetInput = table->getNTuples();
-        if (posFromSupplRelation[bodyAtom].size() == 0) {
-            if (posFromLiteral[bodyAtom].size() == 0) {
-                table->addRawTuple(NULL);
-            } else {
-                Term_t tmpRow[256];
-                vector<std::pair<uint8_t, uint8_t>> pairs = posFromLiteral[bodyAtom];
+        //Copy in input the query that we are about to launch. With several
+        //workers, the tuples added here are the ones in [offsetInput,
+        //endInput): the others are already evaluated by another worker
+        BindingsTable *table;
+        size_t offsetInput, endInput;
+        {
+            QSQR_TablesLock lock(qsqr);
+            table = qsqr->getInputTable(query.getLiteral()->getPredicate());
+            //LOG(DEBUGL) << "ENRICH TABLE " << table->getNTuples();
+            offsetInput = table->getNTuples();
+            if (posFromSupplRelation[bodyAtom].size() == 0) {
+                if (posFromLiteral[bodyAtom].size() == 0) {
+                    table->addRawTuple(NULL);
+                } else {
+                    Term_t tmpRow[256];
+                    vector<std::pair<uint8_t, uint8_t>> pairs = posFromLiteral[bodyAtom];
 
-                for (size_t i = 0; i < pairs.size(); ++i) {
-                    tmpRow[pairs[i].second] = query.getLiteral()->getTermAtPos(pairs[i].first).getValue();
+                    for (size_t i = 0; i < pairs.size(); ++i) {
+                        tmpRow[pairs[i].second] = query.getLiteral()->getTermAtPos(pairs[i].first).getValue();
+                    }
+                    table->addRawTuple(tmpRow);
                 }
-                table->addRawTuple(tmpRow);
-            }
-        } else {
-            Term_t tmpRow[256];
-            if (posFromLiteral[bodyAtom].size() > 0) {
-                vector<std::pair<uint8_t, uint8_t>> pairs = posFromLiteral[bodyAtom];
-                for (size_t i = 0; i < pairs.size(); ++i) {
-                    tmpRow[pairs[i].second] = query.getLiteral()->getTermAtPos(pairs[i].first).getValue();
+            } else {
+                Term_t tmpRow[256];
+                if (posFromLiteral[bodyAtom].size() > 0) {
+                    vector<std::pair<uint8_t, uint8_t>> pairs = posFromLiteral[bodyAtom];
+                    for (size_t i = 0; i < pairs.size(); ++i) {
+                        tmpRow[pairs[i].second] = query.getLiteral()->getTermAtPos(pairs[i].first).getValue();
+                    }
                 }
-            }
-            std::vector<std::pair<uint8_t, uint8_t>> pairs = posFromSupplRelation[bodyAtom];
-            for (size_t i = 0; i < supplRelations[bodyAtom]->getNTuples(); ++i) {
-                const Term_t *tuple = supplRelations[bodyAtom]->getTuple(i);
-                for (std::vector<std::pair<uint8_t, uint8_t>>::iterator itr = pairs.begin();
-                        itr != pairs.end(); ++itr) {
-                    tmpRow[itr->second] = tuple[itr->first];
+                std::vector<std::pair<uint8_t, uint8_t>> pairs = posFromSupplRelation[bodyAtom];
+                for (size_t i = 0; i < supplRelations[bodyAtom]->getNTuples(); ++i) {
+                    const Term_t *tuple = supplRelations[bodyAtom]->getTuple(i);
+                    for (std::vector<std::pair<uint8_t, uint8_t>>::iterator itr = pairs.begin();
+                            itr != pairs.end(); ++itr) {
+                        tmpRow[itr->second] = tuple[itr->first];
+                    }
+                    table->addRawTuple(tmpRow);
                 }
-                table->addRawTuple(tmpRow);
             }
+            endInput = table->getNTuples();
         }
 
         //Call the query if there are new queries
-        if (table->getNTuples() > offsetInput) {
+        if (endInput > offsetInput) {
             Predicate pred = query.getLiteral()->getPredicate();
 #ifdef RECURSIVE_QSQR
             qsqr->evaluate(pred, table, offsetInput);
@@ -461,20 +467,25 @@ void RuleExecutor::evaluateRule(const uint8_t bodyAtom,
             task.inputTable = table;
             task.supplRelations = supplRelations;
             task.offsetInput = offsetInput;
+            task.endInput = endInput;
             task.currentRuleIndex = bodyAtom;
             task.qsqr = qsqr;
             qsqr->pushTask(task);
-            qsqr->evaluate(pred, table, offsetInput);
+            qsqr->evaluateRange(pred, table, offsetInput, endInput);
             return;
 #endif
         }
 
-        //Get previous answers
+        //Get previous answers. They are read directly from the answer
+        //table, without copying them
+        QSQR_TablesLock lock(qsqr);
         BindingsTable *answer = qsqr->getAnswerTable(query.getLiteral());
-        retrievedBindings = answer->projectAndFilter(l, NULL, NULL);
+        retrievedView = answer->projectionView(l);
     }
 
-    if (retrievedBindings == NULL || retrievedBindings->getNRows() == 0) {
+    const size_t nRetrieved = retrievedBindings != NULL ?
+        retrievedBindings->getNRows() : retrievedView.getNRows();
+    if (nRetrieved == 0) {
         if (retrievedBindings != NULL)
             delete retrievedBindings;
         return;
@@ -482,22 +493,27 @@ void RuleExecutor::evaluateRule(const uint8_t bodyAtom,
 
     if (nCurrentJoins > 0) {
         //Sort the current TupleBindings to perform a merge sort with the just-retrieved tuples
-        TupleTable *sortedBindings2 = supplRelations[bodyAtom]->sortBy(posJoinsSupplRel);
-
-        //Sort also the retrieved tuples
-        TupleTable *sortedBindings1 = retrievedBindings->sortBy(posJoinsLiteral);
-
-        //Do the join and copy the results in the following suppl. relation
-        RuleExecutor::join(sortedBindings1, sortedBindings2, &(joins.at(startJoins[bodyAtom])),
-                nCurrentJoins, supplRelations[bodyAtom + 1]);
-
-        delete sortedBindings1;
-        delete sortedBindings2;
+        BindingsView sortedBindings2 = supplRelations[bodyAtom]->sortedView(posJoinsSupplRel);
+
+        //Sort also the retrieved tuples, and do the join and copy the
+        //results in the following suppl. relation
+        if (retrievedBindings != NULL) {
+            TupleTable *sortedBindings1 = retrievedBindings->sortBy(posJoinsLiteral);
+            RuleExecutor::join(sortedBindings1, sortedBindings2, &(joins.at(startJoins[bodyAtom])),
+                    nCurrentJoins, supplRelations[bodyAtom + 1]);
+            delete sortedBindings1;
+        } else {
+            retrievedView.sortBy(posJoinsLiteral);
+            RuleExecutor::join(retrievedView, sortedBindings2, &(joins.at(startJoins[bodyAtom])),
+                    nCurrentJoins, supplRelations[bodyAtom + 1]);
+        }
     } else {
         if (supplRelations[bodyAtom]->getSizeTuples() == 0) {
             //Simply copy all retrieved elements in the following relation
-            for (size_t i = 0; i < retrievedBindings->getNRows(); ++i) {
-                supplRelations[bodyAtom + 1]->addTuple(retrievedBindings->getRow(i));
+            if (retrievedBindings != NULL) {
+                supplRelations[bodyAtom + 1]->addTuples(retrievedBindings);
+            } else {
+                supplRelations[bodyAtom + 1]->addTuples(retrievedView);
             }
         } else {
             LOG(ERRORL) << "Need to perform the cardinal product. Not yet supported";
@@ -583,6 +599,7 @@ void RuleExecutor::copyLastRelInAnswers(QSQR *qsqr,
         BindingsTable **supplRelations,
         BindingsTable *lastSupplRelation) {
     if (nTuples > 0) {
+        QSQR_TablesLock lock(qsqr);
         Literal l = adornedRule.getFirstHead();
         BindingsTable *answer = qsqr->getAnswerTable(&l);
 
@@ -614,22 +631,26 @@ void RuleExecutor::copyLastRelInAnswers(QSQR *qsqr,
 }
 
 void RuleExecutor::evaluate(BindingsTable * input, size_t offsetInput,
+        size_t endInput,
         QSQR * qsqr,
         EDBLayer &layer) {
 
     //Evaluate the rule
-    if (input->getNTuples() > offsetInput) {
+    if (endInput > offsetInput) {
         //Get the new tuples. All the tuples that merge with the head of the
         //adorned rule are being copied in the first supplementary relation
         BindingsTable **supplRelations = createSupplRelations();
 
         //Copy all the tuples that are unifiable with the head in the first
         //supplementary relation.
-        for (size_t i = offsetInput; i < input->getNTuples(); ++i) {
-            const Term_t* tuple = input->getTuple(i);
-            if (isUnifiable(tuple, input->getSizeTuples(),
-                        input->getPosFromAdornment(), layer)) {
-                supplRelations[0]->addTuple(tuple);
+        {
+            QSQR_TablesLock lock(qsqr);
+            for (size_t i = offsetInput; i < endInput; ++i) {
+                const Term_t* tuple = input->getTuple(i);
+                if (isUnifiable(tuple, input->getSizeTuples(),
+                            input->getPosFromAdornment(), layer)) {
+                    supplRelations[0]->addTuple(tuple);
+                }
             }
         }
 
@@ -701,9 +722,12 @@ void RuleExecutor::processTask(QSQR_Task *t) {
                              //LOG(DEBUGL) << "Process RULE_QUERY";
                              Literal l(adornedRule.getBody()[task.currentRuleIndex]);
                              QSQQuery query(l);
-                             BindingsTable *answer = task.qsqr->getAnswerTable(query.getLiteral());
-                             TupleTable *retrievedBindings = answer->
-                                 projectAndFilter(l, NULL, NULL);
+                             BindingsView retrievedBindings;
+                             {
+                                 QSQR_TablesLock lock(task.qsqr);
+                                 BindingsTable *answer = task.qsqr->getAnswerTable(query.getLiteral());
+                                 retrievedBindings = answer->projectionView(l);
+                             }
                              const uint8_t nCurrentJoins = this->njoins[task.currentRuleIndex];
                              std::vector<uint8_t> posJoinsSupplRel;
                              std::vector<uint8_t> posJoinsLiteral;
@@ -715,45 +739,31 @@ void RuleExecutor::processTask(QSQR_Task *t) {
                                  }
                              }
 
-                             if (retrievedBindings == NULL || retrievedBindings->getNRows() == 0) {
-                                 if (retrievedBindings != NULL) {
-                                     delete retrievedBindings;
-                                     retrievedBindings = NULL;
-                                 }
+                             if (retrievedBindings.getNRows() == 0) {
                              } else if (nCurrentJoins > 0) {
-                                 TupleTable *sortedBindings2 = task.supplRelations[task.
+                                 BindingsView sortedBindings2 = task.supplRelations[task.
                                      currentRuleIndex]->
-                                     sortBy(posJoinsSupplRel);
+                                     sortedView(posJoinsSupplRel);
 
                                  //Sort also the retrieved tuples
-                                 TupleTable *sortedBindings1 = retrievedBindings->
-                                     sortBy(posJoinsLiteral);
+                                 retrievedBindings.sortBy(posJoinsLiteral);
 
                                  //Do the join and copy the results in the following suppl. relation
-                                 RuleExecutor::join(sortedBindings1, sortedBindings2,
+                                 RuleExecutor::join(retrievedBindings, sortedBindings2,
                                          &(joins.at(startJoins[task.currentRuleIndex])),
                                          nCurrentJoins, task.supplRelations[task.
                                          currentRuleIndex + 1]);
-
-                                 delete sortedBindings1;
-                                 delete sortedBindings2;
                              } else {
                                  if (task.supplRelations[task.
                                          currentRuleIndex]->getSizeTuples() == 0) {
                                      //Simply copy all retrieved elements in the following relation
-                                     for (size_t i = 0; i < retrievedBindings->getNRows(); ++i) {
-                                         task.supplRelations[task.currentRuleIndex + 1]->
-                                             addTuple(retrievedBindings->getRow(i));
-                                     }
+                                     task.supplRelations[task.currentRuleIndex + 1]->
+                                         addTuples(retrievedBindings);
                                  } else {
                                      //Not supported yet
                                      throw 10;
                                  }
                              }
-
-                             if (retrievedBindings != NULL) {
-                                 delete retrievedBindings;
-                             }
                          }
                          break;
         default:
@@ -779,15 +789,77 @@ char RuleExecutor::cmp(const uint64_t *row1, const uint64_t *row2, const std::pa
     return 0;
 }
 
-void RuleExecutor::join(TupleTable * r1, TupleTable * r2,
+//Accessors to the relations that are joined in RuleExecutor::join
+static inline size_t getNRows(TupleTable *r) {
+    return r->getNRows();
+}
+
+static inline size_t getNRows(const BindingsView &r) {
+    return r.getNRows();
+}
+
+static inline uint8_t getSizeRow(TupleTable *r) {
+    return (uint8_t) r->getSizeRow();
+}
+
+static inline uint8_t getSizeRow(const BindingsView &r) {
+    return r.getSizeRow();
+}
+
+static inline Term_t getValue(TupleTable *r, const size_t row,
+        const uint8_t column) {
+    return (Term_t) r->getRow(row)[column];
+}
+
+static inline Term_t getValue(const BindingsView &r, const size_t row,
+        const uint8_t column) {
+    return r.get(row, column);
+}
+
+static inline const uint64_t *getRow(TupleTable *r, const size_t row,
+        uint64_t *buffer) {
+    return r->getRow(row);
+}
+
+static inline const uint64_t *getRow(const BindingsView &r, const size_t row,
+        uint64_t *buffer) {
+    r.copyRow(row, buffer);
+    return buffer;
+}
+
+template<typename R1, typename R2>
+static char cmpRows(const R1 &r1, const size_t row1, const R2 &r2,
+        const size_t row2, const std::pair<uint8_t, uint8_t> *joins,
+        const uint8_t njoins) {
+    for (int i = 0; i < njoins; ++i) {
+        Term_t v1 = getValue(r1, row1, joins[i].first);
+        Term_t v2 = getValue(r2, row2, joins[i].second);
+        if (v1 < v2) {
+            return -1;
+        }
+        if (v2 < v1) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+template<typename R1, typename R2>
+static void mergeJoin(const R1 &r1, const R2 &r2,
         std::pair<uint8_t, uint8_t> *j, uint8_t nj, BindingsTable * output) {
     //Perform a merge join and copy the data into a row to be copied in the output
+    const size_t nrows1 = getNRows(r1);
+    const size_t nrows2 = getNRows(r2);
+    const uint8_t sizeRow1 = getSizeRow(r1);
+    const uint8_t sizeRow2 = getSizeRow(r2);
+    uint64_t buffer1[256];
+    uint64_t buffer2[256];
     size_t indexR1 = 0;
     size_t indexR2 = 0;
 
     while (true) {
         //Exit condition
-        if (indexR1 >= r1->getNRows() || indexR2 >= r2->getNRows()) {
+        if (indexR1 >= nrows1 || indexR2 >= nrows2) {
 #ifdef DEBUG
             output->statistics();
 #endif
@@ -795,29 +867,30 @@ void RuleExecutor::join(TupleTable * r1, TupleTable * r2,
         }
 
         //Compare the fields in the two relations.
-        char res = RuleExecutor::cmp(r1->getRow(indexR1), r2->getRow(indexR2), j, nj);
+        char res = cmpRows(r1, indexR1, r2, indexR2, j, nj);
         if (res == 0) {
             //Determine the range on both sides.
             size_t startJoin1 = indexR1;
             size_t startJoin2 = indexR2;
             //Find first end
             size_t tmpIndex = startJoin2+1;
-            while (tmpIndex < r2->getNRows() &&
-                    RuleExecutor::cmp(r1->getRow(indexR1), r2->getRow(tmpIndex), j, nj) == 0) {
+            while (tmpIndex < nrows2 &&
+                    cmpRows(r1, indexR1, r2, tmpIndex, j, nj) == 0) {
                 tmpIndex++;
             }
             size_t endJoin2 = tmpIndex;
             //Determine second end
             tmpIndex = startJoin1+1;
-            while (tmpIndex < r1->getNRows() &&
-                    RuleExecutor::cmp(r1->getRow(tmpIndex), r2->getRow(indexR2), j, nj) == 0) {
+            while (tmpIndex < nrows1 &&
+                    cmpRows(r1, tmpIndex, r2, indexR2, j, nj) == 0) {
                 tmpIndex++;
             }
             size_t endJoin1 = tmpIndex;
 
             for (size_t i = startJoin1; i < endJoin1; ++i) {
+                const uint64_t *row1 = getRow(r1, i, buffer1);
                 for (size_t m = startJoin2; m < endJoin2; ++m) {
-                    output->addTuple(r1->getRow(i), (uint8_t)r1->getSizeRow(), r2->getRow(m), (uint8_t)r2->getSizeRow());
+                    output->addTuple(row1, sizeRow1, getRow(r2, m, buffer2), sizeRow2);
                 }
             }
             indexR1 = endJoin1;
@@ -831,3 +904,18 @@ void RuleExecutor::join(TupleTable * r1, TupleTable * r2,
         }
     }
 }
+
+void RuleExecutor::join(TupleTable * r1, TupleTable * r2,
+        std::pair<uint8_t, uint8_t> *j, uint8_t nj, BindingsTable * output) {
+    mergeJoin(r1, r2, j, nj, output);
+}
+
+void RuleExecutor::join(TupleTable * r1, const BindingsView &r2,
+        std::pair<uint8_t, uint8_t> *j, uint8_t nj, BindingsTable * output) {
+    mergeJoin(r1, r2, j, nj, output);
+}
+
+void RuleExecutor::join(const BindingsView &r1, const BindingsView &r2,
+        std::pair<uint8_t, uint8_t> *j, uint8_t nj, BindingsTable * output) {
+    mergeJoin(r1, r2, j, nj, output);
+}
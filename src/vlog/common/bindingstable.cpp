@@ -3,26 +3,55 @@
 
 #include <cstring>
 #include <algorithm>
+#include <functional>
 
 Term_t const * const EMPTY_TUPLE = {0};
-BindingsRow EMPTY_ROW(0, EMPTY_TUPLE);
 
-bool BindingsRow::operator==(const BindingsRow &other) const {
-    if (size == other.size) {
-        if (row == other.row)
-            return true;
-        for (int i = 0; i < size; ++i) {
-            if (row[i] != other.row[i])
-                return false;
+//Initial number of slots of the hash table
+#define BINDINGS_INITIAL_SLOTS 16
+
+struct RowsSorter {
+    uint8_t fields[256];
+    const uint8_t nfields;
+
+    RowsSorter(const std::vector<uint8_t> &f) : nfields((uint8_t) f.size()) {
+        for (int i = 0; i < nfields; ++i) {
+            fields[i] = f[i];
+        }
+    }
+
+    bool operator ()(const Term_t *r1, const Term_t *r2) const {
+        for (int i = 0; i < nfields; ++i) {
+            if (r1[fields[i]] != r2[fields[i]])
+                return r1[fields[i]] < r2[fields[i]];
         }
-        return true;
+        return false;
+    }
+};
+
+void BindingsView::sortBy(const std::vector<uint8_t> &fields) {
+    //Compare the columns of the rows, not of the view
+    std::vector<uint8_t> rowFields;
+    for (auto f : fields) {
+        rowFields.push_back(columns[f]);
+    }
+    RowsSorter sorter(rowFields);
+    std::sort(rows.begin(), rows.end(), std::ref(sorter));
+}
+
+void BindingsTable::init() {
+    nTuples = 0;
+    slots.assign(BINDINGS_INITIAL_SLOTS, 0);
+    if (nPosToCopy > 0) {
+        rawBindings = new RawBindings((uint8_t) nPosToCopy);
+        currentRow = rawBindings->newRow();
+    } else {
+        rawBindings = NULL;
+        currentRow = NULL;
     }
-    LOG(ERRORL) << "Should never happen";
-    return false;
 }
 
 BindingsTable::BindingsTable(uint8_t sizeAdornment, uint8_t adornment) {
-    uniqueElements.max_load_factor(0.75);
     //Mark positions to copy
     std::vector<int> pc;
     for (int i = 0; i < sizeAdornment; ++i) {
@@ -39,225 +68,340 @@ BindingsTable::BindingsTable(uint8_t sizeAdornment, uint8_t adornment) {
         for (std::vector<int>::iterator itr = pc.begin(); itr != pc.end(); ++itr) {
             posToCopy[i++] = *itr;
         }
-        rawBindings = new RawBindings((uint8_t) nPosToCopy);
-        currentRow = rawBindings->newRow();
     } else {
         posToCopy = NULL;
-        rawBindings = NULL;
-        currentRow = NULL;
     }
+    init();
 }
 
 BindingsTable::BindingsTable(size_t sizeTuple) {
-    uniqueElements.max_load_factor(0.75);
     nPosToCopy = sizeTuple;
-    if (nPosToCopy > 0) {
-        rawBindings = new RawBindings((uint8_t) sizeTuple);
-        currentRow = rawBindings->newRow();
-    } else {
-        rawBindings = NULL;
-        currentRow = NULL;
-    }
     posToCopy = NULL;
+    init();
 }
 
 BindingsTable::BindingsTable(uint8_t npc, std::vector<int> pc) {
-    uniqueElements.max_load_factor(0.75);
     this->nPosToCopy = npc;
     if (nPosToCopy > 0) {
         this->posToCopy = new size_t[nPosToCopy];
-        for (int i = 0; i < nPosToCopy; ++i) {
+        for (size_t i = 0; i < nPosToCopy; ++i) {
             posToCopy[i] = pc.at(i);
         }
-        rawBindings = new RawBindings((uint8_t) nPosToCopy);
-        currentRow = rawBindings->newRow();
     } else {
         this->posToCopy = NULL;
-        rawBindings = NULL;
-        currentRow = NULL;
     }
+    init();
 }
 
-void BindingsTable::insertIfNotExists(Term_t const * const cr) {
-    if (cr == EMPTY_TUPLE) {
-        uniqueElements.insert(EMPTY_ROW);
-        return;
+size_t BindingsTable::findSlot(const Term_t *row, const uint64_t h) {
+    const size_t mask = slots.size() - 1;
+    size_t i = h & mask;
+    while (slots[i] != 0) {
+        const size_t idx = slots[i] - 1;
+        if (hashes[idx] == h && std::equal(row, row + nPosToCopy,
+                    getRow(idx))) {
+            return i;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+void BindingsTable::grow() {
+    std::vector<size_t> newSlots(slots.size() * 2, 0);
+    const size_t mask = newSlots.size() - 1;
+    //The tuples are unique, so there is no need to compare them
+    for (size_t idx = 0; idx < nTuples; ++idx) {
+        size_t i = hashes[idx] & mask;
+        while (newSlots[i] != 0) {
+            i = (i + 1) & mask;
+        }
+        newSlots[i] = idx + 1;
     }
-    BindingsRow row((uint8_t) nPosToCopy, cr);
-    /*
-    std::unordered_set<BindingsRow, hash_BindingsRow>::iterator itr = uniqueElements.find(row);
-    if (itr == uniqueElements.end()) {
-        uniqueElements.insert(row);
-    */
-    std::pair<std::unordered_set<BindingsRow, hash_BindingsRow>::iterator, bool> result = uniqueElements.insert(row);
-    if (result.second) {
+    slots.swap(newSlots);
+}
+
+void BindingsTable::insertIfNotExists(const uint64_t h) {
+    const size_t slot = findSlot(currentRow, h);
+    if (slots[slot] == 0) {
+        slots[slot] = ++nTuples;
+        hashes.push_back(h);
         currentRow = rawBindings->newRow();
+        if (nTuples * 2 > slots.size()) {
+            grow();
+        }
+    }
+}
+
+void BindingsTable::addRows(const Term_t *rows, const size_t n) {
+    if (nPosToCopy == 0) {
+        if (n > 0) {
+            addEmptyTuple();
+        }
+        return;
+    }
+    uint64_t h[COLUMN_BATCH_SIZE];
+    for (size_t start = 0; start < n; start += COLUMN_BATCH_SIZE) {
+        const size_t count = std::min((size_t) COLUMN_BATCH_SIZE, n - start);
+        const Term_t *batch = rows + start * nPosToCopy;
+        ColumnKernels::hashRows(batch, count, (uint8_t) nPosToCopy, h);
+        for (size_t i = 0; i < count; ++i) {
+            memcpy(currentRow, batch + i * nPosToCopy,
+                    sizeof(Term_t) * nPosToCopy);
+            insertIfNotExists(h[i]);
+        }
     }
 }
 
 void BindingsTable::addTuple(const Literal *t) {
     if (nPosToCopy == 0) {
-        insertIfNotExists(EMPTY_TUPLE);
+        addEmptyTuple();
     } else {
-        for (int i = 0; i < nPosToCopy; ++i) {
+        for (size_t i = 0; i < nPosToCopy; ++i) {
             currentRow[i] = (Term_t) t->getTermAtPos(posToCopy[i]).getValue();
         }
-        insertIfNotExists(currentRow);
+        insertIfNotExists();
     }
 }
 
 #if ! TERM_IS_UINT64
 void BindingsTable::addTuple(const uint64_t *t) {
     if (nPosToCopy == 0) {
-        insertIfNotExists(EMPTY_TUPLE);
+        addEmptyTuple();
     } else {
         for (int i = 0; i < nPosToCopy; ++i) {
             currentRow[i] = t[posToCopy[i]];
         }
-        insertIfNotExists(currentRow);
+        insertIfNotExists();
     }
 }
 #endif
 
 void BindingsTable::addTuple(const Term_t *t) {
     if (nPosToCopy == 0) {
-        insertIfNotExists(EMPTY_TUPLE);
+        addEmptyTuple();
     } else {
-        for (int i = 0; i < nPosToCopy; ++i) {
+        for (size_t i = 0; i < nPosToCopy; ++i) {
             currentRow[i] = t[posToCopy[i]];
         }
-        insertIfNotExists(currentRow);
+        insertIfNotExists();
     }
 }
 
 void BindingsTable::addTuple(const uint64_t *t1, const uint8_t sizeT1,
-                             const uint64_t *t2, const uint8_t sizeT2) {
+                             const uint64_t *t2, const uint8_t /*sizeT2*/) {
     if (nPosToCopy == 0) {
-        insertIfNotExists(EMPTY_TUPLE);
+        addEmptyTuple();
     } else {
-        for (int i = 0; i < nPosToCopy; ++i) {
+        for (size_t i = 0; i < nPosToCopy; ++i) {
             if (posToCopy[i] >= sizeT1) {
                 currentRow[i] = (Term_t) t2[posToCopy[i] - sizeT1];
             } else {
                 currentRow[i] = (Term_t) t1[posToCopy[i]];
             }
         }
-        insertIfNotExists(currentRow);
+        insertIfNotExists();
     }
 }
 
 void BindingsTable::addTuple(const uint64_t *t, const uint8_t *positions) {
     if (nPosToCopy == 0) {
-        insertIfNotExists(EMPTY_TUPLE);
+        addEmptyTuple();
     } else {
-        for (int i = 0; i < nPosToCopy; ++i) {
+        for (size_t i = 0; i < nPosToCopy; ++i) {
             currentRow[i] = (Term_t) t[positions[i]];
         }
-        insertIfNotExists(currentRow);
+        insertIfNotExists();
     }
 }
 
 void BindingsTable::addRawTuple(Term_t *r) {
     if (nPosToCopy == 0) {
-        insertIfNotExists(EMPTY_TUPLE);
+        addEmptyTuple();
     } else {
-        for (int i = 0; i < nPosToCopy; ++i) {
+        for (size_t i = 0; i < nPosToCopy; ++i) {
             currentRow[i] = r[i];
         }
-        insertIfNotExists(currentRow);
+        insertIfNotExists();
+    }
+}
+
+void BindingsTable::addTuples(const BindingsView &view) {
+    const size_t n = view.getNRows();
+    if (nPosToCopy == 0 || n == 0) {
+        addRows(NULL, n);
+        return;
+    }
+    //Copy the columns of the tuples in a buffer, and add them in batches
+    std::vector<Term_t> rows(std::min((size_t) COLUMN_BATCH_SIZE, n) * nPosToCopy);
+    uint64_t row[256];
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        view.copyRow(i, row);
+        Term_t *dest = rows.data() + count * nPosToCopy;
+        for (size_t j = 0; j < nPosToCopy; ++j) {
+            dest[j] = (Term_t) row[posToCopy != NULL ? posToCopy[j] : j];
+        }
+        if (++count == COLUMN_BATCH_SIZE) {
+            addRows(rows.data(), count);
+            count = 0;
+        }
+    }
+    addRows(rows.data(), count);
+}
+
+void BindingsTable::addTuples(const TupleTable *table) {
+    const size_t n = table->getNRows();
+    if (nPosToCopy == 0 || n == 0) {
+        addRows(NULL, n);
+        return;
+    }
+    std::vector<Term_t> rows(std::min((size_t) COLUMN_BATCH_SIZE, n) * nPosToCopy);
+    size_t count = 0;
+    for (size_t i = 0; i < n; ++i) {
+        const uint64_t *row = table->getRow(i);
+        Term_t *dest = rows.data() + count * nPosToCopy;
+        for (size_t j = 0; j < nPosToCopy; ++j) {
+            dest[j] = (Term_t) row[posToCopy != NULL ? posToCopy[j] : j];
+        }
+        if (++count == COLUMN_BATCH_SIZE) {
+            addRows(rows.data(), count);
+            count = 0;
+        }
+    }
+    addRows(rows.data(), count);
+}
+
+void BindingsTable::addTuples(BindingsTable &other) {
+    if (nPosToCopy == 0 || other.nTuples == 0) {
+        addRows(NULL, other.nTuples);
+        return;
+    }
+    //The rows in an array of RawBindings are contiguous
+    for (size_t start = 0; start < other.nTuples; start += BINDINGS_FRAG_ROWS) {
+        addRows(other.getRow(start), std::min((size_t) BINDINGS_FRAG_ROWS,
+                    other.nTuples - start));
     }
 }
 
 void BindingsTable::clear() {
-    uniqueElements.clear();
+    nTuples = 0;
+    std::vector<size_t>(BINDINGS_INITIAL_SLOTS, 0).swap(slots);
+    std::vector<uint64_t>().swap(hashes);
     if (nPosToCopy > 0) {
         rawBindings->clear();
         currentRow = rawBindings->newRow();
     }
 }
 
-TupleTable *BindingsTable::sortBy(std::vector<uint8_t> &fields) {
-    std::vector<BindingsRow> rowsToSort;
-    for (size_t i = 0; i < uniqueElements.size(); ++i) {
-        BindingsRow row((uint8_t) nPosToCopy, rawBindings->getOffset(i * nPosToCopy));
-        rowsToSort.push_back(row);
+BindingsView BindingsTable::sortedView(const std::vector<uint8_t> &fields) {
+    std::vector<const Term_t*> rows;
+    rows.reserve(nTuples);
+    for (size_t i = 0; i < nTuples; ++i) {
+        rows.push_back(getTuple(i));
+    }
+    std::vector<uint8_t> columns;
+    for (size_t i = 0; i < nPosToCopy; ++i) {
+        columns.push_back(i);
     }
-    FieldsSorter sorter(fields);
-    std::sort(rowsToSort.begin(), rowsToSort.end(), std::ref(sorter));
+    BindingsView view(std::move(rows), std::move(columns));
+    view.sortBy(fields);
+    return view;
+}
+
+TupleTable *BindingsTable::sortBy(std::vector<uint8_t> &fields) {
+    BindingsView view = sortedView(fields);
 
     //Create a TupleTable and return it
     TupleTable *outputTable = new TupleTable(nPosToCopy);
-    for (std::vector<BindingsRow>::iterator itr = rowsToSort.begin(); itr != rowsToSort.end();
-            ++itr) {
-        outputTable->addRow((uint64_t*)itr->row);
+    uint64_t row[256];
+    for (size_t i = 0; i < view.getNRows(); ++i) {
+        view.copyRow(i, row);
+        outputTable->addRow(row);
     }
     return outputTable;
 }
 
-TupleTable *BindingsTable::projectAndFilter(const Literal &l, const std::vector<uint8_t> *posToFilter,
-        const std::vector<Term_t> *valuesToFilter) {
-    uint8_t vars[256];
+BindingsView BindingsTable::projectionView(const Literal &l) {
+    std::vector<uint8_t> vars;
     uint8_t consts[256];
+    Term_t constValues[256];
     uint8_t nconsts = 0;
-    uint8_t nvars = 0;
-    uint64_t currentRow[256];	// Not Term_t; used in trident api.
-
-    for (int i = 0; i < l.getTupleSize(); ++i) {
+    for (size_t i = 0; i < l.getTupleSize(); ++i) {
         if (l.getTermAtPos(i).isVariable()) {
-            vars[nvars++] = i;
+            vars.push_back(i);
         } else {
-            consts[nconsts++] = i;
+            consts[nconsts] = i;
+            constValues[nconsts++] = l.getTermAtPos(i).getValue();
         }
     }
-    TupleTable *output = new TupleTable(nvars);
-#if DEBUG
-    bool warn_done = false;
-#endif
-    for (size_t i = 0; i < uniqueElements.size(); ++i) {
-        Term_t *row = rawBindings->getOffset(i * nPosToCopy);
+
+    std::vector<const Term_t*> rows;
+    if (nconsts == 0) {
+        rows.reserve(nTuples);
+    }
+    for (size_t i = 0; i < nTuples; ++i) {
+        const Term_t *row = getTuple(i);
         bool ok = true;
         for (int j = 0; j < nconsts; ++j) {
-            if (row[consts[j]] != l.getTermAtPos(consts[j]).getValue()) {
+            if (row[consts[j]] != constValues[j]) {
                 ok = false;
                 break;
             }
         }
+        if (ok) {
+            rows.push_back(row);
+        }
+    }
+    return BindingsView(std::move(rows), std::move(vars));
+}
 
-        //check the variables
-        if (ok && posToFilter != NULL && posToFilter->size() != 0) {
-            ok = false;
-            const size_t sizePosToFilter = posToFilter->size();
-            const size_t sizeValuesToFilter = valuesToFilter->size();
-            std::unique_ptr<uint8_t> copyPosToFilter = std::unique_ptr<uint8_t>(new uint8_t[sizePosToFilter]);
+TupleTable *BindingsTable::projectAndFilter(const Literal &l, const std::vector<uint8_t> *posToFilter,
+        const std::vector<Term_t> *valuesToFilter) {
+    BindingsView view = projectionView(l);
+    TupleTable *output = new TupleTable(view.getSizeRow());
+    uint64_t currentRow[256];	// Not Term_t; used in trident api.
 
-#if DEBUG
-	    if (! warn_done) {
-		LOG(DEBUGL) << "Performing linear search (bindingsTable::projectAndFilter). Perhaps this should be optimized";
-		LOG(DEBUGL) << "size = " << sizeValuesToFilter / sizePosToFilter;
-		warn_done = true;
-	    }
-#endif
-            for (int m = 0; m < sizePosToFilter; ++m) {
-                copyPosToFilter.get()[m] = posToFilter->at(m);
-            }
+    if (posToFilter == NULL || posToFilter->size() == 0) {
+        for (size_t i = 0; i < view.getNRows(); ++i) {
+            view.copyRow(i, currentRow);
+            output->addRow(currentRow);
+        }
+        return output;
+    }
 
-            for (size_t j = 0; j < sizeValuesToFilter && !ok; j += sizePosToFilter) {
-                bool okRow = true;
-                for (int m = 0; m < sizePosToFilter; ++m) {
-                    if (row[copyPosToFilter.get()[m]] != valuesToFilter->at(j + m)) {
-                        okRow = false;
-                        break;
-                    }
-                }
-                if (okRow) {
-                    ok = true;
-                }
+    //Put the values to filter in a hash table
+    const size_t sizePosToFilter = posToFilter->size();
+    BindingsTable filterSet(sizePosToFilter);
+    filterSet.addRows(valuesToFilter->data(),
+            valuesToFilter->size() / sizePosToFilter);
+
+    //posToFilter refers to the positions of the tuples, as the constants
+    //of l
+    Term_t key[256];
+    for (size_t i = 0; i < nTuples; ++i) {
+        const Term_t *row = getTuple(i);
+        bool ok = true;
+        for (size_t j = 0; j < l.getTupleSize(); ++j) {
+            const VTerm t = l.getTermAtPos(j);
+            if (!t.isVariable() && row[j] != t.getValue()) {
+                ok = false;
+                break;
             }
         }
-
-        if (ok) {
-            for (int j = 0; j < nvars; ++j)
-                currentRow[j] = row[vars[j]];
+        if (!ok) {
+            continue;
+        }
+        for (size_t m = 0; m < sizePosToFilter; ++m) {
+            key[m] = row[posToFilter->at(m)];
+        }
+        if (filterSet.contains(key)) {
+            uint8_t nvars = 0;
+            for (size_t j = 0; j < l.getTupleSize(); ++j) {
+                if (l.getTermAtPos(j).isVariable()) {
+                    currentRow[nvars++] = row[j];
+                }
+            }
             output->addRow(currentRow);
         }
     }
@@ -270,28 +414,26 @@ TupleTable *BindingsTable::filter(const Literal &l, const std::vector<uint8_t> *
     Term_t consts[256];
     uint8_t posConsts[256];
     uint8_t nconsts = 0;
-    for (int i = 0; i < l.getTupleSize(); ++i) {
+    for (size_t i = 0; i < l.getTupleSize(); ++i) {
         if (!l.getTermAtPos(i).isVariable()) {
             posConsts[nconsts] = i;
             consts[nconsts++] = l.getTermAtPos(i).getValue();
         }
     }
 
-    std::unique_ptr<std::unordered_set<Term_t>> filterSet;
-    if (valuesToFilter != NULL && posToFilter->size() == 1) {
-        filterSet = std::unique_ptr<std::unordered_set<Term_t>>(new std::unordered_set<Term_t>());
-        for (std::vector<Term_t>::const_iterator itr = valuesToFilter->begin();
-                itr != valuesToFilter->end(); ++itr) {
-            filterSet->insert(*itr);
-        }
+    //Put the values to filter in a hash table
+    std::unique_ptr<BindingsTable> filterSet;
+    if (valuesToFilter != NULL && posToFilter != NULL && posToFilter->size() != 0) {
+        filterSet = std::unique_ptr<BindingsTable>(
+                new BindingsTable(posToFilter->size()));
+        filterSet->addRows(valuesToFilter->data(),
+                valuesToFilter->size() / posToFilter->size());
     }
 
     TupleTable *output = new TupleTable(nPosToCopy);
-#if DEBUG
-    bool warn_done = false;
-#endif
-    for (size_t i = 0; i < uniqueElements.size(); ++i) {
-        Term_t *row = rawBindings->getOffset(i * nPosToCopy);
+    Term_t key[256];
+    for (size_t i = 0; i < nTuples; ++i) {
+        const Term_t *row = getTuple(i);
 
         bool ok = true;
         for (int j = 0; j < nconsts; ++j) {
@@ -301,33 +443,11 @@ TupleTable *BindingsTable::filter(const Literal &l, const std::vector<uint8_t> *
             }
         }
 
-        if (ok && posToFilter != NULL && posToFilter->size() != 0) {
-            if (filterSet != NULL) {
-                ok = filterSet->find(row[posToFilter->at(0)]) != filterSet->end();
-            } else {
-                //linear search
-                ok = false;
-#if DEBUG
-		if (! warn_done) {
-		    LOG(DEBUGL) << "Performing linear search (bindingsTable::asTupleTable). Perhaps this should be optimized";
-		    LOG(DEBUGL) << "size = " << valuesToFilter->size() / posToFilter->size();
-		    warn_done = true;
-		}
-#endif
-                const uint8_t sizePosToFilter = (uint8_t) posToFilter->size();
-                for (size_t j = 0; j < valuesToFilter->size() && !ok; j += sizePosToFilter) {
-                    bool okRow = true;
-                    for (int m = 0; m < posToFilter->size(); ++m) {
-                        if (row[posToFilter->at(m)] != valuesToFilter->at(j + m)) {
-                            okRow = false;
-                            break;
-                        }
-                    }
-                    if (okRow) {
-                        ok = true;
-                    }
-                }
+        if (ok && filterSet != NULL) {
+            for (size_t m = 0; m < posToFilter->size(); ++m) {
+                key[m] = row[posToFilter->at(m)];
             }
+            ok = filterSet->contains(key);
         }
 
         if (ok) {
@@ -339,7 +459,7 @@ TupleTable *BindingsTable::filter(const Literal &l, const std::vector<uint8_t> *
 		rc[i] = row[i];
 	    }
             output->addRow(rc);
-	    delete rc;
+	    delete[] rc;
 #endif
 	}
     }
@@ -347,58 +467,49 @@ TupleTable *BindingsTable::filter(const Literal &l, const std::vector<uint8_t> *
 }
 
 std::vector<Term_t> BindingsTable::getProjection(std::vector<uint8_t> pos) {
-    size_t size = uniqueElements.size();
     std::vector<Term_t> outputVector;
-    for (int i = 0; i < size; ++i) {
-        Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
+    outputVector.reserve(nTuples * pos.size());
+    for (size_t i = 0; i < nTuples; ++i) {
+        const Term_t *startTuple = getTuple(i);
         for (std::vector<uint8_t>::iterator itr = pos.begin(); itr != pos.end();
                 ++itr) {
-            outputVector.push_back(*(startTuple + *itr));
+            outputVector.push_back(startTuple[*itr]);
         }
-        startTuple += nPosToCopy;
     }
     return outputVector;
 }
 
 std::vector<Term_t> BindingsTable::getUniqueSortedProjection(std::vector<uint8_t> pos) {
-    size_t size = uniqueElements.size();
     std::vector<Term_t> outputVector;
 
     if (pos.size() == 1) {
         const uint8_t p = pos[0];
-        for (int i = 0; i < size; ++i) {
-            Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
-            outputVector.push_back(startTuple[p]);
+        outputVector.reserve(nTuples);
+        for (size_t i = 0; i < nTuples; ++i) {
+            outputVector.push_back(getTuple(i)[p]);
         }
         sort(outputVector.begin(), outputVector.end());
-        unique(outputVector.begin(), outputVector.end());
+        outputVector.erase(unique(outputVector.begin(), outputVector.end()),
+                outputVector.end());
     } else if (pos.size() == 2) {
         std::vector<std::pair<Term_t, Term_t>> pairs;
         const uint8_t p1 = pos[0];
         const uint8_t p2 = pos[1];
-        for (int i = 0; i < size; ++i) {
-            Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
+        pairs.reserve(nTuples);
+        for (size_t i = 0; i < nTuples; ++i) {
+            const Term_t *startTuple = getTuple(i);
             pairs.push_back(std::make_pair(startTuple[p1], startTuple[p2]));
         }
         sort(pairs.begin(), pairs.end());
-        outputVector.push_back(pairs[0].first);
-        outputVector.push_back(pairs[0].second);
-        for (int i = 1; i < size; ++i) {
-            if (pairs[i].first > pairs[i - 1].first || (pairs[i].first == pairs[i - 1].first && pairs[i].second > pairs[i - 1].second)) {
+        for (size_t i = 0; i < pairs.size(); ++i) {
+            if (i == 0 || pairs[i] != pairs[i - 1]) {
                 outputVector.push_back(pairs[i].first);
                 outputVector.push_back(pairs[i].second);
             }
         }
     } else {
         //not yet supported. TODO
-        for (int i = 0; i < size; ++i) {
-            Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
-            for (std::vector<uint8_t>::iterator itr = pos.begin(); itr != pos.end();
-                    ++itr) {
-                outputVector.push_back(*(startTuple + *itr));
-            }
-            startTuple += nPosToCopy;
-        }
+        return getProjection(pos);
     }
 
     return outputVector;
@@ -409,18 +520,17 @@ const Term_t *BindingsTable::getTuple(size_t idx) {
     if (rawBindings == NULL)
         return EMPTY_TUPLE;
     else
-        return rawBindings->getOffset(idx * nPosToCopy);
+        return getRow(idx);
 }
 
 size_t BindingsTable::getNTuples() {
-    return uniqueElements.size();
+    return nTuples;
 }
 
 void BindingsTable::print() {
-    size_t size = uniqueElements.size();
-    for (int i = 0; i < size; ++i) {
-        Term_t *startTuple = rawBindings->getOffset(i * nPosToCopy);
-        for (int j = 0; j < nPosToCopy; ++j)
+    for (size_t i = 0; i < nTuples; ++i) {
+        const Term_t *startTuple = getTuple(i);
+        for (size_t j = 0; j < nPosToCopy; ++j)
             std::cout << startTuple[j] << " ";
         std::cout << std::endl;
     }
@@ -428,12 +538,7 @@ void BindingsTable::print() {
 
 #ifdef DEBUG
 void BindingsTable::statistics() {
-    /*
-    size_t nbuckets = uniqueElements.bucket_count();
-    for (size_t i = 0; i < nbuckets; i++) {
-	LOG(DEBUGL) << "Size bucket " << i << ": " << uniqueElements.bucket_size(i);
-    }
-    */
+    LOG(DEBUGL) << "BindingsTable: " << nTuples << " tuples, " << slots.size() << " slots";
 }
 #endif
 
@@ -0,0 +1,271 @@
+#include <vlog/concurrentdict.h>
+#include <vlog/hash.h>
+
+#include <kognac/logs.h>
+
+#include <algorithm>
+
+ConcurrentDictionary::ConcurrentDictionary(const uint64_t startingCounter) :
+    startingCounter(startingCounter), counter(startingCounter),
+    directory(new std::atomic<std::atomic<const char*>*>[CDICT_DIR_BLOCKS]),
+    nDirBlocks(0) {
+        for (size_t i = 0; i < CDICT_DIR_BLOCKS; ++i) {
+            directory[i].store(NULL);
+        }
+    }
+
+ConcurrentDictionary::~ConcurrentDictionary() {
+    for (size_t i = 0; i < CDICT_DIR_BLOCKS; ++i) {
+        delete[] directory[i].load();
+    }
+}
+
+uint64_t ConcurrentDictionary::hash(const char *text, const size_t len) {
+    //The finalizer spreads the bits used for the shards
+    return VLogHash::mix(VLogHash::fnvString(text, len));
+}
+
+const char *ConcurrentDictionary::find(const Shard &shard, const char *text,
+        const size_t len, const uint64_t h) const {
+    const size_t mask = shard.slots.size() - 1;
+    size_t pos = h & mask;
+    while (shard.slots[pos] != NULL) {
+        const char *record = shard.slots[pos];
+        if (shard.hashes[pos] == (uint32_t) h && getRecordLen(record) == len
+                && memcmp(record + 12, text, len) == 0) {
+            return record;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return NULL;
+}
+
+const char *ConcurrentDictionary::insert(Shard &shard, const char *text,
+        const size_t len, const uint64_t h) {
+    if (len > UINT32_MAX) {
+        LOG(ERRORL) << "Term too long for the dictionary";
+        throw 10;
+    }
+    //Copy the string in the arena
+    const size_t recordSize = 12 + len;
+    if (shard.blockUsed + recordSize > shard.blockSize) {
+        //The blocks start small, so that shards with few strings do not
+        //waste memory, and double up to CDICT_ARENA_BLOCK
+        const size_t size = std::max(recordSize, std::min(
+                    std::max(shard.blockSize * 2, (size_t) 4096),
+                    (size_t) CDICT_ARENA_BLOCK));
+        shard.blocks.push_back(std::unique_ptr<char[]>(new char[size]));
+        shard.blockUsed = 0;
+        shard.blockSize = size;
+        shard.arenaBytes += size;
+    }
+    char *record = shard.blocks.back().get() + shard.blockUsed;
+    shard.blockUsed += recordSize;
+    const uint64_t id = counter++;
+    const uint32_t l = len;
+    memcpy(record, &id, 8);
+    memcpy(record + 8, &l, 4);
+    memcpy(record + 12, text, len);
+    setRecord(id - startingCounter, record);
+
+    //Keep the table at most half full
+    if ((shard.nentries + 1) * 2 > shard.slots.size()) {
+        std::vector<const char*> slots(shard.slots.size() * 2, NULL);
+        std::vector<uint32_t> hashes(slots.size(), 0);
+        const size_t mask = slots.size() - 1;
+        for (size_t i = 0; i < shard.slots.size(); ++i) {
+            if (shard.slots[i] != NULL) {
+                const char *r = shard.slots[i];
+                size_t pos = hash(r + 12, getRecordLen(r)) & mask;
+                while (slots[pos] != NULL) {
+                    pos = (pos + 1) & mask;
+                }
+                slots[pos] = r;
+                hashes[pos] = shard.hashes[i];
+            }
+        }
+        shard.slots.swap(slots);
+        shard.hashes.swap(hashes);
+    }
+    const size_t mask = shard.slots.size() - 1;
+    size_t pos = h & mask;
+    while (shard.slots[pos] != NULL) {
+        pos = (pos + 1) & mask;
+    }
+    shard.slots[pos] = record;
+    shard.hashes[pos] = (uint32_t) h;
+    shard.nentries++;
+    return record;
+}
+
+void ConcurrentDictionary::setRecord(const uint64_t idx, const char *record) {
+    const uint64_t b = idx >> CDICT_DIR_BITS;
+    if (b >= CDICT_DIR_BLOCKS) {
+        LOG(ERRORL) << "Too many terms in the dictionary";
+        throw 10;
+    }
+    std::atomic<const char*> *block = directory[b].load(
+            std::memory_order_acquire);
+    if (block == NULL) {
+        //Several threads may allocate the block: only one of them wins
+        std::atomic<const char*> *newBlock =
+            new std::atomic<const char*>[1 << CDICT_DIR_BITS];
+        for (size_t i = 0; i < (1 << CDICT_DIR_BITS); ++i) {
+            newBlock[i].store(NULL, std::memory_order_relaxed);
+        }
+        if (directory[b].compare_exchange_strong(block, newBlock)) {
+            block = newBlock;
+            nDirBlocks++;
+        } else {
+            delete[] newBlock;
+        }
+    }
+    block[idx & ((1 << CDICT_DIR_BITS) - 1)].store(record,
+            std::memory_order_release);
+}
+
+const char *ConcurrentDictionary::getRecord(const Term_t id) const {
+    if (id < startingCounter) {
+        return NULL;
+    }
+    const uint64_t idx = id - startingCounter;
+    const uint64_t b = idx >> CDICT_DIR_BITS;
+    if (b >= CDICT_DIR_BLOCKS) {
+        return NULL;
+    }
+    const std::atomic<const char*> *block = directory[b].load(
+            std::memory_order_acquire);
+    if (block == NULL) {
+        return NULL;
+    }
+    return block[idx & ((1 << CDICT_DIR_BITS) - 1)].load(
+            std::memory_order_acquire);
+}
+
+bool ConcurrentDictionary::get(const char *text, const size_t len, Term_t &id) {
+    const uint64_t h = hash(text, len);
+    Shard &shard = getShard(h);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const char *record = find(shard, text, len, h);
+    if (record) {
+        id = getRecordID(record);
+        return true;
+    }
+    return false;
+}
+
+Term_t ConcurrentDictionary::getOrAdd(const char *text, const size_t len) {
+    const uint64_t h = hash(text, len);
+    Shard &shard = getShard(h);
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    const char *record = find(shard, text, len, h);
+    if (!record) {
+        record = insert(shard, text, len, h);
+    }
+    return getRecordID(record);
+}
+
+size_t ConcurrentDictionary::get(const std::vector<Text> &terms,
+        std::vector<Term_t> &ids, std::vector<bool> &found) {
+    ids.resize(terms.size());
+    found.assign(terms.size(), false);
+    //Group the terms by shard
+    std::vector<uint64_t> hashes(terms.size());
+    std::vector<size_t> starts(CDICT_NSHARDS + 1, 0);
+    for (size_t i = 0; i < terms.size(); ++i) {
+        hashes[i] = hash(terms[i].first, terms[i].second);
+        starts[((hashes[i] >> 40) & (CDICT_NSHARDS - 1)) + 1]++;
+    }
+    for (size_t s = 0; s < CDICT_NSHARDS; ++s) {
+        starts[s + 1] += starts[s];
+    }
+    std::vector<size_t> order(terms.size());
+    std::vector<size_t> next(starts.begin(), starts.end() - 1);
+    for (size_t i = 0; i < terms.size(); ++i) {
+        order[next[(hashes[i] >> 40) & (CDICT_NSHARDS - 1)]++] = i;
+    }
+
+    size_t nfound = 0;
+    for (size_t s = 0; s < CDICT_NSHARDS; ++s) {
+        if (starts[s] == starts[s + 1]) {
+            continue;
+        }
+        Shard &shard = shards[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        for (size_t j = starts[s]; j < starts[s + 1]; ++j) {
+            const size_t i = order[j];
+            const char *record = find(shard, terms[i].first, terms[i].second,
+                    hashes[i]);
+            if (record) {
+                ids[i] = getRecordID(record);
+                found[i] = true;
+                nfound++;
+            }
+        }
+    }
+    return nfound;
+}
+
+void ConcurrentDictionary::getOrAdd(const std::vector<Text> &terms,
+        std::vector<Term_t> &ids) {
+    std::vector<bool> found;
+    if (get(terms, ids, found) == terms.size()) {
+        return;
+    }
+    //Another thread may have added some of them in the meantime, so they
+    //are looked up again
+    for (size_t i = 0; i < terms.size(); ++i) {
+        if (!found[i]) {
+            ids[i] = getOrAdd(terms[i].first, terms[i].second);
+        }
+    }
+}
+
+bool ConcurrentDictionary::getText(const Term_t id, const char *&text,
+        size_t &len) const {
+    const char *record = getRecord(id);
+    if (record == NULL) {
+        return false;
+    }
+    text = record + 12;
+    len = getRecordLen(record);
+    return true;
+}
+
+void ConcurrentDictionary::getTexts(const std::vector<Term_t> &ids,
+        std::vector<Text> &texts) const {
+    texts.resize(ids.size());
+    for (size_t i = 0; i < ids.size(); ++i) {
+        const char *record = getRecord(ids[i]);
+        if (record) {
+            texts[i] = std::make_pair(record + 12, getRecordLen(record));
+        } else {
+            texts[i] = std::make_pair((const char*) NULL, (size_t) 0);
+        }
+    }
+}
+
+std::string ConcurrentDictionary::getRawValue(const Term_t id) const {
+    const char *text;
+    size_t len;
+    if (getText(id, text, len)) {
+        return std::string(text, len);
+    }
+    return "";
+}
+
+uint64_t ConcurrentDictionary::getMemoryUsage() {
+    uint64_t size = sizeof(ConcurrentDictionary)
+        + CDICT_DIR_BLOCKS * sizeof(std::atomic<std::atomic<const char*>*>)
+        + nDirBlocks.load() * (1 << CDICT_DIR_BITS)
+        * sizeof(std::atomic<const char*>);
+    for (size_t s = 0; s < CDICT_NSHARDS; ++s) {
+        Shard &shard = shards[s];
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        size += shard.arenaBytes;
+        size += shard.slots.capacity() * sizeof(const char*);
+        size += shard.hashes.capacity() * sizeof(uint32_t);
+        size += shard.blocks.capacity() * sizeof(std::unique_ptr<char[]>);
+    }
+    return size;
+}
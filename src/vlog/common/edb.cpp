@@ -20,6 +20,7 @@
 #include <vlog/sparql/sparqltable.h>
 #endif
 #include <vlog/inmemory/inmemorytable.h>
+#include <vlog/inmemory/binarytable.h>
 
 #include <unordered_map>
 #include <climits>
@@ -28,6 +29,7 @@
 EDBLayer::EDBLayer(EDBLayer &db, bool copyTables) {
     this->predDictionary = db.predDictionary;
     this->termsDictionary = db.termsDictionary;
+    this->termsDictionaryPtr = db.termsDictionary.get();
     if (copyTables) {
         this->dbPredicates = db.dbPredicates;
     }
@@ -117,6 +119,46 @@ void EDBLayer::addInmemoryTable(const EDBConf::Table &tableConf) {
     dbPredicates.insert(make_pair(infot.id, infot));
 }
 
+void EDBLayer::addBinaryTable(const EDBConf::Table &tableConf) {
+    EDBInfoTable infot;
+    const std::string pn = tableConf.predname;
+    if (tableConf.params.size() < 2) {
+        std::string error = "The Binary table " + pn + " needs the directory and the name of the relation. Check the edb.conf file.";
+        LOG(ERRORL) << error;
+        throw error;
+    }
+    const std::string dir = tableConf.params[0];
+    //The IDs of the terms are the ones of the dictionary of the database, so
+    //the tables of the same database must be the first ones, and no term can
+    //have been added before
+    std::shared_ptr<BinaryDictionary> dict;
+    for (auto &p : dbPredicates) {
+        BinaryTable *t = dynamic_cast<BinaryTable*>(p.second.manager.get());
+        if (t == NULL || t->getDictionary()->getDirectory() != dir) {
+            std::string error = "The Binary table " + pn + " must precede the other tables, and all Binary tables must be in the same directory. Check the edb.conf file.";
+            LOG(ERRORL) << error;
+            throw error;
+        }
+        dict = t->getDictionary();
+    }
+    if (getTermsDictionary(false) != NULL) {
+        std::string error = "The Binary table " + pn + " is loaded after some terms were added";
+        LOG(ERRORL) << error;
+        throw error;
+    }
+    if (!dict) {
+        dict = std::shared_ptr<BinaryDictionary>(new BinaryDictionary(dir));
+    }
+    infot.id = (PredId_t) predDictionary->getOrAdd(pn);
+    infot.type = tableConf.type;
+    BinaryTable *table = new BinaryTable(dir + "/" + tableConf.params[1] + ".bin",
+            infot.id, dict, this);
+    infot.manager = std::shared_ptr<EDBTable>(table);
+    infot.arity = table->getArity();
+    dbPredicates.insert(make_pair(infot.id, infot));
+    LOG(DEBUGL) << "Inserted " << pn << " with number " << infot.id;
+}
+
 void EDBLayer::addInmemoryTable(std::string predicate, std::vector<std::vector<std::string>> &rows) {
     PredId_t id = (PredId_t) predDictionary->getOrAdd(predicate);
     addInmemoryTable(predicate, id, rows);
@@ -577,6 +619,15 @@ size_t EDBLayer::estimateCardinality(const Literal &query) {
     }
 }
 
+bool EDBLayer::mayContain(const Literal &query) {
+    PredId_t predid = query.getPredicate().getId();
+    if (dbPredicates.count(predid)) {
+        auto p = dbPredicates.find(predid);
+        return p->second.manager->mayContain(query);
+    }
+    return true;
+}
+
 bool EDBLayer::isEmpty(const Literal &query, std::vector<uint8_t> *posToFilter,
         std::vector<Term_t> *valuesToFilter) {
     const Literal *literal = &query;
@@ -853,19 +904,70 @@ std::shared_ptr<Column> EDBLayer::checkIn(
 
 }
 
+ConcurrentDictionary *EDBLayer::getTermsDictionary(const bool create) {
+    ConcurrentDictionary *dict = termsDictionaryPtr.load(
+            std::memory_order_acquire);
+    if (dict == NULL && create) {
+        std::lock_guard<std::mutex> lock(termsDictionaryMutex);
+        if (!termsDictionary.get()) {
+            LOG(DEBUGL) << "The additional terms will start from " << getNTerms();
+            termsDictionary = std::shared_ptr<ConcurrentDictionary>(
+                    new ConcurrentDictionary(getNTerms()));
+        }
+        dict = termsDictionary.get();
+        termsDictionaryPtr.store(dict, std::memory_order_release);
+    }
+    return dict;
+}
+
 bool EDBLayer::getDictNumber(const char *text, const size_t sizeText, uint64_t &id) {
     bool resp = false;
     if (dbPredicates.size() > 0) {
         resp = dbPredicates.begin()->second.manager->
             getDictNumber(text, sizeText, id);
     }
-    if (!resp && termsDictionary.get()) {
-        std::string t(text, sizeText);
-        resp = termsDictionary->get(t, id);
+    ConcurrentDictionary *dict = getTermsDictionary(false);
+    if (!resp && dict) {
+        Term_t t;
+        resp = dict->get(text, sizeText, t);
+        id = t;
     }
     return resp;
 }
 
+size_t EDBLayer::getDictNumbers(
+        const std::vector<ConcurrentDictionary::Text> &terms,
+        std::vector<uint64_t> &ids, std::vector<bool> &found) {
+    ids.resize(terms.size());
+    found.assign(terms.size(), false);
+    size_t nfound = 0;
+    std::vector<ConcurrentDictionary::Text> missing;
+    std::vector<size_t> posMissing;
+    for (size_t i = 0; i < terms.size(); ++i) {
+        if (dbPredicates.size() > 0 && dbPredicates.begin()->second.manager->
+                getDictNumber(terms[i].first, terms[i].second, ids[i])) {
+            found[i] = true;
+            nfound++;
+        } else {
+            missing.push_back(terms[i]);
+            posMissing.push_back(i);
+        }
+    }
+    ConcurrentDictionary *dict = getTermsDictionary(false);
+    if (!missing.empty() && dict) {
+        std::vector<Term_t> newIDs;
+        std::vector<bool> newFound;
+        nfound += dict->get(missing, newIDs, newFound);
+        for (size_t i = 0; i < missing.size(); ++i) {
+            if (newFound[i]) {
+                ids[posMissing[i]] = newIDs[i];
+                found[posMissing[i]] = true;
+            }
+        }
+    }
+    return nfound;
+}
+
 bool EDBLayer::getOrAddDictNumber(const char *text, const size_t sizeText,
         uint64_t &id) {
     bool resp = false;
@@ -874,29 +976,42 @@ bool EDBLayer::getOrAddDictNumber(const char *text, const size_t sizeText,
             getDictNumber(text, sizeText, id);
     }
     if (!resp) {
-        if (!termsDictionary.get()) {
-            LOG(DEBUGL) << "The additional terms will start from " << getNTerms();
-            termsDictionary = std::shared_ptr<Dictionary>(
-                    new Dictionary(getNTerms()));
-        }
-        std::string t(text, sizeText);
-        id = termsDictionary->getOrAdd(t);
-        LOG(TRACEL) << "getOrAddDictNumber \"" << t << "\" returns " << id;
+        id = getTermsDictionary(true)->getOrAdd(text, sizeText);
+        LOG(TRACEL) << "getOrAddDictNumber \"" << std::string(text, sizeText)
+            << "\" returns " << id;
         resp = true;
     }
     return resp;
 }
 
+void EDBLayer::getOrAddDictNumbers(
+        const std::vector<ConcurrentDictionary::Text> &terms,
+        std::vector<uint64_t> &ids) {
+    std::vector<bool> found;
+    if (getDictNumbers(terms, ids, found) == terms.size()) {
+        return;
+    }
+    //The missing terms are added in the order of terms
+    ConcurrentDictionary *dict = getTermsDictionary(true);
+    for (size_t i = 0; i < terms.size(); ++i) {
+        if (!found[i]) {
+            ids[i] = dict->getOrAdd(terms[i].first, terms[i].second);
+        }
+    }
+}
+
 bool EDBLayer::getDictText(const uint64_t id, char *text) {
     bool resp = false;
     if (dbPredicates.size() > 0) {
         resp = dbPredicates.begin()->second.manager->getDictText(id, text);
     }
-    if (!resp && termsDictionary.get()) {
-        std::string t = termsDictionary->getRawValue(id);
-        if (t != "") {
-            memcpy(text, t.c_str(), t.size());
-            text[t.size()] = '\0';
+    ConcurrentDictionary *dict = getTermsDictionary(false);
+    if (!resp && dict) {
+        const char *t;
+        size_t len;
+        if (dict->getText(id, t, len)) {
+            memcpy(text, t, len);
+            text[len] = '\0';
             return true;
         }
     }
@@ -909,8 +1024,9 @@ std::string EDBLayer::getDictText(const uint64_t id) {
     if (dbPredicates.size() > 0) {
         resp = dbPredicates.begin()->second.manager->getDictText(id, t);
     }
-    if (!resp && termsDictionary.get()) {
-        t = termsDictionary->getRawValue(id);
+    ConcurrentDictionary *dict = getTermsDictionary(false);
+    if (!resp && dict) {
+        t = dict->getRawValue(id);
     }
     return t;
 }
@@ -920,12 +1036,18 @@ uint64_t EDBLayer::getNTerms() {
     if (dbPredicates.size() > 0) {
         size = dbPredicates.begin()->second.manager->getNTerms();
     }
-    if (termsDictionary.get()) {
-        size += termsDictionary->size();
+    ConcurrentDictionary *dict = getTermsDictionary(false);
+    if (dict) {
+        size += dict->size();
     }
     return size;
 }
 
+uint64_t EDBLayer::getTermsDictionaryMemory() {
+    ConcurrentDictionary *dict = getTermsDictionary(false);
+    return dict ? dict->getMemoryUsage() : 0;
+}
+
 Predicate EDBLayer::getDBPredicate(int idPredicate) {
     if (!dbPredicates.count(idPredicate)) {
         throw 10; //cannot happen
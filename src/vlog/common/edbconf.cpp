@@ -8,6 +8,7 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
 
 EDBConf::EDBConf(std::string rawcontent, bool isFile) {
     if (isFile) {
@@ -90,18 +91,20 @@ void EDBConf::parse(std::string f) {
                 || tables[i].type == "MySQL"
                 || tables[i].type == "ODBC"
                 || tables[i].type == "MAPI"
-                || tables[i].type == "MDLITE");
+                || tables[i].type == "MDLITE"
+                || tables[i].type == "Binary");
     }
 
+    //The encoded source provides the dictionary, so it must come first
+    std::stable_partition(tables.begin(), tables.end(),
+            [](const Table &t) { return t.encoded; });
+    //All the Binary tables of a database count as one source
     int countEncoded = 0;
-    for (int i = 0; i < tables.size(); i++) {
-        if (tables[i].encoded) {
+    for (int i = 0; i < tables.size() && tables[i].encoded; i++) {
+        if (i == 0 || tables[i].type != "Binary" || tables[0].type != "Binary"
+                || tables[i].params.empty() || tables[0].params.empty()
+                || tables[i].params[0] != tables[0].params[0]) {
             countEncoded++;
-            if (i > 0) {
-                struct Table temp = tables[0];
-                tables[0] = tables[i];
-                tables[i] = temp;
-            }
         }
     }
     if (countEncoded > 1) {
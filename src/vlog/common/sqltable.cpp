@@ -1,10 +1,17 @@
 #include <sstream>
 #include <string>
+#include <set>
+#include <algorithm>
 
 #include <vlog/sqltable.h>
 #include <vlog/inmemory/inmemorytable.h>
 
+std::list<std::pair<SQLTable*, std::string>> SQLTable::lru;
+size_t SQLTable::cachedTerms = 0;
+std::mutex SQLTable::cacheMutex;
+
 SQLTable::SQLTable(PredId_t predid, std::string name, std::string fieldnames, EDBLayer *layer) :
+    cacheHits(0), cacheMisses(0), tempTableCounter(0),
     predid(predid), tablename(name), layer(layer) {
     std::stringstream ss(fieldnames);
     std::string item;
@@ -59,8 +66,265 @@ std::string SQLTable::repeatedToSQLQuery(const Literal &q) {
     return cond;
 }
 
+std::string SQLTable::getConditions(const Literal &q) {
+    std::string cond = literalConstraintsToSQLQuery(q);
+    std::string cond1 = repeatedToSQLQuery(q);
+    if (cond.empty()) {
+        cond = cond1;
+    } else if (!cond1.empty()) {
+        cond += " and " + cond1;
+    }
+    return cond;
+}
+
+std::shared_ptr<const Segment> SQLTable::getCachedSegment(const std::string &key,
+        const std::vector<uint8_t> &fields) {
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto itr = cache.find(key);
+    if (itr == cache.end()) {
+        return NULL;
+    }
+    lru.splice(lru.begin(), lru, itr->second.lru);
+    if (fields.empty()) {
+        return itr->second.segment;
+    }
+    //A segment sorted by more fields is also sorted by their prefix
+    for (const auto &el : itr->second.sorted) {
+        if (el.first.size() >= fields.size() &&
+                std::equal(fields.begin(), fields.end(), el.first.begin())) {
+            return el.second;
+        }
+    }
+    return NULL;
+}
+
+void SQLTable::addToCache(const std::string &key,
+        const std::vector<uint8_t> &fields,
+        std::shared_ptr<const Segment> segment) {
+    const size_t nterms = segment->getNRows() * arity;
+    if (nterms > SQL_CACHE_MAX_TERMS) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(cacheMutex);
+    auto itr = cache.find(key);
+    if (itr == cache.end()) {
+        lru.push_front(std::make_pair(this, key));
+        CacheEntry entry;
+        entry.lru = lru.begin();
+        entry.nterms = 0;
+        itr = cache.insert(std::make_pair(key, entry)).first;
+    } else {
+        lru.splice(lru.begin(), lru, itr->second.lru);
+    }
+    CacheEntry &entry = itr->second;
+    if (fields.empty()) {
+        if (entry.segment != NULL) {
+            return;
+        }
+        entry.segment = segment;
+    } else {
+        if (entry.sorted.count(fields)) {
+            return;
+        }
+        entry.sorted[fields] = segment;
+    }
+    entry.nterms += nterms;
+    cachedTerms += nterms;
+
+    //Evict the least recently used results, also of the other tables. The
+    //entry just added is the first of the list, so it is never evicted
+    while (cachedTerms > SQL_CACHE_MAX_TERMS && lru.size() > 1) {
+        SQLTable *table = lru.back().first;
+        auto victim = table->cache.find(lru.back().second);
+        cachedTerms -= victim->second.nterms;
+        table->cache.erase(victim);
+        lru.pop_back();
+    }
+}
+
+std::shared_ptr<const Segment> SQLTable::getSegment(const Literal &q,
+        const std::vector<uint8_t> &fields) {
+    const std::string key = getConditions(q);
+    std::shared_ptr<const Segment> segment = getCachedSegment(key, fields);
+    if (segment != NULL) {
+        cacheHits++;
+        return segment;
+    }
+
+    const std::vector<uint8_t> noFields;
+    if (!fields.empty()) {
+        segment = getCachedSegment(key, noFields);
+    }
+    if (segment != NULL) {
+        cacheHits++;
+    } else {
+        cacheMisses++;
+        std::string query = "SELECT DISTINCT * FROM " + tablename;
+        if (!key.empty()) {
+            query += " WHERE " + key;
+        }
+        SegmentInserter inserter(arity);
+        executeQuery(query, &inserter);
+        segment = inserter.getSegment();
+        addToCache(key, noFields, segment);
+    }
+
+    //The rows are sorted here, and not with an ORDER BY, because VLog
+    //sorts on the numbers of the terms, which do not follow the order of
+    //their strings
+    if (!fields.empty()) {
+        segment = segment->sortBy(&fields);
+        addToCache(key, fields, segment);
+    }
+    return segment;
+}
+
+//Drops the temporary table of a filter when it goes out of scope, also if
+//the query that uses it fails
+class SQLTempTable {
+    private:
+        SQLTable *table;
+        const std::string name;
+
+    public:
+        SQLTempTable(SQLTable *table, const std::string &name) :
+            table(table), name(name) {
+        }
+
+        ~SQLTempTable() {
+            if (name.empty()) {
+                return;
+            }
+            try {
+                if (!table->executeUpdate("DROP TABLE " + name)) {
+                    LOG(WARNL) << "Could not drop the table " << name;
+                }
+            } catch (int e) {
+                LOG(WARNL) << "Could not drop the table " << name;
+            }
+        }
+};
+
+bool SQLTable::filterToSQL(const std::vector<uint8_t> &pos,
+        const std::vector<Term_t> &values, std::string &from,
+        std::string &cond, std::string &tmpTable) {
+    const size_t ntuples = values.size() / pos.size();
+    if (!cond.empty()) {
+        cond += " AND ";
+    }
+
+    if (ntuples <= TEMP_TABLE_THRESHOLD) {
+        if (pos.size() == 1) {
+            cond += fieldTables[pos[0]] + " IN (";
+            for (size_t t = 0; t < ntuples; ++t) {
+                if (t > 0) {
+                    cond += ",";
+                }
+                cond += mapToField(values[t], pos[0]);
+            }
+            cond += ")";
+        } else {
+            cond += "(";
+            for (size_t t = 0; t < ntuples; ++t) {
+                if (t > 0) {
+                    cond += " OR ";
+                }
+                cond += "(";
+                for (size_t i = 0; i < pos.size(); ++i) {
+                    std::string pref = i > 0 ? " AND " : "";
+                    cond += pref + fieldTables[pos[i]] + " = " +
+                        mapToField(values[t * pos.size() + i], pos[i]);
+                }
+                cond += ")";
+            }
+            cond += ")";
+        }
+        return true;
+    }
+
+    //Too many values for the query: load them in a temporary table. Its
+    //columns are created from the ones of the table, so that they get
+    //their types
+    tmpTable = "vlog_tmp_" + std::to_string(predid) + "_" +
+        std::to_string(tempTableCounter++);
+    std::string columns = "";
+    for (size_t i = 0; i < pos.size(); ++i) {
+        if (i > 0) {
+            columns += ", ";
+        }
+        columns += fieldTables[pos[i]] + " AS vlog_c" + std::to_string(i);
+    }
+    if (!executeUpdate(createTempTableSQL(tmpTable, "SELECT " + columns +
+                    " FROM " + tablename + " WHERE 1=0"))) {
+        tmpTable = "";
+        return false;
+    }
+    for (size_t start = 0; start < ntuples; start += TEMP_TABLE_INSERT_ROWS) {
+        const size_t end = std::min(ntuples, start + TEMP_TABLE_INSERT_ROWS);
+        std::string insert = "INSERT INTO " + tmpTable + " VALUES ";
+        for (size_t t = start; t < end; ++t) {
+            insert += t > start ? ",(" : "(";
+            for (size_t i = 0; i < pos.size(); ++i) {
+                if (i > 0) {
+                    insert += ",";
+                }
+                insert += mapToField(values[t * pos.size() + i], pos[i]);
+            }
+            insert += ")";
+        }
+        bool loaded;
+        try {
+            loaded = executeUpdate(insert);
+        } catch (int e) {
+            loaded = false;
+        }
+        if (!loaded) {
+            LOG(WARNL) << "Could not load the values to filter in " << tmpTable;
+            SQLTempTable dropTmpTable(this, tmpTable);
+            tmpTable = "";
+            return false;
+        }
+    }
+    from += ", " + tmpTable;
+    for (size_t i = 0; i < pos.size(); ++i) {
+        if (i > 0) {
+            cond += " AND ";
+        }
+        cond += fieldTables[pos[i]] + "=" + tmpTable + ".vlog_c" +
+            std::to_string(i);
+    }
+    LOG(DEBUGL) << "Loaded " << ntuples << " values to filter in " << tmpTable;
+    return true;
+}
+
+std::shared_ptr<const Segment> SQLTable::executeFilter(const Literal &q,
+        const std::vector<uint8_t> &pos, const std::vector<Term_t> &values) {
+    std::string from = tablename;
+    std::string cond = getConditions(q);
+    std::string tmpTable;
+    if (!filterToSQL(pos, values, from, cond, tmpTable)) {
+        return NULL;
+    }
+    SQLTempTable dropTmpTable(this, tmpTable);
+    std::string query = "SELECT DISTINCT " + tablename + ".* FROM " + from +
+        " WHERE " + cond;
+    SegmentInserter inserter(arity);
+    executeQuery(query, &inserter);
+    return inserter.getSegment();
+}
+
 size_t SQLTable::getCardinality(const Literal &q) {
     LOG(DEBUGL) << "getCardinality: query = " << q.tostring(NULL, layer);
+    //The cached results are distinct, as the ones counted with conditions
+    const std::string key = getConditions(q);
+    if (!key.empty()) {
+        const std::vector<uint8_t> noFields;
+        std::shared_ptr<const Segment> segment = getCachedSegment(key, noFields);
+        if (segment != NULL) {
+            cacheHits++;
+            return segment->getNRows();
+        }
+    }
     std::string query = "SELECT COUNT(*) from ";
     std::string cond = literalConstraintsToSQLQuery(q);
     std::string cond1 = repeatedToSQLQuery(q);
@@ -134,39 +398,18 @@ bool SQLTable::isEmpty(const Literal &q, std::vector<uint8_t> *posToFilter,
     return result == 0;
 }
 
-SegmentInserter *SQLTable::getInserter(const Literal &q) {
-    std::string cond = literalConstraintsToSQLQuery(q);
-    std::string cond1 = repeatedToSQLQuery(q);
-    if (cond.empty()) {
-	cond = cond1;
-    } else if (!cond1.empty()) {
-	cond += " and " + cond1;
-    }
-    std::string query = "SELECT DISTINCT * FROM " + tablename;
-    if (!cond.empty()) {
-	query += " WHERE " + cond;
-    }
-    SegmentInserter *inserter = new SegmentInserter(arity);
-    executeQuery(query, inserter);
-    return inserter;
-}
-
 EDBIterator *SQLTable::getIterator(const Literal &q) {
     std::vector<uint8_t> sortFields;
-    // TODO: caching
     if (q.getTupleSize() != arity) {
         return new InmemoryIterator(NULL, predid, sortFields);
     }
     LOG(DEBUGL) << "getIterator: query = " << q.tostring(NULL, layer);
-    SegmentInserter *inserter = getInserter(q);
-    std::shared_ptr<const Segment> segment = inserter->getSegment();
-    delete inserter;
+    std::shared_ptr<const Segment> segment = getSegment(q, sortFields);
     return new InmemoryIterator(segment, predid, sortFields);
 }
 
 EDBIterator *SQLTable::getSortedIterator(const Literal &q,
         const std::vector<uint8_t> &fields) {
-    // TODO: caching
     // Awful semantics: "fields" counts the variable numbers, not the actual fields of the literal...
     std::vector<uint8_t> offsets;
     int nConstantsSeen = 0;
@@ -188,15 +431,102 @@ EDBIterator *SQLTable::getSortedIterator(const Literal &q,
         return new InmemoryIterator(NULL, predid, newFields);
     }
     LOG(DEBUGL) << "getSortedIterator: query = " << q.tostring(NULL, layer);
-    SegmentInserter *inserter = getInserter(q);
-    std::shared_ptr<const Segment> segment = inserter->getSegment();
-    delete inserter;
-    segment = segment->sortBy(&newFields);
+    std::shared_ptr<const Segment> segment = getSegment(q, newFields);
     return new InmemoryIterator(segment, predid, newFields);
 }
 
-// If valuesToFilter is larger than this, we should filter ourselves. TODO.
-#define TEMP_TABLE_THRESHOLD (2*3*4*5*7*11)
+std::shared_ptr<Column> SQLTable::checkIn(
+        std::vector<Term_t> &values,
+        const Literal &l,
+        uint8_t posInL,
+        size_t &sizeOutput) {
+    //If the rows of l are cached, a merge with them costs less than a query
+    const std::vector<uint8_t> noFields;
+    if (values.empty() || l.getTupleSize() != arity ||
+            getCachedSegment(getConditions(l), noFields) != NULL) {
+        return EDBTable::checkIn(values, l, posInL, sizeOutput);
+    }
+    LOG(DEBUGL) << "checkIn: query = " << l.tostring(NULL, layer)
+        << ", values = " << values.size();
+    std::vector<uint8_t> pos;
+    pos.push_back(posInL);
+    std::shared_ptr<const Segment> segment = executeFilter(l, pos, values);
+    if (segment == NULL) {
+        return EDBTable::checkIn(values, l, posInL, sizeOutput);
+    }
+    std::vector<Term_t> found;
+    if (!segment->isEmpty()) {
+        found = segment->getColumn(posInL)->getReader()->asVector();
+        std::sort(found.begin(), found.end());
+        found.erase(std::unique(found.begin(), found.end()), found.end());
+    }
+    sizeOutput = found.size();
+    return ColumnWriter::getColumn(found, true);
+}
+
+std::vector<std::shared_ptr<Column>> SQLTable::checkNewIn(
+        std::vector<std::shared_ptr<Column>> &checkValues,
+        const Literal &l,
+        std::vector<uint8_t> &posInL) {
+    const std::vector<uint8_t> noFields;
+    if (checkValues.empty() || checkValues[0]->isEmpty() ||
+            l.getTupleSize() != arity ||
+            getCachedSegment(getConditions(l), noFields) != NULL) {
+        return EDBTable::checkNewIn(checkValues, l, posInL);
+    }
+
+    //Collect the tuples to check, without the consecutive duplicates
+    const size_t sz = checkValues.size();
+    std::vector<std::unique_ptr<ColumnReader>> readers;
+    for (size_t i = 0; i < sz; ++i) {
+        readers.push_back(checkValues[i]->getReader());
+    }
+    std::vector<Term_t> values;
+    while (readers[0]->hasNext()) {
+        const size_t start = values.size();
+        for (size_t i = 0; i < sz; ++i) {
+            values.push_back(readers[i]->next());
+        }
+        if (start > 0 && std::equal(values.begin() + start, values.end(),
+                    values.begin() + start - sz)) {
+            values.resize(start);
+        }
+    }
+    LOG(DEBUGL) << "checkNewIn: query = " << l.tostring(NULL, layer)
+        << ", tuples = " << values.size() / sz;
+
+    std::shared_ptr<const Segment> segment = executeFilter(l, posInL, values);
+    if (segment == NULL) {
+        return EDBTable::checkNewIn(checkValues, l, posInL);
+    }
+    std::set<std::vector<Term_t>> existing;
+    std::unique_ptr<SegmentIterator> itr = segment->iterator();
+    while (itr->hasNext()) {
+        itr->next();
+        std::vector<Term_t> tuple(sz);
+        for (size_t i = 0; i < sz; ++i) {
+            tuple[i] = itr->get(posInL[i]);
+        }
+        existing.insert(tuple);
+    }
+
+    std::vector<ColumnWriter> cols(sz);
+    std::vector<Term_t> tuple(sz);
+    for (size_t start = 0; start < values.size(); start += sz) {
+        std::copy(values.begin() + start, values.begin() + start + sz,
+                tuple.begin());
+        if (!existing.count(tuple)) {
+            for (size_t i = 0; i < sz; ++i) {
+                cols[i].add(tuple[i]);
+            }
+        }
+    }
+    std::vector<std::shared_ptr<Column>> output;
+    for (auto &el : cols) {
+        output.push_back(el.getColumn());
+    }
+    return output;
+}
 
 void SQLTable::query(QSQQuery *query, TupleTable *outputTable,
                        std::vector<uint8_t> *posToFilter,
@@ -210,52 +540,34 @@ void SQLTable::query(QSQQuery *query, TupleTable *outputTable,
     if (posToFilter == NULL || posToFilter->size() == 0) {
 	iter = getIterator(*l);
     } else {
-	//Create first part of query.
-	std::string sqlQuery = "SELECT DISTINCT * FROM " + tablename;
-	if (valuesToFilter->size() > TEMP_TABLE_THRESHOLD) {
-	    // TODO
-	    LOG(ERRORL) << "Not implemented: SQLTable::query with many values to filter.";
-	    throw 10;
-	}
-	sqlQuery += " WHERE ";
-	std::string cond = literalConstraintsToSQLQuery(*l);
-	if (!cond.empty()) {
-	    sqlQuery += cond;
-	}
-
-	std::string cond1 = repeatedToSQLQuery(*l);
-	if (!cond1.empty()) {
-	    if (!cond.empty()) {
-		sqlQuery += " AND ";
-	    }
-	    sqlQuery += cond1;
-	}
-     
-	if (!cond1.empty() || !cond.empty()) {
-	    sqlQuery += " AND ";
+	std::vector<uint8_t> noFields;
+	std::shared_ptr<const Segment> segment;
+	if (getCachedSegment(getConditions(*l), noFields) == NULL) {
+	    segment = executeFilter(*l, *posToFilter, *valuesToFilter);
 	}
-
-	bool first = true;
-	sqlQuery += "(";
-	for (std::vector<Term_t>::iterator itr = valuesToFilter->begin();
-		itr != valuesToFilter->end();) {
-	    if (! first) {
-		sqlQuery += " OR ";
+	if (segment == NULL) {
+	    //The rows of the literal are cached, or there are too many values
+	    //for the query and no temporary tables: filter the rows here
+	    std::set<std::vector<Term_t>> toFilter;
+	    for (size_t i = 0; i < valuesToFilter->size(); i += posToFilter->size()) {
+		toFilter.insert(std::vector<Term_t>(valuesToFilter->begin() + i,
+			    valuesToFilter->begin() + i + posToFilter->size()));
 	    }
-	    sqlQuery += "(";
-	    for (int i = 0; i < posToFilter->size(); i++, itr++) {
-		std::string pref = i > 0 ? " AND " : "";
-		uint8_t pos = posToFilter->at(i);
-		sqlQuery += pref + fieldTables[pos] + " = " + mapToField(*itr, pos);
+	    std::shared_ptr<const Segment> all = getSegment(*l, noFields);
+	    SegmentInserter inserter(arity);
+	    std::unique_ptr<SegmentIterator> itr = all->iterator();
+	    std::vector<Term_t> key(posToFilter->size());
+	    while (itr->hasNext()) {
+		itr->next();
+		for (int i = 0; i < posToFilter->size(); i++) {
+		    key[i] = itr->get(posToFilter->at(i));
+		}
+		if (toFilter.count(key)) {
+		    inserter.addRow(*itr);
+		}
 	    }
-	    sqlQuery += ")";
-	    first = false;
+	    segment = inserter.getSegment();
 	}
-	sqlQuery += ")";
-	SegmentInserter *inserter = new SegmentInserter(arity);
-	executeQuery(sqlQuery, inserter);
-	std::shared_ptr<const Segment> segment = inserter->getSegment();
-	delete inserter;
 	std::vector<uint8_t> sortFields;
 	iter = new InmemoryIterator(segment, predid, sortFields);
     }
@@ -288,3 +600,15 @@ size_t SQLTable::estimateCardinality(const Literal &query) {
 void SQLTable::releaseIterator(EDBIterator *itr) {
     delete itr;
 }
+
+SQLTable::~SQLTable() {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        for (const auto &el : cache) {
+            cachedTerms -= el.second.nterms;
+            lru.erase(el.second.lru);
+        }
+    }
+    LOG(DEBUGL) << "Cache of the SQL table " << tablename << ": "
+        << cacheHits.load() << " hits, " << cacheMisses.load() << " misses";
+}
@@ -0,0 +1,65 @@
+#include <vlog/arena.h>
+
+#include <kognac/logs.h>
+
+#include <algorithm>
+
+void Arena::newChunk(const size_t minCapacity) {
+    //Large allocations get a chunk of their own, which is not recycled
+    if (minCapacity > ARENA_CHUNK_TERMS) {
+        chunks.push_back(std::shared_ptr<ArenaChunk>(new ArenaChunk(minCapacity)));
+    } else if (!freeChunks.empty()) {
+        chunks.push_back(freeChunks.back());
+        freeChunks.pop_back();
+    } else {
+        chunks.push_back(std::shared_ptr<ArenaChunk>(
+                    new ArenaChunk(ARENA_CHUNK_TERMS)));
+    }
+    used = 0;
+}
+
+Term_t *Arena::allocate(const size_t n, std::shared_ptr<ArenaChunk> &chunk) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (chunks.empty() || used + n > chunks.back()->capacity) {
+        newChunk(n);
+    }
+    chunk = chunks.back();
+    Term_t *out = chunk->data.get() + used;
+    used += n;
+    allocatedTerms += n;
+    return out;
+}
+
+bool Arena::extend(const Term_t *ptr, const size_t oldn, const size_t newn) {
+    std::lock_guard<std::mutex> lock(mutex);
+    if (chunks.empty()) {
+        return false;
+    }
+    const ArenaChunk *last = chunks.back().get();
+    if (ptr + oldn != last->data.get() + used ||
+            used + (newn - oldn) > last->capacity) {
+        return false;
+    }
+    used += newn - oldn;
+    allocatedTerms += newn - oldn;
+    return true;
+}
+
+void Arena::reset() {
+    std::lock_guard<std::mutex> lock(mutex);
+    for (auto &chunk : chunks) {
+        //Chunks still used by a column are left to it
+        if (chunk.use_count() == 1 && chunk->capacity == ARENA_CHUNK_TERMS
+                && freeChunks.size() < ARENA_MAX_FREE_CHUNKS) {
+            freeChunks.push_back(chunk);
+        }
+    }
+    chunks.clear();
+    used = 0;
+    allocatedTerms = 0;
+}
+
+Arena *Arena::getThreadArena() {
+    static thread_local Arena arena;
+    return &arena;
+}
@@ -1,74 +1,188 @@
 #include <vlog/chasemgmt.h>
 
+#include <trident/utils/parallel.h>
+
 //************** ROWS ***************
-uint64_t ChaseMgmt::Rows::addRow(uint64_t* row) {
-    // LOG(TRACEL) << "Addrow: " << row[0];
-    if (!currentblock || blockCounter >= SIZE_BLOCK) {
-        //Create a new block
-        std::unique_ptr<uint64_t[]> n =
-            std::unique_ptr<uint64_t[]>(
-                    new uint64_t[sizerow * SIZE_BLOCK]);
-        currentblock = n.get();
-        blocks.push_back(std::move(n));
-        blockCounter = 0;
-    }
-    for(uint8_t i = 0; i < sizerow; ++i) {
-        currentblock[i] = row[i];
-    }
-    ChaseRow r(sizerow, currentblock);
-    rows[r] = currentcounter;
-    currentblock += sizerow;
-    blockCounter++;
-    if (((uint32_t)currentcounter) == UINT32_MAX) {
+#define ROWS_SLOT_BUSY (UINT64_C(1) << 32)
+#define ROWS_INDEX_MASK (ROWS_SLOT_BUSY - 1)
+#define ROWS_TAG(h) (((h) >> 33) << 33)
+
+uint64_t ChaseMgmt::Rows::hashRow(const uint64_t *row) const {
+    return hash_ChaseRow()(ChaseRow(sizerow, (uint64_t *) row));
+}
+
+uint64_t *ChaseMgmt::Rows::getRow(size_t id) {
+    //Block k starts at row SIZE_BLOCK * (2^k - 1)
+    const uint64_t q = id / SIZE_BLOCK + 1;
+    const int blocknr = 63 - __builtin_clzll(q);
+    const uint64_t offset = id - SIZE_BLOCK * ((UINT64_C(1) << blocknr) - 1);
+    return blocks[blocknr].get() + offset * sizerow;
+}
+
+void ChaseMgmt::Rows::reserve(const uint64_t n) {
+    const uint64_t needed = nrows.load() + n;
+    if (needed >= UINT32_MAX) {
         LOG(ERRORL) << "I can assign at most 2^32 new IDs to an ext. variable... Stop!";
         throw 10;
     }
-    auto out = currentcounter;
-    if (typeChase != TypeChase::SUM_CHASE && typeChase != TypeChase::SUM_RESTRICTED_CHASE) {
-        currentcounter++;
-    } else {
-        for(uint8_t i = 0; i < sizerow; ++i) {
-            if (row[i] & RULEVARMASK) {
-                // LOG(DEBUGL) << "Adding dependency " << row[i] << ", current = " << out;
-                deps.insert(row[i]);
+    while (capacityRows < needed) {
+        const uint64_t size = (uint64_t) SIZE_BLOCK << nblocks;
+        blocks[nblocks].reset(new uint64_t[size * sizerow]);
+        capacityRows += size;
+        nblocks++;
+    }
+    if (needed * 2 <= nslots) {
+        return;
+    }
+    uint64_t newnslots = nslots == 0 ? 1024 : nslots;
+    while (needed * 2 > newnslots) {
+        newnslots *= 2;
+    }
+    std::unique_ptr<std::atomic<uint64_t>[]> newslots(
+            new std::atomic<uint64_t>[newnslots]);
+    for (uint64_t i = 0; i < newnslots; ++i) {
+        newslots[i].store(0, std::memory_order_relaxed);
+    }
+    const uint64_t mask = newnslots - 1;
+    const uint64_t n_rows = nrows.load();
+    for (uint64_t i = 0; i < n_rows; ++i) {
+        const uint64_t h = hashRow(getRow(i));
+        uint64_t pos = h & mask;
+        while (newslots[pos].load(std::memory_order_relaxed) != 0) {
+            pos = (pos + 1) & mask;
+        }
+        newslots[pos].store(ROWS_TAG(h) | (i + 1), std::memory_order_relaxed);
+    }
+    slots = std::move(newslots);
+    nslots = newnslots;
+}
+
+uint64_t ChaseMgmt::Rows::getOrAdd(const uint64_t *row) {
+    const uint64_t h = hashRow(row);
+    const uint64_t tag = ROWS_TAG(h);
+    const uint64_t mask = nslots - 1;
+    uint64_t pos = h & mask;
+    while (true) {
+        uint64_t v = slots[pos].load(std::memory_order_acquire);
+        if (v == 0) {
+            //Claim the slot, then publish the row once it is written
+            if (slots[pos].compare_exchange_strong(v, tag | ROWS_SLOT_BUSY,
+                        std::memory_order_acq_rel)) {
+                const uint64_t id = nrows.fetch_add(1);
+                uint64_t *dest = getRow(id);
+                for (uint8_t i = 0; i < sizerow; ++i) {
+                    dest[i] = row[i];
+                }
+                slots[pos].store(tag | (id + 1), std::memory_order_release);
+                return id;
             }
+            //Another thread took the slot. v contains its value
         }
+        if ((v & ~(ROWS_SLOT_BUSY | ROWS_INDEX_MASK)) == tag) {
+            while (v & ROWS_SLOT_BUSY) {
+                v = slots[pos].load(std::memory_order_acquire);
+            }
+            const uint64_t id = (v & ROWS_INDEX_MASK) - 1;
+            const uint64_t *existing = getRow(id);
+            bool equal = true;
+            for (uint8_t i = 0; i < sizerow && equal; ++i) {
+                equal = existing[i] == row[i];
+            }
+            if (equal) {
+                return id;
+            }
+        }
+        pos = (pos + 1) & mask;
     }
-    // LOG(DEBUGL) << "addRow returns " << out;
-    return out;
 }
 
 bool ChaseMgmt::Rows::existingRow(uint64_t *row, uint64_t &value) {
-    ChaseRow r(sizerow, row);
-    auto search = rows.find(r);
-    if (search != rows.end()) {
-        value = search->second;
-        return true;
+    std::lock_guard<std::mutex> lock(mutex);
+    if (nslots == 0) {
+        return false;
+    }
+    const uint64_t h = hashRow(row);
+    const uint64_t tag = ROWS_TAG(h);
+    const uint64_t mask = nslots - 1;
+    for (uint64_t pos = h & mask; ; pos = (pos + 1) & mask) {
+        const uint64_t v = slots[pos].load(std::memory_order_acquire);
+        if (v == 0) {
+            return false;
+        }
+        if ((v & ~ROWS_INDEX_MASK) == tag) {
+            const uint64_t id = (v & ROWS_INDEX_MASK) - 1;
+            const uint64_t *existing = getRow(id);
+            bool equal = true;
+            for (uint8_t i = 0; i < sizerow && equal; ++i) {
+                equal = existing[i] == row[i];
+            }
+            if (equal) {
+                if (typeChase != TypeChase::SUM_CHASE &&
+                        typeChase != TypeChase::SUM_RESTRICTED_CHASE) {
+                    value = startCounter + id;
+                } else {
+                    value = startCounter;
+                }
+                return true;
+            }
+        }
     }
-    return false;
 }
 
-uint64_t *ChaseMgmt::Rows::getRow(size_t id) {
-    uint64_t blocknr = id / SIZE_BLOCK;
-    uint64_t offset = id % SIZE_BLOCK;
-    auto &block_content = blocks[blocknr];
-    return block_content.get() + offset * sizerow;
+void ChaseMgmt::Rows::addRows(const uint64_t *rows, const uint64_t n,
+        Term_t *values, const int nthreads) {
+    std::lock_guard<std::mutex> lock(mutex);
+    reserve(n);
+    const uint64_t firstNew = nrows.load();
+    if (nthreads > 1 && n >= ROWS_PARALLEL_THRESHOLD) {
+        const uint64_t chunk = (n + nthreads - 1) / nthreads;
+        ParallelTasks::parallel_for(0, n, chunk, [&](const ParallelRange &r) {
+            for (size_t i = r.begin(); i < r.end(); ++i) {
+                values[i] = getOrAdd(rows + i * sizerow);
+            }
+        });
+    } else {
+        for (uint64_t i = 0; i < n; ++i) {
+            values[i] = getOrAdd(rows + i * sizerow);
+        }
+    }
+
+    if (typeChase != TypeChase::SUM_CHASE && typeChase != TypeChase::SUM_RESTRICTED_CHASE) {
+        for (uint64_t i = 0; i < n; ++i) {
+            values[i] += startCounter;
+        }
+    } else {
+        //All the rows get the same ID, which depends on the nulls
+        //that occur in them
+        for (uint64_t i = 0; i < n; ++i) {
+            if (values[i] >= firstNew) {
+                const uint64_t *row = rows + i * sizerow;
+                for (uint8_t j = 0; j < sizerow; ++j) {
+                    if (row[j] & RULEVARMASK) {
+                        deps.insert(row[j]);
+                    }
+                }
+            }
+            values[i] = startCounter;
+        }
+    }
 }
 
 //************** END ROWS *************
 
 //************** RULE CONTAINER ***************
 ChaseMgmt::Rows *ChaseMgmt::RuleContainer::getRows(Var_t var) {
+    std::lock_guard<std::mutex> lock(mutex);
     if (!vars2rows.count(var)) {
         uint8_t sizerow = dependencies[var].size();
         uint64_t startCounter = ruleBaseCounter;
         // The variable is encoded in the space between the rule ID and the
         // counter ID.
         startCounter += VAR_SHIFT(var);
-        vars2rows.insert(std::make_pair(var, Rows(startCounter, sizerow,
-                        dependencies[var], chase)));
+        vars2rows[var] = std::unique_ptr<Rows>(new Rows(startCounter, sizerow,
+                    dependencies[var], chase));
     }
-    return &vars2rows.find(var)->second;
+    return vars2rows[var].get();
 }
 
 //************** END RULE CONTAINER *************
@@ -117,12 +231,9 @@ bool ChaseMgmt::Rows::checkRecursive(uint64_t target, uint64_t value, std::set<u
         }
     }
     else {
-        // Find the right block to check
-        size_t blockNo = value / SIZE_BLOCK;
-        size_t offset = (value % SIZE_BLOCK) * sizerow;
-        auto block = blocks[blockNo].get();
-        for (size_t i = offset; i < offset + sizerow; i++) {
-            if (checkValue(target, block[i], toCheck)) {
+        const uint64_t *row = getRow(value);
+        for (uint8_t i = 0; i < sizerow; i++) {
+            if (checkValue(target, row[i], toCheck)) {
                 return true;
             }
         }
@@ -184,14 +295,16 @@ std::shared_ptr<Column> ChaseMgmt::getNewOrExistingIDs(
         uint32_t ruleid,
         Var_t var,
         std::vector<std::shared_ptr<Column>> &columns,
-        uint64_t sizecolumns) {
+        uint64_t sizecolumns,
+        const int nthreads) {
     assert(sizecolumns > 0);
     auto &ruleContainer = rules[ruleid];
     auto rows = ruleContainer->getRows(var);
     const uint8_t sizerow = rows->getSizeRow();
     assert(sizerow == columns.size());
-    std::vector<Term_t> functerms;
-    uint64_t row[256];
+    std::vector<Term_t> functerms(sizecolumns);
+    //The rows of the batch, one after the other
+    std::vector<uint64_t> batch(sizecolumns * sizerow);
 
     std::vector<std::unique_ptr<ColumnReader>> readers;
     for(uint8_t j = 0; j < sizerow; ++j) {
@@ -199,6 +312,7 @@ std::shared_ptr<Column> ChaseMgmt::getNewOrExistingIDs(
     }
     uint64_t rulevar = RULE_SHIFT(ruleid) + VAR_SHIFT(var);
     for(uint64_t i = 0; i < sizecolumns; ++i) {
+        uint64_t *row = batch.data() + i * sizerow;
         for(uint8_t j = 0; j < sizerow; ++j) {
             if (!readers[j]->hasNext()) {
                 LOG(ERRORL) << "Should not happen ...";
@@ -220,13 +334,8 @@ std::shared_ptr<Column> ChaseMgmt::getNewOrExistingIDs(
                 }
             }
         }
-        LOG(TRACEL) << "check: ruleid = " << ruleid << ", row[0] = " << row[0];
-        uint64_t value = 0;
-        if (!rows->existingRow(row, value)) {
-            value = rows->addRow(row);
-        }
-        functerms.push_back(value);
     }
+    rows->addRows(batch.data(), sizecolumns, functerms.data(), nthreads);
     return ColumnWriter::getColumn(functerms, false);
 }
 
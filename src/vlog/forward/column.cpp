@@ -7,6 +7,14 @@
 #include <iostream>
 #include <inttypes.h>
 
+#if defined(_WIN32)
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 /*CompressedColumn::CompressedColumn(const CompressedColumn &o) : blocks(o.blocks), offsetsize(o.offsetsize),
   deltas(o.deltas), _size(o._size) {
   }*/
@@ -146,6 +154,180 @@ Term_t CompressedColumn::getValue(const size_t pos) const {
     throw 10;
 }
 
+uint8_t PackedColumn::bitsFrame(const Term_t *values, const size_t n,
+        Term_t &base) {
+    Term_t min = values[0];
+    Term_t max = values[0];
+    for (size_t i = 1; i < n; ++i) {
+        if (values[i] < min) {
+            min = values[i];
+        } else if (values[i] > max) {
+            max = values[i];
+        }
+    }
+    base = min;
+    const uint64_t range = max - min;
+    return range == 0 ? 0 : 64 - __builtin_clzll(range);
+}
+
+PackedColumn::PackedColumn(const std::vector<Term_t> &values,
+        const bool sorted) : _size(values.size()), sorted(sorted) {
+    frames.reserve((_size + PACKED_FRAME_SIZE - 1) / PACKED_FRAME_SIZE);
+    for (size_t start = 0; start < _size; start += PACKED_FRAME_SIZE) {
+        const size_t n = std::min((size_t) PACKED_FRAME_SIZE, _size - start);
+        const Term_t *v = &values[start];
+        Term_t base;
+        const uint8_t bits = bitsFrame(v, n, base);
+        const size_t offset = words.size();
+        frames.push_back(PackedColumnFrame(base, offset, bits));
+        if (bits == 0) {
+            continue;
+        }
+        words.resize(offset + (n * bits + 63) / 64, 0);
+        uint64_t *w = &words[offset];
+        for (size_t i = 0; i < n; ++i) {
+            const uint64_t d = v[i] - base;
+            const size_t bitpos = i * bits;
+            const uint8_t shift = bitpos & 63;
+            w[bitpos >> 6] |= d << shift;
+            if (shift + bits > 64) {
+                w[(bitpos >> 6) + 1] |= d >> (64 - shift);
+            }
+        }
+    }
+    words.shrink_to_fit();
+}
+
+size_t PackedColumn::getPackedSize(const std::vector<Term_t> &values) {
+    size_t bytes = 0;
+    for (size_t start = 0; start < values.size(); start += PACKED_FRAME_SIZE) {
+        const size_t n = std::min((size_t) PACKED_FRAME_SIZE,
+                values.size() - start);
+        Term_t base;
+        const uint8_t bits = bitsFrame(&values[start], n, base);
+        bytes += sizeof(PackedColumnFrame) + (n * bits + 63) / 64 * 8;
+    }
+    return bytes;
+}
+
+std::unique_ptr<ColumnReader> PackedColumn::getReader() const {
+    return std::unique_ptr<ColumnReader>(new PackedColumnReader(*this));
+}
+
+std::shared_ptr<Column> PackedColumn::sort() const {
+    if (sorted) {
+        return std::shared_ptr<Column>(new PackedColumn(*this));
+    }
+    std::vector<Term_t> newValues = getReader()->asVector();
+    std::sort(newValues.begin(), newValues.end());
+    return ColumnWriter::getColumn(newValues, true);
+}
+
+std::shared_ptr<Column> PackedColumn::sort(const int nthreads) const {
+    if (sorted || nthreads <= 1) {
+        return sort();
+    }
+    std::vector<Term_t> newValues = getReader()->asVector();
+    ParallelTasks::sort_int(newValues.begin(), newValues.end());
+    return ColumnWriter::getColumn(newValues, true);
+}
+
+std::shared_ptr<Column> PackedColumn::unique() const {
+    //I assume the column is already sorted
+    std::vector<Term_t> newValues = getReader()->asVector();
+    auto last = std::unique(newValues.begin(), newValues.end());
+    newValues.erase(last, newValues.end());
+    return ColumnWriter::getColumn(newValues, true);
+}
+
+bool PackedColumn::isIn(const Term_t t) const {
+    if (sorted) {
+        size_t low = 0;
+        size_t high = _size;
+        while (low < high) {
+            const size_t mid = low + (high - low) / 2;
+            if (getValue(mid) < t) {
+                low = mid + 1;
+            } else {
+                high = mid;
+            }
+        }
+        return low < _size && getValue(low) == t;
+    }
+    std::unique_ptr<ColumnReader> reader = getReader();
+    while (reader->hasNext()) {
+        if (reader->next() == t) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool PackedColumn::isConstant() const {
+    if (_size < 2) {
+        return true;
+    }
+    for (const auto &frame : frames) {
+        if (frame.bits != 0 || frame.base != frames[0].base) {
+            return false;
+        }
+    }
+    return true;
+}
+
+std::vector<Term_t> PackedColumnReader::asVector() {
+    std::vector<Term_t> output(_size);
+    if (_size > 0) {
+        for (size_t i = 0; i < frames.size(); ++i) {
+            const PackedColumnFrame &frame = frames[i];
+            const size_t start = i * PACKED_FRAME_SIZE;
+            const size_t n = std::min((size_t) PACKED_FRAME_SIZE, _size - start);
+            for (size_t j = 0; j < n; ++j) {
+                output[start + j] = frame.base + PackedColumn::unpack(
+                        words + frame.offset, frame.bits, j);
+            }
+        }
+    }
+    return output;
+}
+
+size_t PackedColumnReader::nextBatch(Term_t *buffer, const size_t n) {
+    size_t i = 0;
+    while (i < n && position < _size) {
+        const PackedColumnFrame &frame = frames[position / PACKED_FRAME_SIZE];
+        const size_t idx = position % PACKED_FRAME_SIZE;
+        const size_t toCopy = std::min(n - i,
+                std::min(PACKED_FRAME_SIZE - idx, _size - position));
+        for (size_t j = 0; j < toCopy; ++j) {
+            buffer[i + j] = frame.base + PackedColumn::unpack(
+                    words + frame.offset, frame.bits, idx + j);
+        }
+        i += toCopy;
+        position += toCopy;
+    }
+    return i;
+}
+
+size_t ColumnReaderImpl::skip(const size_t n) {
+    //Moves through the blocks without decoding them
+    size_t i = 0;
+    while (i < n && position < _size) {
+        const size_t blockLen = blocks[currentBlock].size + 1;
+        if (posInBlock >= blockLen) {
+            assert(currentBlock < numBlocks - 1);
+            currentBlock++;
+            posInBlock = 0;
+            continue;
+        }
+        const size_t toSkip = std::min(n - i,
+                std::min(blockLen - posInBlock, _size - position));
+        posInBlock += toSkip;
+        position += toSkip;
+        i += toSkip;
+    }
+    return i;
+}
+
 Term_t ColumnReaderImpl::next() {
     position++;
     if (posInBlock == 0) {
@@ -204,20 +386,38 @@ std::vector<Term_t> ColumnReaderImpl::asVector() {
         Term_t *p = &output[0];
 
         for (size_t j = 0; j < numBlocks; j++) {
-            if (blocks[j].delta == 0) {
-                for (int32_t i = 0; i <= blocks[j].size; ++i) {
-                    *p++ = blocks[j].value;
-                }
-            } else {
-                for (int32_t i = 0; i <= blocks[j].size; ++i) {
-                    *p++ = blocks[j].value + blocks[j].delta * i;
-                }
-            }
+            const size_t count = blocks[j].size + 1;
+            ColumnKernels::decodeRange(blocks[j].value, blocks[j].delta, 0,
+                    count, p);
+            p += count;
         }
     }
     return output;
 }
 
+size_t ColumnReaderImpl::nextBatch(Term_t *buffer, const size_t n) {
+    size_t i = 0;
+    while (i < n && position < _size) {
+        const CompressedColumnBlock &block = blocks[currentBlock];
+        const size_t blockLen = block.size + 1;
+        if (posInBlock >= blockLen) {
+            //Move to the next block
+            assert(currentBlock < numBlocks - 1);
+            currentBlock++;
+            posInBlock = 0;
+            continue;
+        }
+        const size_t toCopy = std::min(n - i,
+                std::min(blockLen - posInBlock, _size - position));
+        ColumnKernels::decodeRange(block.value, block.delta, posInBlock,
+                toCopy, buffer + i);
+        posInBlock += toCopy;
+        position += toCopy;
+        i += toCopy;
+    }
+    return i;
+}
+
 Term_t ColumnReaderImpl::last() {
     return blocks[numBlocks-1].value + blocks[numBlocks-1].delta * blocks[numBlocks-1].size;
 }
@@ -226,6 +426,114 @@ Term_t ColumnReaderImpl::first() {
     return blocks->value;
 }
 
+MappedFile::MappedFile(std::string path, const bool removeFile) :
+    data(NULL), length(0) {
+#if defined(_WIN32)
+    LOG(ERRORL) << "Memory-mapped columns are not supported on Windows";
+    throw 10; //not supported
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1) {
+        LOG(ERRORL) << "Cannot open file " << path;
+        throw 10;
+    }
+    struct stat st;
+    if (fstat(fd, &st) == -1) {
+        close(fd);
+        LOG(ERRORL) << "Cannot read the size of file " << path;
+        throw 10;
+    }
+    length = st.st_size;
+    if (length > 0) {
+        void *addr = mmap(NULL, length, PROT_READ, MAP_SHARED, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            LOG(ERRORL) << "Cannot map file " << path;
+            throw 10;
+        }
+        madvise(addr, length, MADV_SEQUENTIAL);
+        data = (const char *) addr;
+    }
+    close(fd);
+    if (removeFile) {
+        //The mapping keeps the content alive until it is released
+        unlink(path.c_str());
+    }
+#endif
+}
+
+MappedFile::~MappedFile() {
+#if defined(_WIN32)
+#else
+    if (data != NULL) {
+        munmap((void *) data, length);
+    }
+#endif
+}
+
+std::shared_ptr<Column> MmapColumn::sort() const {
+    std::vector<Term_t> newValues(values, values + len);
+    std::sort(newValues.begin(), newValues.end());
+    return ColumnWriter::getColumn(newValues, true);
+}
+
+std::shared_ptr<Column> MmapColumn::sort(const int nthreads) const {
+    if (nthreads <= 1) {
+        return sort();
+    }
+    std::vector<Term_t> newValues(values, values + len);
+    ParallelTasks::sort_int(newValues.begin(), newValues.end());
+    return ColumnWriter::getColumn(newValues, true);
+}
+
+std::shared_ptr<Column> MmapColumn::unique() const {
+    //I assume the column is already sorted
+    std::vector<Term_t> newValues;
+    newValues.reserve(len);
+    Term_t prev = (Term_t) - 1;
+    for (size_t i = 0; i < len; i++) {
+        if (values[i] != prev) {
+            newValues.push_back(values[i]);
+            prev = values[i];
+        }
+    }
+    return ColumnWriter::getColumn(newValues, true);
+}
+
+std::shared_ptr<Column> ArenaColumn::sort() const {
+    if (sorted) {
+        return std::shared_ptr<Column>(new ArenaColumn(pieces, true));
+    }
+    std::vector<Term_t> newValues = getReader()->asVector();
+    std::sort(newValues.begin(), newValues.end());
+    return ColumnWriter::getColumn(newValues, true);
+}
+
+std::shared_ptr<Column> ArenaColumn::sort(const int nthreads) const {
+    if (sorted || nthreads <= 1) {
+        return sort();
+    }
+    std::vector<Term_t> newValues = getReader()->asVector();
+    ParallelTasks::sort_int(newValues.begin(), newValues.end());
+    return ColumnWriter::getColumn(newValues, true);
+}
+
+std::shared_ptr<Column> ArenaColumn::unique() const {
+    //I assume the column is already sorted
+    std::vector<Term_t> newValues;
+    newValues.reserve(len);
+    Term_t prev = (Term_t) - 1;
+    for (const auto &piece : pieces) {
+        for (size_t i = 0; i < piece.len; i++) {
+            if (piece.values[i] != prev) {
+                newValues.push_back(piece.values[i]);
+                prev = piece.values[i];
+            }
+        }
+    }
+    return ColumnWriter::getColumn(newValues, true);
+}
+
 EDBColumn::EDBColumn(EDBLayer &edb, const Literal &lit, uint8_t posColumn,
         const std::vector<uint8_t> presortPos, const bool unq) :
     layer(edb),
@@ -340,7 +648,7 @@ EDBColumnReader::EDBColumnReader(const Literal &l, const uint8_t posColumn,
     : l(l), layer(layer), posColumn(posColumn), presortPos(presortPos),
     unq(unq), //posInItr((l.getTupleSize() - l.getNVars()) + presortPos.size()),
     posInItr(l.getPosVars()[posColumn]),
-    itr(NULL), firstCached((Term_t) - 1),
+    itr(NULL), exhausted(false), firstCached((Term_t) - 1),
     lastCached((Term_t) - 1) {
     }
 
@@ -496,6 +804,9 @@ Term_t EDBColumnReader::first() {
 }
 
 bool EDBColumnReader::hasNext() {
+    if (exhausted) {
+        return false;
+    }
     if (itr == NULL) {
         setupItr();
     }
@@ -504,6 +815,7 @@ bool EDBColumnReader::hasNext() {
         //release the itr
         layer.releaseIterator(itr);
         itr = NULL;
+        exhausted = true;
     }
     return resp;
 }
@@ -513,6 +825,23 @@ Term_t EDBColumnReader::next() {
     return itr->getElementAt(posInItr);
 }
 
+size_t EDBColumnReader::nextBatch(Term_t *buffer, const size_t n) {
+    if (exhausted) {
+        return 0;
+    }
+    if (itr == NULL) {
+        setupItr();
+    }
+    const size_t i = itr->nextBatch(posInItr, buffer, n);
+    if (i < n) {
+        //release the itr
+        layer.releaseIterator(itr);
+        itr = NULL;
+        exhausted = true;
+    }
+    return i;
+}
+
 std::vector<Term_t> EDBColumnReader::asVector() {
     return load(l, posColumn, presortPos, layer, unq);
 }
@@ -524,6 +853,53 @@ void ColumnWriter::concatenate(Column * c) {
     }
 }
 
+//The values are not moved when the column grows: if the current piece cannot
+//be extended in place, because other columns allocated after it, the column
+//continues in a new piece. Every piece is as large as the column so far, so
+//there are few pieces, but at most a chunk, so that the chunks are recycled
+void ColumnWriter::growArena() {
+    const size_t filled = _size - arenaOffset;
+    const size_t newCapacity = std::min((size_t) ARENA_CHUNK_TERMS,
+            std::max((size_t) 64, _size));
+    if (arenaValues != NULL && arena->extend(arenaValues, arenaCapacity,
+                arenaCapacity + newCapacity)) {
+        arenaCapacity += newCapacity;
+        return;
+    }
+    if (filled > 0) {
+        arenaPieces.push_back(ArenaPiece(arenaChunk, arenaValues, filled));
+    }
+    arenaValues = arena->allocate(newCapacity, arenaChunk);
+    arenaOffset = _size;
+    arenaCapacity = newCapacity;
+}
+
+std::shared_ptr<const ZoneMap> ZoneMap::compute(const Column &column) {
+    //Read the column one block at the time, so that the packed columns
+    //are not decompressed all together
+    std::unique_ptr<ColumnReader> reader = column.getReader();
+    std::shared_ptr<ZoneMap> zm(new ZoneMap());
+    std::unique_ptr<Term_t[]> buffer(new Term_t[ZONEMAP_BLOCK_ROWS]);
+    size_t n;
+    while ((n = reader->nextBatch(buffer.get(), ZONEMAP_BLOCK_ROWS)) > 0) {
+        zm->mins.push_back(*std::min_element(buffer.get(), buffer.get() + n));
+        zm->maxs.push_back(*std::max_element(buffer.get(), buffer.get() + n));
+    }
+    if (!zm->mins.empty()) {
+        zm->min = *std::min_element(zm->mins.begin(), zm->mins.end());
+        zm->max = *std::max_element(zm->maxs.begin(), zm->maxs.end());
+    } else {
+        zm->min = zm->max = 0;
+    }
+    return zm;
+}
+
+//Columns are sealed here: they are not modified anymore, so their zone maps
+//can be computed when the first lookup needs them
+static void addZoneMap(Column &column) {
+    column.setLazyZoneMap();
+}
+
 std::shared_ptr<Column> ColumnWriter::getColumn() {
     if (cached) {
         //The column was already being requested
@@ -531,6 +907,29 @@ std::shared_ptr<Column> ColumnWriter::getColumn() {
     }
     cached = true;
 
+    if (arena != NULL) {
+        const Term_t firstv = arenaPieces.empty() ? (_size > 0 ?
+                arenaValues[0] : 0) : arenaPieces[0].values[0];
+        if (_size > 0 && _size <= UINT32_MAX && sorted && firstv == lastv) {
+            cachedColumn = std::shared_ptr<Column>(new CompressedColumn(
+                        lastv, _size));
+        } else if (arenaPieces.empty()) {
+            cachedColumn = std::shared_ptr<Column>(new ArenaColumn(
+                        arenaChunk, arenaValues, _size, sorted));
+            addZoneMap(*cachedColumn);
+        } else {
+            std::vector<ArenaPiece> pieces = arenaPieces;
+            if (_size > arenaOffset) {
+                pieces.push_back(ArenaPiece(arenaChunk, arenaValues,
+                            _size - arenaOffset));
+            }
+            cachedColumn = std::shared_ptr<Column>(new ArenaColumn(pieces,
+                        sorted));
+            addZoneMap(*cachedColumn);
+        }
+        return cachedColumn;
+    }
+
 #ifdef USE_COMPRESSED_COLUMNS
     if (compressed) {
         LOG(TRACEL) << "ColumnWriter::getColumn: blocks.size() = " << blocks.size() << ", _size = " << _size;
@@ -541,14 +940,15 @@ std::shared_ptr<Column> ColumnWriter::getColumn() {
         } else {
             CompressedColumn col(blocks, /*offsetsize, deltas,*/ _size);
             std::vector<Term_t> values = col.getReader()->asVector();
-            cachedColumn = std::shared_ptr<Column>(new InmemoryColumn(values, true));
+            cachedColumn = getVectorColumn(values, sorted);
         }
     } else {
-        cachedColumn = std::shared_ptr<Column>(new InmemoryColumn(values, true));
+        cachedColumn = getVectorColumn(values, sorted);
     }
 #else
     cachedColumn = std::shared_ptr<Column>(new InmemoryColumn(values, true));
 #endif
+    addZoneMap(*cachedColumn);
     return cachedColumn;
 }
 
@@ -607,65 +1007,65 @@ std::shared_ptr<Column> ColumnWriter::getColumn(std::vector<Term_t> &values, boo
         deltas, values.size()));*/
     } else {
         //swap the values. After, "values" is empty
-        return std::shared_ptr<Column>(new InmemoryColumn(values, true));
+        std::shared_ptr<Column> col = getVectorColumn(values, isSorted);
+        addZoneMap(*col);
+        return col;
     }
 #else
-    return std::shared_ptr<Column>(new InmemoryColumn(values, true));
+    std::shared_ptr<Column> col(new InmemoryColumn(values, true));
+    addZoneMap(*col);
+    return col;
 #endif
 }
 
+std::shared_ptr<Column> ColumnWriter::getVectorColumn(
+        std::vector<Term_t> &values, const bool isSorted) {
+    //Pack the column only if it takes at most half of the space of the
+    //vector. The packed column does not expose a vector, so operations
+    //that need one will decompress it.
+    if (values.size() >= PACKED_COLUMN_MIN_SIZE &&
+            PackedColumn::getPackedSize(values) * 2 <=
+            values.size() * sizeof(Term_t)) {
+        std::shared_ptr<Column> col(new PackedColumn(values, isSorted));
+        values.clear();
+        values.shrink_to_fit();
+        return col;
+    }
+    return std::shared_ptr<Column>(new InmemoryColumn(values, true));
+}
+
 void Column::intersection(std::shared_ptr<Column> c1,
         std::shared_ptr<Column> c2, ColumnWriter &writer) {
     std::unique_ptr<ColumnReader> r1 = c1->getReader();
     std::unique_ptr<ColumnReader> r2 = c2->getReader();
-    Term_t v1, v2;
-    if (! r1->hasNext()) {
-        return;
-    }
-    v1 = r1->next();
-    if (! r2->hasNext()) {
-        return;
-    }
-    v2 = r2->next();
-
-    // long count1 = ok1 ? 1 : 0;
-    // long count2 = ok2 ? 1 : 0;
-    // long countout = 0;
-
-    //std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-
 
-    for (;;) {
-        if (v1 < v2) {
-            if (! r1->hasNext()) {
-                return;
-            }
-            v1 = r1->next();
-            // count1++;
-        } else if (v1 > v2) {
-            if (! r2->hasNext()) {
-                return;
-            }
-            v2 = r2->next();
-            // count2++;
-        } else {
-            writer.add(v1);
-            // countout++;
-            if (! r1->hasNext()) {
-                return;
-            }
-            v1 = r1->next();
-            // count1++;
-            if (! r2->hasNext()) {
-                return;
-            }
-            v2 = r2->next();
-            // count2++;
+    //Pull the values in blocks and merge them with the SIMD kernel, instead
+    //of paying two virtual calls per value.
+    std::unique_ptr<Term_t[]> buffer1(new Term_t[COLUMN_BATCH_SIZE]);
+    std::unique_ptr<Term_t[]> buffer2(new Term_t[COLUMN_BATCH_SIZE]);
+    std::unique_ptr<Term_t[]> out(new Term_t[COLUMN_BATCH_SIZE]);
+    size_t n1 = r1->nextBatch(buffer1.get(), COLUMN_BATCH_SIZE);
+    size_t n2 = n1 > 0 ? r2->nextBatch(buffer2.get(), COLUMN_BATCH_SIZE) : 0;
+    size_t i1 = 0, i2 = 0;
+    while (n1 > 0 && n2 > 0) {
+        size_t consumed1, consumed2;
+        const size_t nout = ColumnKernels::intersectSorted(buffer1.get() + i1,
+                n1 - i1, buffer2.get() + i2, n2 - i2, out.get(),
+                consumed1, consumed2);
+        for (size_t i = 0; i < nout; ++i) {
+            writer.add(out[i]);
+        }
+        i1 += consumed1;
+        i2 += consumed2;
+        if (i1 == n1) {
+            n1 = r1->nextBatch(buffer1.get(), COLUMN_BATCH_SIZE);
+            i1 = 0;
+        }
+        if (i2 == n2) {
+            n2 = r2->nextBatch(buffer2.get(), COLUMN_BATCH_SIZE);
+            i2 = 0;
         }
     }
-    //std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
-    //LOG(INFOL) << "Count1=" << count1 << " Count2=" << count2 <<
-    //                        " countout=" << countout << " " << sec.count() * 1000;
 }
 
 // The parallel version may very well be slower than the sequential one, because the parallel
@@ -683,33 +1083,17 @@ void Column::intersection(std::shared_ptr<Column> c1,
     size_t c2Size = vectors[1]->size();
 
     // TODO: parallelize this!
-    Term_t v1, v2;
-    size_t i1 = 1, i2 = 1;
-    v1 = (*vectors[0])[0];
-    v2 = (*vectors[1])[0];
-    for (;;) {
-        if (v1 < v2) {
-            if (i1 >= c1Size) {
-                return;
-            }
-            v1 = (*vectors[0])[i1++];
-        } else if (v1 > v2) {
-            if (i2 >= c2Size) {
-                return;
-            }
-            v2 = (*vectors[1])[i2++];
-        } else {
-            writer.add(v1);
-            if (i1 >= c1Size) {
-                return;
-            }
-            v1 = (*vectors[0])[i1++];
-            if (i2 >= c2Size) {
-                return;
-            }
-            v2 = (*vectors[1])[i2++];
+    if (c1Size > 0 && c2Size > 0) {
+        std::vector<Term_t> out(std::min(c1Size, c2Size));
+        size_t consumed1, consumed2;
+        const size_t nout = ColumnKernels::intersectSorted(&(*vectors[0])[0],
+                c1Size, &(*vectors[1])[0], c2Size, &out[0],
+                consumed1, consumed2);
+        for (size_t i = 0; i < nout; ++i) {
+            writer.add(out[i]);
         }
     }
+    Segment::deleteAllVectors(cols, vectors);
 }
 
 uint64_t Column::countMatches(
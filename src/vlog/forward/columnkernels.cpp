@@ -0,0 +1,187 @@
+#include <vlog/columnkernels.h>
+
+#if !TERM_AS_STRUCT && TERM_IS_UINT64
+#if defined(__AVX512F__)
+#define VLOG_KERNELS_AVX512 1
+#include <immintrin.h>
+#elif defined(__AVX2__)
+#define VLOG_KERNELS_AVX2 1
+#include <immintrin.h>
+#endif
+#endif
+
+size_t ColumnKernels::filterEqual(const Term_t *in, const size_t n,
+        const Term_t v, uint32_t *outPos) {
+    size_t nout = 0;
+    size_t i = 0;
+#if VLOG_KERNELS_AVX512
+    const __m512i vv = _mm512_set1_epi64((long long) v);
+    for (; i + 8 <= n; i += 8) {
+        const __m512i x = _mm512_loadu_si512((const void*)(in + i));
+        uint32_t mask = _mm512_cmpeq_epu64_mask(x, vv);
+        while (mask != 0) {
+            outPos[nout++] = (uint32_t) (i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+#elif VLOG_KERNELS_AVX2
+    const __m256i vv = _mm256_set1_epi64x((long long) v);
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x = _mm256_loadu_si256((const __m256i*)(in + i));
+        uint32_t mask = _mm256_movemask_pd(_mm256_castsi256_pd(
+                    _mm256_cmpeq_epi64(x, vv)));
+        while (mask != 0) {
+            outPos[nout++] = (uint32_t) (i + __builtin_ctz(mask));
+            mask &= mask - 1;
+        }
+    }
+#endif
+    for (; i < n; ++i) {
+        if (in[i] == v) {
+            outPos[nout++] = (uint32_t) i;
+        }
+    }
+    return nout;
+}
+
+size_t ColumnKernels::refineEqual(const Term_t *in, uint32_t *pos,
+        const size_t npos, const Term_t v) {
+    //Positions are sparse, so there is little to gain with gathers here
+    size_t nout = 0;
+    for (size_t i = 0; i < npos; ++i) {
+        if (in[pos[i]] == v) {
+            pos[nout++] = pos[i];
+        }
+    }
+    return nout;
+}
+
+void ColumnKernels::decodeRange(const Term_t value, const int64_t delta,
+        const size_t start, const size_t count, Term_t *out) {
+    const Term_t base = value + delta * (int64_t) start;
+    size_t i = 0;
+    if (delta == 0) {
+        for (; i < count; ++i) {
+            out[i] = base;
+        }
+        return;
+    }
+#if VLOG_KERNELS_AVX512
+    __m512i cur = _mm512_setr_epi64((long long) base,
+            (long long) (base + delta), (long long) (base + 2 * delta),
+            (long long) (base + 3 * delta), (long long) (base + 4 * delta),
+            (long long) (base + 5 * delta), (long long) (base + 6 * delta),
+            (long long) (base + 7 * delta));
+    const __m512i step = _mm512_set1_epi64((long long) (delta * 8));
+    for (; i + 8 <= count; i += 8) {
+        _mm512_storeu_si512((void*)(out + i), cur);
+        cur = _mm512_add_epi64(cur, step);
+    }
+#elif VLOG_KERNELS_AVX2
+    __m256i cur = _mm256_setr_epi64x((long long) base,
+            (long long) (base + delta), (long long) (base + 2 * delta),
+            (long long) (base + 3 * delta));
+    const __m256i step = _mm256_set1_epi64x((long long) (delta * 4));
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_si256((__m256i*)(out + i), cur);
+        cur = _mm256_add_epi64(cur, step);
+    }
+#endif
+    for (; i < count; ++i) {
+        out[i] = base + delta * (int64_t) i;
+    }
+}
+
+size_t ColumnKernels::skipLower(const Term_t *in, const size_t n,
+        const Term_t v) {
+    size_t i = 0;
+#if VLOG_KERNELS_AVX512
+    const __m512i vv = _mm512_set1_epi64((long long) v);
+    for (; i + 8 <= n; i += 8) {
+        const __m512i x = _mm512_loadu_si512((const void*)(in + i));
+        const uint32_t mask = _mm512_cmplt_epu64_mask(x, vv);
+        if (mask != 0xFF) {
+            //The input is sorted, so the lower values are a prefix
+            return i + __builtin_popcount(mask);
+        }
+    }
+#elif VLOG_KERNELS_AVX2
+    //AVX2 only has a signed comparison. Flip the sign bit to compare
+    //unsigned values.
+    const __m256i sign = _mm256_set1_epi64x((long long) 0x8000000000000000ull);
+    const __m256i vv = _mm256_xor_si256(_mm256_set1_epi64x((long long) v), sign);
+    for (; i + 4 <= n; i += 4) {
+        const __m256i x = _mm256_xor_si256(_mm256_loadu_si256(
+                    (const __m256i*)(in + i)), sign);
+        const uint32_t mask = _mm256_movemask_pd(_mm256_castsi256_pd(
+                    _mm256_cmpgt_epi64(vv, x)));
+        if (mask != 0xF) {
+            return i + __builtin_popcount(mask);
+        }
+    }
+#endif
+    while (i < n && in[i] < v) {
+        i++;
+    }
+    return i;
+}
+
+size_t ColumnKernels::intersectSorted(const Term_t *a, const size_t na,
+        const Term_t *b, const size_t nb, Term_t *out,
+        size_t &consumedA, size_t &consumedB) {
+    size_t i = 0, j = 0, nout = 0;
+    while (i < na && j < nb) {
+        if (a[i] < b[j]) {
+            i += skipLower(a + i, na - i, b[j]);
+        } else if (a[i] > b[j]) {
+            j += skipLower(b + j, nb - j, a[i]);
+        } else {
+            out[nout++] = a[i];
+            i++;
+            j++;
+        }
+    }
+    consumedA = i;
+    consumedB = j;
+    return nout;
+}
+
+#if VLOG_KERNELS_AVX2 || VLOG_KERNELS_AVX512
+//Lower 64 bits of the products of the 64-bit lanes. AVX2 only multiplies
+//32-bit values, so the product is composed from the halves.
+static inline __m256i mul64(const __m256i a, const __m256i b) {
+    const __m256i lo = _mm256_mul_epu32(a, b);
+    const __m256i cross = _mm256_add_epi64(
+            _mm256_mul_epu32(_mm256_srli_epi64(a, 32), b),
+            _mm256_mul_epu32(a, _mm256_srli_epi64(b, 32)));
+    return _mm256_add_epi64(lo, _mm256_slli_epi64(cross, 32));
+}
+#endif
+
+void ColumnKernels::hashRows(const Term_t *rows, const size_t nrows,
+        const uint8_t arity, uint64_t *out) {
+    size_t i = 0;
+#if VLOG_KERNELS_AVX2 || VLOG_KERNELS_AVX512
+    //Four rows at a time: every lane hashes one row, and the values of a
+    //column are gathered from the four rows
+    const __m256i offsets = _mm256_setr_epi64x(0, arity, 2 * arity,
+            3 * arity);
+    const __m256i mul = _mm256_set1_epi64x((long long) HASHROW_MUL);
+    const __m256i seed = _mm256_set1_epi64x(
+            (long long) (HASHROW_SEED + arity));
+    for (; i + 4 <= nrows; i += 4) {
+        const Term_t *start = rows + i * arity;
+        __m256i h = seed;
+        for (uint8_t j = 0; j < arity; ++j) {
+            const __m256i v = _mm256_i64gather_epi64(
+                    (const long long*)(start + j), offsets, 8);
+            h = mul64(_mm256_xor_si256(h, v), mul);
+        }
+        h = _mm256_xor_si256(h, _mm256_srli_epi64(h, 32));
+        _mm256_storeu_si256((__m256i*)(out + i), h);
+    }
+#endif
+    for (; i < nrows; ++i) {
+        out[i] = hashRow(rows + i * arity, arity);
+    }
+}
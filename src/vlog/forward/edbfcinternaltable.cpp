@@ -116,6 +116,9 @@ std::shared_ptr<const FCInternalTable> EDBFCInternalTable::filter(
     const Literal newLiteral(query.getLiteral()->getPredicate(), t);
 
     // LOG(DEBUGL) << "EDBFCInternalTable";
+    if (nPosToFilter > 0 && !layer->mayContain(newLiteral)) {
+        return NULL;
+    }
 
     FCInternalTable *filteredTable = new EDBFCInternalTable(iteration,
             newLiteral, layer);
@@ -128,6 +131,18 @@ std::shared_ptr<const FCInternalTable> EDBFCInternalTable::filter(
     }
 }
 
+bool EDBFCInternalTable::mayContain(const uint8_t nConstants,
+        const uint8_t *posConstants, const Term_t *valuesConstants) const {
+    if (nConstants == 0) {
+        return true;
+    }
+    VTuple t = query.getLiteral()->getTuple();
+    for (int i = 0; i < nConstants; ++i) {
+        t.set(VTerm(0, valuesConstants[i]), posConstants[i]);
+    }
+    return layer->mayContain(Literal(query.getLiteral()->getPredicate(), t));
+}
+
 FCInternalTableItr *EDBFCInternalTable::sortBy(const std::vector<uint8_t> &fields) const {
     EDBFCInternalTableItr *itr = new EDBFCInternalTableItr();
     const Literal &l = *query.getLiteral();
@@ -68,22 +68,6 @@ ExistentialRuleProcessor::ExistentialRuleProcessor(
         }
     }
 
-int _compare(std::unique_ptr<SegmentIterator> &itr1,
-        FCInternalTableItr *itr2,
-        const uint8_t *colsCheck,
-        const uint8_t ncolsCheck) {
-    for(uint8_t i = 0; i < ncolsCheck; ++i) {
-        auto t1 = itr1->get(colsCheck[i]);
-        auto t2 = itr2->getCurrentValue(colsCheck[i]);
-        if (t1 < t2) {
-            return -1;
-        } else if (t1 > t2) {
-            return 1;
-        }
-    }
-    return 0;
-}
-
 void ExistentialRuleProcessor::filterDerivations(const Literal &literal,
         FCTable *t,
         Term_t *row,
@@ -142,75 +126,10 @@ void ExistentialRuleProcessor::filterDerivations(FCTable *t,
         std::vector<uint8_t> &columnsToCheck,
         std::vector<std::pair<int,int>> &duplicateExts,
         std::vector<uint64_t> &outputProc) {
-    std::vector<uint64_t> output;
-
     //tobeRetained contained a copy of the head without the existential
-    //replacements. I restrict it to only substitutions that are not in the KG
-    std::shared_ptr<const Segment> seg = std::shared_ptr<const Segment>(
-            new Segment(tobeRetained.size(), tobeRetained));
-
-    //do the filtering
-    const uint8_t *colsCheck = columnsToCheck.data();
-    const uint8_t nColsCheck = columnsToCheck.size();
-    auto sortedSeg = seg->sortBy(NULL);
-
-    auto tableItr = t->read(0);
-    while (!tableItr.isEmpty()) {
-        auto table = tableItr.getCurrentTable();
-        auto itr1 = sortedSeg->iterator();
-        auto itr2 = table->getSortedIterator();
-        uint64_t idx = 0;
-        bool itr1Ok = itr1->hasNext();
-        if (itr1Ok) itr1->next();
-        bool itr2Ok = itr2->hasNext();
-        if (itr2Ok) itr2->next();
-        while (itr1Ok && itr2Ok) {
-            int cmp = _compare(itr1, itr2, colsCheck, nColsCheck);
-            if (cmp > 0) {
-                //the table must move to the next one
-                itr2Ok = itr2->hasNext();
-                if (itr2Ok)
-                    itr2->next();
-            } else if (cmp <= 0) {
-                if (cmp == 0) {
-                    // Check duplicate existentials
-                    if (duplicateExts.size() > 0) {
-                        bool diff = false;
-                        for (int i = 0; i < duplicateExts.size(); i++) {
-                            auto t1 = itr2->getCurrentValue(duplicateExts[i].first);
-                            auto t2 = itr2->getCurrentValue(duplicateExts[i].second);
-                            if (t1 != t2) {
-                                diff = true;
-                                break;
-                            }
-                        }
-                        if (diff) {
-                            // Shift the table.
-                            itr2Ok = itr2->hasNext();
-                            if (itr2Ok)
-                                itr2->next();
-                            continue;
-                        }
-                    }
-                    output.push_back(idx);
-                }
-                itr1Ok = itr1->hasNext();
-                if (itr1Ok)
-                    itr1->next();
-                // Should we not increment idx here??? Added. --Ceriel
-                idx++;
-            }
-        }
-        table->releaseIterator(itr2);
-        itr1->clear();
-        tableItr.moveNextCount();
-    }
-
-    std::sort(output.begin(), output.end());
-    auto end = std::unique(output.begin(), output.end());
-    output.resize(end - output.begin());
-    for(auto el : output)
-        outputProc.push_back(el);
+    //replacements. I look up the rows that are already in the KG in an index
+    //of the head table, which is kept up to date across iterations.
+    t->findInIndex(tobeRetained, columnsToCheck, duplicateExts, outputProc);
 }
 
 // Filters out rows with recursive terms
@@ -485,7 +404,8 @@ void ExistentialRuleProcessor::addColumns(const int blockid,
                             ruleDetails->rule.getId(),
                             t.getId(),
                             knownColumns,
-                            sizecolumns);
+                            sizecolumns,
+                            nthreads);
                     extvars.insert(std::make_pair(t.getId(), extcolumn));
                 }
                 cols.push_back(extvars[t.getId()]);
@@ -706,7 +626,8 @@ void ExistentialRuleProcessor::addColumns(const int blockid,
                             ruleDetails->rule.getId(),
                             t.getId(),
                             depc,
-                            sizecolumns);
+                            sizecolumns,
+                            nthreads);
                     extvars.insert(std::make_pair(t.getId(), extcolumn));
                 }
             }
@@ -1228,7 +1149,8 @@ void ExistentialRuleProcessor::consolidate(const bool isFinished) {
                     ruleDetails->rule.getId(),
                     el.first, //ID of the variable
                     knownColumns,
-                    nrows);
+                    nrows,
+                    nthreads);
             for(uint8_t pos : el.second) { //Add the existential columns to the
                 //final list of columns
                 allColumns[pos] = extcolumn;
@@ -461,7 +461,26 @@ std::shared_ptr<const Segment> InmemoryFCInternalTable::filter_row(std::shared_p
         const Term_t *valuesConstantsToFilter, const uint8_t nRepeatedVars,
         const std::pair<uint8_t, uint8_t> *repeatedVars, int nthreads) {
 
-    if (nthreads > 1) {
+    //Fraction of the blocks of the segment that the zone maps of the
+    //constants cannot exclude
+    double candidateBlocks = 1.0;
+    for (int m = 0; m < nConstantsToFilter; ++m) {
+        const ZoneMap *zm = seg->getColumn(posConstantsToFilter[m])->getZoneMap();
+        if (zm != NULL) {
+            size_t n = 0;
+            for (size_t b = 0; b < zm->getNBlocks(); ++b) {
+                if (zm->mayContain(b, valuesConstantsToFilter[m])) {
+                    n++;
+                }
+            }
+            candidateBlocks = std::min(candidateBlocks,
+                    (double) n / zm->getNBlocks());
+        }
+    }
+
+    //If most blocks can be skipped, one thread scanning the columns does
+    //less work than several threads scanning all the rows
+    if (nthreads > 1 && candidateBlocks > 0.5) {
         size_t sz = seg->getNRows();
         size_t chunk = (sz + nthreads - 1) / nthreads;
 
@@ -488,6 +507,11 @@ std::shared_ptr<const Segment> InmemoryFCInternalTable::filter_row(std::shared_p
         }
     }
 
+    if (nConstantsToFilter > 0) {
+        return filter_columns(seg, nConstantsToFilter, posConstantsToFilter,
+                valuesConstantsToFilter, nRepeatedVars, repeatedVars);
+    }
+
     SegmentInserter inserter(seg->getNColumns());
 
     LOG(DEBUGL) << "Filter_row, nConstantsToFilter = " << (int) nConstantsToFilter << ", nRepeatedVars = " << (int) nRepeatedVars
@@ -498,6 +522,102 @@ std::shared_ptr<const Segment> InmemoryFCInternalTable::filter_row(std::shared_p
     return retval;
 }
 
+std::shared_ptr<const Segment> InmemoryFCInternalTable::filter_columns(
+        std::shared_ptr<const Segment> seg,
+        const uint8_t nConstantsToFilter, const uint8_t *posConstantsToFilter,
+        const Term_t *valuesConstantsToFilter, const uint8_t nRepeatedVars,
+        const std::pair<uint8_t, uint8_t> *repeatedVars) {
+    const uint8_t ncols = seg->getNColumns();
+    SegmentInserter inserter(ncols);
+    std::vector<const ZoneMap *> zoneMaps(nConstantsToFilter);
+    for (int m = 0; m < nConstantsToFilter; ++m) {
+        zoneMaps[m] = seg->getColumn(posConstantsToFilter[m])->getZoneMap();
+    }
+    const size_t nrows = seg->getNRows();
+
+    //Read the columns one block at the time, first the one of the first
+    //constant and then the others, refining the matching positions. The
+    //blocks coincide with the ones of the zone maps: the blocks that cannot
+    //contain a constant are skipped without decoding them, and the other
+    //columns are decoded only for the blocks that have matching rows
+    std::vector<std::unique_ptr<ColumnReader>> readers;
+    std::vector<std::unique_ptr<Term_t[]>> buffers;
+    for (int c = 0; c < ncols; ++c) {
+        readers.push_back(seg->getColumn(c)->getReader());
+        buffers.push_back(std::unique_ptr<Term_t[]>(
+                    new Term_t[COLUMN_BATCH_SIZE]));
+    }
+    std::vector<bool> loaded(ncols);
+    std::unique_ptr<uint32_t[]> positions(new uint32_t[COLUMN_BATCH_SIZE]);
+    Term_t row[256];
+    size_t skippedBlocks = 0;
+    for (size_t start = 0; start < nrows; start += COLUMN_BATCH_SIZE) {
+        const size_t block = start / ZONEMAP_BLOCK_ROWS;
+        const size_t len = std::min((size_t) COLUMN_BATCH_SIZE, nrows - start);
+        bool skip = false;
+        for (int m = 0; m < nConstantsToFilter && !skip; ++m) {
+            if (zoneMaps[m] != NULL &&
+                    !zoneMaps[m]->mayContain(block, valuesConstantsToFilter[m])) {
+                skip = true;
+            }
+        }
+        std::fill(loaded.begin(), loaded.end(), false);
+        size_t npos = 0;
+        if (skip) {
+            skippedBlocks++;
+        } else {
+            const uint8_t first = posConstantsToFilter[0];
+            readers[first]->nextBatch(buffers[first].get(), len);
+            loaded[first] = true;
+            npos = ColumnKernels::filterEqual(buffers[first].get(), len,
+                    valuesConstantsToFilter[0], positions.get());
+            for (int m = 1; m < nConstantsToFilter && npos > 0; ++m) {
+                const uint8_t c = posConstantsToFilter[m];
+                if (!loaded[c]) {
+                    readers[c]->nextBatch(buffers[c].get(), len);
+                    loaded[c] = true;
+                }
+                npos = ColumnKernels::refineEqual(buffers[c].get(),
+                        positions.get(), npos, valuesConstantsToFilter[m]);
+            }
+        }
+        for (int c = 0; c < ncols; ++c) {
+            if (loaded[c]) {
+                continue;
+            }
+            if (npos > 0) {
+                readers[c]->nextBatch(buffers[c].get(), len);
+            } else {
+                readers[c]->skip(len);
+            }
+        }
+
+        for (size_t p = 0; p < npos; ++p) {
+            const uint32_t pos = positions[p];
+            bool ok = true;
+            for (int m = 0; m < nRepeatedVars; ++m) {
+                if (buffers[repeatedVars[m].first][pos] !=
+                        buffers[repeatedVars[m].second][pos]) {
+                    ok = false;
+                    break;
+                }
+            }
+            if (!ok) {
+                continue;
+            }
+            for (int c = 0; c < ncols; ++c) {
+                row[c] = buffers[c][pos];
+            }
+            inserter.addRow(row);
+        }
+    }
+
+    LOG(DEBUGL) << "Filter_columns, nConstantsToFilter = " << (int) nConstantsToFilter
+        << ", segment size = " << nrows << ", skipped blocks = " << skippedBlocks
+        << ", result count = " << inserter.getNRows();
+    return inserter.getSegment();
+}
+
 std::shared_ptr<Column> InmemoryFCInternalTable::getColumn(
         const uint8_t columnIdx) const {
     if (unmergedSegments.size() > 0) {
@@ -545,6 +665,37 @@ Term_t InmemoryFCInternalTable::getValueConstantColumn(const uint8_t columnid) c
     throw 10;
 }
 
+//Checks only the constant columns and the zone maps, so it does not read
+//any row
+static bool segmentMayContain(const Segment &seg, const uint8_t nConstants,
+        const uint8_t *posConstants, const Term_t *valuesConstants) {
+    if (seg.isEmpty()) {
+        return false;
+    }
+    for (int i = 0; i < nConstants; ++i) {
+        Column *col = seg.getColumn(posConstants[i]).get();
+        if (col->isConstant() ? col->first() != valuesConstants[i] :
+                !col->mayContain(valuesConstants[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool InmemoryFCInternalTable::mayContain(const uint8_t nConstants,
+        const uint8_t *posConstants, const Term_t *valuesConstants) const {
+    if (segmentMayContain(*values, nConstants, posConstants, valuesConstants)) {
+        return true;
+    }
+    for (const auto &segment : unmergedSegments) {
+        if (segmentMayContain(*segment.values, nConstants, posConstants,
+                    valuesConstants)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 std::shared_ptr<const FCInternalTable> InmemoryFCInternalTable::filter(const uint8_t nVarsToCopy, const uint8_t *posVarsToCopy,
         const uint8_t nConstantsToFilter, const uint8_t *posConstantsToFilter,
         const Term_t *valuesConstantsToFilter, const uint8_t nRepeatedVars,
@@ -575,6 +726,9 @@ std::shared_ptr<const FCInternalTable> InmemoryFCInternalTable::filter(const uin
                 if (!values->getColumn(posConstantsToFilter[i])->isIn(valuesConstantsToFilter[i])) {
                     match = false;
                 }
+            } else if (!values->getColumn(posConstantsToFilter[i])->mayContain(
+                        valuesConstantsToFilter[i])) {
+                match = false;
             }
         }
     }
@@ -632,6 +786,10 @@ std::shared_ptr<const FCInternalTable> InmemoryFCInternalTable::filter(const uin
 
             if (!found) {
                 isSetBigger = true;
+                if (!itr->values->getColumn(posConstantsToFilter[i])->mayContain(
+                            valuesConstantsToFilter[i])) {
+                    match = false;
+                }
             } else {
                 if (valuesConstantsToFilter[i] != itr->constants[j].second) {
                     match = false;
@@ -790,6 +948,7 @@ FCInternalTableItr *InmemoryFCInternalTable::sortBy(const std::vector<uint8_t> &
     } else {
 #if INMEMINTERNALCACHE
         if (fields.size() <= 3) {
+            std::lock_guard<std::mutex> lock(cachedSortedMutex);
             uint64_t filterByKey = __getKeyFromFieldsFc(fields, fields.size());
             if (cachedSorted.count(filterByKey)) {
                 sortedValues = cachedSorted[filterByKey];
@@ -849,6 +1008,7 @@ FCInternalTableItr *InmemoryFCInternalTable::sortBy(
     } else {
 #if INMEMINTERNALCACHE
         if (fields.size() <= 3) {
+            std::lock_guard<std::mutex> lock(cachedSortedMutex);
             uint64_t filterByKey = __getKeyFromFieldsFc(fields, fields.size());
             if (cachedSorted.count(filterByKey)) {
                 sortedValues = cachedSorted[filterByKey];
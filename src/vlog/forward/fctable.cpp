@@ -2,6 +2,7 @@
 #include <vlog/fctable.h>
 #include <vlog/joinprocessor.h>
 #include <vlog/concepts.h>
+#include <vlog/hash.h>
 
 #include <trident/model/table.h>
 
@@ -11,30 +12,68 @@ FCTable::FCTable(std::mutex *mutex, const uint8_t sizeRow) :
     sizeRow(sizeRow), mutex(mutex) {
     }
 
-std::string FCTable::getSignature(const Literal &literal) {
-    std::string out = "";
+FCCacheKey FCTable::getCacheKey(const Literal &literal) {
+    FCCacheKey key;
+    const int size = literal.getTupleSize();
+    key.terms.resize(size + (size + 63) / 64, 0);
     std::vector<Var_t> existingVars;
-    for (int i = 0; i < literal.getTupleSize(); ++i) {
+    for (int i = 0; i < size; ++i) {
         VTerm t = literal.getTermAtPos(i);
         if (t.isVariable()) {
-            int idx = (int) (-1 * existingVars.size() - 1);
-            bool found = false;
-            for (int j = 0; j < existingVars.size(); ++j) {
+            size_t idx = existingVars.size();
+            for (size_t j = 0; j < existingVars.size(); ++j) {
                 if (existingVars[j] == t.getId()) {
-                    idx = -1 * j - 1;
-                    found = true;
+                    idx = j;
                     break;
                 }
             }
-            if (! found) {
+            if (idx == existingVars.size()) {
                 existingVars.push_back(t.getId());
             }
-            out += " " + std::to_string(idx) + " ";
+            key.terms[i] = idx;
+            key.terms[size + i / 64] |= (uint64_t) 1 << (i % 64);
         } else {
-            out += " " + std::to_string(t.getValue()) + " ";
+            key.terms[i] = t.getValue();
         }
     }
-    return out;
+    const uint64_t h = VLogHash::fnvTerms(key.terms.data(), key.terms.size());
+    key.hash = h ^ (h >> 32);
+    return key;
+}
+
+void FCTable::evict(FCCacheStripe &stripe, const FCCacheKey &keep) {
+    FCCacheManager &m = *cacheManager;
+    std::list<FCCacheRef>::iterator victim = m.lru.end();
+    while (m.bytes > m.budget && victim != m.lru.begin()) {
+        --victim;
+        FCCacheStripe &victimStripe =
+            victim->table->cacheStripes[victim->stripe];
+        if (&victimStripe == &stripe && victim->key == keep) {
+            continue;
+        }
+        //The stripes of the other tables are only tried, since their
+        //threads may be waiting for the lock of the manager
+        std::unique_lock<std::mutex> lock(victimStripe.mutex, std::defer_lock);
+        if (&victimStripe != &stripe && victim->table->mutex != NULL &&
+                !lock.try_lock()) {
+            continue;
+        }
+        auto itr = victimStripe.entries.find(victim->key);
+        m.bytes -= itr->second.bytes;
+        victimStripe.entries.erase(itr);
+        victim = m.lru.erase(victim);
+        m.evictions++;
+    }
+}
+
+FCCacheStats FCCacheManager::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    FCCacheStats stats;
+    stats.hits = hits.load();
+    stats.misses = misses.load();
+    stats.evictions = evictions;
+    stats.bytes = bytes;
+    return stats;
 }
 
 FCIterator FCTable::read(const size_t iteration) const {
@@ -181,18 +220,26 @@ std::shared_ptr<const FCTable> FCTable::filter(const Literal &literal,
         }
         std::shared_ptr<FCTable> output;
         std::vector<FCBlock>::iterator itr = blocks.begin();
-        std::string signature = getSignature(literal);
+        const FCCacheKey key = getCacheKey(literal);
+        FCCacheStripe &stripe = cacheStripes[key.hash % FCCACHE_NSTRIPES];
 
+        // We need a separate lock for the cache. We cannot promote the mutex to an exclusive
+        // lock here, since that leads to deadlocks.
+        std::unique_lock<std::mutex> lock(stripe.mutex, std::defer_lock);
         if (mutex != NULL) {
-            // We need a separate lock for the cache. We cannot promote the mutex to an exclusive
-            // lock here, since that leads to deadlocks.
-            cache_mutex.lock();
+            lock.lock();
         }
 
-        FCCache::iterator cacheItr = cache.find(signature);
-        if (cacheItr != cache.end()) {
+        FCCache::iterator cacheItr = stripe.entries.find(key);
+        if (cacheItr != stripe.entries.end()) {
+            cacheManager->hits++;
             output = cacheItr->second.table;
-            LOG(TRACEL) << "Found cache entry for " + signature;
+            {
+                std::lock_guard<std::mutex> lock(cacheManager->mutex);
+                cacheManager->lru.splice(cacheManager->lru.begin(),
+                        cacheManager->lru, cacheItr->second.lru);
+            }
+            LOG(TRACEL) << "Found cache entry for " + literal.tostring();
 
             //First update the entry if there are more entries. Otherwise return
             if (cacheItr->second.end < blocks[blocks.size() - 1].iteration) {
@@ -200,12 +247,12 @@ std::shared_ptr<const FCTable> FCTable::filter(const Literal &literal,
                     itr++;
                 }
             } else {
-                if (mutex != NULL) {
-                    cache_mutex.unlock();
-                }
                 return output;
             }
         } else {
+            if (cacheManager != NULL) {
+                cacheManager->misses++;
+            }
             output = std::shared_ptr<FCTable>(new FCTable(mutex, literal.getNVars()));
         }
 
@@ -246,15 +293,17 @@ std::shared_ptr<const FCTable> FCTable::filter(const Literal &literal,
             //check if literal subsumes the query
 #ifdef DEBUG
             std::chrono::system_clock::time_point timeFilter = std::chrono::system_clock::now();
-            bool shouldFilter = filterer == NULL ||
-                TableFilterer::intersection(literal, *itr);
+            bool shouldFilter = (filterer == NULL ||
+                    TableFilterer::intersection(literal, *itr)) &&
+                TableFilterer::mayContainConstants(literal, *itr);
             LOG(TRACEL) << "Block query = " << itr->query.tostring(NULL, NULL);
 
             std::chrono::duration<double> secFilter = std::chrono::system_clock::now() - timeFilter;
             LOG(TRACEL) << "Time intersection " << secFilter.count() * 1000 << ", shouldfilter = " << shouldFilter;
 #else
-            bool shouldFilter = filterer == NULL ||
-                TableFilterer::intersection(literal, *itr);
+            bool shouldFilter = (filterer == NULL ||
+                    TableFilterer::intersection(literal, *itr)) &&
+                TableFilterer::mayContainConstants(literal, *itr);
 #endif
             if (shouldFilter) {
                 //Extract only relevant facts with a linear scan
@@ -278,19 +327,33 @@ std::shared_ptr<const FCTable> FCTable::filter(const Literal &literal,
         }
 
         //Store the table in the cache
-        if (cacheItr != cache.end()) {
+        if (cacheManager == NULL) {
+            return output;
+        }
+        const uint64_t bytes = output->getMemoryEstimate();
+        std::lock_guard<std::mutex> managerLock(cacheManager->mutex);
+        if (cacheItr != stripe.entries.end()) {
             //Update the end iteration
             cacheItr->second.end = blocks[blocks.size() - 1].iteration;
-        } else {
+            cacheManager->bytes += bytes;
+            cacheManager->bytes -= cacheItr->second.bytes;
+            cacheItr->second.bytes = bytes;
+        } else if (bytes <= cacheManager->budget) {
             FCCacheBlock b;
             b.table = output;
             b.begin = blocks[0].iteration;
             b.end = blocks[blocks.size() - 1].iteration;
-            cache.insert(std::make_pair(signature, b));
-        }
-        if (mutex != NULL) {
-            cache_mutex.unlock();
+            b.bytes = bytes;
+            FCCacheRef ref;
+            ref.table = this;
+            ref.stripe = &stripe - cacheStripes;
+            ref.key = key;
+            cacheManager->lru.push_front(ref);
+            b.lru = cacheManager->lru.begin();
+            stripe.entries.insert(std::make_pair(key, b));
+            cacheManager->bytes += bytes;
         }
+        evict(stripe, key);
         return output;
     } else {
         throw 10;
@@ -400,10 +463,18 @@ bool FCTable::add(std::shared_ptr<const FCInternalTable> t,
                 lastBlock->table = lastBlock->table->merge(t, nthreads);
 
                 //Invalidate possible subtables which contain partial results
-                for (FCCache::iterator itr = cache.begin(); itr != cache.end(); ++itr) {
-                    if (itr->second.end == lastItr) {
-                        itr->second.end = std::max<Term_t>(0, lastItr - 1);
-                        itr->second.table->removeBlock(lastItr);
+                for (int i = 0; i < FCCACHE_NSTRIPES; ++i) {
+                    FCCacheStripe &stripe = cacheStripes[i];
+                    std::unique_lock<std::mutex> lock(stripe.mutex, std::defer_lock);
+                    if (mutex != NULL) {
+                        lock.lock();
+                    }
+                    for (FCCache::iterator itr = stripe.entries.begin();
+                            itr != stripe.entries.end(); ++itr) {
+                        if (itr->second.end == lastItr) {
+                            itr->second.end = std::max<Term_t>(0, lastItr - 1);
+                            itr->second.table->removeBlock(lastItr);
+                        }
                     }
                 }
                 return false;
@@ -426,6 +497,67 @@ void FCTable::addBlock(FCBlock block) {
     blocks.push_back(block);
 }
 
+void FCTable::replaceBlockTables(
+        const std::vector<std::shared_ptr<const FCInternalTable>> &tables) {
+    assert(tables.size() == blocks.size());
+    std::vector<FCBlock> newBlocks;
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (tables[i] == NULL || tables[i]->isEmpty()) {
+            continue;
+        }
+        const FCBlock &b = blocks[i];
+        newBlocks.push_back(FCBlock(b.iteration, tables[i], b.query,
+                    b.posQueryInRule, b.rule, b.ruleExecOrder, b.isCompleted));
+    }
+    blocks.clear();
+    for (const auto &b : newBlocks) {
+        blocks.push_back(b);
+    }
+    clearCache();
+    std::lock_guard<std::mutex> lock(index_mutex);
+    indices.clear();
+}
+
+void FCTable::findInIndex(const std::vector<std::shared_ptr<Column>> &values,
+        const std::vector<uint8_t> &columnsToCheck,
+        const std::vector<std::pair<int, int>> &equalColumns,
+        std::vector<uint64_t> &output) {
+    std::vector<uint8_t> signature = columnsToCheck;
+    signature.push_back(UINT8_MAX);
+    for (auto &p : equalColumns) {
+        signature.push_back(p.first);
+        signature.push_back(p.second);
+    }
+
+    std::lock_guard<std::mutex> lock(index_mutex);
+    std::unique_ptr<FCTableIndex> &index = indices[signature];
+    if (!index) {
+        index = std::unique_ptr<FCTableIndex>(
+                new FCTableIndex(columnsToCheck, equalColumns));
+    }
+    index->update(blocks);
+
+    const size_t ncols = columnsToCheck.size();
+    std::vector<std::unique_ptr<ColumnReader>> readers;
+    for (auto c : columnsToCheck) {
+        readers.push_back(values[c]->getReader());
+    }
+    const uint64_t nrows = values.empty() ? 0 : values[0]->size();
+    std::vector<Term_t> key(ncols);
+    for (uint64_t i = 0; i < nrows; ++i) {
+        for (size_t j = 0; j < ncols; ++j) {
+            if (!readers[j]->hasNext()) {
+                LOG(ERRORL) << "Should not happen ...";
+                throw 10;
+            }
+            key[j] = readers[j]->next();
+        }
+        if (index->contains(key.data())) {
+            output.push_back(i);
+        }
+    }
+}
+
 void FCTable::removeBlock(const size_t iteration) {
     assert(blocks.size() == 0 || blocks.back().iteration <= iteration);
     if (blocks.size() > 0 && blocks.back().iteration == iteration) {
@@ -455,7 +587,34 @@ size_t FCTable::getNAllRows() const {
     return output;
 }
 
+uint64_t FCTable::getMemoryEstimate() const {
+    uint64_t output = 0;
+    for (const auto &block : blocks) {
+        if (!block.table->isEDB()) {
+            output += block.table->getNRows() * block.table->getRowSize()
+                * sizeof(Term_t);
+        }
+    }
+    return output;
+}
+
+void FCTable::clearCache() {
+    if (cacheManager != NULL) {
+        std::lock_guard<std::mutex> lock(cacheManager->mutex);
+        for (int i = 0; i < FCCACHE_NSTRIPES; ++i) {
+            for (const auto &entry : cacheStripes[i].entries) {
+                cacheManager->bytes -= entry.second.bytes;
+                cacheManager->lru.erase(entry.second.lru);
+            }
+        }
+    }
+    for (int i = 0; i < FCCACHE_NSTRIPES; ++i) {
+        cacheStripes[i].entries.clear();
+    }
+}
+
 FCTable::~FCTable() {
+    clearCache();
 }
 
 FCIterator::FCIterator(
@@ -0,0 +1,117 @@
+#include <vlog/fctableindex.h>
+#include <vlog/fctable.h>
+#include <vlog/hash.h>
+
+#include <kognac/logs.h>
+
+uint64_t FCTableIndex::hashKey(const Term_t *key) const {
+    return VLogHash::mixTerms(key, columns.size());
+}
+
+bool FCTableIndex::equalKey(const Term_t *key, const uint64_t pos) const {
+    const Term_t *existing = keys.data() + pos * columns.size();
+    for (size_t i = 0; i < columns.size(); ++i) {
+        if (existing[i] != key[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void FCTableIndex::insert(const Term_t *key) {
+    if ((nkeys + 1) * 2 > slots.size()) {
+        //Rehash in a table twice as large
+        std::vector<uint64_t> newslots(slots.empty() ? 1024 : slots.size() * 2, 0);
+        const uint64_t mask = newslots.size() - 1;
+        for (uint64_t i = 0; i < nkeys; ++i) {
+            uint64_t pos = hashKey(keys.data() + i * columns.size()) & mask;
+            while (newslots[pos] != 0) {
+                pos = (pos + 1) & mask;
+            }
+            newslots[pos] = i + 1;
+        }
+        slots.swap(newslots);
+    }
+    const uint64_t mask = slots.size() - 1;
+    uint64_t pos = hashKey(key) & mask;
+    while (slots[pos] != 0) {
+        if (equalKey(key, slots[pos] - 1)) {
+            return;
+        }
+        pos = (pos + 1) & mask;
+    }
+    keys.insert(keys.end(), key, key + columns.size());
+    slots[pos] = ++nkeys;
+}
+
+void FCTableIndex::indexTable(const FCInternalTable *table) {
+    const uint8_t rowsize = table->getRowSize();
+    std::vector<std::unique_ptr<ColumnReader>> readers(rowsize);
+    std::vector<bool> used(rowsize, false);
+    for (auto c : columns) {
+        used[c] = true;
+    }
+    for (auto &p : equalColumns) {
+        used[p.first] = true;
+        used[p.second] = true;
+    }
+    for (uint8_t i = 0; i < rowsize; ++i) {
+        if (used[i]) {
+            readers[i] = table->getColumn(i)->getReader();
+        }
+    }
+    std::vector<Term_t> row(rowsize);
+    std::vector<Term_t> key(columns.size());
+    const size_t nrows = table->getNRows();
+    for (size_t r = 0; r < nrows; ++r) {
+        for (uint8_t i = 0; i < rowsize; ++i) {
+            if (used[i]) {
+                if (!readers[i]->hasNext()) {
+                    LOG(ERRORL) << "Should not happen ...";
+                    throw 10;
+                }
+                row[i] = readers[i]->next();
+            }
+        }
+        bool ok = true;
+        for (auto &p : equalColumns) {
+            if (row[p.first] != row[p.second]) {
+                ok = false;
+                break;
+            }
+        }
+        if (ok) {
+            for (size_t i = 0; i < columns.size(); ++i) {
+                key[i] = row[columns[i]];
+            }
+            insert(key.data());
+        }
+    }
+}
+
+void FCTableIndex::update(const std::vector<FCBlock> &blocks) {
+    //A block changes when it is merged with new rows, or when the blocks are
+    //collapsed. Reindexing it is harmless, since rows are never removed.
+    indexedTables.resize(blocks.size());
+    for (size_t i = 0; i < blocks.size(); ++i) {
+        if (indexedTables[i] != blocks[i].table) {
+            indexTable(blocks[i].table.get());
+            indexedTables[i] = blocks[i].table;
+        }
+    }
+}
+
+bool FCTableIndex::contains(const Term_t *key) const {
+    if (nkeys == 0) {
+        return false;
+    }
+    const uint64_t mask = slots.size() - 1;
+    uint64_t pos = hashKey(key) & mask;
+    while (slots[pos] != 0) {
+        if (equalKey(key, slots[pos] - 1)) {
+            return true;
+        }
+        pos = (pos + 1) & mask;
+    }
+    return false;
+}
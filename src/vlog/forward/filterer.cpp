@@ -2,6 +2,7 @@
 #include <vlog/concepts.h>
 #include <vlog/fctable.h>
 #include <vlog/fcinttable.h>
+#include <vlog/profiler.h>
 
 #include <vector>
 
@@ -23,10 +24,29 @@ bool TableFilterer::intersection(const Literal &currentQuery,
     }
 }
 
+bool TableFilterer::mayContainConstants(const Literal &currentQuery,
+        const FCBlock &block) {
+    uint8_t nConstants = 0;
+    uint8_t posConstants[256];
+    Term_t valuesConstants[256];
+    for (int i = 0; i < currentQuery.getTupleSize(); ++i) {
+        const VTerm t = currentQuery.getTermAtPos(i);
+        if (!t.isVariable()) {
+            posConstants[nConstants] = i;
+            valuesConstants[nConstants++] = t.getValue();
+        }
+    }
+    if (nConstants == 0) {
+        return true;
+    }
+    return block.table->mayContain(nConstants, posConstants, valuesConstants);
+}
+
 bool TableFilterer::producedDerivationInPreviousSteps(
         const Literal &outputQuery,
         const Literal &currentQuery,
         const FCBlock *block) {
+    ProfilePhaseTimer timer(PROFILE_FILTERING);
 
     const RuleExecutionDetails *rule = block->rule;
     if (rule == NULL || rule->nIDBs == 0) {
@@ -68,6 +88,7 @@ bool TableFilterer::isEligibleForPartialSubs(
         const FCInternalTable *currentResults,
         const int nPosFromFirst,
         const int nPosFromSecond) {
+    ProfilePhaseTimer timer(PROFILE_FILTERING);
 
     if (!naiver->opt_filter()) {
         LOG(DEBUGL) << "isEligibleForPartialSubs disabled";
@@ -236,6 +257,7 @@ bool TableFilterer::producedDerivationInPreviousStepsWithSubs(
         const std::pair<uint8_t, uint8_t> *posHead,
         const int nPosForLit,
         const std::pair<uint8_t, uint8_t> *posLiteral) {
+    ProfilePhaseTimer timer(PROFILE_FILTERING);
 
     if (outputQueries.size() > 1)
         throw 10; // Work only with one head
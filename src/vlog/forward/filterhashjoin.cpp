@@ -212,9 +212,14 @@ void FilterHashJoin::run(const std::vector<FilterHashJoinBlock> &inputTables, co
         const size_t startCarprod, const size_t endCartprod,
         const std::vector<uint8_t> ps, int &processedTables,
         const std::vector<std::pair<uint8_t, Term_t>> *valueColumnsToFilter,
-        const std::vector<std::pair<uint8_t, uint8_t>> *columnsToFilterOut) {
+        const std::vector<std::pair<uint8_t, uint8_t>> *columnsToFilterOut,
+        std::mutex *tablesMutex) {
 
     std::vector<uint8_t> posToSort = ps;
+    std::unique_lock<std::mutex> lock;
+    if (tablesMutex != NULL) {
+        lock = std::unique_lock<std::mutex>(*tablesMutex, std::defer_lock);
+    }
 
     LOG(TRACEL) << "FilterHashJoin::run: start = " << startCarprod << ", end = " << endCartprod;
     //Calculate the correct offset of the variables to retrieve the existing bindings
@@ -234,11 +239,17 @@ void FilterHashJoin::run(const std::vector<FilterHashJoinBlock> &inputTables, co
     if (inputTables.size() == 1) {
         const FCInternalTable *table = inputTables[0].table;
         FCInternalTableItr *itr;
+        if (tablesMutex != NULL) {
+            lock.lock();
+        }
         if (posToSort.size() > 0) {
             itr = table->sortBy(posToSort);
         } else {
             itr = table->getIterator();
         }
+        if (tablesMutex != NULL) {
+            lock.unlock();
+        }
         if (itr->hasNext()) {
             processedTables++;
 
@@ -251,6 +262,9 @@ void FilterHashJoin::run(const std::vector<FilterHashJoinBlock> &inputTables, co
                         columnsToFilterOut);
             }
         }
+        if (tablesMutex != NULL) {
+            lock.lock();
+        }
         table->releaseIterator(itr);
     } else {
         //Collect all the iterators in a single merged one. Give to each iterator the counter
@@ -267,6 +281,9 @@ void FilterHashJoin::run(const std::vector<FilterHashJoinBlock> &inputTables, co
             sortingCriteria = posToSort;
         }
 
+        if (tablesMutex != NULL) {
+            lock.lock();
+        }
         for (std::vector<FilterHashJoinBlock>::const_iterator itrTable = inputTables.cbegin();
                 itrTable != inputTables.cend(); ++itrTable) {
             const FCInternalTable *table = itrTable->table;
@@ -285,6 +302,9 @@ void FilterHashJoin::run(const std::vector<FilterHashJoinBlock> &inputTables, co
                 table->releaseIterator(itr);
             }
         }
+        if (tablesMutex != NULL) {
+            lock.unlock();
+        }
 
         for (int i = 0; i < tables.size(); ++i) {
             assert(tables[i]->getRowSize() == tables[0]->getRowSize());
@@ -300,6 +320,9 @@ void FilterHashJoin::run(const std::vector<FilterHashJoinBlock> &inputTables, co
                     valueColumnsToFilter, columnsToFilterOut);
         }
         //Release all counters
+        if (tablesMutex != NULL) {
+            lock.lock();
+        }
         for (int i = 0; i < iterators.size(); ++i) {
             tables[i]->releaseIterator(iterators[i].first);
         }
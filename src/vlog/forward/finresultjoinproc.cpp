@@ -1,5 +1,6 @@
 #include <vlog/finalresultjoinproc.h>
 #include <vlog/seminaiver.h>
+#include <vlog/spill.h>
 #include <climits>
 
 void SingleHeadFinalRuleProcessor::processResults(std::vector<int> &blockid, Term_t *p,
@@ -490,12 +491,21 @@ void SingleHeadFinalRuleProcessor::mergeTmpt(const int blockid, const bool uniqu
 }
 #endif
 
+std::shared_ptr<const Segment> SingleHeadFinalRuleProcessor::seal(
+        std::shared_ptr<const Segment> seg) {
+    SegmentSpiller *spiller = t->getSpiller();
+    if (spiller == NULL) {
+        return seg;
+    }
+    return spiller->seal(seg);
+}
+
 void SingleHeadFinalRuleProcessor::consolidateSegment(std::shared_ptr<const Segment> seg) {
     std::shared_ptr<const FCInternalTable> ptrTable(
             new InmemoryFCInternalTable(rowsize,
                 iteration,
                 true,
-                seg));
+                seal(seg)));
     t->add(ptrTable, literal, posLiteralInRule, ruleDetails, ruleExecOrder,
             iteration, true, nthreads);
 }
@@ -531,7 +541,7 @@ void SingleHeadFinalRuleProcessor::consolidate(const bool isFinished,
                                 new InmemoryFCInternalTable(rowsize,
                                     iteration,
                                     true,
-                                    seg));
+                                    seal(seg)));
                         t->add(ptrTable, literal, posLiteralInRule, ruleDetails, ruleExecOrder,
                                 iteration, isFinished, nthreads);
 #if 0
@@ -561,7 +571,7 @@ void SingleHeadFinalRuleProcessor::consolidate(const bool isFinished,
                         else
                             sortedSegment = utmpt[i]->getSegment()->sortBy(NULL, nthreads, false);
 
-                        std::shared_ptr<const FCInternalTable> ptrTable(new InmemoryFCInternalTable(rowsize, iteration, true, sortedSegment));
+                        std::shared_ptr<const FCInternalTable> ptrTable(new InmemoryFCInternalTable(rowsize, iteration, true, seal(sortedSegment)));
 #if 0
                         FCInternalTableItr *test = ptrTable->getIterator();
                         int ncols = test->getNColumns();
@@ -582,7 +592,7 @@ void SingleHeadFinalRuleProcessor::consolidate(const bool isFinished,
                         t->add(ptrTable, literal, posLiteralInRule,
                                 ruleDetails, ruleExecOrder, iteration, isFinished, nthreads);
                     } else {
-                        std::shared_ptr<const FCInternalTable> ptrTable(new InmemoryFCInternalTable(rowsize, iteration, true, utmpt[i]->getSegment()));
+                        std::shared_ptr<const FCInternalTable> ptrTable(new InmemoryFCInternalTable(rowsize, iteration, true, seal(utmpt[i]->getSegment())));
 #if 0
                         FCInternalTableItr *test = ptrTable->getIterator();
                         int ncols = test->getNColumns();
@@ -632,7 +642,7 @@ void SingleHeadFinalRuleProcessor::consolidate(const bool isFinished,
                             new InmemoryFCInternalTable(rowsize,
                                 iteration,
                                 true,
-                                seg));
+                                seal(seg)));
 
 
 #if 0
@@ -0,0 +1,927 @@
+#include <vlog/incremental.h>
+#include <vlog/fctable.h>
+#include <vlog/fcinttable.h>
+#include <vlog/segment.h>
+#include <vlog/column.h>
+#include <vlog/inmemory/inmemorytable.h>
+
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <chrono>
+#include <functional>
+#include <set>
+
+//Which facts of a relation are visible during an evaluation
+typedef enum IncrView {
+    OLD_VIEW, //The facts before the update
+    NEW_VIEW  //The facts before the update, minus the removed, plus the added
+} IncrView;
+
+struct IncrAtom {
+    Predicate pred;
+    //For every position, the index of the variable in the rule or -1 if
+    //the position contains a constant
+    std::vector<int> vars;
+    std::vector<Term_t> consts;
+
+    IncrAtom(const Literal &l, std::map<Var_t, int> &varIdx) :
+        pred(l.getPredicate()) {
+            for (int i = 0; i < l.getTupleSize(); ++i) {
+                const VTerm t = l.getTermAtPos(i);
+                if (t.isVariable()) {
+                    if (!varIdx.count(t.getId())) {
+                        const int idx = varIdx.size();
+                        varIdx[t.getId()] = idx;
+                    }
+                    vars.push_back(varIdx[t.getId()]);
+                    consts.push_back(0);
+                } else {
+                    vars.push_back(-1);
+                    consts.push_back(t.getValue());
+                }
+            }
+        }
+
+    uint8_t arity() const {
+        return vars.size();
+    }
+};
+
+struct IncrRule {
+    std::vector<IncrAtom> heads;
+    std::vector<IncrAtom> body;
+    int nvars;
+    bool supported;
+};
+
+//A block of an IDB table. Its rows are copied only when the block is read,
+//and are kept with their indexes as long as the block does not change
+struct IncrBlock {
+    std::shared_ptr<const FCInternalTable> table;
+    size_t iteration;
+
+    bool loaded;
+    //The rows of the block, one after the other
+    std::vector<Term_t> rows;
+    //Hash indexes on rows, by bitmask of the positions that are bound
+    std::map<uint64_t, std::unordered_multimap<uint64_t, size_t>> indexes;
+
+    IncrBlock(std::shared_ptr<const FCInternalTable> table,
+            const size_t iteration) : table(table), iteration(iteration),
+    loaded(false) {
+    }
+
+    size_t getNRows(const uint8_t arity) const {
+        return arity == 0 ? 0 : rows.size() / arity;
+    }
+};
+
+struct IncrRelation {
+    Predicate pred;
+    const bool edb;
+    const uint8_t arity;
+
+    //The blocks of the IDB table before the update. They are synchronized
+    //with the table at the first read of every update
+    bool synced;
+    std::vector<std::unique_ptr<IncrBlock>> blocks;
+
+    IncrTupleSet removed;
+    IncrTupleSet added;
+
+    IncrRelation(const Predicate &pred) : pred(pred),
+    edb(pred.getType() == EDB), arity(pred.getCardinality()),
+    synced(false) {
+    }
+};
+
+static bool matches(const Term_t *row,
+        const std::vector<std::pair<uint8_t, Term_t>> &bound) {
+    for (const auto &b : bound) {
+        if (row[b.first] != b.second) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//Reads the facts of relations and evaluates rules. It does not change
+//the relations
+class IncrEvaluator {
+    private:
+        SemiNaiver &sn;
+        EDBLayer &layer;
+
+        //Scans the rows of a block of an IDB table
+        bool scanBlock(IncrBlock &block, const uint8_t arity,
+                const std::vector<std::pair<uint8_t, Term_t>> &bound,
+                const std::function<bool(const Term_t *)> &callback) {
+            load(block, arity);
+            const size_t nrows = block.getNRows(arity);
+            if (bound.empty() || arity > 64) {
+                for (size_t i = 0; i < nrows; ++i) {
+                    const Term_t *r = &block.rows[i * arity];
+                    if (matches(r, bound) && !callback(r)) {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            uint64_t mask = 0;
+            Term_t values[256];
+            for (int i = 0; i < bound.size(); ++i) {
+                mask |= (uint64_t) 1 << bound[i].first;
+            }
+            //The values must be hashed in the order of the positions
+            int n = 0;
+            for (int i = 0; i < arity; ++i) {
+                if (mask & ((uint64_t) 1 << i)) {
+                    for (const auto &b : bound) {
+                        if (b.first == i) {
+                            values[n++] = b.second;
+                            break;
+                        }
+                    }
+                }
+            }
+
+            auto idx = block.indexes.find(mask);
+            if (idx == block.indexes.end()) {
+                std::unordered_multimap<uint64_t, size_t> &index = block.indexes[mask];
+                index.reserve(nrows);
+                Term_t key[256];
+                for (size_t i = 0; i < nrows; ++i) {
+                    const Term_t *r = &block.rows[i * arity];
+                    int m = 0;
+                    for (int j = 0; j < arity; ++j) {
+                        if (mask & ((uint64_t) 1 << j)) {
+                            key[m++] = r[j];
+                        }
+                    }
+                    index.insert(std::make_pair(VLogHash::fnvTerms(key, m), i));
+                }
+                idx = block.indexes.find(mask);
+            }
+            auto range = idx->second.equal_range(VLogHash::fnvTerms(values, n));
+            for (auto itr = range.first; itr != range.second; ++itr) {
+                const Term_t *r = &block.rows[itr->second * arity];
+                if (matches(r, bound) && !callback(r)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        //Scans the facts of the relation before the update
+        bool scanBase(IncrRelation &rel,
+                const std::vector<std::pair<uint8_t, Term_t>> &bound,
+                const std::function<bool(const Term_t *)> &callback) {
+            Term_t row[256];
+            if (rel.edb) {
+                VTuple t(rel.arity);
+                for (int i = 0; i < rel.arity; ++i) {
+                    t.set(VTerm(i + 1, 0), i);
+                }
+                for (const auto &b : bound) {
+                    t.set(VTerm(0, b.second), b.first);
+                }
+                Literal query(rel.pred, t);
+                EDBIterator *itr = layer.getIterator(query);
+                bool cont = true;
+                while (cont && itr->hasNext()) {
+                    itr->next();
+                    for (int i = 0; i < rel.arity; ++i) {
+                        row[i] = itr->getElementAt(i);
+                    }
+                    if (matches(row, bound)) {
+                        cont = callback(row);
+                    }
+                }
+                layer.releaseIterator(itr);
+                return cont;
+            }
+
+            //The zone maps of the blocks exclude most of the blocks that do
+            //not contain the bound values, so they are not read
+            sync(rel);
+            uint8_t nbound = 0;
+            uint8_t posBound[256];
+            Term_t valuesBound[256];
+            for (const auto &b : bound) {
+                posBound[nbound] = b.first;
+                valuesBound[nbound++] = b.second;
+            }
+            for (auto &block : rel.blocks) {
+                if (nbound > 0 && !block->table->mayContain(nbound, posBound,
+                            valuesBound)) {
+                    continue;
+                }
+                if (!scanBlock(*block, rel.arity, bound, callback)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+    public:
+        IncrEvaluator(SemiNaiver &sn, EDBLayer &layer) : sn(sn), layer(layer) {
+        }
+
+        //Brings the blocks of rel up to date with the blocks of its table.
+        //The blocks that did not change since the previous update keep
+        //their rows and indexes
+        void sync(IncrRelation &rel) {
+            if (rel.synced) {
+                return;
+            }
+            rel.synced = true;
+            std::vector<std::unique_ptr<IncrBlock>> blocks;
+            FCIterator itr = sn.getTable(rel.pred.getId());
+            while (!itr.isEmpty()) {
+                std::shared_ptr<const FCInternalTable> table = itr.getCurrentTable();
+                std::unique_ptr<IncrBlock> block;
+                for (auto &b : rel.blocks) {
+                    if (b != NULL && b->table == table) {
+                        block = std::move(b);
+                        break;
+                    }
+                }
+                if (block == NULL) {
+                    block = std::unique_ptr<IncrBlock>(new IncrBlock(table,
+                                itr.getCurrentIteration()));
+                }
+                blocks.push_back(std::move(block));
+                itr.moveNextCount();
+            }
+            rel.blocks.swap(blocks);
+        }
+
+        void load(IncrBlock &block, const uint8_t arity) {
+            if (block.loaded) {
+                return;
+            }
+            block.loaded = true;
+            FCInternalTableItr *titr = block.table->getIterator();
+            while (titr->hasNext()) {
+                titr->next();
+                for (int i = 0; i < arity; ++i) {
+                    block.rows.push_back(titr->getCurrentValue(i));
+                }
+            }
+            block.table->releaseIterator(titr);
+        }
+
+        //Invokes callback on every fact of rel in view that has the bound
+        //values. Stops if callback returns false.
+        bool scan(IncrRelation &rel, const IncrView view,
+                const std::vector<std::pair<uint8_t, Term_t>> &bound,
+                const std::function<bool(const Term_t *)> &callback) {
+            if (view == OLD_VIEW || rel.removed.empty()) {
+                if (!scanBase(rel, bound, callback)) {
+                    return false;
+                }
+            } else {
+                IncrTuple t(rel.arity);
+                bool cont = scanBase(rel, bound, [&](const Term_t *row) {
+                        t.assign(row, row + rel.arity);
+                        if (rel.removed.count(t)) {
+                            return true;
+                        }
+                        return callback(row);
+                        });
+                if (!cont) {
+                    return false;
+                }
+            }
+            if (view == NEW_VIEW) {
+                for (const auto &t : rel.added) {
+                    if (matches(t.data(), bound) && !callback(t.data())) {
+                        return false;
+                    }
+                }
+            }
+            return true;
+        }
+
+        bool contains(IncrRelation &rel, const IncrView view,
+                const IncrTuple &t) {
+            if (view == NEW_VIEW) {
+                if (rel.added.count(t)) {
+                    return true;
+                }
+                if (rel.removed.count(t)) {
+                    return false;
+                }
+            }
+            std::vector<std::pair<uint8_t, Term_t>> bound;
+            for (int i = 0; i < rel.arity; ++i) {
+                bound.push_back(std::make_pair(i, t[i]));
+            }
+            return !scanBase(rel, bound, [](const Term_t *) {
+                    return false;
+                    });
+        }
+
+        //Binds the variables of atom to the values in row. Returns false if
+        //row does not match the atom. The newly bound variables are
+        //appended to newVars.
+        static bool unify(const IncrAtom &atom, const Term_t *row,
+                std::vector<Term_t> &binding, std::vector<char> &isBound,
+                std::vector<int> &newVars) {
+            for (int i = 0; i < atom.arity(); ++i) {
+                const int v = atom.vars[i];
+                if (v == -1) {
+                    if (atom.consts[i] != row[i]) {
+                        return false;
+                    }
+                } else if (isBound[v]) {
+                    if (binding[v] != row[i]) {
+                        return false;
+                    }
+                } else {
+                    binding[v] = row[i];
+                    isBound[v] = 1;
+                    newVars.push_back(v);
+                }
+            }
+            return true;
+        }
+
+        static void unbind(std::vector<char> &isBound, std::vector<int> &vars,
+                const size_t from) {
+            for (size_t i = from; i < vars.size(); ++i) {
+                isBound[vars[i]] = 0;
+            }
+            vars.resize(from);
+        }
+
+        static IncrTuple instantiate(const IncrAtom &atom,
+                const std::vector<Term_t> &binding) {
+            IncrTuple t(atom.arity());
+            for (int i = 0; i < atom.arity(); ++i) {
+                t[i] = atom.vars[i] == -1 ? atom.consts[i] : binding[atom.vars[i]];
+            }
+            return t;
+        }
+
+        //Joins the body atoms that are not done yet. At every step, the
+        //atom with most bound positions is joined next. emit is invoked
+        //for every complete binding; if it returns false the join stops.
+        bool join(const IncrRule &rule, std::vector<char> &done,
+                const size_t ndone, std::vector<Term_t> &binding,
+                std::vector<char> &isBound, const IncrView view,
+                const std::function<IncrRelation&(const Predicate&)> &getRelation,
+                const std::function<bool()> &emit) {
+            if (ndone == rule.body.size()) {
+                return emit();
+            }
+
+            int next = -1;
+            int maxBound = -1;
+            for (int i = 0; i < rule.body.size(); ++i) {
+                if (done[i]) {
+                    continue;
+                }
+                int nbound = 0;
+                for (const int v : rule.body[i].vars) {
+                    if (v == -1 || isBound[v]) {
+                        nbound++;
+                    }
+                }
+                if (nbound > maxBound) {
+                    maxBound = nbound;
+                    next = i;
+                }
+            }
+
+            const IncrAtom &atom = rule.body[next];
+            std::vector<std::pair<uint8_t, Term_t>> bound;
+            for (int i = 0; i < atom.arity(); ++i) {
+                const int v = atom.vars[i];
+                if (v == -1) {
+                    bound.push_back(std::make_pair(i, atom.consts[i]));
+                } else if (isBound[v]) {
+                    bound.push_back(std::make_pair(i, binding[v]));
+                }
+            }
+
+            done[next] = 1;
+            std::vector<int> newVars;
+            bool cont = scan(getRelation(atom.pred), view, bound,
+                    [&](const Term_t *row) {
+                    bool c = true;
+                    if (unify(atom, row, binding, isBound, newVars)) {
+                        c = join(rule, done, ndone + 1, binding, isBound,
+                                view, getRelation, emit);
+                    }
+                    unbind(isBound, newVars, 0);
+                    return c;
+                    });
+            done[next] = 0;
+            return cont;
+        }
+};
+
+IncrementalMaterializer::IncrementalMaterializer(SemiNaiver &sn,
+        EDBLayer &layer, Program &program) : sn(sn), layer(layer),
+    program(program) {
+        for (const Rule &r : program.getAllRules()) {
+            std::unique_ptr<IncrRule> rule(new IncrRule());
+            std::map<Var_t, int> varIdx;
+            rule->supported = !r.isExistential() && !r.getBody().empty();
+            for (const Literal &l : r.getBody()) {
+                rule->supported &= !l.isNegated();
+                rule->body.push_back(IncrAtom(l, varIdx));
+            }
+            for (const Literal &l : r.getHeads()) {
+                rule->supported &= l.getPredicate().getType() != EDB;
+                rule->heads.push_back(IncrAtom(l, varIdx));
+            }
+            rule->nvars = varIdx.size();
+            rules.push_back(std::move(rule));
+        }
+    }
+
+bool IncrementalMaterializer::isSupported() const {
+    for (const auto &rule : rules) {
+        if (!rule->supported) {
+            return false;
+        }
+    }
+    return true;
+}
+
+IncrRelation &IncrementalMaterializer::getRelation(const Predicate &pred) {
+    auto itr = relations.find(pred.getId());
+    if (itr == relations.end()) {
+        IncrRelation *rel = new IncrRelation(Predicate(pred.getId(), 0,
+                    pred.getType(), pred.getCardinality()));
+        relations[pred.getId()] = std::unique_ptr<IncrRelation>(rel);
+        return *rel;
+    }
+    return *itr->second;
+}
+
+void IncrementalMaterializer::addFacts(const PredId_t pred,
+        const std::vector<Term_t> &rows) {
+    const uint8_t arity = layer.getPredArity(pred);
+    IncrTupleSet &set = edbInsertions[pred];
+    for (size_t i = 0; i + arity <= rows.size(); i += arity) {
+        set.insert(IncrTuple(rows.begin() + i, rows.begin() + i + arity));
+    }
+}
+
+void IncrementalMaterializer::removeFacts(const PredId_t pred,
+        const std::vector<Term_t> &rows) {
+    const uint8_t arity = layer.getPredArity(pred);
+    IncrTupleSet &set = edbDeletions[pred];
+    for (size_t i = 0; i + arity <= rows.size(); i += arity) {
+        set.insert(IncrTuple(rows.begin() + i, rows.begin() + i + arity));
+    }
+}
+
+static std::vector<Term_t> encodeRows(EDBLayer &layer, Program &program,
+        std::string pred, std::vector<std::vector<std::string>> &rows,
+        PredId_t &predId) {
+    Predicate p = program.getPredicate(pred);
+    if (p.getType() != EDB) {
+        std::string e = "Predicate \"" + pred + "\" is not an EDB predicate";
+        LOG(ERRORL) << e;
+        throw (e);
+    }
+    predId = p.getId();
+    std::vector<Term_t> out;
+    for (auto &row : rows) {
+        if (row.size() != p.getCardinality()) {
+            std::string e = "Wrong arity of a fact of predicate \"" + pred + "\"";
+            LOG(ERRORL) << e;
+            throw (e);
+        }
+        for (auto &term : row) {
+            uint64_t val;
+            layer.getOrAddDictNumber(term.c_str(), term.size(), val);
+            out.push_back(val);
+        }
+    }
+    return out;
+}
+
+void IncrementalMaterializer::addFacts(std::string pred,
+        std::vector<std::vector<std::string>> &rows) {
+    PredId_t id;
+    std::vector<Term_t> values = encodeRows(layer, program, pred, rows, id);
+    addFacts(id, values);
+}
+
+void IncrementalMaterializer::removeFacts(std::string pred,
+        std::vector<std::vector<std::string>> &rows) {
+    PredId_t id;
+    std::vector<Term_t> values = encodeRows(layer, program, pred, rows, id);
+    removeFacts(id, values);
+}
+
+void IncrementalMaterializer::readFacts(std::string file, bool remove) {
+    std::ifstream ifs(file);
+    if (ifs.fail()) {
+        std::string e = "Could not open file " + file;
+        LOG(ERRORL) << e;
+        throw (e);
+    }
+    std::map<std::string, std::vector<std::vector<std::string>>> facts;
+    while (!ifs.eof()) {
+        std::vector<std::string> row = readRow(ifs);
+        if (row.size() < 2) {
+            continue;
+        }
+        std::string pred = row[0];
+        row.erase(row.begin());
+        facts[pred].push_back(row);
+    }
+    for (auto &p : facts) {
+        LOG(INFOL) << (remove ? "Removing " : "Adding ") << p.second.size()
+            << " facts of predicate " << p.first;
+        if (remove) {
+            removeFacts(p.first, p.second);
+        } else {
+            addFacts(p.first, p.second);
+        }
+    }
+}
+
+//Evaluates the rule with the atom at position posDelta restricted to the
+//facts in delta, and the other atoms on view. emit receives the
+//instantiated heads.
+static void evalDelta(IncrEvaluator &eval, const IncrRule &rule,
+        const int posDelta, const IncrTupleSet &delta, const IncrView view,
+        const std::function<IncrRelation&(const Predicate&)> &getRelation,
+        const std::function<void(const IncrAtom&, const IncrTuple&)> &emit) {
+    std::vector<Term_t> binding(rule.nvars);
+    std::vector<char> isBound(rule.nvars);
+    std::vector<char> done(rule.body.size());
+    std::vector<int> newVars;
+    done[posDelta] = 1;
+    for (const IncrTuple &t : delta) {
+        if (IncrEvaluator::unify(rule.body[posDelta], t.data(), binding,
+                    isBound, newVars)) {
+            eval.join(rule, done, 1, binding, isBound, view, getRelation,
+                    [&]() {
+                    for (const IncrAtom &head : rule.heads) {
+                    emit(head, IncrEvaluator::instantiate(head, binding));
+                    }
+                    return true;
+                    });
+        }
+        IncrEvaluator::unbind(isBound, newVars, 0);
+    }
+}
+
+void IncrementalMaterializer::overdelete() {
+    IncrEvaluator eval(sn, layer);
+    auto getRel = [&](const Predicate &p) -> IncrRelation& {
+        return getRelation(p);
+    };
+    std::map<PredId_t, IncrTupleSet> delta;
+    for (auto &p : relations) {
+        if (p.second->edb && !p.second->removed.empty()) {
+            delta[p.first] = p.second->removed;
+        }
+    }
+
+    size_t round = 0;
+    size_t total = 0;
+    while (!delta.empty()) {
+        std::vector<std::pair<const IncrAtom*, IncrTuple>> derived;
+        for (const auto &rule : rules) {
+            for (int i = 0; i < rule->body.size(); ++i) {
+                auto d = delta.find(rule->body[i].pred.getId());
+                if (d == delta.end()) {
+                    continue;
+                }
+                evalDelta(eval, *rule, i, d->second, OLD_VIEW, getRel,
+                        [&](const IncrAtom &head, const IncrTuple &t) {
+                        derived.push_back(std::make_pair(&head, t));
+                        });
+            }
+        }
+        std::map<PredId_t, IncrTupleSet> next;
+        for (auto &d : derived) {
+            IncrRelation &rel = getRelation(d.first->pred);
+            if (rel.removed.insert(d.second).second) {
+                next[rel.pred.getId()].insert(d.second);
+                total++;
+            }
+        }
+        delta.swap(next);
+        round++;
+    }
+    LOG(INFOL) << "Overdeleted " << total << " facts in " << round << " rounds";
+}
+
+void IncrementalMaterializer::rederive() {
+    IncrEvaluator eval(sn, layer);
+    auto getRel = [&](const Predicate &p) -> IncrRelation& {
+        return getRelation(p);
+    };
+    std::vector<std::pair<IncrRelation*, IncrTuple>> rederived;
+    for (auto &p : relations) {
+        IncrRelation &rel = *p.second;
+        if (rel.edb || rel.removed.empty()) {
+            continue;
+        }
+        for (const IncrTuple &t : rel.removed) {
+            bool found = false;
+            for (const auto &rule : rules) {
+                for (const IncrAtom &head : rule->heads) {
+                    if (found || head.pred.getId() != p.first) {
+                        continue;
+                    }
+                    std::vector<Term_t> binding(rule->nvars);
+                    std::vector<char> isBound(rule->nvars);
+                    std::vector<char> done(rule->body.size());
+                    std::vector<int> newVars;
+                    if (IncrEvaluator::unify(head, t.data(), binding, isBound,
+                                newVars)) {
+                        eval.join(*rule, done, 0, binding, isBound, NEW_VIEW,
+                                getRel, [&]() {
+                                found = true;
+                                return false;
+                                });
+                    }
+                }
+                if (found) {
+                    break;
+                }
+            }
+            if (found) {
+                rederived.push_back(std::make_pair(&rel, t));
+            }
+        }
+    }
+    for (auto &r : rederived) {
+        r.first->added.insert(r.second);
+    }
+    LOG(INFOL) << "Rederived " << rederived.size() << " facts";
+}
+
+void IncrementalMaterializer::insert() {
+    IncrEvaluator eval(sn, layer);
+    auto getRel = [&](const Predicate &p) -> IncrRelation& {
+        return getRelation(p);
+    };
+    std::map<PredId_t, IncrTupleSet> delta;
+    for (auto &p : relations) {
+        if (!p.second->added.empty()) {
+            delta[p.first] = p.second->added;
+        }
+    }
+
+    size_t round = 0;
+    size_t total = 0;
+    while (!delta.empty()) {
+        std::vector<std::pair<const IncrAtom*, IncrTuple>> derived;
+        for (const auto &rule : rules) {
+            for (int i = 0; i < rule->body.size(); ++i) {
+                auto d = delta.find(rule->body[i].pred.getId());
+                if (d == delta.end()) {
+                    continue;
+                }
+                evalDelta(eval, *rule, i, d->second, NEW_VIEW, getRel,
+                        [&](const IncrAtom &head, const IncrTuple &t) {
+                        derived.push_back(std::make_pair(&head, t));
+                        });
+            }
+        }
+        std::map<PredId_t, IncrTupleSet> next;
+        for (auto &d : derived) {
+            IncrRelation &rel = getRelation(d.first->pred);
+            if (!eval.contains(rel, NEW_VIEW, d.second)) {
+                rel.added.insert(d.second);
+                next[rel.pred.getId()].insert(d.second);
+                total++;
+            }
+        }
+        delta.swap(next);
+        round++;
+    }
+    LOG(INFOL) << "Inserted " << total << " facts in " << round << " rounds";
+}
+
+//Returns true if the table contains EDB columns that read one of the
+//predicates in preds
+static bool readsEDB(const FCInternalTable *table,
+        const std::set<PredId_t> &preds) {
+    for (int i = 0; i < table->getRowSize(); ++i) {
+        std::shared_ptr<Column> col = table->getColumn(i);
+        if (col == NULL || !col->isEDB()) {
+            continue;
+        }
+        EDBColumn *edbCol = dynamic_cast<EDBColumn*>(col.get());
+        if (edbCol == NULL || preds.count(
+                    edbCol->getLiteral().getPredicate().getId())) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static bool readsEDB(FCIterator itr, const std::set<PredId_t> &preds) {
+    while (!itr.isEmpty()) {
+        if (readsEDB(itr.getCurrentTable().get(), preds)) {
+            return true;
+        }
+        itr.moveNextCount();
+    }
+    return false;
+}
+
+void IncrementalMaterializer::apply() {
+    IncrEvaluator eval(sn, layer);
+    std::set<PredId_t> updatedEDB;
+    for (auto &p : relations) {
+        if (p.second->edb && (!p.second->removed.empty() ||
+                    !p.second->added.empty())) {
+            updatedEDB.insert(p.first);
+        }
+    }
+
+    //The removed facts are deleted in place: only the blocks that may
+    //contain them are copied without them. The blocks that read the EDB
+    //tables that are rewritten are copied as well, and this must happen
+    //before the EDB tables change
+    std::vector<uint8_t> allPos;
+    for (PredId_t pid : program.getAllPredicateIDs()) {
+        if (!program.isPredicateIDB(pid)) {
+            continue;
+        }
+        auto r = relations.find(pid);
+        IncrTupleSet netRemoved;
+        if (r != relations.end()) {
+            for (const IncrTuple &t : r->second->removed) {
+                if (!r->second->added.count(t)) {
+                    netRemoved.insert(t);
+                }
+            }
+        }
+        if (netRemoved.empty() && (updatedEDB.empty() ||
+                    !readsEDB(sn.getTable(pid), updatedEDB))) {
+            continue;
+        }
+
+        IncrRelation &rel = getRelation(program.getPredicate(pid));
+        eval.sync(rel);
+        while (allPos.size() < rel.arity) {
+            allPos.push_back(allPos.size());
+        }
+        std::vector<std::shared_ptr<const FCInternalTable>> tables;
+        size_t nchanged = 0;
+        size_t nremoved = 0;
+        for (auto &block : rel.blocks) {
+            bool change = readsEDB(block->table.get(), updatedEDB);
+            for (auto itr = netRemoved.begin(); !change &&
+                    itr != netRemoved.end(); ++itr) {
+                change = block->table->mayContain(rel.arity, allPos.data(),
+                        itr->data());
+            }
+            if (!change) {
+                tables.push_back(block->table);
+                continue;
+            }
+            eval.load(*block, rel.arity);
+            std::vector<Term_t> rows;
+            SegmentInserter inserter(rel.arity);
+            IncrTuple t(rel.arity);
+            for (size_t i = 0; i < block->getNRows(rel.arity); ++i) {
+                const Term_t *row = &block->rows[i * rel.arity];
+                t.assign(row, row + rel.arity);
+                if (netRemoved.count(t)) {
+                    nremoved++;
+                    continue;
+                }
+                inserter.addRow(row);
+                rows.insert(rows.end(), row, row + rel.arity);
+            }
+            std::shared_ptr<const FCInternalTable> newTable;
+            if (!inserter.isEmpty()) {
+                newTable = std::shared_ptr<const FCInternalTable>(
+                        new InmemoryFCInternalTable(rel.arity, block->iteration,
+                            block->table->isSorted(), inserter.getSegment()));
+            }
+            block->table = newTable;
+            block->rows.swap(rows);
+            block->indexes.clear();
+            tables.push_back(newTable);
+            nchanged++;
+        }
+        if (nchanged > 0) {
+            LOG(DEBUGL) << "Removed " << nremoved << " facts of predicate "
+                << pid << " from " << nchanged << " blocks";
+            sn.getTable(pid, rel.arity)->replaceBlockTables(tables);
+        }
+    }
+
+    //Rewrite the EDB tables
+    for (PredId_t pid : updatedEDB) {
+        IncrRelation &rel = *relations[pid];
+        if (layer.getPredType(pid) != "INMEMORY") {
+            LOG(WARNL) << "The table of predicate " << layer.getPredName(pid)
+                << " is copied in main memory to apply the update";
+        }
+        std::vector<uint64_t> rows;
+        std::vector<std::pair<uint8_t, Term_t>> bound;
+        eval.scan(rel, NEW_VIEW, bound, [&](const Term_t *row) {
+                rows.insert(rows.end(), row, row + rel.arity);
+                return true;
+                });
+        layer.addInmemoryTable(pid, rel.arity, rows);
+        //The table will be read again from the EDB layer
+        sn.replaceTable(pid, NULL);
+    }
+
+    //The added facts are appended to the IDB tables as a new block
+    const size_t iteration = sn.nextIteration();
+    for (auto &p : relations) {
+        IncrRelation &rel = *p.second;
+        if (rel.edb) {
+            continue;
+        }
+        SegmentInserter inserter(rel.arity);
+        for (const IncrTuple &t : rel.added) {
+            if (!rel.removed.count(t)) {
+                inserter.addRow(t.data());
+            }
+        }
+        if (inserter.isEmpty()) {
+            continue;
+        }
+
+        LOG(DEBUGL) << "Adding " << inserter.getNRows()
+            << " facts to the table of predicate " << p.first;
+        FCTable *table = sn.getTable(p.first, rel.arity);
+        std::shared_ptr<const FCInternalTable> newTable(
+                new InmemoryFCInternalTable(rel.arity, iteration, true,
+                    inserter.getSortedAndUniqueSegment()));
+        VTuple t(rel.arity);
+        for (int i = 0; i < rel.arity; ++i) {
+            t.set(VTerm(i + 1, 0), i);
+        }
+        table->addBlock(FCBlock(iteration, newTable, Literal(rel.pred, t),
+                    0, NULL, 0, true));
+    }
+}
+
+void IncrementalMaterializer::update() {
+    if (!isSupported()) {
+        LOG(ERRORL) << "The program contains rules with existential variables"
+            " or negation, which cannot be maintained incrementally";
+        throw 10;
+    }
+    std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
+
+    //Retain only the updates that change the EDB
+    IncrEvaluator eval(sn, layer);
+    for (auto &p : edbDeletions) {
+        IncrRelation &rel = getRelation(program.getPredicate(p.first));
+        for (const IncrTuple &t : p.second) {
+            if (eval.contains(rel, OLD_VIEW, t)) {
+                rel.removed.insert(t);
+            }
+        }
+    }
+    for (auto &p : edbInsertions) {
+        IncrRelation &rel = getRelation(program.getPredicate(p.first));
+        for (const IncrTuple &t : p.second) {
+            if (!eval.contains(rel, NEW_VIEW, t)) {
+                rel.added.insert(t);
+            }
+        }
+    }
+    edbDeletions.clear();
+    edbInsertions.clear();
+
+    overdelete();
+    rederive();
+    insert();
+    apply();
+
+    //The blocks of the IDB tables are kept for the following updates, so
+    //that only the blocks that change are read and indexed again
+    for (auto itr = relations.begin(); itr != relations.end();) {
+        if (itr->second->edb) {
+            itr = relations.erase(itr);
+        } else {
+            itr->second->removed.clear();
+            itr->second->added.clear();
+            itr->second->synced = false;
+            ++itr;
+        }
+    }
+
+    std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
+    LOG(INFOL) << "Runtime incremental update = " << sec.count() * 1000
+        << " milliseconds";
+}
+
+IncrementalMaterializer::~IncrementalMaterializer() {
+}
@@ -0,0 +1,259 @@
+#include <vlog/joinorder.h>
+
+#include <kognac/logs.h>
+
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+double JoinOrderOptimizer::sampleDistinct(const Column *column) {
+    const size_t n = column->size();
+    if (n == 0) {
+        return 0;
+    }
+    if (column->isConstant()) {
+        return 1;
+    }
+    if (!column->supportsDirectAccess()) {
+        return n;
+    }
+    //Guaranteed-error estimator (Charikar et al.) on an evenly spaced sample
+    const size_t r = std::min<size_t>(n, JOINORDER_SAMPLE_SIZE);
+    std::vector<Term_t> sample;
+    sample.reserve(r);
+    for (size_t i = 0; i < r; ++i) {
+        sample.push_back(column->getValue(i * n / r));
+    }
+    std::sort(sample.begin(), sample.end());
+    double f1 = 0, others = 0;
+    size_t i = 0;
+    while (i < r) {
+        size_t j = i + 1;
+        while (j < r && sample[j] == sample[i]) {
+            j++;
+        }
+        if (j - i == 1) {
+            f1++;
+        } else {
+            others++;
+        }
+        i = j;
+    }
+    return std::min<double>(n, std::sqrt((double) n / r) * f1 + others);
+}
+
+const std::vector<double> &JoinOrderOptimizer::getBlockStats(
+        std::shared_ptr<const FCInternalTable> table) {
+    auto it = blockStats.find(table.get());
+    if (it != blockStats.end() && it->second.first.lock() == table) {
+        return it->second.second;
+    }
+    if (blockStats.size() > 100000) {
+        //Drop the statistics of the blocks that no longer exist
+        for (auto i = blockStats.begin(); i != blockStats.end();) {
+            if (i->second.first.expired()) {
+                i = blockStats.erase(i);
+            } else {
+                ++i;
+            }
+        }
+    }
+    std::vector<double> distinct;
+    for (uint8_t i = 0; i < table->getRowSize(); ++i) {
+        distinct.push_back(sampleDistinct(table->getColumn(i).get()));
+    }
+    auto &entry = blockStats[table.get()];
+    entry.first = table;
+    entry.second = distinct;
+    return entry.second;
+}
+
+std::vector<double> JoinOrderOptimizer::getEDBDistinct(const Literal &literal,
+        EDBLayer &layer, const size_t card) {
+    std::lock_guard<std::mutex> lock(mutex);
+    const std::string key = literal.tostring();
+    auto it = edbStats.find(key);
+    if (it != edbStats.end() && it->second.first == card) {
+        return it->second.second;
+    }
+    //Not all the layers can count the distinct values of a column
+    const std::string type = layer.getTypeEDBPredicate(
+            literal.getPredicate().getId());
+    const bool supported = type == "" || type == "Trident" || type == "INMEMORY";
+    std::vector<double> distinct;
+    for (uint8_t i = 0; i < literal.getTupleSize(); ++i) {
+        if (!literal.getTermAtPos(i).isVariable()) {
+            distinct.push_back(1);
+        } else if (supported) {
+            distinct.push_back(std::min<double>(card,
+                        layer.getCardinalityColumn(literal, i)));
+        } else {
+            distinct.push_back(card);
+        }
+    }
+    edbStats[key] = std::make_pair(card, distinct);
+    return distinct;
+}
+
+std::vector<double> JoinOrderOptimizer::getIDBDistinct(const Literal &literal,
+        FCIterator itr, const size_t card) {
+    std::lock_guard<std::mutex> lock(mutex);
+    //The values of different blocks may overlap: the sum is an upper bound
+    std::vector<double> distinct(literal.getTupleSize(), 0);
+    while (!itr.isEmpty()) {
+        const std::vector<double> &stats = getBlockStats(itr.getCurrentTable());
+        for (uint8_t i = 0; i < distinct.size() && i < stats.size(); ++i) {
+            distinct[i] += stats[i];
+        }
+        itr.moveNextCount();
+    }
+    for (uint8_t i = 0; i < distinct.size(); ++i) {
+        if (!literal.getTermAtPos(i).isVariable()) {
+            distinct[i] = 1;
+        } else {
+            distinct[i] = std::max<double>(1, std::min<double>(card, distinct[i]));
+        }
+    }
+    return distinct;
+}
+
+JoinOrderOptimizer::Atom JoinOrderOptimizer::getAtom(const Literal *literal,
+        const size_t card, const std::vector<double> &distinct) {
+    Atom atom;
+    atom.literal = literal;
+    atom.card = card;
+    for (uint8_t i = 0; i < literal->getTupleSize(); ++i) {
+        const VTerm t = literal->getTermAtPos(i);
+        if (t.isVariable()) {
+            //A repeated variable has at most the values of every column
+            auto it = atom.distinct.find(t.getId());
+            if (it == atom.distinct.end()) {
+                atom.distinct[t.getId()] = std::max<double>(1, distinct[i]);
+            } else {
+                it->second = std::min(it->second, std::max<double>(1, distinct[i]));
+            }
+        }
+    }
+    return atom;
+}
+
+double JoinOrderOptimizer::estimateCost(const std::vector<Atom> &atoms,
+        const std::vector<int> &order, bool &connected) {
+    connected = true;
+    const Atom &first = atoms[order[0]];
+    double size = first.card;
+    double cost = first.card;
+    std::map<Var_t, double> distinct = first.distinct;
+    for (size_t i = 1; i < order.size(); ++i) {
+        const Atom &atom = atoms[order[i]];
+        double selectivity = 1;
+        bool shared = false;
+        for (auto &v : atom.distinct) {
+            auto it = distinct.find(v.first);
+            if (it != distinct.end()) {
+                shared = true;
+                selectivity /= std::max(it->second, v.second);
+                it->second = std::min(it->second, v.second);
+            } else {
+                distinct[v.first] = v.second;
+            }
+        }
+        //Atoms without variables only filter the results
+        connected &= shared || atom.distinct.empty();
+        size = std::max(1.0, size * atom.card * selectivity);
+        for (auto &v : distinct) {
+            v.second = std::min(v.second, size);
+        }
+        cost += atom.card + size;
+    }
+    return cost;
+}
+
+std::vector<int> JoinOrderOptimizer::orderDP(const std::vector<Atom> &atoms) {
+    const int n = atoms.size();
+    const uint32_t all = (1u << n) - 1;
+    //Best order (and its cost) for every set of atoms
+    std::vector<double> bestCost(all + 1, std::numeric_limits<double>::max());
+    std::vector<std::vector<int>> bestOrder(all + 1);
+    for (int i = 0; i < n; ++i) {
+        bestCost[1u << i] = atoms[i].card;
+        bestOrder[1u << i].push_back(i);
+    }
+    for (uint32_t set = 1; set < all; ++set) {
+        if (bestOrder[set].empty()) {
+            continue;
+        }
+        for (int i = 0; i < n; ++i) {
+            if (set & (1u << i)) {
+                continue;
+            }
+            std::vector<int> order = bestOrder[set];
+            order.push_back(i);
+            bool connected;
+            const double cost = estimateCost(atoms, order, connected);
+            if (connected && cost < bestCost[set | (1u << i)]) {
+                bestCost[set | (1u << i)] = cost;
+                bestOrder[set | (1u << i)] = order;
+            }
+        }
+    }
+    return bestOrder[all];
+}
+
+std::vector<int> JoinOrderOptimizer::orderGreedy(const std::vector<Atom> &atoms) {
+    const int n = atoms.size();
+    std::vector<int> best;
+    double bestCost = std::numeric_limits<double>::max();
+    //Try every atom as the first one, then add the atom that keeps the
+    //cost lowest
+    for (int first = 0; first < n; ++first) {
+        std::vector<int> order;
+        order.push_back(first);
+        std::vector<bool> used(n, false);
+        used[first] = true;
+        double cost = atoms[first].card;
+        while (order.size() < n) {
+            int next = -1;
+            double nextCost = std::numeric_limits<double>::max();
+            for (int i = 0; i < n; ++i) {
+                if (used[i]) {
+                    continue;
+                }
+                order.push_back(i);
+                bool connected;
+                const double c = estimateCost(atoms, order, connected);
+                order.pop_back();
+                if (connected && c < nextCost) {
+                    nextCost = c;
+                    next = i;
+                }
+            }
+            if (next < 0) {
+                break;
+            }
+            order.push_back(next);
+            used[next] = true;
+            cost = nextCost;
+        }
+        if (order.size() == n && cost < bestCost) {
+            bestCost = cost;
+            best = order;
+        }
+    }
+    return best;
+}
+
+std::vector<int> JoinOrderOptimizer::getOrder(const std::vector<Atom> &atoms) {
+    if (atoms.size() <= 1) {
+        std::vector<int> order;
+        for (int i = 0; i < atoms.size(); ++i) {
+            order.push_back(i);
+        }
+        return order;
+    }
+    if (atoms.size() <= JOINORDER_MAX_DP) {
+        return orderDP(atoms);
+    } else {
+        return orderGreedy(atoms);
+    }
+}
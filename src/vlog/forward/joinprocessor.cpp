@@ -3,6 +3,7 @@
 #include <vlog/seminaiver.h>
 #include <vlog/filterhashjoin.h>
 #include <vlog/finalresultjoinproc.h>
+#include <vlog/morsel.h>
 #include <trident/model/table.h>
 
 #include <google/dense_hash_map>
@@ -578,23 +579,50 @@ void JoinExecutor::join(SemiNaiver * naiver, const FCInternalTable * t1,
     // isJoinVerificative and isJoinTwoToOneJoin. Check performance issues.
     if (literal.isNegated()) {
         LOG(TRACEL) << "Calling leftjoin";
+        RuleProfiler::setJoin("leftjoin");
         leftjoin(t1, naiver, outputLiterals, literal, min, max,
                 joinsCoordinates, output, nthreads);
     }
     //First I calculate whether the join is verificative or explorative.
     else if (JoinExecutor::isJoinVerificative(t1, hv, currentLiteral)) {
         LOG(TRACEL) << "Executing verificativeJoin";
+        RuleProfiler::setJoin("verificative");
         verificativeJoin(naiver, t1, literal, min, max, output, hv,
                 currentLiteral, nthreads);
     } else if (JoinExecutor::isJoinTwoToOneJoin(hv, currentLiteral)) {
         //Is the join of the like (A),(A,B)=>(A|B). Then we can speed up the merge join
         LOG(TRACEL) << "Executing joinTwoToOne";
+        RuleProfiler::setJoin("twotoone");
         joinTwoToOne(naiver, t1, literal, min, max, output, hv,
                 currentLiteral, nthreads);
     } else {
         //This code is to execute more generic joins. We do hash join if
         //keys are few and there is no ordering. Otherwise, merge join.
         int factor = literalIsExpensive(literal, naiver->getEDBLayer()) ? 50 : 1;
+        if (naiver->getJoinAlgorithm() == HASH_JOIN) {
+            //The hash join queries the literal once per key of t1, so it
+            //keeps the conditions under which it used to be chosen
+            if (t1->estimateNRows() <= factor * THRESHOLD_HASHJOIN
+                    && joinsCoordinates.size() < 3 && joinsCoordinates.size() > 0
+                    && (factor != 1 || joinsCoordinates.size() > 1 ||
+                        joinsCoordinates[0].first != joinsCoordinates[0].second ||
+                        joinsCoordinates[0].first != 0)) {
+                LOG(TRACEL) << "Executing hashjoin (selected).";
+                RuleProfiler::setJoin("hash");
+                hashjoin(t1, naiver, outputLiterals, literal, min, max, filterValueVars,
+                        joinsCoordinates, output,
+                        lastLiteral, ruleDetails, hv, processedTables, nthreads);
+#ifdef DEBUG
+                output->checkSizes();
+#endif
+                return;
+            }
+            if (naiver->shouldWarnJoinAlgorithm()) {
+                LOG(WARNL) << "The hash join cannot be applied to some joins"
+                    << " (the first is on " << literal.tostring(naiver->getProgram(), &naiver->getEDBLayer())
+                    << "): they are executed with a merge join";
+            }
+        }
         //No hash joins if there are functors
         /*if (t1->estimateNRows() <= factor * THRESHOLD_HASHJOIN
                 && joinsCoordinates.size() < 3 && joinsCoordinates.size() > 0
@@ -610,6 +638,7 @@ void JoinExecutor::join(SemiNaiver * naiver, const FCInternalTable * t1,
 #endif
         } else {*/
             LOG(TRACEL) << "Executing mergejoin.";
+            RuleProfiler::setJoin("merge");
             mergejoin(t1, naiver, outputLiterals, literal, min, max,
                     joinsCoordinates, output, nthreads);
 #ifdef DEBUG
@@ -650,6 +679,193 @@ uint8_t removePosConstants(uint8_t c, Literal literal) {
     return result;
 }
 
+struct SelectiveHashJoinKey {
+    std::pair<Term_t, Term_t> key;
+    size_t start;
+    size_t end;
+};
+
+//Executes the join for a single entry of the hashmap in
+//JoinExecutor::execSelectiveHashJoin. If retrievalMutex is not NULL, the
+//probe is executed concurrently by several threads. Only the retrieval and
+//the sorting of the tables, which populate shared caches, are serialized
+//with it. The tables do not change during the probe, since the derivations
+//are consolidated after all the entries have been probed.
+struct SelectiveHashJoinProbe {
+    SemiNaiver *naiver;
+    const Literal &literal;
+    const uint8_t njoinfields;
+    const uint8_t idxJoinFieldInLiteral1;
+    const uint8_t idxJoinFieldInLiteral2;
+    const uint8_t idxJoinField1;
+    const uint8_t idxJoinField2;
+    const std::vector<Literal> *outputLiterals;
+    const uint8_t rowSize;
+    const size_t min, max;
+    std::vector<Term_t> &values;
+    const JoinHashMap &map;
+    const DoubleJoinHashMap &doublemap;
+    const std::vector<uint8_t> &newPosToSort;
+    std::mutex *retrievalMutex;
+
+    SelectiveHashJoinProbe(SemiNaiver *naiver, const Literal &literal,
+            const uint8_t njoinfields,
+            const uint8_t idxJoinFieldInLiteral1,
+            const uint8_t idxJoinFieldInLiteral2,
+            const uint8_t idxJoinField1, const uint8_t idxJoinField2,
+            const std::vector<Literal> *outputLiterals,
+            const uint8_t rowSize, const size_t min, const size_t max,
+            std::vector<Term_t> &values, const JoinHashMap &map,
+            const DoubleJoinHashMap &doublemap,
+            const std::vector<uint8_t> &newPosToSort,
+            std::mutex *retrievalMutex) :
+        naiver(naiver), literal(literal), njoinfields(njoinfields),
+        idxJoinFieldInLiteral1(idxJoinFieldInLiteral1),
+        idxJoinFieldInLiteral2(idxJoinFieldInLiteral2),
+        idxJoinField1(idxJoinField1), idxJoinField2(idxJoinField2),
+        outputLiterals(outputLiterals), rowSize(rowSize), min(min), max(max),
+        values(values), map(map), doublemap(doublemap),
+        newPosToSort(newPosToSort), retrievalMutex(retrievalMutex) {
+        }
+
+    std::unique_lock<std::mutex> lockRetrieval() const {
+        if (retrievalMutex != NULL) {
+            return std::unique_lock<std::mutex>(*retrievalMutex);
+        }
+        return std::unique_lock<std::mutex>();
+    }
+
+    void operator()(const SelectiveHashJoinKey &k,
+            ResultJoinProcessor *resultsContainer,
+            int &processedTables) const {
+        //We need these to filter duplicates
+        const std::pair<uint8_t, uint8_t> *posFromFirst = resultsContainer->getPosFromFirst();
+        const uint8_t nPosFromFirst = resultsContainer->getNCopyFromFirst();
+        std::vector<DuplicateContainers> existingTuples;
+
+        VTuple tuple = literal.getTuple();
+        size_t start = k.start;
+        const size_t end = k.end;
+        //set up the query and coordinates
+        if (njoinfields > 0) {
+            // Watch out: the variables could occur more than once in the literal. --Ceriel
+            tuple.replaceAll(tuple.get(idxJoinFieldInLiteral1), VTerm(0, k.key.first));
+        }
+        if (njoinfields > 1) {
+            tuple.replaceAll(tuple.get(idxJoinFieldInLiteral2), VTerm(0, k.key.second));
+        }
+        Literal literalToQuery(literal.getPredicate(), tuple);
+
+        //These are values that cannot appear in certain positions,
+        //otherwise they will generate duplicated derivations
+        std::vector<std::pair<uint8_t, Term_t>> valuesToFilterOut;
+        std::vector<std::pair<uint8_t, uint8_t>> columnsToFilterOut;
+
+        TableFilterer queryFilterer(naiver);
+
+        //Query the rewritten literal
+        std::chrono::system_clock::time_point startRetr = std::chrono::system_clock::now();
+        FCIterator tableItr;
+        {
+            std::unique_lock<std::mutex> lock = lockRetrieval();
+            tableItr = naiver->getTable(literalToQuery, min, max, &queryFilterer);
+        }
+#if DEBUG
+        std::chrono::duration<double> secRetr = std::chrono::system_clock::now() - startRetr;
+        LOG(TRACEL) << "Time retrieving table " << secRetr.count() * 1000;
+        LOG(TRACEL) << "literal to query = " << literal.tostring();
+#endif
+        if (tableItr.isEmpty()) {
+            LOG(TRACEL) << "Empty table!";
+            return;
+        }
+
+        std::vector<std::pair<const FCBlock *, uint32_t>> tables;
+        LOG(TRACEL) << "rowSize = " << (int) rowSize << ", start = " << start << ", end = " << end;
+        const size_t nderivations = (end - start) / rowSize;
+        while (!tableItr.isEmpty()) {
+            tables.push_back(std::make_pair(tableItr.getCurrentBlock(), nderivations));
+            tableItr.moveNextCount();
+        }
+
+        //Query the head of the rule to see whether there is previous data to check for duplicates
+        bool emptyIterals = true;
+#if DEBUG
+        LOG(TRACEL) << "Check " << (end - start) / rowSize << " duplicates";
+#endif
+        // This block was commented out. WHY???
+        // Fixed now for when outputLiterals has length 1.
+        // Note that this code is essential for correct functioning ... --Ceriel
+        while (outputLiterals != NULL && outputLiterals->size() == 1 &&  start < end) {
+            VTuple t = (*outputLiterals)[0].getTuple();
+            for (int i = 0; i < nPosFromFirst; ++i) {
+                // Watch out: variable could be used more than once --Ceriel
+                t.replaceAll(t.get(posFromFirst[i].first), VTerm(0, values[start + posFromFirst[i].second]));
+            }
+            Literal l((*outputLiterals)[0].getPredicate(), t);
+
+            //Filter the tables in input checking whether the input query produced
+            //by the rule can have produced output tuples in following derivations
+            uint32_t nEmptyDerivations = 0;
+            for (auto& table : tables) {
+                if (queryFilterer.producedDerivationInPreviousSteps(
+                            l, literalToQuery, table.first)) {
+                    table.second--;
+                    nEmptyDerivations++;
+                }
+            }
+
+            if (nEmptyDerivations < tables.size()) {
+                std::unique_lock<std::mutex> lock = lockRetrieval();
+                FCIterator outputItr = naiver->getTable(l, 0, (size_t) - 1);
+                if (!outputItr.isEmpty()) {
+                    existingTuples.
+                        push_back(DuplicateContainers(
+                                    outputItr,
+                                    resultsContainer->getNCopyFromSecond()));
+                    emptyIterals = false;
+                } else {
+                    existingTuples.push_back(DuplicateContainers());
+                }
+            } else {
+                existingTuples.push_back(DuplicateContainers());
+            }
+            start += rowSize;
+        }
+
+        std::vector<FilterHashJoinBlock> retainedTables;
+        for (auto& table : tables) {
+            if (table.second > 0) {
+                FilterHashJoinBlock b;
+                b.table = table.first->table.get();
+                b.iteration = table.first->iteration;
+                retainedTables.push_back(b);
+            }
+        }
+
+#if DEBUG
+        LOG(TRACEL) << "Start actual join...";
+#endif
+        FilterHashJoin exec(resultsContainer, &map, &doublemap, &values, rowSize, njoinfields,
+                idxJoinField1, idxJoinField2,
+                &literalToQuery, true, false, (emptyIterals) ? NULL : &existingTuples,
+                0, NULL, NULL); //The last three parameters are
+        //not set because the flag 'isDerivationUnique' is set to false
+        LOG(TRACEL) << "Retained table size = " << retainedTables.size();
+        if (retainedTables.size() > 0) {
+            exec.run(retainedTables, true, k.start, k.end,
+                    newPosToSort, processedTables,
+                    valuesToFilterOut.size() > 0 ? &valuesToFilterOut : NULL,
+                    columnsToFilterOut.size() > 0 ? &columnsToFilterOut : NULL,
+                    retrievalMutex);
+        }
+
+        for (auto& tuple : existingTuples) {
+            tuple.clear();
+        }
+    }
+};
+
 void JoinExecutor::execSelectiveHashJoin(const RuleExecutionDetails & currentRule,
         SemiNaiver * naiver, const JoinHashMap & map,
         const DoubleJoinHashMap & doublemap,
@@ -660,7 +876,7 @@ void JoinExecutor::execSelectiveHashJoin(const RuleExecutionDetails & currentRul
         const bool literalSharesVarsWithHead,
         const size_t min, const size_t max,
         const std::vector<std::pair<uint8_t, uint8_t>> *filterValueVars,
-        int &processedTables) {
+        int &processedTables, int nthreads) {
 
     //Go through the literal. Every constant increase the index
     uint8_t idxJoinFieldInLiteral1 = idxJoinField1;
@@ -737,218 +953,74 @@ void JoinExecutor::execSelectiveHashJoin(const RuleExecutionDetails & currentRul
             }
         }
 
-        //We need these to filter duplicates
-        const std::pair<uint8_t, uint8_t> *posFromFirst = resultsContainer->getPosFromFirst();
-        const uint8_t nPosFromFirst = resultsContainer->getNCopyFromFirst();
-        std::vector<DuplicateContainers> existingTuples;
-
-        //Iterating through the hashmap
-        JoinHashMap::const_iterator itr1;
-        DoubleJoinHashMap::const_iterator itr2;
-        {
-            bool ok;
-            if (njoinfields < 2) {
-                itr1 = map.begin();
-                ok = itr1 != map.end();
-            } else {
-                itr2 = doublemap.begin();
-                ok = itr2 != doublemap.end();
-            }
-
-            while (ok) {
-                VTuple tuple = literal.getTuple();
-                existingTuples.clear();
-
-                size_t start, end;
-                //set up the query and coordinates
-                if (njoinfields < 2) {
-                    if (njoinfields > 0) {
-                        // uint8_t var = tuple.get(idxJoinFieldInLiteral1).getId();
-                        // tuple.set(VTerm(0, itr1->first), idxJoinFieldInLiteral1);
-                        // Watch out: this variable could occur more than once in the literal. --Ceriel
-                        tuple.replaceAll(tuple.get(idxJoinFieldInLiteral1), VTerm(0, itr1->first));
-                    }
-                    start = itr1->second.first;
-                    end = itr1->second.second;
-                } else {
-                    // uint8_t var1 = tuple.get(idxJoinFieldInLiteral1).getId();
-                    // uint8_t var2 = tuple.get(idxJoinFieldInLiteral2).getId();
-                    // tuple.set(VTerm(0, itr2->first.first), idxJoinFieldInLiteral1);
-                    // tuple.set(VTerm(0, itr2->first.second), idxJoinFieldInLiteral2);
-                    // Watch out: the variables could occur more than once in the literal. --Ceriel
-                    tuple.replaceAll(tuple.get(idxJoinFieldInLiteral1), VTerm(0, itr2->first.first));
-                    tuple.replaceAll(tuple.get(idxJoinFieldInLiteral2), VTerm(0, itr2->first.second));
-
-                    start = itr2->second.first;
-                    end = itr2->second.second;
-                }
-                Literal literalToQuery(literal.getPredicate(), tuple);
-
-                //These are values that cannot appear in certain positions,
-                //otherwise they will generate duplicated derivations
-                std::vector<std::pair<uint8_t, Term_t>> valuesToFilterOut;
-                std::vector<std::pair<uint8_t, uint8_t>> columnsToFilterOut;
-
-                TableFilterer queryFilterer(naiver);
-
-                //Query the rewritten literal
-                std::chrono::system_clock::time_point startRetr = std::chrono::system_clock::now();
-                FCIterator tableItr = naiver->getTable(literalToQuery, min, max, &queryFilterer);
-#if DEBUG
-                std::chrono::duration<double> secRetr = std::chrono::system_clock::now() - startRetr;
-                LOG(TRACEL) << "Time retrieving table " << secRetr.count() * 1000;
-                LOG(TRACEL) << "literal to query = " << literal.tostring();
-#endif
-                if (tableItr.isEmpty()) {
-                    LOG(TRACEL) << "Empty table!";
-                    //Move to the next entry in the hashmap
-                    if (njoinfields < 2) {
-                        itr1++;
-                        ok = itr1 != map.end();
-                    } else {
-                        itr2++;
-                        ok = itr2 != doublemap.end();
-                    }
-                    continue;
-                }
-
-                std::vector<std::pair<const FCBlock *, uint32_t>> tables;
-                LOG(TRACEL) << "rowSize = " << (int) rowSize << ", start = " << start << ", end = " << end;
-                const size_t nderivations = (end - start) / rowSize;
-                while (!tableItr.isEmpty()) {
-                    tables.push_back(std::make_pair(tableItr.getCurrentBlock(), nderivations));
-                    tableItr.moveNextCount();
-                }
-
-                //Query the head of the rule to see whether there is previous data to check for duplicates
-                //std::chrono::system_clock::time_point startD = std::chrono::system_clock::now();
-                bool emptyIterals = true;
-#if DEBUG
-                LOG(TRACEL) << "Check " << (end - start) / rowSize << " duplicates";
-#endif
-                // This block was commented out. WHY???
-                // Fixed now for when outputLiterals has length 1.
-                // Note that this code is essential for correct functioning ... --Ceriel
-                while (outputLiterals != NULL && outputLiterals->size() == 1 &&  start < end) {
-                    VTuple t = (*outputLiterals)[0].getTuple();
-                    for (int i = 0; i < nPosFromFirst; ++i) {
-                        Var_t var = t.get(posFromFirst[i].first).getId();
-                        // t.set(VTerm(0, values[start + posFromFirst[i].second]), posFromFirst[i].first);
-                        // Watch out: variable could be used more than once --Ceriel
-                        t.replaceAll(t.get(posFromFirst[i].first), VTerm(0, values[start + posFromFirst[i].second]));
-                    }
-                    Literal l((*outputLiterals)[0].getPredicate(), t);
-
-                    //Filter the tables in input checking whether the input query produced
-                    //by the rule can have produced output tuples in following derivations
-                    uint32_t nEmptyDerivations = 0;
-                    for (auto& table : tables) {
-                        if (queryFilterer.producedDerivationInPreviousSteps(
-                                    l, literalToQuery, table.first)) {
-                            table.second--;
-                            nEmptyDerivations++;
-                        }
-                    }
-
-                    if (nEmptyDerivations < tables.size()) {
-                        FCIterator outputItr = naiver->getTable(l, 0, (size_t) - 1);
-                        if (!outputItr.isEmpty()) {
-                            existingTuples.
-                                push_back(DuplicateContainers(
-                                            outputItr,
-                                            resultsContainer->getNCopyFromSecond()));
-                            emptyIterals = false;
-                        } else {
-                            existingTuples.push_back(DuplicateContainers());
-                        }
-                    } else {
-                        existingTuples.push_back(DuplicateContainers());
-                    }
-                    start += rowSize;
-                }
-
-
-                {
-                    std::vector<FilterHashJoinBlock> retainedTables;
-                    for (auto& table : tables) {
-                        if (table.second > 0) {
-                            FilterHashJoinBlock b;
-                            b.table = table.first->table.get();
-                            b.iteration = table.first->iteration;
-                            retainedTables.push_back(b);
-                        }
-                    }
-                    //std::chrono::duration<double> secD = std::chrono::system_clock::now() - startD;
-
-#if DEBUG
-                    LOG(TRACEL) << "Start actual join...";
-#endif
-                    //std::chrono::system_clock::time_point startJ = std::chrono::system_clock::now();
-                    {
-                        std::vector<uint8_t> ps = newPosToSort;
-
-                        FilterHashJoin exec(resultsContainer, &map, &doublemap, &values, rowSize, njoinfields,
-                                idxJoinField1, idxJoinField2,
-                                &literalToQuery, true, false, (emptyIterals) ? NULL : &existingTuples,
-                                0, NULL, NULL); //The last three parameters are
-                        //not set because the flag 'isDerivationUnique' is set to false
-                        LOG(TRACEL) << "Retained table size = " << retainedTables.size();
-                        if (retainedTables.size() > 0) {
-                            if (njoinfields == 1) {
-                                // LOG(TRACEL) << "first = " << (int) itr1->second.first << ", second = " << (int) itr1->second.second;
-                                // LOG(TRACEL) << "idxJoinField = " << (int) idxJoinField1;
-                                exec.run(retainedTables, true, itr1->second.first, itr1->second.second,
-                                        newPosToSort, processedTables,
-                                        valuesToFilterOut.size() > 0 ? &valuesToFilterOut : NULL,
-                                        columnsToFilterOut.size() > 0 ? &columnsToFilterOut : NULL);
-                            } else {
-                                exec.run(retainedTables, true, itr2->second.first, itr2->second.second,
-                                        newPosToSort, processedTables,
-                                        valuesToFilterOut.size() > 0 ? &valuesToFilterOut : NULL,
-                                        columnsToFilterOut.size() > 0 ? &columnsToFilterOut : NULL);
-
-                            }
+        //Collect the entries of the hashmap, so that they can be split
+        //among the threads
+        std::vector<SelectiveHashJoinKey> keys;
+        if (njoinfields < 2) {
+            keys.reserve(map.size());
+            for (auto &el : map) {
+                SelectiveHashJoinKey k;
+                k.key = std::make_pair(el.first, (Term_t) 0);
+                k.start = el.second.first;
+                k.end = el.second.second;
+                keys.push_back(k);
+            }
+        } else {
+            keys.reserve(doublemap.size());
+            for (auto &el : doublemap) {
+                SelectiveHashJoinKey k;
+                k.key = el.first;
+                k.start = el.second.first;
+                k.end = el.second.second;
+                keys.push_back(k);
+            }
+        }
+
+        if (nthreads > 1 && keys.size() > 1) {
+            //Every thread probes the entries of a morsel and writes the
+            //derivations in its own buffer. The buffers are merged in the
+            //output and consolidated once, after all the entries have been
+            //probed, so the threads only share the lock that serializes the
+            //retrieval of the tables. Skewed entries are balanced by
+            //stealing the morsels of the other threads.
+            std::mutex retrievalMutex;
+            SelectiveHashJoinProbe probe(naiver, literal, njoinfields,
+                    idxJoinFieldInLiteral1, idxJoinFieldInLiteral2,
+                    idxJoinField1, idxJoinField2, outputLiterals, rowSize,
+                    min, max, values, map, doublemap, newPosToSort,
+                    &retrievalMutex);
+            std::vector<std::unique_ptr<BufferedJoinProcessor>> buffers;
+            for (int i = 0; i < nthreads; ++i) {
+                buffers.push_back(std::unique_ptr<BufferedJoinProcessor>(
+                            new BufferedJoinProcessor(resultsContainer)));
+            }
+            std::vector<int> processed(nthreads);
+            const size_t morselSize = std::max((size_t) 1,
+                    keys.size() / (nthreads * MORSELS_PER_THREAD));
+            LOG(DEBUGL) << "Probing " << keys.size() << " entries with "
+                << nthreads << " threads, morsel size = " << morselSize;
+            MorselScheduler::run(keys.size(), morselSize, nthreads,
+                    [&](const int worker, const size_t begin, const size_t end) {
+                        for (size_t i = begin; i < end; ++i) {
+                            probe(keys[i], buffers[worker].get(), processed[worker]);
                         }
-                    }
-                    //std::chrono::duration<double> secJ = std::chrono::system_clock::now() - startJ;
-                } //retained tables
-
-                for (auto& tuple : existingTuples) {
-                    tuple.clear();
-                }
-
-                //size_t uniqueDerivation = out->getUniqueDerivation();
-                //size_t unfilteredDerivation = out->getUnfilteredDerivation();
-                //std::chrono::system_clock::time_point startC = std::chrono::system_clock::now();
+                    });
+            for (int i = 0; i < nthreads; ++i) {
+                buffers[i]->flush();
+                processedTables += processed[i];
+            }
+            resultsContainer->consolidate(false);
+        } else {
+            SelectiveHashJoinProbe probe(naiver, literal, njoinfields,
+                    idxJoinFieldInLiteral1, idxJoinFieldInLiteral2,
+                    idxJoinField1, idxJoinField2, outputLiterals, rowSize,
+                    min, max, values, map, doublemap, newPosToSort, NULL);
+            for (const auto &k : keys) {
+                probe(k, resultsContainer, processedTables);
                 resultsContainer->consolidate(false);
-                //std::chrono::duration<double> secC = std::chrono::system_clock::now() - startC;
-
-#if DEBUG
-                /*** LOGGING ***/
-                std::string sMapValues = "";
-                /*
-                   for (int i = itr->second.first; i < itr->second.second; ++i) {
-                   sMapValues += to_string(values[i]) + " ";
-                   }
-                   */
-                //LOG(TRACEL) << "HashJoin: ntables=" << tableItr.getNTables() << " exitingTuples=" << existingTuples.size() << " GetRetrTime=" << secRetr.count() * 1000 << " GetDuplTime=" << secD.count() * 1000 << " JoinTime=" << secJ.count() * 1000 << "ms ConsolidationTime=" << secC.count() * 1000 << "ms. Input=" << exec.getProcessedElements() << " Output(f)=" << uniqueDerivation << " Output(nf)=" << unfilteredDerivation << " JoinKey=" << itr->first << " MapValues=" << sMapValues;
-                /*** END LOGGING ***/
-#endif
-
-                //Move to the next entry in the hashmap
-                if (njoinfields == 1) {
-                    itr1++;
-                    ok = itr1 != map.end();
-                } else {
-                    itr2++;
-                    ok = itr2 != doublemap.end();
-                }
             }
-
-
-        } //before map
-    } // exiting containers
-
+        }
+    }
 }
 
 void JoinExecutor::hashjoin(const FCInternalTable * t1, SemiNaiver * naiver,
@@ -1102,7 +1174,7 @@ void JoinExecutor::hashjoin(const FCInternalTable * t1, SemiNaiver * naiver,
             (joinsCoordinates.size() > 1) ? joinsCoordinates[1].second : 0,
             outputLiterals, literal, t1->getRowSize(), lastPosToSort, values,
             literalSharesVarsWithHead, min, max, filterValueVars,
-            processedTables);
+            processedTables, nthreads);
 }
 
 int JoinExecutor::cmp(const Term_t *r1, const Term_t *r2, const uint8_t s) {
@@ -1250,9 +1322,15 @@ void JoinExecutor::mergejoin(const FCInternalTable * t1, SemiNaiver * naiver,
             it.moveNextCount();
         }
 
-        if (tablesToMergeJoin.size() > 0)
-            do_mergejoin(t1, fields1, tablesToMergeJoin, fields1, NULL, NULL,
-                    fields2, output, nthreads);
+        if (tablesToMergeJoin.size() > 0) {
+            if (naiver->getJoinAlgorithm() == RADIX_JOIN && fields1.size() > 0) {
+                do_radixjoin(t1, tablesToMergeJoin, fields1, fields2, output,
+                        nthreads);
+            } else {
+                do_mergejoin(t1, fields1, tablesToMergeJoin, fields1, NULL, NULL,
+                        fields2, output, nthreads);
+            }
+        }
     } else {
         //Positions to return when filtering the input query
         std::vector<uint8_t> posToCopy;
@@ -1369,6 +1447,9 @@ void JoinExecutor::mergejoin(const FCInternalTable * t1, SemiNaiver * naiver,
                 if (idxOtherPos.size() > 0 && valueOtherPos[0].size() > 1) {
                     do_mergejoin(filteredT1.get(), fieldsToSortInMap, tablesToMergeJoin,
                             fields1, &(idxOtherPos[0]), &(valueOtherPos[0]), fields2, output, nthreads);
+                } else if (naiver->getJoinAlgorithm() == RADIX_JOIN && fields1.size() > 0) {
+                    do_radixjoin(filteredT1.get(), tablesToMergeJoin,
+                            fields1, fields2, output, nthreads);
                 } else {
                     do_mergejoin(filteredT1.get(), fieldsToSortInMap, tablesToMergeJoin,
                             fields1, NULL, NULL, fields2, output, nthreads);
@@ -1788,8 +1869,8 @@ void JoinExecutor::do_merge_join_classicalgo(const std::vector<const std::vector
 #endif
 }
 
-void JoinExecutor::do_merge_join_fasteralgo(FCInternalTableItr * sortedItr1,
-        FCInternalTableItr * sortedItr2,
+void JoinExecutor::do_merge_join_fasteralgo(VectorFCInternalTableItr * sortedItr1,
+        VectorFCInternalTableItr * sortedItr2,
         const std::vector<uint8_t> &fields1,
         const std::vector<uint8_t> &fields2,
         const uint8_t posBlocks,
@@ -1797,6 +1878,12 @@ void JoinExecutor::do_merge_join_fasteralgo(FCInternalTableItr * sortedItr1,
         const Term_t *valBlocks,
         ResultJoinProcessor * output) {
 
+    //Both sides are read in batches of COLUMN_BATCH_SIZE values, only in the
+    //columns that are needed
+    std::unique_ptr<Term_t[]> buffer1(new Term_t[COLUMN_BATCH_SIZE]);
+    std::unique_ptr<Term_t[]> buffer2(new Term_t[COLUMN_BATCH_SIZE]);
+    size_t n;
+
     //First grouping the keys on the left side adding information on the bucket to add
     std::vector<std::pair<Term_t, uint32_t>> keys;
     Term_t currentKey = 0;
@@ -1804,25 +1891,29 @@ void JoinExecutor::do_merge_join_fasteralgo(FCInternalTableItr * sortedItr1,
     bool isFirst = true;
     const uint8_t posKey = fields1[0];
     const uint8_t posKeyInS = fields2[0];
-    while (sortedItr1->hasNext()) {
-        sortedItr1->next();
-        Term_t v = sortedItr1->getCurrentValue(posKey);
-        if (isFirst) {
-            currentKey = v;
-            isFirst = false;
-        } else {
-            if (currentKey != v) {
-                keys.push_back(std::make_pair(currentKey, currentValue));
+    std::unique_ptr<ColumnReader> keyReader = sortedItr1->getColumnReader(posKey);
+    std::unique_ptr<ColumnReader> blockReader = sortedItr1->getColumnReader(posBlocks);
+    while ((n = keyReader->nextBatch(buffer1.get(), COLUMN_BATCH_SIZE)) > 0) {
+        blockReader->nextBatch(buffer2.get(), n);
+        for (size_t j = 0; j < n; ++j) {
+            const Term_t v = buffer1[j];
+            if (isFirst) {
                 currentKey = v;
-                currentValue = 0;
+                isFirst = false;
+            } else {
+                if (currentKey != v) {
+                    keys.push_back(std::make_pair(currentKey, currentValue));
+                    currentKey = v;
+                    currentValue = 0;
+                }
             }
-        }
 
-        uint8_t idxBlock = 0;
-        while (valBlocks[idxBlock] < sortedItr1->getCurrentValue(posBlocks)) {
-            idxBlock++;
+            uint8_t idxBlock = 0;
+            while (valBlocks[idxBlock] < buffer2[j]) {
+                idxBlock++;
+            }
+            currentValue |= 1 << idxBlock;
         }
-        currentValue |= 1 << idxBlock;
     }
     if (!isFirst) {
         keys.push_back(std::make_pair(currentKey, currentValue));
@@ -1836,25 +1927,28 @@ void JoinExecutor::do_merge_join_fasteralgo(FCInternalTableItr * sortedItr1,
     for (int i = 0; i < counts.size(); i++) {
         counts[i] = 0;
     }
-    while (itr != keys.end() && sortedItr2->hasNext()) {
-        sortedItr2->next();
-        while (sortedItr2->getCurrentValue(posKeyInS) < itr->first && sortedItr2->hasNext()) {
-            sortedItr2->next();
-        }
-        while (itr != keys.end() && itr->first < sortedItr2->getCurrentValue(posKeyInS)) {
-            itr++;
-        }
-        if (itr != keys.end() && itr->first == sortedItr2->getCurrentValue(posKeyInS)) {
-            uint64_t v = itr->second;
-            uint8_t idx = 0;
-            while (v != 0) {
-                if (v & 1) {
-                    //Output the derivation
-                    output->processResultsAtPos(idx, 0, sortedItr2->getCurrentValue(posToCopy), false);
-                    counts[idx]++;
+    keyReader = sortedItr2->getColumnReader(posKeyInS);
+    std::unique_ptr<ColumnReader> copyReader = sortedItr2->getColumnReader(posToCopy);
+    while (itr != keys.end() &&
+            (n = keyReader->nextBatch(buffer1.get(), COLUMN_BATCH_SIZE)) > 0) {
+        copyReader->nextBatch(buffer2.get(), n);
+        for (size_t j = 0; j < n && itr != keys.end(); ++j) {
+            const Term_t v2 = buffer1[j];
+            while (itr != keys.end() && itr->first < v2) {
+                itr++;
+            }
+            if (itr != keys.end() && itr->first == v2) {
+                uint64_t v = itr->second;
+                uint8_t idx = 0;
+                while (v != 0) {
+                    if (v & 1) {
+                        //Output the derivation
+                        output->processResultsAtPos(idx, 0, buffer2[j], false);
+                        counts[idx]++;
+                    }
+                    v = (v >> 1);
+                    idx++;
                 }
-                v = (v >> 1);
-                idx++;
             }
         }
     }
@@ -2105,12 +2199,13 @@ void JoinExecutor::do_mergejoin(const FCInternalTable * filteredT1,
         }
         assert(t2->getNRows() == t2Size);
         if (faster) {
-            sortedItr2 = new VectorFCInternalTableItr(vectors2, 0, t2Size);
+            VectorFCInternalTableItr *vectorItr2 =
+                new VectorFCInternalTableItr(vectors2, 0, t2Size);
             LOG(TRACEL) << "Faster algo";
-            JoinExecutor::do_merge_join_fasteralgo(itr1, sortedItr2, fields1,
+            JoinExecutor::do_merge_join_fasteralgo(itr1, vectorItr2, fields1,
                     fields2, posBlocks, nValBlocks,
                     valBlocks, output);
-            delete sortedItr2;
+            delete vectorItr2;
 #if DEBUG
             output->checkSizes();
 #endif
@@ -2156,6 +2251,193 @@ void JoinExecutor::do_mergejoin(const FCInternalTable * filteredT1,
 #endif
 }
 
+struct RadixJoinEntry {
+    uint64_t hash;
+    size_t row;
+};
+
+static inline uint64_t radixHash(const std::vector<const std::vector<Term_t> *> &vectors,
+        const std::vector<uint8_t> &fields, const size_t row) {
+    uint64_t h = 0;
+    for (auto f : fields) {
+        h = (h ^ (uint64_t) (*vectors[f])[row]) * 0x9E3779B97F4A7C15ull;
+        h ^= h >> 32;
+    }
+    return h;
+}
+
+//Distributes the rows in 2^nbits partitions according to the highest bits
+//of their hash. On exit, the entries of partition p are stored in
+//entries[offsets[p], offsets[p + 1]).
+static void radixPartition(const std::vector<const std::vector<Term_t> *> &vectors,
+        const std::vector<uint8_t> &fields, const size_t nrows,
+        const int nbits, const int nthreads,
+        std::vector<RadixJoinEntry> &entries, std::vector<size_t> &offsets) {
+    const size_t npartitions = (size_t) 1 << nbits;
+    const int nchunks = std::max(1, nthreads);
+    const size_t chunkSize = (nrows + nchunks - 1) / nchunks;
+    std::vector<uint64_t> hashes(nrows);
+    std::vector<std::vector<size_t>> histograms(nchunks,
+            std::vector<size_t>(npartitions));
+
+    //First pass: hash the rows and count the size of the partitions
+    MorselScheduler::run(nchunks, 1, nthreads,
+            [&](const int worker, const size_t chunk, const size_t) {
+                const size_t begin = std::min(nrows, chunk * chunkSize);
+                const size_t end = std::min(nrows, begin + chunkSize);
+                std::vector<size_t> &histogram = histograms[chunk];
+                for (size_t i = begin; i < end; ++i) {
+                    const uint64_t h = radixHash(vectors, fields, i);
+                    hashes[i] = h;
+                    histogram[nbits == 0 ? 0 : h >> (64 - nbits)]++;
+                }
+            });
+
+    //Every chunk writes in its own range of every partition
+    offsets.resize(npartitions + 1);
+    size_t pos = 0;
+    for (size_t p = 0; p < npartitions; ++p) {
+        offsets[p] = pos;
+        for (int c = 0; c < nchunks; ++c) {
+            const size_t n = histograms[c][p];
+            histograms[c][p] = pos;
+            pos += n;
+        }
+    }
+    offsets[npartitions] = pos;
+
+    //Second pass: scatter
+    entries.resize(nrows);
+    MorselScheduler::run(nchunks, 1, nthreads,
+            [&](const int worker, const size_t chunk, const size_t) {
+                const size_t begin = std::min(nrows, chunk * chunkSize);
+                const size_t end = std::min(nrows, begin + chunkSize);
+                std::vector<size_t> &cursor = histograms[chunk];
+                for (size_t i = begin; i < end; ++i) {
+                    const uint64_t h = hashes[i];
+                    RadixJoinEntry &e = entries[cursor[nbits == 0 ? 0 : h >> (64 - nbits)]++];
+                    e.hash = h;
+                    e.row = i;
+                }
+            });
+}
+
+void JoinExecutor::do_radixjoin(const FCInternalTable * t1,
+        std::vector<std::shared_ptr<const FCInternalTable>> &tables2,
+        const std::vector<uint8_t> &fields1,
+        const std::vector<uint8_t> &fields2,
+        ResultJoinProcessor * output, int nthreads) {
+    const size_t totalsize1 = t1->getNRows();
+    if (totalsize1 >= UINT32_MAX) {
+        //The hash tables of the partitions use 32 bits offsets
+        std::vector<uint8_t> fieldsToSort = fields1;
+        do_mergejoin(t1, fieldsToSort, tables2, fields1, NULL, NULL, fields2,
+                output, nthreads);
+        return;
+    }
+    nthreads = std::max(1, nthreads);
+
+    //Choose the number of partitions so that the hash table of a partition
+    //(entry, bucket and chain) fits in the L2 cache
+    const size_t entryBytes = sizeof(RadixJoinEntry) + 2 * sizeof(uint32_t);
+    int nbits = 0;
+    while (nbits < RADIX_MAX_BITS &&
+            (totalsize1 * entryBytes >> nbits) > RADIX_PARTITION_BYTES) {
+        nbits++;
+    }
+    const size_t npartitions = (size_t) 1 << nbits;
+    LOG(DEBUGL) << "Radix join: left size = " << totalsize1 << ", partitions = "
+        << npartitions << ", tables = " << tables2.size();
+
+    FCInternalTableItr *itr1 = t1->getIterator();
+    std::vector<const std::vector<Term_t> *> vectors1 = itr1->getAllVectors(nthreads);
+    std::vector<RadixJoinEntry> entries1;
+    std::vector<size_t> offsets1;
+    radixPartition(vectors1, fields1, totalsize1, nbits, nthreads, entries1,
+            offsets1);
+
+    std::mutex m;
+    std::vector<std::unique_ptr<Output>> outputs;
+    for (int i = 0; i < nthreads; ++i) {
+        outputs.push_back(std::unique_ptr<Output>(
+                    new Output(output, nthreads > 1 ? &m : NULL)));
+    }
+    std::vector<std::vector<uint32_t>> heads(nthreads);
+    std::vector<std::vector<uint32_t>> chains(nthreads);
+
+    for (auto t2 : tables2) {
+        FCInternalTableItr *itr2 = t2->getIterator();
+        std::vector<const std::vector<Term_t> *> vectors2 = itr2->getAllVectors(nthreads);
+        const size_t totalsize2 = t2->getNRows();
+        std::vector<RadixJoinEntry> entries2;
+        std::vector<size_t> offsets2;
+        radixPartition(vectors2, fields2, totalsize2, nbits, nthreads,
+                entries2, offsets2);
+
+        //Build and probe every pair of partitions
+        MorselScheduler::run(npartitions, std::max((size_t) 1,
+                    npartitions / (nthreads * MORSELS_PER_THREAD)), nthreads,
+                [&](const int worker, const size_t begin, const size_t end) {
+                    std::vector<uint32_t> &head = heads[worker];
+                    std::vector<uint32_t> &chain = chains[worker];
+                    Output *out = outputs[worker].get();
+                    for (size_t p = begin; p < end; ++p) {
+                        const RadixJoinEntry *build = &entries1[offsets1[p]];
+                        const size_t nbuild = offsets1[p + 1] - offsets1[p];
+                        const RadixJoinEntry *probe = &entries2[offsets2[p]];
+                        const size_t nprobe = offsets2[p + 1] - offsets2[p];
+                        if (nbuild == 0 || nprobe == 0) {
+                            continue;
+                        }
+                        size_t nbuckets = 1;
+                        while (nbuckets < 2 * nbuild) {
+                            nbuckets <<= 1;
+                        }
+                        const uint64_t mask = nbuckets - 1;
+                        head.assign(nbuckets, UINT32_MAX);
+                        chain.resize(nbuild);
+                        for (uint32_t i = 0; i < nbuild; ++i) {
+                            const uint64_t b = build[i].hash & mask;
+                            chain[i] = head[b];
+                            head[b] = i;
+                        }
+                        for (size_t j = 0; j < nprobe; ++j) {
+                            const RadixJoinEntry &e2 = probe[j];
+                            for (uint32_t i = head[e2.hash & mask]; i != UINT32_MAX;
+                                    i = chain[i]) {
+                                const RadixJoinEntry &e1 = build[i];
+                                if (e1.hash != e2.hash) {
+                                    continue;
+                                }
+                                bool same = true;
+                                for (int f = 0; f < fields1.size(); ++f) {
+                                    if ((*vectors1[fields1[f]])[e1.row] !=
+                                            (*vectors2[fields2[f]])[e2.row]) {
+                                        same = false;
+                                        break;
+                                    }
+                                }
+                                if (same) {
+                                    out->processResults(0, vectors1, e1.row,
+                                            vectors2, e2.row, false);
+                                }
+                            }
+                        }
+                    }
+                });
+        for (auto &out : outputs) {
+            out->flush();
+        }
+#if DEBUG
+        output->checkSizes();
+#endif
+        itr2->deleteAllVectors(vectors2);
+        t2->releaseIterator(itr2);
+    }
+    itr1->deleteAllVectors(vectors1);
+    t1->releaseIterator(itr1);
+}
+
 /*bool JoinExecutor::same(const Segment * segment, const uint32_t idx1, const uint32_t idx2,
   const std::vector<uint8_t> &fields) {
   for (std::vector<uint8_t>::const_iterator itr = fields.cbegin(); itr != fields.cend();
@@ -0,0 +1,297 @@
+#include <vlog/leapfrog.h>
+#include <vlog/resultjoinproc.h>
+#include <vlog/column.h>
+
+#include <kognac/logs.h>
+
+#include <algorithm>
+#include <map>
+#include <set>
+
+bool LeapfrogTrieJoin::isCyclic(const std::vector<std::vector<Var_t>> &atoms) {
+    std::vector<std::set<Var_t>> edges;
+    for (const auto &a : atoms) {
+        edges.push_back(std::set<Var_t>(a.begin(), a.end()));
+    }
+    bool changed = true;
+    while (changed && edges.size() > 1) {
+        changed = false;
+        //Remove the variables that occur in only one edge
+        std::map<Var_t, int> occurrences;
+        for (const auto &e : edges) {
+            for (auto v : e) {
+                occurrences[v]++;
+            }
+        }
+        for (auto &e : edges) {
+            for (auto it = e.begin(); it != e.end();) {
+                if (occurrences[*it] == 1) {
+                    it = e.erase(it);
+                    changed = true;
+                } else {
+                    ++it;
+                }
+            }
+        }
+        //Remove the edges contained in other edges
+        for (size_t i = 0; i < edges.size(); ++i) {
+            for (size_t j = 0; j < edges.size(); ++j) {
+                if (i != j && std::includes(edges[j].begin(), edges[j].end(),
+                            edges[i].begin(), edges[i].end())) {
+                    edges.erase(edges.begin() + i);
+                    changed = true;
+                    i--;
+                    break;
+                }
+            }
+        }
+    }
+    return edges.size() > 1;
+}
+
+void LeapfrogTrieJoin::addRelation(const std::vector<Var_t> &vars,
+        const std::vector<std::shared_ptr<Column>> &columns,
+        const bool sorted) {
+    Relation r;
+    r.vars = vars;
+    r.width = vars.size();
+    r.input = columns;
+    r.inputSorted = sorted;
+    r.nrows = 0;
+    relations.push_back(std::move(r));
+}
+
+void LeapfrogTrieJoin::addRelation(const std::vector<Var_t> &vars,
+        std::vector<std::vector<Term_t>> &columns) {
+    Relation r;
+    r.vars = vars;
+    r.width = vars.size();
+    r.inputSorted = false;
+    r.copied.swap(columns);
+    r.nrows = r.copied.empty() ? 0 : r.copied[0].size();
+    relations.push_back(std::move(r));
+}
+
+static void readColumn(const Column &column, std::vector<Term_t> &out) {
+    std::unique_ptr<ColumnReader> reader = column.getReader();
+    size_t n = 0;
+    while (true) {
+        out.resize(n + COLUMN_BATCH_SIZE);
+        const size_t read = reader->nextBatch(out.data() + n, COLUMN_BATCH_SIZE);
+        n += read;
+        if (read == 0) {
+            break;
+        }
+    }
+    out.resize(n);
+}
+
+//Sorts the copied columns of r on the columns perm[0], perm[1], ..., and
+//puts them in that order. Duplicates are kept: the search restricts every
+//relation to the range of rows of a value, so they never repeat a binding
+static void sortCopied(std::vector<std::vector<Term_t>> &copied,
+        const std::vector<uint8_t> &perm, const size_t nrows) {
+    std::vector<size_t> idx(nrows);
+    for (size_t j = 0; j < nrows; ++j) {
+        idx[j] = j;
+    }
+    std::sort(idx.begin(), idx.end(), [&](const size_t a, const size_t b) {
+            for (auto c : perm) {
+                const Term_t va = copied[c][a];
+                const Term_t vb = copied[c][b];
+                if (va != vb) {
+                    return va < vb;
+                }
+            }
+            return false;
+            });
+    std::vector<std::vector<Term_t>> sorted(perm.size());
+    for (size_t c = 0; c < perm.size(); ++c) {
+        const std::vector<Term_t> &in = copied[perm[c]];
+        std::vector<Term_t> &out = sorted[c];
+        out.resize(nrows);
+        for (size_t j = 0; j < nrows; ++j) {
+            out[j] = in[idx[j]];
+        }
+    }
+    copied.swap(sorted);
+}
+
+void LeapfrogTrieJoin::prepare() {
+    //Variables that occur in more relations come first, so that the
+    //intersections prune as early as possible. Ties keep the order in which
+    //the variables appear, which is often the order of the columns of the
+    //relations, so that they can be read in place
+    std::map<Var_t, int> occurrences;
+    for (const auto &r : relations) {
+        for (auto v : r.vars) {
+            if (!occurrences.count(v)) {
+                variables.push_back(v);
+            }
+            occurrences[v]++;
+        }
+    }
+    std::stable_sort(variables.begin(), variables.end(),
+            [&occurrences](const Var_t a, const Var_t b) {
+            return occurrences[a] > occurrences[b];
+            });
+    std::map<Var_t, size_t> posVar;
+    for (size_t i = 0; i < variables.size(); ++i) {
+        posVar[variables[i]] = i;
+    }
+
+    participants.resize(variables.size());
+    for (int i = 0; i < relations.size(); ++i) {
+        Relation &r = relations[i];
+        //Order of the columns in the global order
+        std::vector<uint8_t> perm(r.width);
+        for (uint8_t j = 0; j < r.width; ++j) {
+            perm[j] = j;
+        }
+        std::sort(perm.begin(), perm.end(), [&](const uint8_t a, const uint8_t b) {
+                return posVar[r.vars[a]] < posVar[r.vars[b]];
+                });
+        bool inOrder = true;
+        for (uint8_t j = 0; j < r.width; ++j) {
+            inOrder = inOrder && perm[j] == j;
+        }
+
+        r.columns.clear();
+        if (r.inputSorted && inOrder) {
+            //Read the columns in place. Only those that are not backed by a
+            //vector (e.g., EDB or compressed columns) are copied
+            r.copied.resize(r.width);
+            for (uint8_t c = 0; c < r.width; ++c) {
+                Column &column = *r.input[c];
+                if (column.isBackedByVector()) {
+                    const std::vector<Term_t> &v = column.getVectorRef();
+                    r.columns.push_back(v.data());
+                    r.nrows = v.size();
+                } else {
+                    readColumn(column, r.copied[c]);
+                    r.columns.push_back(r.copied[c].data());
+                    r.nrows = r.copied[c].size();
+                }
+            }
+        } else {
+            if (!r.input.empty()) {
+                r.copied.resize(r.width);
+                for (uint8_t c = 0; c < r.width; ++c) {
+                    readColumn(*r.input[c], r.copied[c]);
+                }
+                r.nrows = r.copied[0].size();
+            }
+            r.input.clear();
+            sortCopied(r.copied, perm, r.nrows);
+            for (uint8_t c = 0; c < r.width; ++c) {
+                r.columns.push_back(r.copied[c].data());
+            }
+        }
+
+        std::vector<Var_t> vars(r.width);
+        for (uint8_t c = 0; c < r.width; ++c) {
+            vars[c] = r.vars[perm[c]];
+            participants[posVar[vars[c]]].push_back(std::make_pair(i, c));
+        }
+        r.vars = vars;
+        r.begin = 0;
+        r.end = r.nrows;
+    }
+    bindings.resize(variables.size());
+}
+
+size_t LeapfrogTrieJoin::seek(const Relation &r, const uint8_t col,
+        size_t from, const size_t to, const Term_t value) {
+    //Galloping search: the next value is usually close
+    size_t step = 1;
+    size_t hi = from;
+    while (hi < to && r.get(hi, col) < value) {
+        from = hi + 1;
+        hi += step;
+        step *= 2;
+    }
+    hi = std::min(hi, to);
+    while (from < hi) {
+        const size_t mid = from + (hi - from) / 2;
+        if (r.get(mid, col) < value) {
+            from = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return from;
+}
+
+void LeapfrogTrieJoin::search(const size_t depth, ResultJoinProcessor *output) {
+    if (depth == variables.size()) {
+        output->processResults(0, bindings.data(), NULL, false);
+        nresults++;
+        return;
+    }
+    const auto &parts = participants[depth];
+    const size_t k = parts.size();
+    std::vector<size_t> pos(k);
+    std::vector<size_t> savedBegin(k), savedEnd(k);
+    for (size_t i = 0; i < k; ++i) {
+        const Relation &r = relations[parts[i].first];
+        pos[i] = r.begin;
+        savedBegin[i] = r.begin;
+        savedEnd[i] = r.end;
+    }
+
+    while (true) {
+        //Leapfrog: move every relation to the largest current value
+        Term_t maxv = 0;
+        for (size_t i = 0; i < k; ++i) {
+            const Relation &r = relations[parts[i].first];
+            if (pos[i] >= savedEnd[i]) {
+                return;
+            }
+            maxv = std::max(maxv, r.get(pos[i], parts[i].second));
+        }
+        bool allEqual = true;
+        for (size_t i = 0; i < k; ++i) {
+            const Relation &r = relations[parts[i].first];
+            pos[i] = seek(r, parts[i].second, pos[i], savedEnd[i], maxv);
+            if (pos[i] >= savedEnd[i]) {
+                return;
+            }
+            if (r.get(pos[i], parts[i].second) != maxv) {
+                allEqual = false;
+            }
+        }
+        if (!allEqual) {
+            continue;
+        }
+
+        //Every relation contains maxv: restrict them to the rows with it
+        for (size_t i = 0; i < k; ++i) {
+            Relation &r = relations[parts[i].first];
+            r.begin = pos[i];
+            r.end = maxv == ~((Term_t) 0) ? savedEnd[i] :
+                seek(r, parts[i].second, pos[i], savedEnd[i], maxv + 1);
+        }
+        bindings[depth] = maxv;
+        search(depth + 1, output);
+        for (size_t i = 0; i < k; ++i) {
+            Relation &r = relations[parts[i].first];
+            pos[i] = r.end;
+            r.begin = savedBegin[i];
+            r.end = savedEnd[i];
+        }
+        if (maxv == ~((Term_t) 0)) {
+            return;
+        }
+    }
+}
+
+void LeapfrogTrieJoin::join(ResultJoinProcessor *output) {
+    for (const auto &r : relations) {
+        if (r.nrows == 0) {
+            return;
+        }
+    }
+    search(0, output);
+    LOG(DEBUGL) << "Leapfrog triejoin of " << relations.size()
+        << " relations produced " << nresults << " bindings";
+}
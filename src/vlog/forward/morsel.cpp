@@ -0,0 +1,115 @@
+#include <vlog/morsel.h>
+
+#include <kognac/logs.h>
+
+#include <thread>
+#include <mutex>
+#include <vector>
+#include <memory>
+#include <algorithm>
+
+struct MorselSlice {
+    std::mutex mutex;
+    size_t begin;
+    size_t end;
+};
+
+static bool nextMorsel(MorselSlice &slice, const size_t morselSize,
+        size_t &begin, size_t &end) {
+    std::lock_guard<std::mutex> lock(slice.mutex);
+    if (slice.begin >= slice.end) {
+        return false;
+    }
+    begin = slice.begin;
+    end = std::min(slice.end, begin + morselSize);
+    slice.begin = end;
+    return true;
+}
+
+static bool steal(std::vector<std::unique_ptr<MorselSlice>> &slices,
+        const int thief) {
+    while (true) {
+        //Pick the victim with most remaining work
+        int victim = -1;
+        size_t remaining = 0;
+        for (int i = 0; i < slices.size(); ++i) {
+            if (i == thief) {
+                continue;
+            }
+            std::lock_guard<std::mutex> lock(slices[i]->mutex);
+            if (slices[i]->end > slices[i]->begin &&
+                    slices[i]->end - slices[i]->begin > remaining) {
+                remaining = slices[i]->end - slices[i]->begin;
+                victim = i;
+            }
+        }
+        if (victim == -1) {
+            return false;
+        }
+
+        size_t begin, end;
+        {
+            std::lock_guard<std::mutex> lock(slices[victim]->mutex);
+            MorselSlice &v = *slices[victim];
+            if (v.end <= v.begin) {
+                //Someone was faster. Try again
+                continue;
+            }
+            end = v.end;
+            begin = v.begin + (v.end - v.begin) / 2;
+            v.end = begin;
+        }
+        std::lock_guard<std::mutex> lock(slices[thief]->mutex);
+        slices[thief]->begin = begin;
+        slices[thief]->end = end;
+        return true;
+    }
+}
+
+void MorselScheduler::run(const size_t nitems, const size_t morselSize,
+        const int nthreads,
+        std::function<void(const int, const size_t, const size_t)> task) {
+    if (nitems == 0) {
+        return;
+    }
+    const size_t msize = std::max((size_t) 1, morselSize);
+    if (nthreads < 2 || nitems <= msize) {
+        for (size_t begin = 0; begin < nitems; begin += msize) {
+            task(0, begin, std::min(nitems, begin + msize));
+        }
+        return;
+    }
+
+    std::vector<std::unique_ptr<MorselSlice>> slices;
+    const size_t sliceSize = (nitems + nthreads - 1) / nthreads;
+    for (int i = 0; i < nthreads; ++i) {
+        std::unique_ptr<MorselSlice> s(new MorselSlice());
+        s->begin = std::min(nitems, i * sliceSize);
+        s->end = std::min(nitems, (i + 1) * sliceSize);
+        slices.push_back(std::move(s));
+    }
+
+    auto worker = [&](const int id) {
+        size_t begin, end;
+        size_t nstolen = 0;
+        while (true) {
+            while (nextMorsel(*slices[id], msize, begin, end)) {
+                task(id, begin, end);
+            }
+            if (!steal(slices, id)) {
+                break;
+            }
+            nstolen++;
+        }
+        LOG(TRACEL) << "Worker " << id << " stole work " << nstolen << " times";
+    };
+
+    std::vector<std::thread> threads;
+    for (int i = 1; i < nthreads; ++i) {
+        threads.push_back(std::thread(worker, i));
+    }
+    worker(0);
+    for (auto &t : threads) {
+        t.join();
+    }
+}
@@ -0,0 +1,182 @@
+#include <vlog/profiler.h>
+#include <vlog/utils.h>
+
+#include <kognac/logs.h>
+#include <nlohmann/json.hpp>
+
+#include <fstream>
+#include <map>
+#include <algorithm>
+
+#if defined(__linux__)
+#include <unistd.h>
+#endif
+
+using json = nlohmann::json;
+
+static const char *phaseNames[PROFILE_NPHASES] = {
+    "retrieval", "filtering", "join", "consolidation", "deduplication"
+};
+
+//State of the thread that executes a rule
+static thread_local RuleProfile *currentProfile = NULL;
+static thread_local int currentPhase = -1;
+static thread_local std::chrono::steady_clock::time_point phaseStart;
+
+RuleProfile *RuleProfiler::current() {
+    return currentProfile;
+}
+
+void RuleProfiler::setCurrent(RuleProfile *profile) {
+    currentProfile = profile;
+    currentPhase = -1;
+}
+
+void RuleProfiler::setJoin(const char *join) {
+    if (currentProfile != NULL && !currentProfile->atoms.empty()) {
+        currentProfile->atoms.back().join = join;
+    }
+}
+
+int64_t RuleProfiler::getResidentMemory() {
+#if defined(__linux__)
+    std::ifstream statm("/proc/self/statm");
+    uint64_t size, resident;
+    if (statm >> size >> resident) {
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+    }
+#endif
+    return 0;
+}
+
+void RuleProfiler::add(const RuleProfile &profile) {
+    std::lock_guard<std::mutex> lock(mutex);
+    profiles.push_back(profile);
+}
+
+std::string RuleProfiler::getRuleString(Program *program, EDBLayer &layer,
+        const size_t ruleid) {
+    if (ruleid < program->getNRules()) {
+        return program->getRule(ruleid).tostring(program, &layer);
+    }
+    return "";
+}
+
+void RuleProfiler::printSummary(Program *program, EDBLayer &layer,
+        const int n) {
+    std::map<size_t, std::pair<double, uint64_t>> rules;
+    for (const auto &p : profiles) {
+        rules[p.ruleid].first += p.timeMs;
+        rules[p.ruleid].second += p.derivations;
+    }
+    std::vector<std::pair<size_t, std::pair<double, uint64_t>>> sorted(
+            rules.begin(), rules.end());
+    std::sort(sorted.begin(), sorted.end(), [](
+                const std::pair<size_t, std::pair<double, uint64_t>> &a,
+                const std::pair<size_t, std::pair<double, uint64_t>> &b) {
+            return a.second.first > b.second.first;
+            });
+    LOG(INFOL) << "Most expensive rules:";
+    for (int i = 0; i < n && i < sorted.size(); ++i) {
+        LOG(INFOL) << "  " << sorted[i].second.first << "ms, "
+            << sorted[i].second.second << " derivations: "
+            << getRuleString(program, layer, sorted[i].first);
+    }
+}
+
+void RuleProfiler::exportJSON(std::string file, Program *program,
+        EDBLayer &layer) {
+    json out = json::array();
+    for (const auto &p : profiles) {
+        json rule;
+        rule["rule"] = getRuleString(program, layer, p.ruleid);
+        rule["ruleid"] = p.ruleid;
+        rule["iteration"] = p.iteration;
+        rule["combinations"] = p.combinations;
+        rule["timeMs"] = p.timeMs;
+        json phases;
+        for (int i = 0; i < PROFILE_NPHASES; ++i) {
+            phases[phaseNames[i]] = p.phasesMs[i];
+        }
+        rule["phasesMs"] = phases;
+        rule["derivations"] = p.derivations;
+        rule["memoryDeltaKB"] = p.memoryDelta;
+        json atoms = json::array();
+        for (const auto &a : p.atoms) {
+            json atom;
+            atom["literal"] = a.literal;
+            atom["posInPlan"] = a.posInPlan;
+            atom["join"] = a.join;
+            atom["rowsIn"] = a.rowsIn;
+            atom["rowsLeft"] = a.rowsLeft;
+            atom["rowsOut"] = a.rowsOut;
+            atom["timeMs"] = a.timeMs;
+            atoms.push_back(atom);
+        }
+        rule["atoms"] = atoms;
+        out.push_back(rule);
+    }
+    std::ofstream f(file);
+    if (!f.good()) {
+        LOG(ERRORL) << "Cannot write the profile to " << file;
+        throw 10;
+    }
+    f << out.dump(1) << std::endl;
+}
+
+void RuleProfiler::exportCSV(std::string file, Program *program,
+        EDBLayer &layer) {
+    std::ofstream f(file);
+    if (!f.good()) {
+        LOG(ERRORL) << "Cannot write the profile to " << file;
+        throw 10;
+    }
+    f << "ruleid,rule,iteration,combinations,timeMs";
+    for (int i = 0; i < PROFILE_NPHASES; ++i) {
+        f << "," << phaseNames[i] << "Ms";
+    }
+    f << ",derivations,memoryDeltaKB,joins" << std::endl;
+    for (const auto &p : profiles) {
+        f << p.ruleid << ","
+            << VLogUtils::csvString(getRuleString(program, layer, p.ruleid))
+            << "," << p.iteration << "," << p.combinations << "," << p.timeMs;
+        for (int i = 0; i < PROFILE_NPHASES; ++i) {
+            f << "," << p.phasesMs[i];
+        }
+        std::string joins;
+        for (const auto &a : p.atoms) {
+            if (!joins.empty()) {
+                joins += " ";
+            }
+            joins += a.join;
+        }
+        f << "," << p.derivations << "," << p.memoryDelta << "," << joins
+            << std::endl;
+    }
+}
+
+ProfilePhaseTimer::ProfilePhaseTimer(const ProfilePhase phase) :
+    profile(currentProfile), previousPhase(currentPhase) {
+        if (profile == NULL) {
+            return;
+        }
+        //The time until now belongs to the enclosing phase
+        auto now = std::chrono::steady_clock::now();
+        if (currentPhase >= 0) {
+            std::chrono::duration<double, std::milli> d = now - phaseStart;
+            profile->phasesMs[currentPhase] += d.count();
+        }
+        currentPhase = phase;
+        phaseStart = now;
+    }
+
+ProfilePhaseTimer::~ProfilePhaseTimer() {
+    if (profile == NULL || profile != currentProfile) {
+        return;
+    }
+    auto now = std::chrono::steady_clock::now();
+    std::chrono::duration<double, std::milli> d = now - phaseStart;
+    profile->phasesMs[currentPhase] += d.count();
+    currentPhase = previousPhase;
+    phaseStart = now;
+}
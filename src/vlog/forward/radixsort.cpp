@@ -0,0 +1,155 @@
+#include <vlog/radixsort.h>
+#include <vlog/segment.h>
+#include <vlog/morsel.h>
+
+#include <kognac/logs.h>
+
+#include <algorithm>
+
+#define RADIX_SORT_BUCKETS (1 << RADIX_SORT_BITS)
+
+void RadixSorter::sort(const std::vector<const std::vector<Term_t> *> &vectors,
+        std::vector<size_t> &idxs, const int nthreads) {
+    const size_t n = idxs.size();
+    if (n < RADIX_SORT_MIN_ROWS || vectors.empty()) {
+        SegmentSorter sorter(vectors);
+        std::sort(idxs.begin(), idxs.end(), std::ref(sorter));
+        return;
+    }
+
+    //The chunks are fixed so that every pass preserves the relative order
+    //of the rows, which is what makes the sort stable
+    const int nchunks = std::max(1, nthreads);
+    const size_t chunkSize = (n + nchunks - 1) / nchunks;
+    std::vector<Term_t> keys(n);
+    std::vector<Term_t> keys2(n);
+    std::vector<size_t> idxs2(n);
+    std::vector<std::vector<size_t>> histograms(nchunks,
+            std::vector<size_t>(RADIX_SORT_BUCKETS));
+    std::vector<Term_t> diffs(nchunks);
+    size_t npasses = 0;
+
+    for (int c = (int) vectors.size() - 1; c >= 0; --c) {
+        //Load the values of the column in the current order of the rows,
+        //and find out which bits are not constant
+        const Term_t *col = vectors[c]->data();
+        const Term_t first = col[idxs[0]];
+        MorselScheduler::run(nchunks, 1, nthreads,
+                [&](const int worker, const size_t chunk, const size_t) {
+                    const size_t begin = std::min(n, chunk * chunkSize);
+                    const size_t end = std::min(n, begin + chunkSize);
+                    Term_t diff = 0;
+                    for (size_t i = begin; i < end; ++i) {
+                        const Term_t v = col[idxs[i]];
+                        keys[i] = v;
+                        diff |= v ^ first;
+                    }
+                    diffs[chunk] = diff;
+                });
+        Term_t diff = 0;
+        for (int i = 0; i < nchunks; ++i) {
+            diff |= diffs[i];
+        }
+
+        for (int shift = 0; shift < (int) (sizeof(Term_t) * 8);
+                shift += RADIX_SORT_BITS) {
+            if (((diff >> shift) & (RADIX_SORT_BUCKETS - 1)) == 0) {
+                continue;
+            }
+            npasses++;
+
+            MorselScheduler::run(nchunks, 1, nthreads,
+                    [&](const int worker, const size_t chunk, const size_t) {
+                        const size_t begin = std::min(n, chunk * chunkSize);
+                        const size_t end = std::min(n, begin + chunkSize);
+                        std::vector<size_t> &histogram = histograms[chunk];
+                        std::fill(histogram.begin(), histogram.end(), 0);
+                        for (size_t i = begin; i < end; ++i) {
+                            histogram[(keys[i] >> shift) & (RADIX_SORT_BUCKETS - 1)]++;
+                        }
+                    });
+
+            //Every chunk writes in its own range of every bucket
+            size_t pos = 0;
+            for (size_t b = 0; b < RADIX_SORT_BUCKETS; ++b) {
+                for (int chunk = 0; chunk < nchunks; ++chunk) {
+                    const size_t count = histograms[chunk][b];
+                    histograms[chunk][b] = pos;
+                    pos += count;
+                }
+            }
+
+            MorselScheduler::run(nchunks, 1, nthreads,
+                    [&](const int worker, const size_t chunk, const size_t) {
+                        const size_t begin = std::min(n, chunk * chunkSize);
+                        const size_t end = std::min(n, begin + chunkSize);
+                        std::vector<size_t> &cursor = histograms[chunk];
+                        for (size_t i = begin; i < end; ++i) {
+                            const size_t p = cursor[(keys[i] >> shift) &
+                                (RADIX_SORT_BUCKETS - 1)]++;
+                            keys2[p] = keys[i];
+                            idxs2[p] = idxs[i];
+                        }
+                    });
+            keys.swap(keys2);
+            idxs.swap(idxs2);
+        }
+    }
+    LOG(TRACEL) << "Radix sort of " << n << " rows and " << vectors.size()
+        << " columns took " << npasses << " passes";
+}
+
+static bool sameRow(const std::vector<const std::vector<Term_t> *> &vectors,
+        const size_t r1, const size_t r2) {
+    for (int i = 0; i < vectors.size(); ++i) {
+        if ((*vectors[i])[r1] != (*vectors[i])[r2]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void RadixSorter::unique(const std::vector<const std::vector<Term_t> *> &vectors,
+        std::vector<size_t> &idxs, const int nthreads) {
+    const size_t n = idxs.size();
+    if (n < 2) {
+        return;
+    }
+    const int nchunks = n < RADIX_SORT_MIN_ROWS ? 1 : std::max(1, nthreads);
+    const size_t chunkSize = (n + nchunks - 1) / nchunks;
+
+    //First count the rows to keep in every chunk, then copy them
+    std::vector<size_t> counts(nchunks + 1);
+    MorselScheduler::run(nchunks, 1, nthreads,
+            [&](const int worker, const size_t chunk, const size_t) {
+                const size_t begin = std::min(n, chunk * chunkSize);
+                const size_t end = std::min(n, begin + chunkSize);
+                size_t count = 0;
+                for (size_t i = begin; i < end; ++i) {
+                    if (i == 0 || !sameRow(vectors, idxs[i - 1], idxs[i])) {
+                        count++;
+                    }
+                }
+                counts[chunk + 1] = count;
+            });
+    for (int i = 0; i < nchunks; ++i) {
+        counts[i + 1] += counts[i];
+    }
+    if (counts[nchunks] == n) {
+        return;
+    }
+
+    std::vector<size_t> out(counts[nchunks]);
+    MorselScheduler::run(nchunks, 1, nthreads,
+            [&](const int worker, const size_t chunk, const size_t) {
+                const size_t begin = std::min(n, chunk * chunkSize);
+                const size_t end = std::min(n, begin + chunkSize);
+                size_t pos = counts[chunk];
+                for (size_t i = begin; i < end; ++i) {
+                    if (i == 0 || !sameRow(vectors, idxs[i - 1], idxs[i])) {
+                        out[pos++] = idxs[i];
+                    }
+                }
+            });
+    idxs.swap(out);
+}
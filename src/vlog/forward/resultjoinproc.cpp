@@ -1,5 +1,6 @@
 #include <vlog/resultjoinproc.h>
 #include <vlog/fcinttable.h>
+#include <vlog/spill.h>
 
 void copyFromArray(Term_t *dest, FCInternalTableItr *source, const uint8_t n, const int *pos) {
     for (int i = 0; i < n; ++i)
@@ -42,17 +43,16 @@ void ResultJoinProcessor::copyRawRow(const Term_t *first,
 InterTableJoinProcessor::InterTableJoinProcessor(const uint8_t rowsize,
         std::vector<std::pair<uint8_t, uint8_t>> &posFromFirst,
         std::vector<std::pair<uint8_t, uint8_t>> &posFromSecond,
-        int nthreads) :
+        int nthreads, Arena *arena) :
     ResultJoinProcessor(rowsize, (uint8_t) posFromFirst.size(), (uint8_t) posFromSecond.size(),
             (posFromFirst.size() > 0) ?  & (posFromFirst[0]) : NULL,
             posFromSecond.size() > 0 ? & (posFromSecond[0]) : NULL, nthreads,
-            false) {
+            false), arena(arena), spiller(NULL) {
         currentSegmentSize = MAX_NSEGMENTS;
         nonEmptyZeroRowsize = false;
         segments = new std::shared_ptr<SegmentInserter>[currentSegmentSize];
         for (uint32_t i = 0; i < currentSegmentSize; ++i) {
-            segments[i] = std::shared_ptr<SegmentInserter>(new SegmentInserter(rowsize));
-
+            segments[i] = newSegmentInserter();
         }
     }
 
@@ -211,6 +211,9 @@ void InterTableJoinProcessor::consolidate(const bool isFinished) {
 
     if (segs.size() > 0) {
         std::shared_ptr<const Segment> seg = segs.size() == 1 ? segs[0] : SegmentInserter::merge(segs);
+        if (spiller != NULL) {
+            seg = spiller->seal(seg);
+        }
         if (table == NULL) {
             table = std::shared_ptr<const FCInternalTable>(
                     new InmemoryFCInternalTable(rowsize, 0,
@@ -223,10 +226,8 @@ void InterTableJoinProcessor::consolidate(const bool isFinished) {
 
         for (uint32_t i = 0; i < currentSegmentSize; ++i) {
             if (segments[i] != NULL && !segments[i]->isEmpty()) {
-                uint8_t rs = table->getRowSize();
-                assert(rs == rowsize);
-                segments[i] = std::shared_ptr<SegmentInserter>(
-                        new SegmentInserter(rs));
+                assert(table->getRowSize() == rowsize);
+                segments[i] = newSegmentInserter();
             }
         }
     }
@@ -310,3 +311,111 @@ void InterTableJoinProcessor::processResults(const int blockid, const bool uniqu
 InterTableJoinProcessor::~InterTableJoinProcessor() {
     delete[] segments;
 }
+
+BufferedJoinProcessor::BufferedJoinProcessor(ResultJoinProcessor *output) :
+    ResultJoinProcessor(output->getRowSize(), output->getNCopyFromFirst(),
+            output->getNCopyFromSecond(), output->getPosFromFirst(),
+            output->getPosFromSecond(), -1, false), output(output) {
+        const Term_t *outputRow = output->getRawRow();
+        for (int i = 0; i < rowsize; ++i) {
+            row[i] = outputRow[i];
+        }
+    }
+
+void BufferedJoinProcessor::processResults(const int blockid, const bool unique,
+        std::mutex *m) {
+    rows.insert(rows.end(), row, row + rowsize);
+    rowsBlockId.push_back(blockid);
+    rowsUnique.push_back(unique);
+}
+
+void BufferedJoinProcessor::processResults(std::vector<int> &blockid, Term_t *p,
+        std::vector<bool> &unique, std::mutex *m) {
+    for (int j = 0; j < blockid.size(); j++) {
+        for (int i = 0; i < nCopyFromFirst; ++i) {
+            row[posFromFirst[i].first] = *p;
+            p++;
+        }
+        for (int i = 0; i < nCopyFromSecond; ++i) {
+            row[posFromSecond[i].first] = *p;
+            p++;
+        }
+        processResults(blockid[j], unique[j], NULL);
+    }
+}
+
+void BufferedJoinProcessor::processResults(const int blockid, const Term_t *first,
+        FCInternalTableItr* second, const bool unique) {
+    copyRawRow(first, second);
+    processResults(blockid, unique, NULL);
+}
+
+void BufferedJoinProcessor::processResults(const int blockid, FCInternalTableItr *first,
+        FCInternalTableItr* second, const bool unique) {
+    for (int i = 0; i < nCopyFromFirst; ++i) {
+        row[posFromFirst[i].first] = first->getCurrentValue(posFromFirst[i].second);
+    }
+    for (int i = 0; i < nCopyFromSecond; ++i) {
+        row[posFromSecond[i].first] = second->getCurrentValue(posFromSecond[i].second);
+    }
+    processResults(blockid, unique, NULL);
+}
+
+void BufferedJoinProcessor::processResults(const int blockid,
+        const std::vector<const std::vector<Term_t> *> &vectors1, size_t i1,
+        const std::vector<const std::vector<Term_t> *> &vectors2, size_t i2,
+        const bool unique) {
+    for (int i = 0; i < nCopyFromFirst; i++) {
+        row[posFromFirst[i].first] = (*vectors1[posFromFirst[i].second])[i1];
+    }
+    for (int i = 0; i < nCopyFromSecond; i++) {
+        row[posFromSecond[i].first] = (*vectors2[posFromSecond[i].second])[i2];
+    }
+    processResults(blockid, unique, NULL);
+}
+
+void BufferedJoinProcessor::addColumns(const int blockid,
+        std::vector<std::shared_ptr<Column>> &columns,
+        const bool unique, const bool sorted) {
+    ColumnsBlock b;
+    b.blockid = blockid;
+    b.columns = columns;
+    b.unique = unique;
+    b.sorted = sorted;
+    columnsBlocks.push_back(b);
+}
+
+bool BufferedJoinProcessor::isBlockEmpty(const int blockId, const bool unique) const {
+    for (int i = 0; i < rowsBlockId.size(); ++i) {
+        if (rowsBlockId[i] == blockId && rowsUnique[i] == unique)
+            return false;
+    }
+    for (const auto &b : columnsBlocks) {
+        if (b.blockid == blockId && b.unique == unique)
+            return false;
+    }
+    return true;
+}
+
+bool BufferedJoinProcessor::isEmpty() const {
+    return rowsBlockId.empty() && columnsBlocks.empty();
+}
+
+void BufferedJoinProcessor::flush() {
+    Term_t *outputRow = output->getRawRow();
+    const Term_t *r = rows.data();
+    for (size_t j = 0; j < rowsBlockId.size(); ++j) {
+        for (int i = 0; i < rowsize; ++i) {
+            outputRow[i] = r[i];
+        }
+        output->processResults(rowsBlockId[j], false);
+        r += rowsize;
+    }
+    for (auto &b : columnsBlocks) {
+        output->addColumns(b.blockid, b.columns, false, b.sorted);
+    }
+    rows.clear();
+    rowsBlockId.clear();
+    rowsUnique.clear();
+    columnsBlocks.clear();
+}
@@ -248,9 +248,11 @@ void RuleExecutionPlan::calculateJoinsCoordinates(const std::vector<Literal> &he
                 }
             }
             extvars2posFromSecond = extvars2pos;
+            outputVariables.push_back(std::vector<Var_t>());
         } else {
             existingVariables = newExistingVariables;
             sizeOutputRelation.push_back(existingVariables.size());
+            outputVariables.push_back(existingVariables);
         }
         joinCoordinates.push_back(jc);
         posFromFirst.push_back(pf);
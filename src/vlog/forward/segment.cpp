@@ -2,6 +2,8 @@
 #include <vlog/segment_support.h>
 #include <vlog/support.h>
 #include <vlog/fcinttable.h>
+#include <vlog/radixsort.h>
+#include <vlog/profiler.h>
 
 //#include <tbb/parallel_for.h>
 
@@ -323,7 +325,6 @@ std::shared_ptr<Segment> Segment::intsort(
             } else {
                 //Sort function
                 std::vector<const std::vector<Term_t> *> vectors = getAllVectors(varColumns);
-                SegmentSorter sorter(vectors);
 
                 const size_t allRows = vectors[0]->size();
                 std::vector<size_t> rows;
@@ -332,7 +333,7 @@ std::shared_ptr<Segment> Segment::intsort(
                     rows.push_back(i);
                 }
 
-                std::sort(rows.begin(), rows.end(), std::ref(sorter));
+                RadixSorter::sort(vectors, rows, 1);
                 // LOG(TRACEL) << "Sort done.";
 
                 //Reconstruct the fields
@@ -478,13 +479,7 @@ std::shared_ptr<Segment> Segment::intsort(
 
                 //Sort
                 //start = std::chrono::system_clock::now();
-                PairComparator pc(rawv1, rawv2);
-
-                if (idxs.size() > 1000) {
-                    ParallelTasks::sort_int(idxs.begin(), idxs.end(), pc, nthreads);
-                } else {
-                    std::sort(idxs.begin(), idxs.end(), pc);
-                }
+                RadixSorter::sort(vectors, idxs, nthreads);
                 //sec1 = std::chrono::system_clock::now() - start;
                 //LOG(WARNL) << "---- parallel sort =" << sec1.count() * 1000 << " " << nthreads;
 
@@ -580,43 +575,35 @@ std::shared_ptr<Segment> Segment::intsort(
                 //sec1 = std::chrono::system_clock::now() - start;
                 //LOG(WARNL) << "---- copy back =" << sec1.count() * 1000 << " " << nthreads;
             } else {
-                //Sort function
-                SegmentSorter sorter(vectors);
-
-                if (nthreads > 1 && idxs.size() > 1000) {
-                    ParallelTasks::sort_int(idxs.begin(), idxs.end(), std::ref(sorter), nthreads);
-                } else {
-                    std::sort(idxs.begin(), idxs.end(), std::ref(sorter));
-                }
+                RadixSorter::sort(vectors, idxs, nthreads);
                 // LOG(TRACEL) << "Sort done.";
-                //
-                if (! filterDupl) {
-                    std::vector<std::vector<Term_t>> out(varColumns.size());
-                    // Not sure if it makes sense to do this in parallel at all
-                    if (nthreads <= 1 || chunks < 10000) {
-                        // Sequential version
-                        for (size_t i = 0; i < idxs.size(); i++) {
-                            for (int j = 0; j < out.size(); j++) {
-                                out[j].push_back((*vectors[j])[idxs[i]]);
-                            }
-                        }
-                    } else {
-                        // Parallel version
-                        for (int i = 0; i < out.size(); i++) {
-                            out[i].resize(idxs.size());
+                if (filterDupl) {
+                    RadixSorter::unique(vectors, idxs, nthreads);
+                    chunks = (idxs.size() + nthreads - 1) / nthreads;
+                }
+
+                std::vector<std::vector<Term_t>> out(varColumns.size());
+                // Not sure if it makes sense to do this in parallel at all
+                if (nthreads <= 1 || chunks < 10000) {
+                    // Sequential version
+                    for (size_t i = 0; i < idxs.size(); i++) {
+                        for (int j = 0; j < out.size(); j++) {
+                            out[j].push_back((*vectors[j])[idxs[i]]);
                         }
-                        //tbb::parallel_for(tbb::blocked_range<size_t>(0, idxs.size(), chunks),
-                        //        CreateColumns(idxs, vectors, out));
-                        ParallelTasks::parallel_for(0, idxs.size(), chunks,
-                                CreateColumns(idxs, vectors, out));
-                    }
-                    sortedColumns.push_back(ColumnWriter::getColumn(out[0], true));
-                    for (int i = 1; i < out.size(); i++) {
-                        sortedColumns.push_back(ColumnWriter::getColumn(out[i], false));
                     }
                 } else {
-                    // TODO!
-                    throw 10;
+                    // Parallel version
+                    for (int i = 0; i < out.size(); i++) {
+                        out[i].resize(idxs.size());
+                    }
+                    //tbb::parallel_for(tbb::blocked_range<size_t>(0, idxs.size(), chunks),
+                    //        CreateColumns(idxs, vectors, out));
+                    ParallelTasks::parallel_for(0, idxs.size(), chunks,
+                            CreateColumns(idxs, vectors, out));
+                }
+                sortedColumns.push_back(ColumnWriter::getColumn(out[0], true));
+                for (int i = 1; i < out.size(); i++) {
+                    sortedColumns.push_back(ColumnWriter::getColumn(out[i], false));
                 }
             }
             deleteAllVectors(varColumns, vectors);
@@ -626,7 +613,7 @@ std::shared_ptr<Segment> Segment::intsort(
         std::vector<std::shared_ptr<Column>> allSortedColumns;
 
         assert(varColumns.size() > 0);
-        size_t newsize = varColumns[0]->size();
+        size_t newsize = sortedColumns[0]->size();
 
         for (int i = 0; i < nfields; ++i) {
             bool isVar = false;
@@ -1230,6 +1217,7 @@ std::shared_ptr<const Segment> SegmentInserter::retain(
         std::shared_ptr<const FCInternalTable> existingValues,
         const bool duplicates,
         const int nthreads) {
+    ProfilePhaseTimer timer(PROFILE_DEDUPLICATION);
 
     if (segment->isEmpty())
         return segment;
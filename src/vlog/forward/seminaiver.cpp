@@ -6,6 +6,7 @@
 #include <vlog/filterer.h>
 #include <vlog/finalresultjoinproc.h>
 #include <vlog/extresultjoinproc.h>
+#include <vlog/leapfrog.h>
 #include <vlog/utils.h>
 #include <trident/model/table.h>
 #include <kognac/consts.h>
@@ -84,11 +85,17 @@ SemiNaiver::SemiNaiver(EDBLayer &layer,
     multithreaded(multithreaded),
     typeChase(typeChase),
     running(false),
+    cacheManager(new FCCacheManager(FCCACHE_DEFAULT_BUDGET)),
     layer(layer),
     program(program),
     nthreads(nthreads),
     checkCyclicTerms(false),
     ignoreExistentialRules(ignoreExistentialRules),
+    joinAlgorithm(MERGE_JOIN),
+    joinAlgorithmWarned(false),
+    joinOrder(HEURISTIC_ORDER),
+    multiwayJoin(true),
+    sidewaysFilters(false),
     RMFC_program(RMFC_check) {
 
         std::vector<Rule> ruleset = program->getAllRules();
@@ -723,7 +730,8 @@ bool SemiNaiver::bodyChangedSince(Rule &rule, size_t iteration) {
 bool SemiNaiver::checkIfAtomsAreEmpty(const RuleExecutionDetails &ruleDetails,
         const RuleExecutionPlan &plan,
         size_t limitView,
-        std::vector<size_t> &cards) {
+        std::vector<size_t> &cards,
+        std::vector<std::pair<size_t, size_t>> *ranges) {
     const int nBodyLiterals = plan.plan.size();
     bool isOneRelEmpty = false;
     //First I check if there are tuples in each relation.
@@ -743,6 +751,9 @@ bool SemiNaiver::checkIfAtomsAreEmpty(const RuleExecutionDetails &ruleDetails,
         }
 
         cards.push_back(estimateCardTable(*plan.plan[i], min, max));
+        if (ranges != NULL) {
+            ranges->push_back(std::make_pair(min, max));
+        }
         LOG(DEBUGL) << "Estimation of the atom " <<
             plan.plan[i]->tostring(program, &layer) <<
             " is " << cards.back() << " in the range " <<
@@ -1155,17 +1166,108 @@ void SemiNaiver::reorderPlan(RuleExecutionPlan &plan,
     }
 }
 
+bool SemiNaiver::reorderPlanByCost(RuleExecutionPlan &plan,
+        const std::vector<size_t> &cards,
+        const std::vector<std::pair<size_t, size_t>> &ranges,
+        const std::vector<Literal> &heads,
+        bool copyAllVars) {
+    //Negated atoms are filters: they are placed after the others, and
+    //reorderPlanForNegatedLiterals moves them where their variables are bound
+    std::vector<JoinOrderOptimizer::Atom> atoms;
+    std::vector<int> positions;
+    std::vector<int> negated;
+    for (int i = 0; i < plan.plan.size(); ++i) {
+        const Literal *literal = plan.plan[i];
+        if (literal->isNegated()) {
+            negated.push_back(i);
+            continue;
+        }
+        std::vector<double> distinct;
+        if (literal->getPredicate().getType() == EDB) {
+            distinct = joinOrderOptimizer.getEDBDistinct(*literal, layer, cards[i]);
+        } else {
+            FCTable *table = predicatesTables[literal->getPredicate().getId()];
+            FCIterator itr;
+            if (table != NULL) {
+                itr = table->read(ranges[i].first, ranges[i].second);
+            }
+            distinct = joinOrderOptimizer.getIDBDistinct(*literal, itr, cards[i]);
+        }
+        atoms.push_back(JoinOrderOptimizer::getAtom(literal, cards[i], distinct));
+        positions.push_back(i);
+    }
+    if (atoms.empty()) {
+        return false;
+    }
+
+    std::vector<int> order = joinOrderOptimizer.getOrder(atoms);
+    if (order.empty()) {
+        LOG(DEBUGL) << "No order without cartesian products";
+        return false;
+    }
+    std::vector<int> orderLiterals;
+    for (auto i : order) {
+        orderLiterals.push_back(positions[i]);
+    }
+    std::copy(negated.begin(), negated.end(), std::back_inserter(orderLiterals));
+
+    bool toReorder = false;
+    for (int i = 0; i < orderLiterals.size(); ++i) {
+        LOG(DEBUGL) << "Cost-based plan: atom " << orderLiterals[i] << " has card " << cards[orderLiterals[i]];
+        if (orderLiterals[i] != i) {
+            toReorder = true;
+        }
+    }
+    if (toReorder) {
+        plan = plan.reorder(orderLiterals, heads, copyAllVars);
+    }
+    return true;
+}
+
+FCTable *SemiNaiver::newTable(const int card) {
+    FCTable *table = new FCTable(NULL, card);
+    table->setSpiller(spiller);
+    table->setCacheManager(cacheManager);
+    return table;
+}
+
 FCTable *SemiNaiver::getTable(const PredId_t pred, const int card) {
     FCTable *endTable;
     if (predicatesTables[pred] != NULL) {
         endTable = predicatesTables[pred];
     } else {
-        endTable = new FCTable(NULL, card);
+        endTable = newTable(card);
         predicatesTables[pred] = endTable;
     }
     return endTable;
 }
 
+void SemiNaiver::setMemoryBudget(uint64_t bytes, std::string spillDir) {
+    spiller = std::shared_ptr<SegmentSpiller>(new SegmentSpiller(bytes,
+                spillDir));
+    for (FCTable *table : predicatesTables) {
+        if (table != NULL) {
+            table->setSpiller(spiller);
+        }
+    }
+}
+
+void SemiNaiver::replaceTable(const PredId_t pred, FCTable *table) {
+    if (predicatesTables[pred] != NULL) {
+        delete predicatesTables[pred];
+    }
+    if (table != NULL) {
+        table->setSpiller(spiller);
+        table->setCacheManager(cacheManager);
+    }
+    predicatesTables[pred] = table;
+}
+
+void SemiNaiver::setFilterCacheBudget(uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(cacheManager->mutex);
+    cacheManager->budget = bytes;
+}
+
 void SemiNaiver::saveDerivationIntoDerivationList(FCTable *endTable) {
     LOG(ERRORL) << "Legacy method. Shouldn't be needed anymore ...";
     throw 10;
@@ -1175,6 +1277,10 @@ void SemiNaiver::saveStatistics(StatsRule &stats) {
     statsRuleExecution.push_back(stats);
 }
 
+void SemiNaiver::registerDerivation(const FCBlock &block) {
+    listDerivations.push_back(block);
+}
+
 bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
         const size_t iteration, const size_t limitView,
         std::vector<ResultJoinProcessor*> *finalResultContainer) {
@@ -1190,6 +1296,325 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
     return answer;
 }
 
+std::shared_ptr<const FCInternalTable> SemiNaiver::applySidewaysFilters(
+        const RuleExecutionPlan &plan,
+        const int pos,
+        const RuleExecutionDetails &ruleDetails,
+        std::shared_ptr<const FCInternalTable> results,
+        std::map<std::pair<int, Var_t>, std::unique_ptr<BloomFilter>> &filters) {
+    const std::vector<Var_t> &vars = plan.outputVariables[pos];
+    const size_t nrows = results->getNRows();
+    if (vars.empty() || nrows < SIP_MIN_RATIO) {
+        return results;
+    }
+
+    //The next atom is joined with the results anyway. The atoms after it
+    //can remove rows before that join
+    std::vector<std::pair<uint8_t, const BloomFilter*>> toCheck;
+    for (int k = pos + 2; k < plan.plan.size(); ++k) {
+        const Literal *literal = plan.plan[k];
+        if (literal->isNegated()) {
+            continue;
+        }
+        size_t min = plan.ranges[k].first;
+        size_t max = plan.ranges[k].second;
+        if (min == 1)
+            min = ruleDetails.lastExecution;
+        if (max == 1)
+            max = ruleDetails.lastExecution - 1;
+        if (min > max) {
+            continue;
+        }
+        for (uint8_t col = 0; col < vars.size(); ++col) {
+            const Var_t v = vars[col];
+            auto key = std::make_pair(k, v);
+            auto itr = filters.find(key);
+            if (itr == filters.end()) {
+                //Position of the variable in the columns of the atom
+                int posInLiteral = -1;
+                int nvars = 0;
+                for (int j = 0; j < literal->getTupleSize(); ++j) {
+                    const VTerm t = literal->getTermAtPos(j);
+                    if (t.isVariable()) {
+                        if (t.getId() == v) {
+                            posInLiteral = nvars;
+                            break;
+                        }
+                        nvars++;
+                    }
+                }
+                if (posInLiteral == -1) {
+                    continue;
+                }
+                BloomFilter *filter = NULL;
+                const size_t card = estimateCardinality(*literal, min, max);
+                if (card <= SIP_MAX_ROWS && card * SIP_MIN_RATIO <= nrows) {
+                    filter = new BloomFilter(card);
+                    FCIterator literalItr = getTable(*literal, min, max);
+                    while (!literalItr.isEmpty()) {
+                        auto table = literalItr.getCurrentTable();
+                        auto reader = table->getColumn(posInLiteral)->getReader();
+                        while (reader->hasNext()) {
+                            filter->add(reader->next());
+                        }
+                        literalItr.moveNextCount();
+                    }
+                }
+                //A NULL filter records that the atom is not selective enough
+                itr = filters.insert(std::make_pair(key,
+                            std::unique_ptr<BloomFilter>(filter))).first;
+            }
+            if (itr->second != NULL) {
+                toCheck.push_back(std::make_pair(col, itr->second.get()));
+            }
+        }
+    }
+    if (toCheck.empty()) {
+        return results;
+    }
+
+    const uint8_t rowsize = results->getRowSize();
+    SegmentInserter inserter(rowsize);
+    FCInternalTableItr *itr = results->getIterator();
+    while (itr->hasNext()) {
+        itr->next();
+        bool ok = true;
+        for (const auto &f : toCheck) {
+            if (!f.second->mayContain(itr->getCurrentValue(f.first))) {
+                ok = false;
+                break;
+            }
+        }
+        if (ok) {
+            inserter.addRow(itr);
+        }
+    }
+    results->releaseIterator(itr);
+    LOG(DEBUGL) << "Sideways filters on " << toCheck.size() << " variables kept "
+        << inserter.getNRows() << " rows out of " << nrows;
+    if (inserter.getNRows() == nrows) {
+        return results;
+    }
+    if (inserter.isEmpty()) {
+        return std::shared_ptr<const FCInternalTable>();
+    }
+    return std::shared_ptr<const FCInternalTable>(
+            new InmemoryFCInternalTable(rowsize, 0, results->isSorted(),
+                inserter.getSegment()));
+}
+
+bool SemiNaiver::useMultiwayJoin(const RuleExecutionDetails &ruleDetails,
+        const RuleExecutionPlan &plan) {
+    //Only cyclic bodies are joined at once: there, the binary joins can
+    //materialize intermediate results much larger than the output, which
+    //the leapfrog triejoin never does. This holds with several threads as
+    //well, even though the triejoin runs on one of them
+    if (!multiwayJoin || ruleDetails.rule.isExistential() ||
+            plan.plan.size() < 3) {
+        return false;
+    }
+    std::vector<std::vector<Var_t>> atoms;
+    for (const auto literal : plan.plan) {
+        if (literal->isNegated()) {
+            return false;
+        }
+        atoms.push_back(literal->getAllVars());
+    }
+    return LeapfrogTrieJoin::isCyclic(atoms);
+}
+
+void SemiNaiver::executeMultiwayJoin(const RuleExecutionPlan &plan,
+        std::vector<Literal> &heads,
+        int &processedTables,
+        const size_t iteration,
+        RuleExecutionDetails &ruleDetails,
+        const int orderExecution,
+        std::vector<ResultJoinProcessor*> *finalResultContainer) {
+    const std::chrono::system_clock::time_point start =
+        std::chrono::system_clock::now();
+    RuleProfile *profile = RuleProfiler::current();
+    LeapfrogTrieJoin lftj;
+    for (int i = 0; i < plan.plan.size(); ++i) {
+        const Literal *literal = plan.plan[i];
+        size_t min = plan.ranges[i].first;
+        size_t max = plan.ranges[i].second;
+        if (min == 1)
+            min = ruleDetails.lastExecution;
+        if (max == 1)
+            max = ruleDetails.lastExecution - 1;
+        if (min > max) {
+            return;
+        }
+
+        //The columns of the tables are the occurrences of the variables.
+        //Only the first occurrence of every variable is copied, and the
+        //others must have the same value
+        std::vector<Var_t> vars = literal->getAllVars();
+        std::vector<uint8_t> firstOccurrence;
+        std::vector<std::pair<uint8_t, uint8_t>> repeated;
+        std::vector<Var_t> occurrences;
+        for (int j = 0; j < literal->getTupleSize(); ++j) {
+            const VTerm t = literal->getTermAtPos(j);
+            if (t.isVariable()) {
+                auto itr = std::find(occurrences.begin(), occurrences.end(),
+                        t.getId());
+                if (itr == occurrences.end()) {
+                    firstOccurrence.push_back(occurrences.size());
+                } else {
+                    repeated.push_back(std::make_pair(
+                                itr - occurrences.begin(), occurrences.size()));
+                }
+                occurrences.push_back(t.getId());
+            }
+        }
+        if (vars.empty()) {
+            //The atom is ground: it only needs to be non-empty
+            if (checkEmpty(literal)) {
+                return;
+            }
+            continue;
+        }
+
+        FCIterator literalItr = getTable(*literal, min, max);
+        if (literal->getPredicate().getType() == IDB) {
+            processedTables += literalItr.getNTables();
+        }
+        size_t rowsIn = 0;
+        if (repeated.empty() && literalItr.getNTables() == 1) {
+            //A single table is read in place, in its sorted order
+            std::shared_ptr<const FCInternalTable> table =
+                literalItr.getCurrentTable();
+            FCInternalTableItr *itr = table->getSortedIterator();
+            std::vector<std::shared_ptr<Column>> columns = itr->getAllColumns();
+            table->releaseIterator(itr);
+            rowsIn = table->getNRows();
+            if (rowsIn > 0) {
+                lftj.addRelation(vars, columns, true);
+            }
+        } else {
+            //The tables of several iterations, or the rows where the
+            //repeated variables have the same value, are copied
+            std::vector<std::vector<Term_t>> columns(firstOccurrence.size());
+            while (!literalItr.isEmpty()) {
+                std::shared_ptr<const FCInternalTable> table =
+                    literalItr.getCurrentTable();
+                FCInternalTableItr *itr = table->getIterator();
+                while (itr->hasNext()) {
+                    itr->next();
+                    bool ok = true;
+                    for (const auto &p : repeated) {
+                        if (itr->getCurrentValue(p.first) !=
+                                itr->getCurrentValue(p.second)) {
+                            ok = false;
+                            break;
+                        }
+                    }
+                    if (ok) {
+                        for (size_t j = 0; j < firstOccurrence.size(); ++j) {
+                            columns[j].push_back(
+                                    itr->getCurrentValue(firstOccurrence[j]));
+                        }
+                    }
+                }
+                table->releaseIterator(itr);
+                literalItr.moveNextCount();
+            }
+            rowsIn = columns[0].size();
+            if (rowsIn > 0) {
+                lftj.addRelation(vars, columns);
+            }
+        }
+        if (profile) {
+            AtomProfile atom;
+            atom.literal = literal->tostring(program, &layer);
+            atom.posInPlan = i;
+            atom.join = "leapfrog";
+            atom.rowsIn = rowsIn;
+            atom.rowsLeft = 0;
+            atom.rowsOut = 0;
+            atom.timeMs = 0;
+            profile->atoms.push_back(atom);
+        }
+        if (rowsIn == 0) {
+            return;
+        }
+    }
+    lftj.prepare();
+
+    //The bindings are passed as "first" row, in the order of the variables
+    //chosen by the triejoin
+    const std::vector<Var_t> &variables = lftj.getVariables();
+    std::vector<std::pair<uint8_t, uint8_t>> posFromFirst;
+    std::vector<std::pair<uint8_t, uint8_t>> posFromSecond;
+    uint32_t countVars = 0;
+    for (const auto &head : heads) {
+        for (int j = 0; j < head.getTupleSize(); ++j) {
+            const VTerm t = head.getTermAtPos(j);
+            if (t.isVariable()) {
+                auto itr = std::find(variables.begin(), variables.end(),
+                        t.getId());
+                if (itr == variables.end()) {
+                    LOG(ERRORL) << "Variable of the head not in the body";
+                    throw 10;
+                }
+                posFromFirst.push_back(std::make_pair(countVars + j,
+                            itr - variables.begin()));
+            }
+        }
+        countVars += head.getTupleSize();
+    }
+
+    ResultJoinProcessor *joinOutput;
+    if (heads.size() == 1) {
+        FCTable *table = getTable(heads[0].getPredicate().getId(),
+                heads[0].getPredicate().getCardinality());
+        joinOutput = new SingleHeadFinalRuleProcessor(
+                posFromFirst,
+                posFromSecond,
+                listDerivations,
+                table,
+                heads[0],
+                0,
+                &ruleDetails,
+                orderExecution,
+                iteration,
+                finalResultContainer == NULL,
+                -1,
+                ignoreDuplicatesElimination);
+    } else {
+        joinOutput = new FinalRuleProcessor(
+                posFromFirst,
+                posFromSecond,
+                listDerivations,
+                heads, &ruleDetails,
+                orderExecution, iteration,
+                finalResultContainer == NULL,
+                -1, this,
+                ignoreDuplicatesElimination);
+    }
+    {
+        ProfilePhaseTimer timer(PROFILE_JOIN);
+        lftj.join(joinOutput);
+    }
+    {
+        ProfilePhaseTimer timer(PROFILE_CONSOLIDATION);
+        joinOutput->consolidate(true);
+    }
+    if (profile && !profile->atoms.empty()) {
+        //The atoms are joined at once: the last one gets the output and the
+        //time of the whole join
+        std::chrono::duration<double> d =
+            std::chrono::system_clock::now() - start;
+        profile->atoms.back().rowsOut = lftj.getNResults();
+        profile->atoms.back().timeMs = d.count() * 1000;
+    }
+    if (finalResultContainer) {
+        finalResultContainer->push_back(joinOutput);
+    } else {
+        delete joinOutput;
+    }
+}
+
 bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
         std::vector<Literal> &heads,
         const size_t iteration,
@@ -1233,6 +1658,19 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
     int orderExecution = 0;
     int processedTables = 0;
 
+    //The intermediate results are allocated in the arena of this thread,
+    //which is reset when the rule is executed
+    Arena *arena = Arena::getThreadArena();
+
+    //If a profiler is set, the operators report to the profile of this rule
+    RuleProfile profile;
+    if (profiler) {
+        profile.ruleid = ruleDetails.ruleid;
+        profile.iteration = iteration;
+        profile.memoryDelta = RuleProfiler::getResidentMemory();
+        RuleProfiler::setCurrent(&profile);
+    }
+
     //If the last iteration the rule failed because an atom was empty, I record this
     //because I might use this info to skip some computation later on
     const bool failEmpty = ruleDetails.failedBecauseEmpty;
@@ -1251,17 +1689,30 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
         const int nBodyLiterals = plan.plan.size();
 
         //**** Should I skip the evaluation because some atoms are empty? ***
-        bool isOneRelEmpty = checkIfAtomsAreEmpty(ruleDetails, plan, limitView, cards);
+        std::vector<std::pair<size_t, size_t>> ranges;
+        bool isOneRelEmpty = checkIfAtomsAreEmpty(ruleDetails, plan, limitView,
+                cards, &ranges);
         if (isOneRelEmpty) {
             LOG(DEBUGL) << "Aborting this combination";
             continue;
         }
 
-        //Reorder the list of atoms depending on the observed cardinalities
-        reorderPlan(plan, cards, heads, checkCyclicTerms);
+        //Reorder the list of atoms depending on the observed cardinalities.
+        //The plan is recomputed at every execution, since the sizes of the
+        //IDB tables change
+        if (joinOrder != COST_ORDER ||
+                !reorderPlanByCost(plan, cards, ranges, heads, checkCyclicTerms)) {
+            reorderPlan(plan, cards, heads, checkCyclicTerms);
+        }
         //Reorder for input negation (can we merge these two?)
         reorderPlanForNegatedLiterals(plan, heads);
 
+        if (useMultiwayJoin(ruleDetails, plan)) {
+            executeMultiwayJoin(plan, heads, processedTables, iteration,
+                    ruleDetails, orderExecution, finalResultContainer);
+            continue;
+        }
+
 #ifdef DEBUG
         std::string listLiterals = "EXEC COMB: ";
         for (const auto literal : plan.plan) {
@@ -1274,6 +1725,7 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
 
         std::shared_ptr<const FCInternalTable> currentResults = NULL;
         int optimalOrderIdx = 0;
+        std::map<std::pair<int, Var_t>, std::unique_ptr<BloomFilter>> filters;
 
         bool first = true;
         while (optimalOrderIdx < nBodyLiterals) {
@@ -1301,7 +1753,10 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
                         plan.sizeOutputRelation[optimalOrderIdx],
                         plan.posFromFirst[optimalOrderIdx],
                         plan.posFromSecond[optimalOrderIdx],
-                        ! multithreaded ? -1 : nthreads);
+                        ! multithreaded ? -1 : nthreads,
+                        arena);
+                ((InterTableJoinProcessor*)joinOutput)->setSpiller(
+                        spiller.get());
             } else {
                 if (ruleDetails.rule.isExistential()) {
                     joinOutput = new ExistentialRuleProcessor(
@@ -1379,6 +1834,20 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
             LOG(DEBUGL) << "Evaluating atom " << optimalOrderIdx << " " << bodyLiteral->tostring() <<
                 " min=" << min << " max=" << max;
 
+            std::chrono::system_clock::time_point startAtom;
+            if (profiler) {
+                AtomProfile atom;
+                atom.literal = bodyLiteral->tostring(program, &layer);
+                atom.posInPlan = optimalOrderIdx;
+                atom.join = (first || currentResults == NULL) ? "scan" : "";
+                atom.rowsIn = estimateCardinality(*bodyLiteral, min, max);
+                atom.rowsLeft = currentResults != NULL ? currentResults->getNRows() : 0;
+                atom.rowsOut = 0;
+                atom.timeMs = 0;
+                profile.atoms.push_back(atom);
+                startAtom = std::chrono::system_clock::now();
+            }
+
             if (first || currentResults == NULL) {
                 // Added the case "currentResults == NULL", which may occur when part of a body is processed,
                 // but this part does not contribute anything to the rest of the processing of the rule.
@@ -1389,6 +1858,7 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
                         || plan.posFromFirst[optimalOrderIdx].size() > 0
                         || plan.joinCoordinates[optimalOrderIdx].size() > 0) {
                     std::chrono::system_clock::time_point startFirstA = std::chrono::system_clock::now();
+                    ProfilePhaseTimer timer(PROFILE_JOIN);
                     processRuleFirstAtom(nBodyLiterals, bodyLiteral,
                             heads, min, max, processedTables,
                             lastLiteral,
@@ -1410,16 +1880,19 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
             } else {
                 //Perform the join
                 std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
-                JoinExecutor::join(this, currentResults.get(),
-                        lastLiteral ? &heads: NULL,
-                        *bodyLiteral, min, max, filterValueVars,
-                        plan.joinCoordinates[optimalOrderIdx],
-                        joinOutput,
-                        lastLiteral, ruleDetails,
-                        plan,
-                        processedTables,
-                        optimalOrderIdx,
-                        multithreaded ? nthreads : -1);
+                {
+                    ProfilePhaseTimer timer(PROFILE_JOIN);
+                    JoinExecutor::join(this, currentResults.get(),
+                            lastLiteral ? &heads: NULL,
+                            *bodyLiteral, min, max, filterValueVars,
+                            plan.joinCoordinates[optimalOrderIdx],
+                            joinOutput,
+                            lastLiteral, ruleDetails,
+                            plan,
+                            processedTables,
+                            optimalOrderIdx,
+                            multithreaded ? nthreads : -1);
+                }
                 std::chrono::duration<double> d =
                     std::chrono::system_clock::now() - start;
                 LOG(DEBUGL) << "Time join: " << d.count() * 1000;
@@ -1430,6 +1903,7 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
             std::chrono::system_clock::time_point startC =
                 std::chrono::system_clock::now();
             if (! first) {
+                ProfilePhaseTimer timer(PROFILE_CONSOLIDATION);
                 joinOutput->consolidate(true);
                 std::chrono::duration<double> d =
                     std::chrono::system_clock::now() - startC;
@@ -1437,10 +1911,38 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
             }
 
             bool notEmptyZeroRowsize = false;
+            //True if the intermediate result is empty only because the
+            //sideways filters removed all its rows
+            bool emptiedByFilters = false;
             //Prepare for the processing of the next atom (if any)
             if (!lastLiteral && !first) {
                 currentResults = ((InterTableJoinProcessor*)joinOutput)->getTable();
                 notEmptyZeroRowsize = ((InterTableJoinProcessor*)joinOutput)->getNonEmptyZeroRowsize();
+                if (sidewaysFilters && currentResults != NULL &&
+                        currentResults->getRowSize() > 0) {
+                    ProfilePhaseTimer timer(PROFILE_FILTERING);
+                    const bool wasEmpty = currentResults->isEmpty();
+                    currentResults = applySidewaysFilters(plan, optimalOrderIdx,
+                            ruleDetails, currentResults, filters);
+                    emptiedByFilters = !wasEmpty && (currentResults == NULL ||
+                            currentResults->isEmpty());
+                }
+            }
+            if (profiler && !profile.atoms.empty() &&
+                    profile.atoms.back().posInPlan == optimalOrderIdx) {
+                AtomProfile &atom = profile.atoms.back();
+                if (!lastLiteral && !first && currentResults != NULL) {
+                    atom.rowsOut = currentResults->getNRows();
+                } else if (lastLiteral) {
+                    for (auto &h : heads) {
+                        FCTable *t = getTable(h.getPredicate().getId(),
+                                h.getPredicate().getCardinality());
+                        atom.rowsOut += t->getNRows(iteration);
+                    }
+                }
+                std::chrono::duration<double> d =
+                    std::chrono::system_clock::now() - startAtom;
+                atom.timeMs = d.count() * 1000;
             }
             if (lastLiteral && finalResultContainer) {
                 finalResultContainer->push_back(joinOutput);
@@ -1454,8 +1956,11 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
                 LOG(DEBUGL) << "The evaluation of atom " <<
                     (optimalOrderIdx - 1) << " returned no result";
                 //If the range was 0 to MAX_INT, then also other combinations
-                //will never fire anything
-                if (min == 0 && max == (size_t) - 1 && failEmpty && atomFail == bodyLiteral) {
+                //will never fire anything. This does not hold if the rows
+                //were removed by the sideways filters, since these depend
+                //on the atoms joined later in this combination
+                if (min == 0 && max == (size_t) - 1 && failEmpty &&
+                        atomFail == bodyLiteral && !emptiedByFilters) {
                     orderExecution = orderExecutions->size();
                     ruleDetails.failedBecauseEmpty = true;
                     ruleDetails.atomFailure = bodyLiteral;
@@ -1465,6 +1970,9 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
         }
     }
 
+    const uint64_t arenaTerms = arena->getAllocatedTerms();
+    arena->reset();
+
     bool prodDer = false;
     for (auto &h : heads) {
         auto idHeadPredicate = h.getPredicate().getId();
@@ -1473,7 +1981,8 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
         if (!t->isEmpty(iteration)) {
             FCBlock block = t->getLastBlock();
             if (block.iteration == iteration) {
-                listDerivations.push_back(block);
+                registerDerivation(block);
+                profile.derivations += block.table->getNRows();
             }
             prodDer |= true;
         }
@@ -1483,6 +1992,14 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
         std::chrono::system_clock::now() - startRule;
     double td = totalDuration.count() * 1000;
 
+    if (profiler) {
+        profile.combinations = orderExecution;
+        profile.timeMs = td;
+        profile.memoryDelta = RuleProfiler::getResidentMemory() - profile.memoryDelta;
+        RuleProfiler::setCurrent(NULL);
+        profiler->add(profile);
+    }
+
 #ifdef WEBINTERFACE
     StatsRule stats;
     stats.iteration = iteration;
@@ -1518,7 +2035,8 @@ bool SemiNaiver::executeRule(RuleExecutionDetails &ruleDetails,
         << ", Total runtime " << stream.str()
         << ", join " << durationJoin.count() * 1000
         << "ms, consolidation " << durationConsolidation.count() * 1000
-        << "ms, retrieving first atom " << durationFirstAtom.count() * 1000 << "ms.";
+        << "ms, retrieving first atom " << durationFirstAtom.count() * 1000
+        << "ms, intermediate results " << arenaTerms * sizeof(Term_t) / 1024 << "KB.";
 
     std::string trueFalseString = prodDer ? "true" : "false";
     //std::cout << "Executed rule " << ruleDetails.rule.getId() << ": " << trueFalseString << '\n';
@@ -1637,23 +2155,23 @@ size_t SemiNaiver::estimateCardinality(const Literal &literal, const size_t minI
     }
 }
 
-FCIterator SemiNaiver::getTableFromEDBLayer(const Literal & literal) {
-    PredId_t id = literal.getPredicate().getId();
-    FCTable *table = predicatesTables[id];
-    if (table == NULL) {
-        table = SemiNaiver::getTable(id, (uint8_t) literal.getTupleSize());
-
-        VTuple t = literal.getTuple();
-        //Add all different variables
-        for (int i = 0; i < t.getSize(); ++i) {
-            t.set(VTerm(i + 1, 0), i);
-        }
-        Literal mostGenericLiteral(literal.getPredicate(), t);
+FCTable *SemiNaiver::newEDBTable(const Literal &literal) {
+    FCTable *table = newTable((uint8_t) literal.getTupleSize());
 
-        std::shared_ptr<FCInternalTable> ptrTable(new EDBFCInternalTable(0,
-                    mostGenericLiteral, &layer));
-        table->add(ptrTable, mostGenericLiteral, 0, NULL, 0, 0, true, nthreads);
+    VTuple t = literal.getTuple();
+    //Add all different variables
+    for (int i = 0; i < t.getSize(); ++i) {
+        t.set(VTerm(i + 1, 0), i);
     }
+    Literal mostGenericLiteral(literal.getPredicate(), t);
+
+    std::shared_ptr<FCInternalTable> ptrTable(new EDBFCInternalTable(0,
+                mostGenericLiteral, &layer));
+    table->add(ptrTable, mostGenericLiteral, 0, NULL, 0, 0, true, nthreads);
+    return table;
+}
+
+FCIterator SemiNaiver::readEDBTable(FCTable *table, const Literal &literal) {
     if (literal.getNUniqueVars() < literal.getTupleSize()) {
         return table->filter(literal, nthreads)->read(0);
     } else {
@@ -1661,8 +2179,19 @@ FCIterator SemiNaiver::getTableFromEDBLayer(const Literal & literal) {
     }
 }
 
+FCIterator SemiNaiver::getTableFromEDBLayer(const Literal & literal) {
+    PredId_t id = literal.getPredicate().getId();
+    FCTable *table = predicatesTables[id];
+    if (table == NULL) {
+        table = newEDBTable(literal);
+        predicatesTables[id] = table;
+    }
+    return readEDBTable(table, literal);
+}
+
 FCIterator SemiNaiver::getTable(const Literal & literal,
         const size_t min, const size_t max, TableFilterer *filter) {
+    ProfilePhaseTimer timer(PROFILE_RETRIEVAL);
     //BEGIN -- Get the table that correspond to the current literal
     //std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
     if (literal.getPredicate().getType() == EDB) {
@@ -1778,6 +2307,10 @@ void SemiNaiver::printCountAllIDBs(std::string prefix) {
     }
     LOG(DEBUGL) << prefix << "Predicates without derivation: " << emptyRel;
     LOG(INFOL) << prefix << "Total # derivations: " << c;
+    FCCacheStats cacheStats = cacheManager->getStats();
+    LOG(INFOL) << prefix << "Filter cache: " << cacheStats.hits << " hits, "
+        << cacheStats.misses << " misses, " << cacheStats.evictions
+        << " evictions, " << cacheStats.bytes << " bytes";
 }
 
 std::pair<uint8_t, uint8_t> SemiNaiver::removePosConstants(
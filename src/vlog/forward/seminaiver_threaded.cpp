@@ -3,17 +3,24 @@
 #include <vlog/finalresultjoinproc.h>
 
 #include <vector>
+#include <map>
+#include <algorithm>
 
 bool SemiNaiverThreaded::executeUntilSaturation(
         std::vector<RuleExecutionDetails> &ruleset,
         std::vector<StatIteration> &costRules,
-	uint32_t limitView,
-        bool fixpoint) {
-
-    if (limitView != 0) {
-	LOG(ERRORL) << "limitView not implemented in parallel version;";
-	abort();
+        size_t limitView,
+        bool fixpoint, unsigned long *timeout) {
+
+    if (limitView != 0 || !fixpoint || checkCyclicTerms) {
+        //The restricted chase and the cyclicity checks depend on the order
+        //in which the rules are executed
+        return SemiNaiver::executeUntilSaturation(ruleset, costRules,
+                limitView, fixpoint, timeout);
     }
+    const std::vector<int> order =
+        StatusRuleExecution_ThreadSafe::sortByDependencies(ruleset);
+
     //Create n threads
     std::vector<std::thread> threads(interRuleThreads);
     bool anotherRound;
@@ -22,7 +29,8 @@ bool SemiNaiverThreaded::executeUntilSaturation(
         std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
         //LOG(INFOL) << "Creating threads ...";
         //Create a shared datastructure to record the execution of the rules
-        StatusRuleExecution_ThreadSafe status(ruleset.size());
+        StatusRuleExecution_ThreadSafe status(ruleset, order,
+                program->getNPredicates());
 
         //Execute the rules on multiple threads
         size_t iterationBeginBlock = iteration;
@@ -32,7 +40,8 @@ bool SemiNaiverThreaded::executeUntilSaturation(
                     std::ref(ruleset),
                     &status,
                     &costRules,
-                    iterationBeginBlock);
+                    iterationBeginBlock,
+                    timeout);
         }
 
         //Wait until all threads are finished
@@ -50,10 +59,13 @@ bool SemiNaiverThreaded::executeUntilSaturation(
             }
             newMarked[i] = false;
         }
+        if (timeout != NULL && *timeout == 0) {
+            return newDer;
+        }
 
         //LOG(INFOL) << "Another round = " << anotherRound;
         std::chrono::duration<double> sec2 = std::chrono::system_clock::now() - start;
-        LOG(WARNL) << "--Time round " << sec2.count() * 1000 << " " << iteration;
+        LOG(DEBUGL) << "--Time round " << sec2.count() * 1000 << " " << iteration;
         newDer |= anotherRound;
     } while (anotherRound);
     return newDer;
@@ -146,43 +158,31 @@ void SemiNaiverThreaded::runThread(
         std::vector<RuleExecutionDetails> &ruleset,
         StatusRuleExecution_ThreadSafe *status,
         std::vector<StatIteration> *costRules,
-        size_t lastExec) {
+        size_t lastExec,
+        unsigned long *timeout) {
 
-    int ruleToExecute = status->getRuleIDToExecute();
-    SemiNaiver_Threadlocal *data = new SemiNaiver_Threadlocal();
-    thread_data.reset(data);
+    //Every worker keeps its own state on its stack
+    SemiNaiver_Threadlocal data;
 
     std::vector<ResultJoinProcessor*> res;
 
+    int ruleToExecute = status->getRuleIDToExecute();
     while (ruleToExecute != -1) {
 
-        //Get atomic iteration
-        data->iteration = getAtomicIteration();
-        Literal headLiteral = ruleset[ruleToExecute].rule.getFirstHead();
-        PredId_t idHeadPredicate = headLiteral.getPredicate().getId();
-        std::vector<PredId_t> predicates;
-        predicates.push_back(idHeadPredicate);
-        std::vector<Literal> body = ruleset[ruleToExecute].rule.getBody();
-        for (std::vector<Literal>::const_iterator itr = body.begin(); itr != body.end(); ++itr) {
-            if (itr->getPredicate().getType() == IDB) {
-                predicates.push_back(itr->getPredicate().getId());
-            }
-        }
-        // Sort predicates, to avoid deadlock
-        std::sort(predicates.begin(), predicates.end());
-
-        lock(predicates, idHeadPredicate);
+        //The iteration is taken after the predicates are reserved, so that
+        //all the derivations of the body predicates have a lower iteration
+        data.iteration = getAtomicIteration();
 
         //Execute the rule
         std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
         bool response = executeRule(ruleset[ruleToExecute],
-                data->iteration,
+                data.iteration,
 		0,
                 // &res);
         NULL);
         std::chrono::duration<double> sec = std::chrono::system_clock::now() - start;
         StatIteration stat;
-        stat.iteration = data->iteration;
+        stat.iteration = data.iteration;
         stat.rule = &ruleset[ruleToExecute].rule;
         stat.time = sec.count() * 1000;
         stat.derived = response;
@@ -194,28 +194,32 @@ void SemiNaiverThreaded::runThread(
 
         //Change it to "lastExecution"
         // ruleset[ruleToExecute].lastExecution = lastExec;
-        ruleset[ruleToExecute].lastExecution = data->iteration;
+        ruleset[ruleToExecute].lastExecution = data.iteration;
 
         if (response) {
-            newMarked[idHeadPredicate] = true;
-            marked[idHeadPredicate] = true;
+            mutexInsert.lock();
+            for (const auto &head : ruleset[ruleToExecute].rule.getHeads()) {
+                newMarked[head.getPredicate().getId()] = true;
+                marked[head.getPredicate().getId()] = true;
+            }
+            mutexInsert.unlock();
             if (ruleset[ruleToExecute].rule.isRecursive()) {
                 int recursiveIterations = 0;
                 do {
                     // LOG(INFOL) << "Iteration " << iteration;
-                    data->iteration = getAtomicIteration();
+                    data.iteration = getAtomicIteration();
                     start = std::chrono::system_clock::now();
                     recursiveIterations++;
                     response = executeRule(ruleset[ruleToExecute],
-                            data->iteration,
+                            data.iteration,
 			    0,
                             // &res);
                     NULL);
 
-                    ruleset[ruleToExecute].lastExecution = data->iteration;
+                    ruleset[ruleToExecute].lastExecution = data.iteration;
                     sec = std::chrono::system_clock::now() - start;
                     ++recursiveIterations;
-                    stat.iteration = data->iteration;
+                    stat.iteration = data.iteration;
                     stat.rule = &ruleset[ruleToExecute].rule;
                     stat.time = sec.count() * 1000;
                     stat.derived = response;
@@ -232,7 +236,15 @@ void SemiNaiverThreaded::runThread(
             }
         }
 
-        unlock(predicates, idHeadPredicate);
+        status->releaseRule(ruleToExecute);
+
+        if (timeout != NULL && *timeout != 0) {
+            std::chrono::duration<double> s = std::chrono::system_clock::now() - startTime;
+            if (s.count() > *timeout) {
+                *timeout = 0;   // To indicate materialization was stopped because of timeout.
+                status->stop();
+            }
+        }
 
         ruleToExecute = status->getRuleIDToExecute();
     }
@@ -259,109 +271,213 @@ void SemiNaiverThreaded::saveStatistics(StatsRule &stats) {
     SemiNaiver::saveStatistics(stats);
 }
 
-StatusRuleExecution_ThreadSafe::StatusRuleExecution_ThreadSafe(const int nrules)
-    : rulecount(0), nrules(nrules) {
+void SemiNaiverThreaded::registerDerivation(const FCBlock &block) {
+    std::lock_guard<std::mutex> lock(mutexListDer);
+    SemiNaiver::registerDerivation(block);
+}
+
+StatusRuleExecution_ThreadSafe::StatusRuleExecution_ThreadSafe(
+        const std::vector<RuleExecutionDetails> &ruleset,
+        const std::vector<int> &order,
+        const size_t npredicates)
+    : pending(order.begin(), order.end()), readers(npredicates, 0),
+    writing(npredicates, false), running(0), stopped(false) {
+        for (const auto &details : ruleset) {
+            std::vector<PredId_t> heads;
+            for (const auto &head : details.rule.getHeads()) {
+                heads.push_back(head.getPredicate().getId());
+            }
+            std::sort(heads.begin(), heads.end());
+            heads.erase(std::unique(heads.begin(), heads.end()), heads.end());
+
+            //A body predicate that is also in the head is reserved only as
+            //a writer
+            std::vector<PredId_t> body;
+            for (const auto &literal : details.rule.getBody()) {
+                PredId_t p = literal.getPredicate().getId();
+                if (!std::binary_search(heads.begin(), heads.end(), p)) {
+                    body.push_back(p);
+                }
+            }
+            std::sort(body.begin(), body.end());
+            body.erase(std::unique(body.begin(), body.end()), body.end());
+
+            writes.push_back(heads);
+            reads.push_back(body);
+        }
     }
 
+bool StatusRuleExecution_ThreadSafe::canReserve(const int ruleid) const {
+    for (auto p : writes[ruleid]) {
+        if (writing[p] || readers[p] > 0) {
+            return false;
+        }
+    }
+    for (auto p : reads[ruleid]) {
+        if (writing[p]) {
+            return false;
+        }
+    }
+    return true;
+}
 
 int StatusRuleExecution_ThreadSafe::getRuleIDToExecute() {
     //Return -1 if no rule is available. Otherwise return the ID of the rule to
     //execute.
-    std::lock_guard<std::mutex> lock(mutexRules);
-    if (rulecount == nrules) {
-        return -1;
+    std::unique_lock<std::mutex> lock(mutexRules);
+    while (!stopped && !pending.empty()) {
+        for (auto itr = pending.begin(); itr != pending.end(); ++itr) {
+            if (canReserve(*itr)) {
+                const int ruleid = *itr;
+                for (auto p : writes[ruleid]) {
+                    writing[p] = true;
+                }
+                for (auto p : reads[ruleid]) {
+                    readers[p]++;
+                }
+                pending.erase(itr);
+                running++;
+                LOG(DEBUGL) << "Got rule " << ruleid;
+                return ruleid;
+            }
+        }
+        //All the remaining rules conflict with the ones being executed
+        ruleReleased.wait(lock);
     }
-    LOG(DEBUGL) << "Got rule " << rulecount;
-    return rulecount++;
+    return -1;
 }
 
-void StatusRuleExecution_ThreadSafe::registerDerivations(
-        ResultJoinProcessor *res) {
+void StatusRuleExecution_ThreadSafe::releaseRule(const int ruleid) {
     std::lock_guard<std::mutex> lock(mutexRules);
-    tmpderivations.push_back(res);
+    for (auto p : writes[ruleid]) {
+        writing[p] = false;
+    }
+    for (auto p : reads[ruleid]) {
+        readers[p]--;
+    }
+    running--;
+    ruleReleased.notify_all();
 }
 
-FCTable *SemiNaiverThreaded::getTable(const PredId_t pred, const uint8_t card) {
-    if (predicatesTables[pred] == NULL) {
-        std::lock_guard<std::mutex> lock(mutexGetTable);
-        return SemiNaiver::getTable(pred, card);
-    }
-    return predicatesTables[pred];
+void StatusRuleExecution_ThreadSafe::stop() {
+    std::lock_guard<std::mutex> lock(mutexRules);
+    stopped = true;
+    ruleReleased.notify_all();
 }
 
-FCIterator SemiNaiverThreaded::getTableFromEDBLayer(const Literal &literal) {
-    PredId_t id = literal.getPredicate().getId();
-    FCTable *table = predicatesTables[id];
-    if (table == NULL) {
-        std::lock_guard<std::mutex> lock(mutexGetTable);
-        return SemiNaiver::getTableFromEDBLayer(literal);
+std::vector<int> StatusRuleExecution_ThreadSafe::sortByDependencies(
+        const std::vector<RuleExecutionDetails> &ruleset) {
+    //Rule i -> rule j if i derives a predicate in the body of j (as in
+    //SemiNaiver::createGraphRuleDependency)
+    const int n = ruleset.size();
+    std::map<PredId_t, std::vector<int>> definedBy;
+    for (int i = 0; i < n; ++i) {
+        for (const auto &head : ruleset[i].rule.getHeads()) {
+            definedBy[head.getPredicate().getId()].push_back(i);
+        }
+    }
+    std::vector<std::vector<int>> edges(n);
+    for (int j = 0; j < n; ++j) {
+        for (const auto &literal : ruleset[j].rule.getBody()) {
+            auto itr = definedBy.find(literal.getPredicate().getId());
+            if (literal.getPredicate().getType() == IDB && itr != definedBy.end()) {
+                for (auto i : itr->second) {
+                    edges[i].push_back(j);
+                }
+            }
+        }
     }
-    return SemiNaiver::getTableFromEDBLayer(literal);
-}
 
-bool SemiNaiverThreaded::tryLock(std::vector<PredId_t> &predicates, PredId_t idHeadPredicate) {
-    PredId_t prev = (PredId_t) - 1;
-    LOG(DEBUGL) << "Getting locks ...";
-    for (std::vector<PredId_t>::const_iterator itr = predicates.begin(); itr != predicates.end(); ++itr) {
-        if (*itr != prev) {
-            LOG(DEBUGL) << "Getting lock " << *itr;
-            bool gotlock;
-            if (*itr == idHeadPredicate) {
-                gotlock = mutexes[*itr].try_lock();
-            } else {
-                gotlock = mutexes[*itr].try_lock(); //Previously it was a shared lock
+    //Strongly connected components (Tarjan, iterative). They are found in
+    //reverse topological order
+    std::vector<int> index(n, -1), lowlink(n, 0), component(n, -1);
+    std::vector<bool> onStack(n, false);
+    std::vector<int> stack;
+    std::vector<std::pair<int, size_t>> callStack;
+    int counter = 0, ncomponents = 0;
+    for (int root = 0; root < n; ++root) {
+        if (index[root] != -1) {
+            continue;
+        }
+        callStack.push_back(std::make_pair(root, 0));
+        while (!callStack.empty()) {
+            const int v = callStack.back().first;
+            size_t &next = callStack.back().second;
+            if (next == 0 && index[v] == -1) {
+                index[v] = lowlink[v] = counter++;
+                stack.push_back(v);
+                onStack[v] = true;
             }
-            if (! gotlock) {
-                prev = (PredId_t) -1;
-                for (std::vector<PredId_t>::const_iterator itr1 = predicates.begin(); itr1 != itr; ++itr1) {
-                    if (*itr1 != prev) {
-                        if (*itr1 == idHeadPredicate) {
-                            mutexes[*itr1].unlock();
-                        } else {
-                            mutexes[*itr1].unlock(); //Previously it was a shared lock
-                        }
-                    }
+            if (next < edges[v].size()) {
+                const int w = edges[v][next++];
+                if (index[w] == -1) {
+                    callStack.push_back(std::make_pair(w, 0));
+                } else if (onStack[w]) {
+                    lowlink[v] = std::min(lowlink[v], index[w]);
                 }
-                return false;
+                continue;
+            }
+            if (lowlink[v] == index[v]) {
+                int w;
+                do {
+                    w = stack.back();
+                    stack.pop_back();
+                    onStack[w] = false;
+                    component[w] = ncomponents;
+                } while (w != v);
+                ncomponents++;
+            }
+            callStack.pop_back();
+            if (!callStack.empty()) {
+                const int parent = callStack.back().first;
+                lowlink[parent] = std::min(lowlink[parent], lowlink[v]);
             }
         }
-        prev = *itr;
     }
-    LOG(DEBUGL) << "Got locks!";
-    return true;
+
+    std::vector<int> order(n);
+    for (int i = 0; i < n; ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [&component](int a, int b) {
+            return component[a] > component[b];
+            });
+    return order;
 }
 
-void SemiNaiverThreaded::lock(std::vector<PredId_t> &predicates, PredId_t idHeadPredicate) {
+void StatusRuleExecution_ThreadSafe::registerDerivations(
+        ResultJoinProcessor *res) {
+    std::lock_guard<std::mutex> lock(mutexRules);
+    tmpderivations.push_back(res);
+}
 
-    PredId_t prev = (PredId_t) - 1;
-    LOG(DEBUGL) << "Getting locks ...";
-    for (std::vector<PredId_t>::const_iterator itr = predicates.begin(); itr != predicates.end(); ++itr) {
-        if (*itr != prev) {
-            LOG(DEBUGL) << "Getting lock " << *itr;
-            if (*itr == idHeadPredicate) {
-                mutexes[*itr].lock();
-            } else {
-                mutexes[*itr].lock(); //Previously it was a shared lock
-            }
-        }
-        prev = *itr;
-    }
-    LOG(DEBUGL) << "Got locks!";
+//predicatesTables holds plain pointers, so the lookup is always done under
+//mutexGetTable. A table is stored only once it is complete: another thread
+//never sees an EDB table before its content is added.
+FCTable *SemiNaiverThreaded::getTable(const PredId_t pred, const int card) {
+    std::lock_guard<std::mutex> lock(mutexGetTable);
+    return SemiNaiver::getTable(pred, card);
 }
 
-void SemiNaiverThreaded::unlock(std::vector<PredId_t> &predicates, PredId_t idHeadPredicate) {
-    PredId_t prev = (PredId_t) - 1;
-    LOG(DEBUGL) << "Releasing locks ...";
-    for (std::vector<PredId_t>::const_iterator itr = predicates.begin(); itr != predicates.end(); ++itr) {
-        if (*itr != prev) {
-            LOG(DEBUGL) << "Releasing lock " << *itr;
-            if (*itr == idHeadPredicate) {
-                mutexes[*itr].unlock();
-            } else {
-                mutexes[*itr].unlock(); //Previously it was a shared lock
-            }
+FCIterator SemiNaiverThreaded::getTableFromEDBLayer(const Literal &literal) {
+    PredId_t id = literal.getPredicate().getId();
+    FCTable *table;
+    {
+        std::lock_guard<std::mutex> lock(mutexGetTable);
+        table = predicatesTables[id];
+    }
+    if (table == NULL) {
+        //Fill the table outside the lock, then check again before storing
+        //it: another thread may have stored its own copy in the meantime
+        FCTable *newtable = newEDBTable(literal);
+        std::lock_guard<std::mutex> lock(mutexGetTable);
+        table = predicatesTables[id];
+        if (table == NULL) {
+            predicatesTables[id] = newtable;
+            table = newtable;
+        } else {
+            delete newtable;
         }
-        prev = *itr;
     }
-    LOG(DEBUGL) << "Released locks!";
+    return readEDBTable(table, literal);
 }
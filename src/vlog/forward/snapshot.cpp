@@ -0,0 +1,328 @@
+#include <vlog/seminaiver.h>
+#include <vlog/fctable.h>
+#include <vlog/fcinttable.h>
+#include <vlog/column.h>
+#include <vlog/hash.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <cstring>
+#include <map>
+
+/*
+ * A snapshot is a directory with two files:
+ * - snapshot.data contains the columns of all the blocks of the IDB tables,
+ *   one after the other, as arrays of Term_t. The file is memory-mapped when
+ *   the snapshot is loaded, so the columns are not read in main memory
+ *   until they are used.
+ * - snapshot.meta describes the content of snapshot.data: for every IDB
+ *   predicate (identified by name) the list of its blocks, with their
+ *   iteration, the rule that derived them and the position of their columns.
+ *   Constant columns are stored only in the meta file. The meta file also
+ *   contains a hash of the rules and one of the EDB: the columns contain the
+ *   IDs of the dictionary, so they are meaningless for another database.
+ */
+#define SNAPSHOT_MAGIC "VLOGSNAP"
+#define SNAPSHOT_VERSION 2
+
+#define SNAPSHOT_COL_DATA 0
+#define SNAPSHOT_COL_CONSTANT 1
+
+template<typename T>
+static void writeValue(std::ostream &out, const T v) {
+    out.write((const char *) &v, sizeof(T));
+}
+
+template<typename T>
+static T readValue(std::istream &in) {
+    T v;
+    in.read((char *) &v, sizeof(T));
+    if (!in.good()) {
+        LOG(ERRORL) << "The snapshot is truncated";
+        throw 10;
+    }
+    return v;
+}
+
+static void writeString(std::ostream &out, const std::string &s) {
+    writeValue<uint32_t>(out, s.size());
+    out.write(s.c_str(), s.size());
+}
+
+static std::string readString(std::istream &in) {
+    const uint32_t len = readValue<uint32_t>(in);
+    std::string s(len, '\0');
+    in.read(&s[0], len);
+    if (!in.good()) {
+        LOG(ERRORL) << "The snapshot is truncated";
+        throw 10;
+    }
+    return s;
+}
+
+//The snapshot can only be loaded with the same rules. The hash is stable
+//across executions, unlike std::hash
+static uint64_t getProgramHash(Program *program, EDBLayer &layer) {
+    uint64_t h = FNV_OFFSET;
+    for (auto &rule : program->getAllRules()) {
+        const std::string s = rule.tostring(program, &layer);
+        h = VLogHash::fnvString(s.c_str(), s.size(), h);
+    }
+    return h;
+}
+
+//The rows of every EDB predicate are hashed one by one and summed, so that
+//the hash does not depend on the order in which the EDB layer returns them
+static uint64_t getEDBHash(EDBLayer &layer) {
+    std::map<std::string, PredId_t> preds;
+    for (const PredId_t id : layer.getAllPredicateIDs()) {
+        preds.insert(std::make_pair(layer.getPredName(id), id));
+    }
+    uint64_t h = FNV_OFFSET;
+    for (auto &p : preds) {
+        h = VLogHash::fnvString(p.first.c_str(), p.first.size(), h);
+        const uint8_t arity = layer.getPredArity(p.second);
+        h = VLogHash::fnv(h, arity);
+        if (arity == 0) {
+            continue;
+        }
+        VTuple t(arity);
+        for (uint8_t i = 0; i < arity; ++i) {
+            t.set(VTerm(i + 1, 0), i);
+        }
+        Literal query(layer.getDBPredicate(p.second), t);
+        EDBIterator *itr = layer.getIterator(query);
+        uint64_t rows = 0;
+        uint64_t sum = 0;
+        while (itr->hasNext()) {
+            itr->next();
+            uint64_t r = FNV_OFFSET;
+            for (uint8_t i = 0; i < arity; ++i) {
+                r = VLogHash::fnv(r, itr->getElementAt(i));
+            }
+            sum += r;
+            rows++;
+        }
+        layer.releaseIterator(itr);
+        h = VLogHash::fnv(h, rows);
+        h = VLogHash::fnv(h, sum);
+    }
+    return h;
+}
+
+//The IDs of the nulls are assigned by the ChaseMgmt, which is created again
+//at every run and is not part of the snapshot. A materialization continued
+//from a snapshot would then reuse the IDs of the nulls already in it.
+static void checkNoExistentialRules(Program *program) {
+    if (program->areExistentialRules()) {
+        LOG(ERRORL) << "Snapshots are not supported with existential rules";
+        throw 10;
+    }
+}
+
+void SemiNaiver::storeSnapshot(std::string path) {
+    checkNoExistentialRules(program);
+    Utils::create_directories(path);
+    std::ofstream meta(path + "/snapshot.meta", std::ios_base::binary);
+    std::ofstream data(path + "/snapshot.data", std::ios_base::binary);
+    if (!meta.good() || !data.good()) {
+        LOG(ERRORL) << "Cannot create the snapshot in " << path;
+        throw 10;
+    }
+
+    meta.write(SNAPSHOT_MAGIC, strlen(SNAPSHOT_MAGIC));
+    writeValue<uint32_t>(meta, SNAPSHOT_VERSION);
+    writeValue<uint64_t>(meta, getProgramHash(program, layer));
+    writeValue<uint64_t>(meta, getEDBHash(layer));
+    writeValue<uint32_t>(meta, typeChase);
+    writeValue<uint64_t>(meta, iteration);
+
+    std::vector<PredId_t> preds;
+    for (PredId_t i = 0; i < predicatesTables.size(); ++i) {
+        FCTable *table = predicatesTables[i];
+        if (table != NULL && !table->isEmpty() &&
+                program->getPredicate(i).getType() == IDB) {
+            preds.push_back(i);
+        }
+    }
+    writeValue<uint64_t>(meta, preds.size());
+
+    std::unique_ptr<Term_t[]> buffer(new Term_t[COLUMN_BATCH_SIZE]);
+    uint64_t offset = 0;
+    uint64_t nrowsTotal = 0;
+    for (const PredId_t pred : preds) {
+        FCTable *table = predicatesTables[pred];
+        writeString(meta, program->getPredicateName(pred));
+        writeValue<uint8_t>(meta, table->getSizeRow());
+        FCIterator itr = table->read(0);
+        writeValue<uint64_t>(meta, itr.getNTables());
+        while (!itr.isEmpty()) {
+            const FCBlock *block = itr.getCurrentBlock();
+            std::shared_ptr<const FCInternalTable> t = block->table;
+            const uint64_t nrows = t->getNRows();
+            writeValue<uint64_t>(meta, block->iteration);
+            writeValue<int64_t>(meta, block->rule != NULL ?
+                    (int64_t) block->rule->ruleid : -1);
+            writeValue<uint32_t>(meta, block->posQueryInRule);
+            writeValue<uint32_t>(meta, block->ruleExecOrder);
+            writeValue<uint8_t>(meta, block->isCompleted);
+            writeValue<uint8_t>(meta, t->isSorted());
+            writeValue<uint64_t>(meta, nrows);
+
+            const VTuple query = block->query.getTuple();
+            writeValue<uint8_t>(meta, query.getSize());
+            for (int i = 0; i < query.getSize(); ++i) {
+                writeValue<uint32_t>(meta, query.get(i).getId());
+                writeValue<uint64_t>(meta, query.get(i).getValue());
+            }
+
+            for (uint8_t i = 0; i < t->getRowSize(); ++i) {
+                std::shared_ptr<Column> col = t->getColumn(i);
+                if (nrows > 0 && nrows <= UINT32_MAX && col->isConstant()) {
+                    writeValue<uint8_t>(meta, SNAPSHOT_COL_CONSTANT);
+                    writeValue<uint64_t>(meta, col->first());
+                    continue;
+                }
+                writeValue<uint8_t>(meta, SNAPSHOT_COL_DATA);
+                writeValue<uint64_t>(meta, offset);
+                std::unique_ptr<ColumnReader> reader = col->getReader();
+                size_t n;
+                while ((n = reader->nextBatch(buffer.get(), COLUMN_BATCH_SIZE)) > 0) {
+                    data.write((const char *) buffer.get(), n * sizeof(Term_t));
+                    offset += n * sizeof(Term_t);
+                }
+            }
+            nrowsTotal += nrows;
+            itr.moveNextCount();
+        }
+    }
+
+    meta.close();
+    data.close();
+    if (meta.fail() || data.fail()) {
+        LOG(ERRORL) << "Failed writing the snapshot in " << path;
+        throw 10;
+    }
+    LOG(INFOL) << "Stored a snapshot of " << preds.size() << " predicates ("
+        << nrowsTotal << " rows, " << offset / (1024 * 1024)
+        << " MB of columns) in " << path;
+}
+
+void SemiNaiver::loadSnapshot(std::string path) {
+    checkNoExistentialRules(program);
+    std::ifstream meta(path + "/snapshot.meta", std::ios_base::binary);
+    if (!meta.good()) {
+        LOG(ERRORL) << "Cannot open the snapshot in " << path;
+        throw 10;
+    }
+    char magic[sizeof(SNAPSHOT_MAGIC)];
+    meta.read(magic, strlen(SNAPSHOT_MAGIC));
+    if (!meta.good() || strncmp(magic, SNAPSHOT_MAGIC, strlen(SNAPSHOT_MAGIC)) != 0
+            || readValue<uint32_t>(meta) != SNAPSHOT_VERSION) {
+        LOG(ERRORL) << "The file " << path << "/snapshot.meta is not a snapshot"
+            " or was created by another version";
+        throw 10;
+    }
+    if (readValue<uint64_t>(meta) != getProgramHash(program, layer)) {
+        LOG(ERRORL) << "The snapshot in " << path << " was created with different rules";
+        throw 10;
+    }
+    if (readValue<uint64_t>(meta) != getEDBHash(layer)) {
+        LOG(ERRORL) << "The snapshot in " << path << " was created from a different EDB";
+        throw 10;
+    }
+    if (readValue<uint32_t>(meta) != typeChase) {
+        LOG(WARNL) << "The snapshot in " << path << " was created with another type of chase";
+    }
+    const uint64_t lastIteration = readValue<uint64_t>(meta);
+
+    //The old tables are replaced
+    for (PredId_t i = 0; i < predicatesTables.size(); ++i) {
+        if (predicatesTables[i] != NULL &&
+                program->getPredicate(i).getType() == IDB) {
+            delete predicatesTables[i];
+            predicatesTables[i] = NULL;
+        }
+    }
+
+    std::map<uint64_t, const RuleExecutionDetails*> rules;
+    for (auto &strata : allIDBRules) {
+        for (auto &r : strata) {
+            rules[r.ruleid] = &r;
+        }
+    }
+    for (auto &r : allEDBRules) {
+        rules[r.ruleid] = &r;
+    }
+
+    std::shared_ptr<MappedFile> data(new MappedFile(path + "/snapshot.data",
+                false));
+    const uint64_t npreds = readValue<uint64_t>(meta);
+    uint64_t nrowsTotal = 0;
+    for (uint64_t p = 0; p < npreds; ++p) {
+        std::string name = readString(meta);
+        const uint8_t card = readValue<uint8_t>(meta);
+        Predicate pred = program->getPredicate(name);
+        if (pred.getType() != IDB || pred.getCardinality() != card) {
+            LOG(ERRORL) << "The predicate " << name << " in the snapshot does"
+                " not match the rules";
+            throw 10;
+        }
+        FCTable *table = getTable(pred.getId(), card);
+        const uint64_t nblocks = readValue<uint64_t>(meta);
+        for (uint64_t b = 0; b < nblocks; ++b) {
+            const size_t it = readValue<uint64_t>(meta);
+            const int64_t ruleid = readValue<int64_t>(meta);
+            const uint32_t posQueryInRule = readValue<uint32_t>(meta);
+            const uint32_t ruleExecOrder = readValue<uint32_t>(meta);
+            const bool isCompleted = readValue<uint8_t>(meta);
+            const bool sorted = readValue<uint8_t>(meta);
+            const uint64_t nrows = readValue<uint64_t>(meta);
+
+            const uint8_t sizeQuery = readValue<uint8_t>(meta);
+            VTuple query(sizeQuery);
+            for (uint8_t i = 0; i < sizeQuery; ++i) {
+                const Var_t id = readValue<uint32_t>(meta);
+                query.set(VTerm(id, readValue<uint64_t>(meta)), i);
+            }
+
+            std::vector<std::shared_ptr<Column>> columns;
+            for (uint8_t i = 0; i < card; ++i) {
+                const uint8_t type = readValue<uint8_t>(meta);
+                const uint64_t value = readValue<uint64_t>(meta);
+                if (type == SNAPSHOT_COL_CONSTANT) {
+                    columns.push_back(std::shared_ptr<Column>(
+                                new CompressedColumn(value, nrows)));
+                } else {
+                    if (value + nrows * sizeof(Term_t) > data->getLength()) {
+                        LOG(ERRORL) << "The file " << path << "/snapshot.data is truncated";
+                        throw 10;
+                    }
+                    columns.push_back(std::shared_ptr<Column>(
+                                new MmapColumn(data, value, nrows)));
+                }
+            }
+
+            const RuleExecutionDetails *rule = NULL;
+            if (ruleid >= 0) {
+                auto r = rules.find(ruleid);
+                if (r == rules.end()) {
+                    LOG(ERRORL) << "Rule " << ruleid << " in the snapshot does not exist";
+                    throw 10;
+                }
+                rule = r->second;
+            }
+            std::shared_ptr<const Segment> seg(new Segment(card, columns));
+            std::shared_ptr<const FCInternalTable> t(
+                    new InmemoryFCInternalTable(card, it, sorted, seg));
+            table->addBlock(FCBlock(it, t, Literal(pred, query),
+                        posQueryInRule, rule, ruleExecOrder, isCompleted));
+            nrowsTotal += nrows;
+        }
+    }
+    iteration = lastIteration;
+    LOG(INFOL) << "Loaded a snapshot of " << npreds << " predicates ("
+        << nrowsTotal << " rows) from " << path;
+}
@@ -0,0 +1,154 @@
+#include <vlog/spill.h>
+
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <cstdlib>
+#include <algorithm>
+
+#if defined(_WIN32)
+#include <process.h>
+#define getpid _getpid
+#else
+#include <unistd.h>
+#endif
+
+SegmentSpiller::SegmentSpiller(const uint64_t budget, std::string spillDir) :
+    budget(budget), spillDir(spillDir), inMemoryBytes(0), spilledBytes(0),
+    nFiles(0) {
+        if (this->spillDir.empty()) {
+            const char *tmp = std::getenv("TMPDIR");
+            this->spillDir = tmp != NULL ? tmp : "/tmp";
+        }
+        LOG(INFOL) << "Derived tables larger than " << budget / (1024 * 1024)
+            << " MB will be spilled to " << this->spillDir;
+    }
+
+uint64_t SegmentSpiller::getMemorySize(const Segment &seg) {
+    uint64_t bytes = 0;
+    for (int i = 0; i < seg.getNColumns(); ++i) {
+        std::shared_ptr<Column> col = seg.getColumn(i);
+        if (col != NULL && !col->isEDB()) {
+            bytes += col->getRepresentationSize() * sizeof(Term_t);
+        }
+    }
+    return bytes;
+}
+
+std::shared_ptr<const Segment> SegmentSpiller::seal(
+        std::shared_ptr<const Segment> seg) {
+    const uint64_t bytes = getMemorySize(*seg);
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (inMemoryBytes + bytes <= budget) {
+            inMemoryBytes += bytes;
+            return track(seg, bytes);
+        }
+    }
+    return spill(seg);
+}
+
+std::shared_ptr<const Segment> SegmentSpiller::track(
+        std::shared_ptr<const Segment> seg, const uint64_t bytes) {
+    if (bytes == 0) {
+        return seg;
+    }
+    std::shared_ptr<SegmentSpiller> spiller = shared_from_this();
+    return std::shared_ptr<const Segment>(seg.get(),
+            [spiller, seg, bytes](const Segment *) {
+            spiller->release(bytes);
+            });
+}
+
+void SegmentSpiller::release(const uint64_t bytes) {
+    std::lock_guard<std::mutex> lock(mutex);
+    inMemoryBytes -= std::min(bytes, inMemoryBytes);
+}
+
+std::shared_ptr<const Segment> SegmentSpiller::spill(
+        std::shared_ptr<const Segment> seg) {
+    const uint8_t ncols = seg->getNColumns();
+    const size_t nrows = seg->getNRows();
+
+    //Only the columns that are stored uncompressed are worth to be moved
+    //on disk
+    std::vector<bool> toSpill(ncols);
+    bool any = false;
+    for (int i = 0; i < ncols; ++i) {
+        std::shared_ptr<Column> col = seg->getColumn(i);
+        toSpill[i] = col != NULL && !col->isEDB() &&
+            col->getRepresentationSize() * 4 >= col->size() &&
+            col->size() == nrows;
+        any |= toSpill[i];
+    }
+    if (!any) {
+        const uint64_t bytes = getMemorySize(*seg);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            inMemoryBytes += bytes;
+        }
+        return track(seg, bytes);
+    }
+
+    std::string path;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        path = spillDir + "/vlog-spill-" + std::to_string(getpid()) + "-" +
+            std::to_string(nFiles++) + ".bin";
+    }
+
+    //Write the columns sequentially, one after the other
+    std::vector<size_t> offsets(ncols);
+    size_t offset = 0;
+    {
+        std::ofstream out(path, std::ios_base::binary);
+        if (!out.good()) {
+            LOG(ERRORL) << "Cannot create the file " << path;
+            throw 10;
+        }
+        std::unique_ptr<Term_t[]> buffer(new Term_t[COLUMN_BATCH_SIZE]);
+        for (int i = 0; i < ncols; ++i) {
+            if (!toSpill[i]) {
+                continue;
+            }
+            offsets[i] = offset;
+            std::unique_ptr<ColumnReader> reader = seg->getColumn(i)->getReader();
+            size_t n;
+            while ((n = reader->nextBatch(buffer.get(), COLUMN_BATCH_SIZE)) > 0) {
+                out.write((const char *) buffer.get(), n * sizeof(Term_t));
+                offset += n * sizeof(Term_t);
+            }
+        }
+        out.close();
+        if (out.fail()) {
+            LOG(ERRORL) << "Failed writing the file " << path;
+            throw 10;
+        }
+    }
+
+    std::shared_ptr<MappedFile> file(new MappedFile(path, true));
+    std::vector<std::shared_ptr<Column>> columns;
+    uint64_t remainingBytes = 0;
+    for (int i = 0; i < ncols; ++i) {
+        if (toSpill[i]) {
+            columns.push_back(std::shared_ptr<Column>(new MmapColumn(file,
+                            offsets[i], nrows)));
+        } else {
+            std::shared_ptr<Column> col = seg->getColumn(i);
+            columns.push_back(col);
+            if (col != NULL && !col->isEDB()) {
+                remainingBytes += col->getRepresentationSize() * sizeof(Term_t);
+            }
+        }
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        inMemoryBytes += remainingBytes;
+        spilledBytes += offset;
+    }
+    LOG(DEBUGL) << "Spilled " << nrows << " rows (" << offset
+        << " bytes) to " << path;
+    return track(std::shared_ptr<const Segment>(new Segment(ncols, columns)),
+            remainingBytes);
+}
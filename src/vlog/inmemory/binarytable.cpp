@@ -0,0 +1,412 @@
+#include <vlog/inmemory/binarytable.h>
+#include <vlog/edb.h>
+#include <vlog/segment.h>
+
+#include <kognac/utils.h>
+#include <kognac/logs.h>
+
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+
+template<typename T>
+static void writeValue(std::ostream &out, const T v) {
+    out.write((const char *) &v, sizeof(T));
+}
+
+//Checks the header of a mapped file and returns the position after it
+static const uint64_t *checkHeader(const MappedFile &file, const char *magic,
+        const size_t nfields, const std::string &path) {
+    if (file.getLength() < 16 + nfields * 8
+            || memcmp(file.getData(), magic, 8) != 0) {
+        std::string error = "The file " + path + " is not a binary VLog file";
+        LOG(ERRORL) << error;
+        throw error;
+    }
+    const uint64_t *header = (const uint64_t *) (file.getData() + 8);
+    if (header[0] != BINARY_VERSION) {
+        std::string error = "The file " + path + " has an unsupported version";
+        LOG(ERRORL) << error;
+        throw error;
+    }
+    return header + 1;
+}
+
+BinaryDictionary::BinaryDictionary(std::string dir) : dir(dir) {
+    const std::string path = dir + "/dict.bin";
+    if (!Utils::exists(path)) {
+        std::string error = "The dictionary " + path + " does not exist. Check the edb.conf file.";
+        LOG(ERRORL) << error;
+        throw error;
+    }
+    file = std::shared_ptr<MappedFile>(new MappedFile(path, false));
+    const uint64_t *header = checkHeader(*file, BINARY_DICT_MAGIC, 1, path);
+    nterms = header[0];
+    offsets = header + 1;
+    strings = (const char *) (offsets + nterms + 1);
+    if ((const char *) offsets + (nterms + 1) * 8 > file->getData() +
+            file->getLength() || strings + offsets[nterms] >
+            file->getData() + file->getLength()) {
+        std::string error = "The dictionary " + path + " is truncated";
+        LOG(ERRORL) << error;
+        throw error;
+    }
+    LOG(DEBUGL) << "Mapped dictionary " << path << " with " << nterms << " terms";
+}
+
+bool BinaryDictionary::getNumber(const char *text, const size_t len,
+        uint64_t &id) const {
+    //The strings are sorted as std::string
+    uint64_t lo = 0, hi = nterms;
+    while (lo < hi) {
+        const uint64_t mid = lo + (hi - lo) / 2;
+        const size_t l = offsets[mid + 1] - offsets[mid];
+        int cmp = memcmp(strings + offsets[mid], text, std::min(l, len));
+        if (cmp == 0) {
+            cmp = l < len ? -1 : (l > len ? 1 : 0);
+        }
+        if (cmp == 0) {
+            id = mid;
+            return true;
+        } else if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return false;
+}
+
+bool BinaryDictionary::getText(const uint64_t id, const char *&text,
+        size_t &len) const {
+    if (id >= nterms) {
+        return false;
+    }
+    text = strings + offsets[id];
+    len = offsets[id + 1] - offsets[id];
+    return true;
+}
+
+BinaryTable::BinaryTable(std::string path, PredId_t predid,
+        std::shared_ptr<BinaryDictionary> dictionary, EDBLayer *layer) :
+    InmemoryTable(predid, 0, std::shared_ptr<const Segment>(), layer),
+    dictionary(dictionary), nrows(0), nzones(0) {
+        if (!Utils::exists(path)) {
+            std::string error = "The relation " + path + " does not exist. Check the edb.conf file.";
+            LOG(ERRORL) << error;
+            throw error;
+        }
+        file = std::shared_ptr<MappedFile>(new MappedFile(path, false));
+        const uint64_t *header = checkHeader(*file, BINARY_TABLE_MAGIC, 4, path);
+        nrows = header[1];
+        const uint64_t zoneRows = header[2];
+        nzones = header[3];
+        if (header[0] == 0 || header[0] > 255 || zoneRows != BINARY_ZONE_ROWS ||
+                16 + (4 + header[0] * (2 * nzones + nrows)) * 8 > file->getLength()) {
+            std::string error = "The relation " + path + " is malformed";
+            LOG(ERRORL) << error;
+            throw error;
+        }
+        arity = header[0];
+        const Term_t *data = (const Term_t *) (header + 4);
+        for (uint8_t i = 0; i < arity; ++i) {
+            zones.push_back(data);
+            data += 2 * nzones;
+        }
+        std::vector<std::shared_ptr<Column>> cols;
+        for (uint8_t i = 0; i < arity; ++i) {
+            columns.push_back(data);
+            cols.push_back(std::shared_ptr<Column>(new MmapColumn(file,
+                            (const char *) data - file->getData(), nrows)));
+            data += nrows;
+        }
+        //The zones of the file are larger than the blocks of the zone maps,
+        //so every block gets the bounds of the zone that contains it
+        if (nrows >= ZONEMAP_MIN_ROWS) {
+            for (uint8_t i = 0; i < arity; ++i) {
+                std::shared_ptr<ZoneMap> zm(new ZoneMap());
+                const size_t nblocks = (nrows + ZONEMAP_BLOCK_ROWS - 1) /
+                    ZONEMAP_BLOCK_ROWS;
+                for (size_t b = 0; b < nblocks; ++b) {
+                    const size_t z = b * ZONEMAP_BLOCK_ROWS / BINARY_ZONE_ROWS;
+                    zm->mins.push_back(zones[i][2 * z]);
+                    zm->maxs.push_back(zones[i][2 * z + 1]);
+                }
+                zm->min = *std::min_element(zm->mins.begin(), zm->mins.end());
+                zm->max = *std::max_element(zm->maxs.begin(), zm->maxs.end());
+                cols[i]->setZoneMap(zm);
+            }
+        }
+        if (nrows > 0) {
+            segment = std::shared_ptr<const Segment>(new Segment(arity, cols));
+        }
+        LOG(DEBUGL) << "Mapped relation " << path << " with " << nrows << " rows";
+    }
+
+uint64_t BinaryTable::scan(const Literal &q, SegmentInserter *inserter) {
+    std::vector<uint8_t> posConstants;
+    std::vector<Term_t> valueConstants;
+    std::vector<std::pair<uint8_t, uint8_t>> repeatedVars;
+    for (uint8_t i = 0; i < arity; ++i) {
+        const VTerm t = q.getTermAtPos(i);
+        if (!t.isVariable()) {
+            posConstants.push_back(i);
+            valueConstants.push_back(t.getValue());
+            continue;
+        }
+        for (uint8_t j = 0; j < i; ++j) {
+            if (q.getTermAtPos(j).getId() == t.getId()) {
+                repeatedVars.push_back(std::make_pair(i, j));
+                break;
+            }
+        }
+    }
+
+    //The rows are sorted, so the constants in the first columns restrict
+    //the rows to a range
+    uint64_t begin = 0;
+    uint64_t end = nrows;
+    uint8_t prefix = 0;
+    while (prefix < arity && !q.getTermAtPos(prefix).isVariable()) {
+        const Term_t v = q.getTermAtPos(prefix).getValue();
+        const Term_t *col = columns[prefix];
+        begin = std::lower_bound(col + begin, col + end, v) - col;
+        end = std::upper_bound(col + begin, col + end, v) - col;
+        prefix++;
+    }
+
+    uint64_t count = 0;
+    Term_t row[256];
+    for (uint64_t z = begin / BINARY_ZONE_ROWS; z * BINARY_ZONE_ROWS < end;
+            ++z) {
+        bool skip = false;
+        for (size_t c = 0; c < posConstants.size() && !skip; ++c) {
+            const Term_t *zone = zones[posConstants[c]] + 2 * z;
+            skip = valueConstants[c] < zone[0] || valueConstants[c] > zone[1];
+        }
+        if (skip) {
+            continue;
+        }
+        const uint64_t s = std::max(begin, z * BINARY_ZONE_ROWS);
+        const uint64_t e = std::min(end, (z + 1) * BINARY_ZONE_ROWS);
+        for (uint64_t r = s; r < e; ++r) {
+            bool match = true;
+            for (size_t c = 0; c < posConstants.size() && match; ++c) {
+                match = columns[posConstants[c]][r] == valueConstants[c];
+            }
+            for (size_t c = 0; c < repeatedVars.size() && match; ++c) {
+                match = columns[repeatedVars[c].first][r] ==
+                    columns[repeatedVars[c].second][r];
+            }
+            if (match) {
+                count++;
+                if (inserter) {
+                    for (uint8_t i = 0; i < arity; ++i) {
+                        row[i] = columns[i][r];
+                    }
+                    inserter->addRow(row);
+                }
+            }
+        }
+    }
+    return count;
+}
+
+size_t BinaryTable::getCardinality(const Literal &q) {
+    if (q.getTupleSize() != arity) {
+        return 0;
+    }
+    if (q.getNUniqueVars() == q.getTupleSize()) {
+        return nrows;
+    }
+    return scan(q, NULL);
+}
+
+EDBIterator *BinaryTable::getIterator(const Literal &q) {
+    if (q.getTupleSize() != arity || q.getNUniqueVars() == q.getTupleSize()) {
+        return InmemoryTable::getIterator(q);
+    }
+    //The rows are added in the order of the file, so they are sorted by the
+    //variables
+    SegmentInserter inserter(arity);
+    scan(q, &inserter);
+    std::shared_ptr<const Segment> filtered;
+    if (!inserter.isEmpty()) {
+        filtered = inserter.getSegment();
+    }
+    std::vector<uint8_t> sortFields;
+    for (uint8_t i = 0; i < arity; ++i) {
+        if (q.getTermAtPos(i).isVariable()) {
+            sortFields.push_back(i);
+            break;
+        }
+    }
+    return new InmemoryIterator(filtered, predid, sortFields);
+}
+
+bool BinaryTable::getDictNumber(const char *text, const size_t sizeText,
+        uint64_t &id) {
+    return dictionary->getNumber(text, sizeText, id);
+}
+
+bool BinaryTable::getDictText(const uint64_t id, char *text) {
+    const char *t;
+    size_t len;
+    if (dictionary->getText(id, t, len)) {
+        memcpy(text, t, len);
+        text[len] = '\0';
+        return true;
+    }
+    return false;
+}
+
+bool BinaryTable::getDictText(const uint64_t id, std::string &text) {
+    const char *t;
+    size_t len;
+    if (dictionary->getText(id, t, len)) {
+        text = std::string(t, len);
+        return true;
+    }
+    return false;
+}
+
+uint64_t BinaryTable::getNTerms() {
+    return dictionary->getNTerms();
+}
+
+void BinaryTable::convert(EDBLayer &layer, std::string dir) {
+    Utils::create_directories(dir);
+
+    //Read all the relations and collect their terms
+    std::vector<PredId_t> preds;
+    std::vector<std::vector<Term_t>> rows;
+    std::vector<Term_t> terms;
+    for (const PredId_t id : layer.getAllPredicateIDs()) {
+        const uint8_t arity = layer.getPredArity(id);
+        if (arity == 0) {
+            LOG(WARNL) << "Skipping " << layer.getPredName(id) << ": arity 0";
+            continue;
+        }
+        VTuple t(arity);
+        for (uint8_t i = 0; i < arity; ++i) {
+            t.set(VTerm(i + 1, 0), i);
+        }
+        Literal query(layer.getDBPredicate(id), t);
+        std::vector<Term_t> r;
+        EDBIterator *itr = layer.getIterator(query);
+        while (itr->hasNext()) {
+            itr->next();
+            for (uint8_t i = 0; i < arity; ++i) {
+                r.push_back(itr->getElementAt(i));
+            }
+        }
+        layer.releaseIterator(itr);
+        terms.insert(terms.end(), r.begin(), r.end());
+        preds.push_back(id);
+        rows.push_back(std::move(r));
+        LOG(INFOL) << "Read " << rows.back().size() / arity << " rows of "
+            << layer.getPredName(id);
+    }
+
+    std::sort(terms.begin(), terms.end());
+    terms.erase(std::unique(terms.begin(), terms.end()), terms.end());
+
+    //The new IDs are the positions of the terms sorted by their text
+    std::vector<std::string> texts(terms.size());
+    for (size_t i = 0; i < terms.size(); ++i) {
+        texts[i] = layer.getDictText(terms[i]);
+    }
+    std::vector<size_t> order(terms.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&texts](size_t a, size_t b) {
+            return texts[a] < texts[b];
+            });
+    std::vector<Term_t> newIDs(terms.size());
+    std::vector<uint64_t> offsets(1, 0);
+    for (size_t i = 0; i < order.size(); ++i) {
+        //Different IDs with the same text get the same new ID
+        if (i == 0 || texts[order[i]] != texts[order[i - 1]]) {
+            offsets.push_back(offsets.back() + texts[order[i]].size());
+        }
+        newIDs[order[i]] = offsets.size() - 2;
+    }
+
+    std::ofstream dict(dir + "/dict.bin", std::ios_base::binary);
+    dict.write(BINARY_DICT_MAGIC, 8);
+    writeValue<uint64_t>(dict, BINARY_VERSION);
+    writeValue<uint64_t>(dict, offsets.size() - 1);
+    dict.write((const char *) offsets.data(), offsets.size() * 8);
+    for (size_t i = 0; i < order.size(); ++i) {
+        if (i == 0 || texts[order[i]] != texts[order[i - 1]]) {
+            dict.write(texts[order[i]].c_str(), texts[order[i]].size());
+        }
+    }
+    dict.close();
+    if (!dict.good()) {
+        LOG(ERRORL) << "Cannot write the dictionary in " << dir;
+        throw 10;
+    }
+    LOG(INFOL) << "Written " << offsets.size() - 1 << " terms";
+
+    std::ofstream conf(dir + "/edb.conf");
+    for (size_t p = 0; p < preds.size(); ++p) {
+        const uint8_t arity = layer.getPredArity(preds[p]);
+        SegmentInserter inserter(arity);
+        Term_t row[256];
+        const std::vector<Term_t> &r = rows[p];
+        for (size_t i = 0; i < r.size(); i += arity) {
+            for (uint8_t j = 0; j < arity; ++j) {
+                row[j] = newIDs[std::lower_bound(terms.begin(), terms.end(),
+                        r[i + j]) - terms.begin()];
+            }
+            inserter.addRow(row);
+        }
+        std::vector<Term_t>().swap(rows[p]);
+        std::vector<std::vector<Term_t>> cols(arity);
+        uint64_t nrows = 0;
+        if (!inserter.isEmpty()) {
+            std::shared_ptr<const Segment> segment =
+                inserter.getSortedAndUniqueSegment();
+            nrows = segment->getNRows();
+            for (uint8_t j = 0; j < arity; ++j) {
+                cols[j] = segment->getColumn(j)->getReader()->asVector();
+            }
+        }
+        const uint64_t nzones = (nrows + BINARY_ZONE_ROWS - 1) / BINARY_ZONE_ROWS;
+        const std::string name = "r" + std::to_string(p);
+        std::ofstream out(dir + "/" + name + ".bin", std::ios_base::binary);
+        out.write(BINARY_TABLE_MAGIC, 8);
+        writeValue<uint64_t>(out, BINARY_VERSION);
+        writeValue<uint64_t>(out, arity);
+        writeValue<uint64_t>(out, nrows);
+        writeValue<uint64_t>(out, BINARY_ZONE_ROWS);
+        writeValue<uint64_t>(out, nzones);
+        for (uint8_t j = 0; j < arity; ++j) {
+            for (uint64_t z = 0; z < nzones; ++z) {
+                const auto b = cols[j].begin() + z * BINARY_ZONE_ROWS;
+                const auto e = cols[j].begin() + std::min(nrows,
+                        (z + 1) * BINARY_ZONE_ROWS);
+                const auto minmax = std::minmax_element(b, e);
+                writeValue<Term_t>(out, *minmax.first);
+                writeValue<Term_t>(out, *minmax.second);
+            }
+        }
+        for (uint8_t j = 0; j < arity; ++j) {
+            out.write((const char *) cols[j].data(), nrows * sizeof(Term_t));
+        }
+        out.close();
+        if (!out.good()) {
+            LOG(ERRORL) << "Cannot write the relation " << name << " in " << dir;
+            throw 10;
+        }
+
+        conf << "EDB" << p << "_predname=" << layer.getPredName(preds[p]) << std::endl;
+        conf << "EDB" << p << "_type=Binary" << std::endl;
+        conf << "EDB" << p << "_param0=" << dir << std::endl;
+        conf << "EDB" << p << "_param1=" << name << std::endl;
+        LOG(INFOL) << "Written " << nrows << " rows of "
+            << layer.getPredName(preds[p]);
+    }
+}
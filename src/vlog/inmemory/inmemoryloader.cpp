@@ -0,0 +1,412 @@
+#include <vlog/inmemory/inmemoryloader.h>
+#include <vlog/edb.h>
+#include <vlog/hash.h>
+
+#include <kognac/utils.h>
+#include <kognac/filereader.h>
+#include <kognac/logs.h>
+
+#include <trident/utils/parallel.h>
+
+#include <zstr/zstr.hpp>
+
+#include <fstream>
+#include <cstring>
+#include <algorithm>
+#include <memory>
+
+uint64_t InmemoryLoader::LocalDictionary::hash(const char *text,
+        const size_t len) {
+    return VLogHash::fnvString(text, len);
+}
+
+uint32_t InmemoryLoader::LocalDictionary::getOrAdd(const char *text,
+        const size_t len) {
+    if ((size() + 1) * 2 > slots.size()) {
+        //Rehash in a table twice as large
+        std::vector<uint32_t> newslots(slots.size() * 2, 0);
+        const uint64_t mask = newslots.size() - 1;
+        for (uint32_t id = 0; id < size(); ++id) {
+            size_t l;
+            const char *t = get(id, l);
+            uint64_t pos = hash(t, l) & mask;
+            while (newslots[pos] != 0) {
+                pos = (pos + 1) & mask;
+            }
+            newslots[pos] = id + 1;
+        }
+        slots.swap(newslots);
+    }
+    const uint64_t mask = slots.size() - 1;
+    uint64_t pos = hash(text, len) & mask;
+    while (slots[pos] != 0) {
+        size_t l;
+        const char *t = get(slots[pos] - 1, l);
+        if (l == len && memcmp(t, text, len) == 0) {
+            return slots[pos] - 1;
+        }
+        pos = (pos + 1) & mask;
+    }
+    const uint32_t id = size();
+    strings.insert(strings.end(), text, text + len);
+    offsets.push_back(strings.size());
+    slots[pos] = id + 1;
+    return id;
+}
+
+InmemoryLoader::InmemoryLoader(EDBLayer *layer, const int ntasks) :
+    layer(layer), ntasks(std::max(1, ntasks)), arity(0) {
+    }
+
+const char *InmemoryLoader::parseCSVRow(const char *pos, const char *end,
+        const bool eof, std::vector<char> &buffer,
+        std::vector<size_t> &fieldEnds) {
+    buffer.clear();
+    fieldEnds.clear();
+    size_t fieldStart = 0;
+    bool insideEscaped = false;
+    bool justSeenQuote = false;
+    int quoteCount = 0;     // keep track of number of concecutive quotes.
+    while (true) {
+        const bool atEnd = (pos == end);
+        if (atEnd && !eof) {
+            return NULL;
+        }
+        const char c = atEnd ? '\n' : *pos++;
+        if (atEnd) {
+            if (buffer.size() == fieldStart && fieldEnds.empty()) {
+                return pos;
+            }
+        }
+        if (c == '\r') {
+            // ignore these?
+            continue;
+        }
+        if (buffer.size() == fieldStart && ! justSeenQuote) {
+            // Watch out for more than one initial quote ...
+            if (c == '"') {
+                // Initial character is a quote.
+                insideEscaped = true;
+                justSeenQuote = true;
+                continue;
+            }
+        } else if (c == '"') {
+            quoteCount++;
+            insideEscaped = (quoteCount & 1) == 0;
+            if (insideEscaped) {
+                buffer.pop_back();
+            }
+        } else {
+            quoteCount = 0;
+        }
+        if (atEnd || (! insideEscaped && (c == '\n' || c == ','))) {
+            if (justSeenQuote && buffer.size() > fieldStart) {
+                buffer.pop_back();
+            }
+            fieldEnds.push_back(buffer.size());
+            fieldStart = buffer.size();
+            if (c == '\n') {
+                return pos;
+            }
+            insideEscaped = false;
+        } else {
+            buffer.push_back(c);
+        }
+        justSeenQuote = (c == '"');
+    }
+}
+
+std::vector<const char*> InmemoryLoader::splitCSV(const char *begin,
+        const char *end, const bool eof) const {
+    std::vector<const char*> bounds;
+    bounds.push_back(begin);
+    const size_t target = (end - begin) / ntasks + 1;
+    if (memchr(begin, '"', end - begin) == NULL) {
+        //Without quotes, every newline ends a row
+        const char *last = end;
+        if (!eof) {
+            last = begin;
+            for (const char *p = end; p > begin; --p) {
+                if (p[-1] == '\n') {
+                    last = p;
+                    break;
+                }
+            }
+        }
+        const char *pos = begin;
+        while ((size_t) (last - pos) > target) {
+            const char *nl = (const char*) memchr(pos + target, '\n',
+                    last - pos - target);
+            if (nl == NULL || nl + 1 == last) {
+                break;
+            }
+            pos = nl + 1;
+            bounds.push_back(pos);
+        }
+        if (last != begin) {
+            bounds.push_back(last);
+        }
+    } else {
+        //A newline may be inside a quoted field: the rows must be scanned
+        std::vector<char> buffer;
+        std::vector<size_t> fieldEnds;
+        const char *pos = begin;
+        const char *next = begin + target;
+        while (pos < end) {
+            const char *r = parseCSVRow(pos, end, eof, buffer, fieldEnds);
+            if (r == NULL || r == pos) {
+                break;
+            }
+            pos = r;
+            if (pos >= next && pos < end) {
+                bounds.push_back(pos);
+                next = pos + target;
+            }
+        }
+        if (bounds.back() != pos) {
+            bounds.push_back(pos);
+        }
+    }
+    return bounds;
+}
+
+void InmemoryLoader::parseCSV(const char *begin, const char *end, Part &part) {
+    std::vector<char> buffer;
+    std::vector<size_t> fieldEnds;
+    const char *pos = begin;
+    while (pos < end) {
+        pos = parseCSVRow(pos, end, true, buffer, fieldEnds);
+        if (fieldEnds.empty()) {
+            break;
+        }
+        if (part.arity == 0) {
+            if (fieldEnds.size() > 255) {
+                part.error = "Too many fields";
+                return;
+            }
+            part.arity = fieldEnds.size();
+        } else if (fieldEnds.size() != part.arity) {
+            part.error = "Multiple arities";
+            return;
+        }
+        size_t start = 0;
+        for (auto e : fieldEnds) {
+            part.rows.push_back(part.dict.getOrAdd(buffer.data() + start,
+                        e - start));
+            start = e;
+        }
+    }
+}
+
+void InmemoryLoader::addParts(std::vector<Part> &parts,
+        const std::string &file) {
+    for (auto &part : parts) {
+        if (part.error != "") {
+            LOG(ERRORL) << part.error;
+            throw (part.error + " in file " + file);
+        }
+        if (part.arity == 0) {
+            continue;
+        }
+        if (arity == 0) {
+            arity = part.arity;
+        } else if (part.arity != arity) {
+            LOG(ERRORL) << "Multiple arities";
+            throw ("Multiple arities in file " + file);
+        }
+    }
+    if (arity == 0) {
+        return;
+    }
+    //One inserter per part, so that the parts are added in parallel
+    while (inserters.size() < parts.size()) {
+        inserters.push_back(std::unique_ptr<SegmentInserter>(
+                    new SegmentInserter(arity)));
+    }
+
+    //The terms that are already known are looked up in parallel. The others
+    //are added part by part, in order, so the IDs follow the first
+    //occurrence of the terms in the file
+    std::vector<std::vector<Term_t>> globalIDs(parts.size());
+    std::vector<std::vector<bool>> found(parts.size());
+    ParallelTasks::parallel_for(0, parts.size(), 1,
+            [&parts, &globalIDs, &found, this](const ParallelRange &r) {
+                for (size_t i = r.begin(); i != r.end(); ++i) {
+                    const LocalDictionary &dict = parts[i].dict;
+                    std::vector<ConcurrentDictionary::Text> terms(dict.size());
+                    for (uint32_t id = 0; id < dict.size(); ++id) {
+                        terms[id].first = dict.get(id, terms[id].second);
+                    }
+                    layer->getDictNumbers(terms, globalIDs[i], found[i]);
+                }
+            });
+    for (size_t i = 0; i < parts.size(); ++i) {
+        const LocalDictionary &dict = parts[i].dict;
+        for (uint32_t id = 0; id < dict.size(); ++id) {
+            if (!found[i][id]) {
+                size_t len;
+                const char *text = dict.get(id, len);
+                uint64_t val;
+                layer->getOrAddDictNumber(text, len, val);
+                globalIDs[i][id] = val;
+            }
+        }
+    }
+
+    const uint8_t a = arity;
+    ParallelTasks::parallel_for(0, parts.size(), 1,
+            [&parts, &globalIDs, this, a](const ParallelRange &r) {
+                for (size_t i = r.begin(); i != r.end(); ++i) {
+                    SegmentInserter *inserter = inserters[i].get();
+                    const std::vector<uint32_t> &rows = parts[i].rows;
+                    const std::vector<Term_t> &ids = globalIDs[i];
+                    Term_t rowc[256];
+                    for (size_t j = 0; j < rows.size(); j += a) {
+                        for (uint8_t k = 0; k < a; ++k) {
+                            rowc[k] = ids[rows[j + k]];
+                        }
+                        inserter->addRow(rowc);
+                    }
+                }
+            });
+}
+
+void InmemoryLoader::loadCSV(const std::string &file, const bool gzipped) {
+    std::unique_ptr<std::istream> ifs;
+    if (gzipped) {
+        ifs = std::unique_ptr<std::istream>(new zstr::ifstream(file));
+    } else {
+        ifs = std::unique_ptr<std::istream>(new std::ifstream(file,
+                    std::ios_base::in | std::ios_base::binary));
+    }
+    if (ifs->fail()) {
+        std::string e = "Could not open file " + file;
+        LOG(ERRORL) << e;
+        throw (e);
+    }
+    LOG(DEBUGL) << "Reading " << file << " with " << ntasks << " tasks";
+
+    //Bytes of the file still to read. They are unknown for gzipped files
+    int64_t remaining = gzipped ? -1 : Utils::fileSize(file);
+    //The buffer is allocated without initializing it, since it is
+    //overwritten by the reads
+    std::unique_ptr<char[]> buffer;
+    size_t capacity = 0;
+    size_t carry = 0;
+    bool eof = false;
+    while (!eof) {
+        size_t toRead = (size_t) ntasks * INMEMORY_CHUNK_SIZE;
+        if (remaining >= 0 && (size_t) remaining < toRead) {
+            toRead = remaining;
+        }
+        if (!buffer || carry + toRead > capacity) {
+            capacity = std::max(carry + toRead, (size_t) 1);
+            char *newBuffer = new char[capacity];
+            if (carry > 0) {
+                memcpy(newBuffer, buffer.get(), carry);
+            }
+            buffer.reset(newBuffer);
+        }
+        ifs->read(buffer.get() + carry, toRead);
+        const size_t nread = ifs->gcount();
+        if (remaining >= 0) {
+            remaining -= nread;
+        }
+        eof = nread < toRead || remaining == 0;
+        const char *begin = buffer.get();
+        const char *end = begin + carry + nread;
+
+        std::vector<const char*> bounds = splitCSV(begin, end, eof);
+        std::vector<Part> parts(bounds.size() - 1);
+        ParallelTasks::parallel_for(0, parts.size(), 1,
+                [&parts, &bounds](const ParallelRange &r) {
+                    for (size_t i = r.begin(); i != r.end(); ++i) {
+                        parseCSV(bounds[i], bounds[i + 1], parts[i]);
+                    }
+                });
+        addParts(parts, file);
+
+        //The incomplete row at the end is parsed with the next block
+        carry = end - bounds.back();
+        memmove(buffer.get(), bounds.back(), carry);
+    }
+}
+
+void InmemoryLoader::loadNT(const std::string &file, const bool gzipped) {
+    //A gzipped file cannot be split
+    std::vector<FileInfo> pieces;
+    const int64_t size = Utils::fileSize(file);
+    const int npieces = gzipped ? 1 : ntasks;
+    const int64_t pieceSize = size / npieces + 1;
+    for (int i = 0; i < npieces && i * pieceSize < size; ++i) {
+        FileInfo f;
+        f.start = i * pieceSize;
+        f.size = std::min(pieceSize, size - f.start);
+        f.path = file;
+        f.splittable = !gzipped;
+        pieces.push_back(f);
+    }
+    LOG(DEBUGL) << "Reading " << file << " in " << pieces.size() << " parts";
+
+    std::vector<Part> parts(pieces.size());
+    ParallelTasks::parallel_for(0, parts.size(), 1,
+            [&parts, &pieces](const ParallelRange &r) {
+                for (size_t i = r.begin(); i != r.end(); ++i) {
+                    Part &part = parts[i];
+                    part.arity = 3;
+                    FileReader reader(pieces[i]);
+                    std::string literal;
+                    while (reader.parseTriple()) {
+                        if (reader.isTripleValid()) {
+                            int len[3];
+                            const char *terms[3];
+                            terms[0] = reader.getCurrentS(len[0]);
+                            terms[1] = reader.getCurrentP(len[1]);
+                            terms[2] = reader.getCurrentO(len[2]);
+                            for (int k = 0; k < 3; ++k) {
+                                //Plain string literals get the xsd:string datatype
+                                if (terms[k] == NULL || len[k] == 0) {
+                                    part.rows.push_back(part.dict.getOrAdd("", 0));
+                                } else if (len[k] > 1 && terms[k][0] == '"' &&
+                                        terms[k][len[k] - 1] == '"') {
+                                    literal.assign(terms[k], len[k]);
+                                    literal += "^^<http://www.w3.org/2001/XMLSchema#string>";
+                                    part.rows.push_back(part.dict.getOrAdd(literal.c_str(),
+                                            literal.size()));
+                                } else {
+                                    part.rows.push_back(part.dict.getOrAdd(terms[k], len[k]));
+                                }
+                            }
+                        }
+                    }
+                }
+            });
+    addParts(parts, file);
+    if (arity == 0) {
+        arity = 3;
+    }
+}
+
+std::shared_ptr<const Segment> InmemoryLoader::getSegment() {
+    std::vector<SegmentInserter*> nonEmpty;
+    for (auto &inserter : inserters) {
+        if (!inserter->isEmpty()) {
+            nonEmpty.push_back(inserter.get());
+        }
+    }
+    if (nonEmpty.empty()) {
+        return NULL;
+    }
+    std::vector<std::shared_ptr<const Segment>> segments(nonEmpty.size());
+    ParallelTasks::parallel_for(0, nonEmpty.size(), 1,
+            [&nonEmpty, &segments](const ParallelRange &r) {
+                for (size_t i = r.begin(); i != r.end(); ++i) {
+                    segments[i] = nonEmpty[i]->getSortedAndUniqueSegment();
+                }
+            });
+    inserters.clear();
+    if (segments.size() == 1) {
+        return segments[0];
+    }
+    return SegmentInserter::merge(segments);
+}
@@ -1,11 +1,11 @@
 #include <vlog/inmemory/inmemorytable.h>
+#include <vlog/inmemory/inmemoryloader.h>
 #include <vlog/fcinttable.h>
 #include <vlog/support.h>
 
 #include <kognac/utils.h>
-#include <kognac/filereader.h>
 
-#include <zstr/zstr.hpp>
+#include <thread>
 
 std::vector<std::string> readRow(istream &ifs) {
     char buffer[65536];
@@ -67,124 +67,38 @@ std::vector<std::string> readRow(istream &ifs) {
     }
 }
 
-std::string convertString(const char *s, int len) {
-    if (s == NULL || len == 0) {
-        return "";
-    }
-
-    std::string ss = std::string(s, s+len);
-
-    if (len > 1 && s[0] == '"' && s[len-1] == '"') {
-        return (ss + "^^<http://www.w3.org/2001/XMLSchema#string>").c_str();
-    }
-    return ss;
-}
-
 InmemoryTable::InmemoryTable(std::string repository, std::string tablename,
         PredId_t predid, EDBLayer *layer) {
     this->layer = layer;
     arity = 0;
     this->predid = predid;
-    SegmentInserter *inserter = NULL;
     //Load the table in the database
     if (repository == "") {
         repository = ".";
     }
     std::string tablefile = repository + "/" + tablename + ".csv";
     std::string gz = tablefile + ".gz";
-    istream *ifs = NULL;
-    /*if (Utils::exists(gz)) {
-        ifs = new zstr::ifstream(gz);
-        if (ifs->fail()) {
-            std::string e = "While importing data for predicate \"" + layer->getPredName(predid) + "\": could not open file " + gz;
-            LOG(ERRORL) << e;
-            throw (e);
-        }
-    } else if (Utils::exists(tablefile)) {*/
-        ifs = new std::ifstream(tablefile, ios_base::in | ios_base::binary);
-        if (ifs->fail()) {
-            std::string e = "While importing data for predicate \"" + layer->getPredName(predid) + "\": could not open file " + tablefile;
-            LOG(ERRORL) << e;
-            throw (e);
-        }
-    //}
-    if (ifs != NULL) {
-        LOG(DEBUGL) << "Reading " << tablefile;
-        size_t longLineNumber = 0;
-        while (! ifs->eof()) {
-            ++longLineNumber;
-            std::vector<std::string> row = readRow(*ifs);
-            Term_t rowc[256];
-            if (arity == 0) {
-                arity = row.size();
-            }
-            if (row.size() == 0) {
-                break;
-            } else if (row.size() != arity) {
-                LOG(ERRORL) << "Multiple arities";
-                throw ("Multiple arities in file " + tablefile);
-            }
-            if (inserter == NULL) {
-                inserter = new SegmentInserter(arity);
-            }
-            for (int i = 0; i < arity; i++) {
-                uint64_t val;
-                layer->getOrAddDictNumber(row[i].c_str(), row[i].size(), val);
-                rowc[i] = val;
-            }
-            inserter->addRow(rowc);
-        }
-        delete ifs;
+    std::string ntfile = repository + "/" + tablename + ".nt";
+    std::string ntgz = ntfile + ".gz";
+    InmemoryLoader loader(layer,
+            std::max((unsigned int) 1, std::thread::hardware_concurrency()));
+    if (Utils::exists(tablefile)) {
+        loader.loadCSV(tablefile, false);
+    } else if (Utils::exists(gz)) {
+        loader.loadCSV(gz, true);
+    } else if (Utils::exists(ntgz)) {
+        loader.loadNT(ntgz, true);
+    } else if (Utils::exists(ntfile)) {
+        loader.loadNT(ntfile, false);
     } else {
-        tablefile = repository + "/" + tablename + ".nt";
-        std::string gz = tablefile + ".gz";
-        FileInfo f;
-        f.start = 0;
-        if (Utils::exists(gz)) {
-            f.size = Utils::fileSize(gz);
-            f.path = gz;
-            f.splittable = false;
-        } else if (Utils::exists(tablefile)) {
-            f.size = Utils::fileSize(tablefile);
-            f.path = tablefile;
-            f.splittable = true;
-        } else {
-            std::string e = "While importing data for predicate \"" + layer->getPredName(predid) + "\": could not open file " + tablefile + " nor " + (repository + "/" + tablename + ".csv") + " nor gzipped versions";
-            LOG(ERRORL) << e;
-            throw(e);
-        }
-        FileReader reader(f);
-        while (reader.parseTriple()) {
-            if (reader.isTripleValid()) {
-                Term_t rowc[3];
-                int ls, lp, lo;
-                const char *s = reader.getCurrentS(ls);
-                std::string ss = convertString(s, ls);
-                const char *p = reader.getCurrentP(lp);
-                std::string sp = convertString(p, lp);
-                const char *o = reader.getCurrentO(lo);
-                std::string so = convertString(o, lo);
-                if (inserter == NULL) {
-                    inserter = new SegmentInserter(3);
-                }
-                uint64_t val;
-                layer->getOrAddDictNumber(ss.c_str(), ss.size(), val);
-                rowc[0] = val;
-                layer->getOrAddDictNumber(sp.c_str(), sp.size(), val);
-                rowc[1] = val;
-                layer->getOrAddDictNumber(so.c_str(), so.size(), val);
-                rowc[2] = val;
-                inserter->addRow(rowc);
-            }
-        }
-        arity = 3;
-    }
-    if (inserter == NULL) {
-        segment = NULL;
-    } else {
-        segment = inserter->getSortedAndUniqueSegment();
-        delete inserter;
-    }
+        std::string e = "While importing data for predicate \"" + layer->getPredName(predid) + "\": could not open file " + ntfile + " nor " + tablefile + " nor gzipped versions";
+        LOG(ERRORL) << e;
+        throw(e);
+    }
+    arity = loader.getArity();
+    segment = loader.getSegment();
+    LOG(DEBUGL) << "Dictionary of the additional terms: " << layer->getNTerms()
+        << " terms, " << layer->getTermsDictionaryMemory() << " bytes";
 }
 
 InmemoryTable::InmemoryTable(PredId_t predid,
@@ -342,6 +256,23 @@ bool InmemoryTable::isEmpty(const Literal &q, std::vector<uint8_t> *posToFilter,
     }
 }
 
+bool InmemoryTable::mayContain(const Literal &q) {
+    if (segment == NULL) {
+        return false;
+    }
+    for (uint8_t i = 0; i < q.getTupleSize(); ++i) {
+        const VTerm t = q.getTermAtPos(i);
+        if (!t.isVariable()) {
+            std::shared_ptr<Column> col = segment->getColumn(i);
+            if (col->isConstant() ? col->first() != t.getValue() :
+                    !col->mayContain(t.getValue())) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
 void _literal2filter(const Literal &query, std::vector<uint8_t> &posVarsToCopy,
         std::vector<uint8_t> &posConstantsToFilter,
         std::vector<Term_t> &valuesConstantsToFilter,
@@ -867,6 +798,23 @@ Term_t InmemoryIterator::getElementAt(const uint8_t p) {
     return iterator->get(p);
 }
 
+size_t InmemoryIterator::nextBatch(const uint8_t p, Term_t *buffer,
+        const size_t n) {
+    //The duplicates are skipped one row at a time by hasNext
+    if (skipDuplicatedFirst) {
+        return EDBIterator::nextBatch(p, buffer, n);
+    }
+    if (!iterator || (hasNextChecked && !hasNextValue)) {
+        return 0;
+    }
+    //The columns are read in blocks, so the rows do not go through the
+    //row of values of the iterator
+    const size_t read = iterator->nextBatch(p, buffer, n);
+    isFirst = false;
+    hasNextChecked = false;
+    return read;
+}
+
 PredId_t InmemoryIterator::getPredicateID() {
     return predid;
 }
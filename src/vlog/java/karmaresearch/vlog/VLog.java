@@ -583,6 +583,96 @@ public class VLog {
     public native boolean materialize(boolean skolem, int timeout)
             throws NotStartedException;
 
+    /**
+     * Schedules the addition of facts to the specified EDB predicate. The
+     * facts are only added, and the materialization updated, when
+     * {@link #updateMaterialization()} is called.
+     *
+     * @param predicate
+     *            the EDB predicate
+     * @param contents
+     *            the facts to add
+     * @exception NotStartedException
+     *                is thrown when vlog is not started yet, or materialization
+     *                has not run yet
+     * @exception EDBConfigurationException
+     *                is thrown when the predicate is not an EDB predicate, or
+     *                the arity of the facts is wrong.
+     */
+    public native void addFacts(String predicate, String[][] contents)
+            throws NotStartedException, EDBConfigurationException;
+
+    /**
+     * Schedules the removal of facts from the specified EDB predicate. The
+     * facts are only removed, and the materialization updated, when
+     * {@link #updateMaterialization()} is called.
+     *
+     * @param predicate
+     *            the EDB predicate
+     * @param contents
+     *            the facts to remove
+     * @exception NotStartedException
+     *                is thrown when vlog is not started yet, or materialization
+     *                has not run yet
+     * @exception EDBConfigurationException
+     *                is thrown when the predicate is not an EDB predicate, or
+     *                the arity of the facts is wrong.
+     */
+    public native void deleteFacts(String predicate, String[][] contents)
+            throws NotStartedException, EDBConfigurationException;
+
+    /**
+     * Applies the facts scheduled with {@link #addFacts(String, String[][])}
+     * and {@link #deleteFacts(String, String[][])} to the database, and
+     * updates the materialization incrementally, without recomputing it.
+     * This is only possible for rules without existential variables and
+     * negation.
+     *
+     * @exception NotStartedException
+     *                is thrown when vlog is not started yet, or materialization
+     *                has not run yet
+     * @exception MaterializationException
+     *                is thrown when the rules cannot be maintained
+     *                incrementally, or the update fails for some reason.
+     */
+    public native void updateMaterialization() throws NotStartedException;
+
+    /**
+     * Stores the materialization in a snapshot in the specified directory,
+     * so that it can be reloaded with {@link #loadSnapshot(String, boolean)}
+     * instead of being computed again.
+     *
+     * @param directory
+     *            the directory of the snapshot
+     * @exception NotStartedException
+     *                is thrown when vlog is not started yet, or materialization
+     *                has not run yet
+     * @exception IOException
+     *                is thrown when the snapshot could not be written, or the
+     *                rules contain existential variables
+     */
+    public native void storeSnapshot(String directory)
+            throws NotStartedException, IOException;
+
+    /**
+     * Loads the materialization from a snapshot created with
+     * {@link #storeSnapshot(String)}, instead of computing it. The snapshot
+     * must have been created with the same rules and the same database.
+     *
+     * @param directory
+     *            the directory of the snapshot
+     * @param skolem
+     *            whether further updates use the skolem chase
+     *            <code>true</code> or the restricted chase <code>false</code>.
+     * @exception NotStartedException
+     *                is thrown when vlog is not started yet.
+     * @exception MaterializationException
+     *                is thrown when the snapshot cannot be loaded, or was
+     *                created with other rules or another database.
+     */
+    public native void loadSnapshot(String directory, boolean skolem)
+            throws NotStartedException;
+
     /**
      * Creates a CSV file at the specified location, for the specified
      * predicate.
@@ -3,6 +3,7 @@
 #include <vlog/concepts.h>
 #include <vlog/edb.h>
 #include <vlog/seminaiver.h>
+#include <vlog/incremental.h>
 #include <vlog/cycles/checker.h>
 #include <vlog/reasoner.h>
 #include <vlog/utils.h>
@@ -21,14 +22,24 @@ class VLogInfo {
 		SemiNaiver *sn;
 		Program *program;
 		EDBLayer *layer;
+		IncrementalMaterializer *incr;
 
 		VLogInfo() {
 			sn = NULL;
 			program = NULL;
 			layer = NULL;
+			incr = NULL;
+		}
+
+		void resetIncremental() {
+			if (incr != NULL) {
+				delete incr;
+				incr = NULL;
+			}
 		}
 
 		~VLogInfo() {
+			resetIncremental();
 			if (layer != NULL) {
 				delete layer;
 				layer = NULL;
@@ -350,6 +361,7 @@ extern "C" {
 				throwEDBConfigurationException(env, "Cannot add data if there already are rules");
 				return;
 			}
+			f->resetIncremental();
 			delete f->program;
 			f->program = NULL;
 		}
@@ -689,6 +701,7 @@ JNIEXPORT jlong JNICALL Java_karmaresearch_vlog_VLog_nativeQuerySize(JNIEnv * en
 		}
 		if (rules != NULL) {
 			// Create a new program, to remove any left-overs from old rule stuff
+			f->resetIncremental();
 			delete f->program;
 			f->program = new Program(f->layer);
 
@@ -754,6 +767,7 @@ JNIEXPORT jlong JNICALL Java_karmaresearch_vlog_VLog_nativeQuerySize(JNIEnv * en
 			return;
 		}
 
+		f->resetIncremental();
 		delete f->program;
 		f->program = new Program(f->layer);
 
@@ -788,6 +802,7 @@ JNIEXPORT jlong JNICALL Java_karmaresearch_vlog_VLog_nativeQuerySize(JNIEnv * en
 			return false;
 		}
 
+		f->resetIncremental();
 		if (f->sn != NULL) {
 			delete f->sn;
             f->sn = NULL;
@@ -837,6 +852,164 @@ JNIEXPORT jlong JNICALL Java_karmaresearch_vlog_VLog_nativeQuerySize(JNIEnv * en
 		return (jboolean) true;
 	}
 
+	// Utility method to convert a String[][] to rows of strings
+	static bool getRows(JNIEnv *env, jobjectArray data,
+			std::vector<std::vector<std::string>> &values) {
+		if (data == NULL) {
+			throwEDBConfigurationException(env, "null data");
+			return false;
+		}
+		jsize nrows = env->GetArrayLength(data);
+		for (int i = 0; i < nrows; i++) {
+			std::vector<std::string> value;
+			jobjectArray atom = (jobjectArray) env->GetObjectArrayElement(data, (jsize) i);
+			if (atom == NULL) {
+				continue;
+			}
+			jint arity = env->GetArrayLength(atom);
+			for (int j = 0; j < arity; j++) {
+				jstring v = (jstring) env->GetObjectArrayElement(atom, (jsize) j);
+				if (v == NULL) {
+					throwEDBConfigurationException(env, "null data");
+					return false;
+				}
+				value.push_back(jstring2string(env, v));
+			}
+			values.push_back(value);
+		}
+		return true;
+	}
+
+	static void scheduleFacts(JNIEnv *env, jobject obj, jstring jpred, jobjectArray data, bool remove) {
+		VLogInfo *f = getVLogInfo(env, obj);
+		if (f == NULL || f->sn == NULL) {
+			throwNotStartedException(env, "Materialization has not run yet");
+			return;
+		}
+		std::vector<std::vector<std::string>> values;
+		if (! getRows(env, data, values)) {
+			return;
+		}
+		if (f->incr == NULL) {
+			f->incr = new IncrementalMaterializer(*(f->sn), *(f->layer), *(f->program));
+		}
+		std::string pred = jstring2string(env, jpred);
+		try {
+			if (remove) {
+				f->incr->removeFacts(pred, values);
+			} else {
+				f->incr->addFacts(pred, values);
+			}
+		} catch(std::string s) {
+			throwEDBConfigurationException(env, s.c_str());
+		}
+	}
+
+	/*
+	 * Class:     karmaresearch_vlog_VLog
+	 * Method:    addFacts
+	 * Signature: (Ljava/lang/String;[[Ljava/lang/String;)V
+	 */
+	JNIEXPORT void JNICALL Java_karmaresearch_vlog_VLog_addFacts(JNIEnv *env, jobject obj, jstring jpred, jobjectArray data) {
+		scheduleFacts(env, obj, jpred, data, false);
+	}
+
+	/*
+	 * Class:     karmaresearch_vlog_VLog
+	 * Method:    deleteFacts
+	 * Signature: (Ljava/lang/String;[[Ljava/lang/String;)V
+	 */
+	JNIEXPORT void JNICALL Java_karmaresearch_vlog_VLog_deleteFacts(JNIEnv *env, jobject obj, jstring jpred, jobjectArray data) {
+		scheduleFacts(env, obj, jpred, data, true);
+	}
+
+	/*
+	 * Class:     karmaresearch_vlog_VLog
+	 * Method:    updateMaterialization
+	 * Signature: ()V
+	 */
+	JNIEXPORT void JNICALL Java_karmaresearch_vlog_VLog_updateMaterialization(JNIEnv *env, jobject obj) {
+		VLogInfo *f = getVLogInfo(env, obj);
+		if (f == NULL || f->sn == NULL) {
+			throwNotStartedException(env, "Materialization has not run yet");
+			return;
+		}
+		if (f->incr == NULL) {
+			return;
+		}
+		if (! f->incr->isSupported()) {
+			f->resetIncremental();
+			throwMaterializationException(env, "The rules cannot be maintained incrementally");
+			return;
+		}
+		//The materializer is kept for the following updates, since it
+		//caches the blocks of the IDB tables that it has read
+		try {
+			f->incr->update();
+		} catch(std::string s) {
+			f->resetIncremental();
+			throwMaterializationException(env, s.c_str());
+		} catch(const char *e) {
+			f->resetIncremental();
+			throwMaterializationException(env, e);
+		} catch(std::bad_alloc e) {
+			f->resetIncremental();
+			throwMaterializationException(env, e.what());
+		}
+	}
+
+	/*
+	 * Class:     karmaresearch_vlog_VLog
+	 * Method:    storeSnapshot
+	 * Signature: (Ljava/lang/String;)V
+	 */
+	JNIEXPORT void JNICALL Java_karmaresearch_vlog_VLog_storeSnapshot(JNIEnv *env, jobject obj, jstring jdir) {
+		VLogInfo *f = getVLogInfo(env, obj);
+		if (f == NULL || f->sn == NULL) {
+			throwNotStartedException(env, "Materialization has not run yet");
+			return;
+		}
+		std::string dir = jstring2string(env, jdir);
+		try {
+			f->sn->storeSnapshot(dir);
+		} catch(int e) {
+			throwIOException(env, ("Could not store the snapshot in " + dir).c_str());
+		}
+	}
+
+	/*
+	 * Class:     karmaresearch_vlog_VLog
+	 * Method:    loadSnapshot
+	 * Signature: (Ljava/lang/String;Z)V
+	 */
+	JNIEXPORT void JNICALL Java_karmaresearch_vlog_VLog_loadSnapshot(JNIEnv *env, jobject obj, jstring jdir, jboolean skolem) {
+		VLogInfo *f = getVLogInfo(env, obj);
+		if (f == NULL || f->program == NULL) {
+			throwNotStartedException(env, "VLog is not started yet");
+			return;
+		}
+
+		f->resetIncremental();
+		if (f->sn != NULL) {
+			delete f->sn;
+			f->sn = NULL;
+		}
+
+		std::string dir = jstring2string(env, jdir);
+		LOG(INFOL) << "Loading the materialization from " << dir;
+		try {
+			f->sn = new SemiNaiver(*(f->layer), f->program, true, false, false,
+					(bool) skolem ?
+					TypeChase::SKOLEM_CHASE : TypeChase::RESTRICTED_CHASE,
+					-1, false, false);
+			f->sn->loadSnapshot(dir);
+		} catch(int e) {
+			delete f->sn;
+			f->sn = NULL;
+			throwMaterializationException(env, ("Could not load the snapshot in " + dir).c_str());
+		}
+	}
+
 	/*
 	 * Class:     karmaresearch_vlog_VLog
 	 * Method:    writePredicateToCsv
@@ -81,6 +81,12 @@ uint64_t MAPITable::getSizeFromDB(const std::string &query) {
     return result;
 }
 
+bool MAPITable::executeUpdate(const std::string &query) {
+    MapiHdl handle = doquery(con, query);
+    mapi_close_handle(handle);
+    return true;
+}
+
 MAPITable::~MAPITable() {
     mapi_destroy(con);
 }
@@ -0,0 +1,318 @@
+#include <vlog/ml/algoselector.h>
+
+#include <kognac/logs.h>
+
+#include <cmath>
+#include <fstream>
+#include <sstream>
+#include <random>
+#include <algorithm>
+
+std::vector<std::string> AlgoSelector::getFeatureNames() {
+    return std::vector<std::string>({"arity", "nConstants", "nRepeatedVars",
+            "nRules", "maxBodyAtoms", "nIDBBodyAtoms", "recursive",
+            "logEDBCard", "logCost"});
+}
+
+std::vector<double> AlgoSelector::getFeatures(const Literal &query,
+        Program &program, EDBLayer &layer, const uint64_t estimatedCost) {
+    const int arity = query.getTupleSize();
+    const int nConstants = query.getNConstants();
+    double nRules = 0;
+    double maxBodyAtoms = 0;
+    double nIDBBodyAtoms = 0;
+    double recursive = 0;
+    double edbCard = 0;
+    if (query.getPredicate().getType() == IDB) {
+        const PredId_t id = query.getPredicate().getId();
+        for (auto ruleId : program.getRulesIDsByPredicate(id)) {
+            const Rule &rule = program.getRule(ruleId);
+            nRules++;
+            maxBodyAtoms = std::max(maxBodyAtoms, (double) rule.getBody().size());
+            nIDBBodyAtoms += rule.getNIDBPredicates();
+            if (rule.isRecursive()) {
+                recursive = 1;
+            }
+            for (const auto &literal : rule.getBody()) {
+                if (literal.getPredicate().getType() == EDB) {
+                    edbCard += layer.estimateCardinality(literal);
+                }
+            }
+        }
+    } else {
+        edbCard = layer.estimateCardinality(query);
+    }
+
+    std::vector<double> features;
+    features.push_back(arity);
+    features.push_back(nConstants);
+    features.push_back(arity - nConstants - query.getNUniqueVars());
+    features.push_back(nRules);
+    features.push_back(maxBodyAtoms);
+    features.push_back(nIDBBodyAtoms);
+    features.push_back(recursive);
+    features.push_back(log10(1 + edbCard));
+    features.push_back(log10(1 + (double) estimatedCost));
+    return features;
+}
+
+void AlgoSelector::writeTrainingHeader(std::ostream &out) {
+    out << "#query";
+    for (const auto &name : getFeatureNames()) {
+        out << "\t" << name;
+    }
+    out << "\testimatedCost\ttimeQSQR\ttimeMagic" << std::endl;
+}
+
+void AlgoSelector::writeTrainingRecord(std::ostream &out,
+        const TrainingRecord &record) {
+    out << record.query;
+    for (auto f : record.features) {
+        out << "\t" << f;
+    }
+    out << "\t" << record.estimatedCost << "\t" << record.timeQSQR << "\t"
+        << record.timeMagic << std::endl;
+}
+
+std::vector<TrainingRecord> AlgoSelector::readTrainingLog(std::string file) {
+    std::ifstream in(file);
+    if (!in.good()) {
+        LOG(ERRORL) << "Could not open the training log " << file;
+        throw 10;
+    }
+    std::vector<TrainingRecord> records;
+    std::string line;
+    while (std::getline(in, line)) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        std::vector<std::string> fields;
+        std::stringstream ss(line);
+        std::string field;
+        while (std::getline(ss, field, '\t')) {
+            fields.push_back(field);
+        }
+        if (fields.size() != ALGOSEL_NFEATURES + 4) {
+            LOG(ERRORL) << "Malformed line in the training log " << file
+                << ": " << line;
+            throw 10;
+        }
+        TrainingRecord record;
+        record.query = fields[0];
+        for (int i = 0; i < ALGOSEL_NFEATURES; ++i) {
+            record.features.push_back(std::stod(fields[1 + i]));
+        }
+        record.estimatedCost = std::stoull(fields[ALGOSEL_NFEATURES + 1]);
+        record.timeQSQR = std::stod(fields[ALGOSEL_NFEATURES + 2]);
+        record.timeMagic = std::stod(fields[ALGOSEL_NFEATURES + 3]);
+        records.push_back(record);
+    }
+    return records;
+}
+
+int AlgoSelector::build(std::vector<const TrainingRecord*> &records,
+        const size_t begin, const size_t end, const int depth,
+        const int maxDepth, const size_t minLeaf) {
+    double timeQSQR = 0;
+    double timeMagic = 0;
+    for (size_t i = begin; i < end; ++i) {
+        timeQSQR += records[i]->timeQSQR;
+        timeMagic += records[i]->timeMagic;
+    }
+    const int idx = nodes.size();
+    Node leaf;
+    leaf.feature = -1;
+    leaf.threshold = 0;
+    leaf.left = leaf.right = -1;
+    leaf.qsqr = timeQSQR <= timeMagic;
+    nodes.push_back(leaf);
+
+    //The cost of a node is the total runtime of its records with the
+    //algorithm it chooses. Look for the split that reduces it the most
+    const double cost = std::min(timeQSQR, timeMagic);
+    if (depth >= maxDepth || end - begin < 2 * minLeaf || cost == 0) {
+        return idx;
+    }
+    double bestCost = cost;
+    int bestFeature = -1;
+    double bestThreshold = 0;
+    for (int f = 0; f < ALGOSEL_NFEATURES; ++f) {
+        std::sort(records.begin() + begin, records.begin() + end,
+                [f](const TrainingRecord *a, const TrainingRecord *b) {
+                return a->features[f] < b->features[f];
+                });
+        double leftQSQR = 0;
+        double leftMagic = 0;
+        for (size_t i = begin; i + 1 < end; ++i) {
+            leftQSQR += records[i]->timeQSQR;
+            leftMagic += records[i]->timeMagic;
+            const size_t nleft = i + 1 - begin;
+            if (nleft < minLeaf || end - begin - nleft < minLeaf ||
+                    records[i]->features[f] == records[i + 1]->features[f]) {
+                continue;
+            }
+            const double splitCost = std::min(leftQSQR, leftMagic) +
+                std::min(timeQSQR - leftQSQR, timeMagic - leftMagic);
+            if (splitCost < bestCost) {
+                bestCost = splitCost;
+                bestFeature = f;
+                bestThreshold = (records[i]->features[f] +
+                        records[i + 1]->features[f]) / 2;
+            }
+        }
+    }
+    //Ignore the improvements that are only rounding errors
+    if (bestFeature == -1 || bestCost > cost * (1 - 1e-9)) {
+        return idx;
+    }
+
+    auto middle = std::partition(records.begin() + begin, records.begin() + end,
+            [bestFeature, bestThreshold](const TrainingRecord *r) {
+            return r->features[bestFeature] <= bestThreshold;
+            });
+    const size_t mid = middle - records.begin();
+    const int left = build(records, begin, mid, depth + 1, maxDepth, minLeaf);
+    const int right = build(records, mid, end, depth + 1, maxDepth, minLeaf);
+    nodes[idx].feature = bestFeature;
+    nodes[idx].threshold = bestThreshold;
+    nodes[idx].left = left;
+    nodes[idx].right = right;
+    return idx;
+}
+
+void AlgoSelector::train(const std::vector<TrainingRecord> &records,
+        const int maxDepth, const size_t minLeaf) {
+    nodes.clear();
+    if (records.empty()) {
+        LOG(ERRORL) << "There are no records to train the model";
+        throw 10;
+    }
+    std::vector<const TrainingRecord*> pointers;
+    for (const auto &r : records) {
+        pointers.push_back(&r);
+    }
+    build(pointers, 0, pointers.size(), 0, maxDepth, std::max((size_t) 1, minLeaf));
+    LOG(DEBUGL) << "Trained a decision tree with " << nodes.size() << " nodes";
+}
+
+bool AlgoSelector::chooseQSQR(const std::vector<double> &features) const {
+    int idx = 0;
+    while (nodes[idx].feature != -1) {
+        if (features[nodes[idx].feature] <= nodes[idx].threshold) {
+            idx = nodes[idx].left;
+        } else {
+            idx = nodes[idx].right;
+        }
+    }
+    return nodes[idx].qsqr;
+}
+
+void AlgoSelector::save(std::string file) const {
+    std::ofstream out(file);
+    out << ALGOSEL_MAGIC << " " << ALGOSEL_VERSION << std::endl;
+    out << ALGOSEL_NFEATURES << " " << nodes.size() << std::endl;
+    out.precision(17);
+    for (const auto &node : nodes) {
+        out << node.feature << " " << node.threshold << " " << node.left
+            << " " << node.right << " " << (node.qsqr ? 1 : 0) << std::endl;
+    }
+    if (out.fail()) {
+        LOG(ERRORL) << "Could not write the model in " << file;
+        throw 10;
+    }
+}
+
+void AlgoSelector::load(std::string file) {
+    std::ifstream in(file);
+    std::string magic;
+    int version = 0;
+    int nfeatures = 0;
+    size_t nnodes = 0;
+    in >> magic >> version >> nfeatures >> nnodes;
+    if (in.fail() || magic != ALGOSEL_MAGIC || version != ALGOSEL_VERSION
+            || nfeatures != ALGOSEL_NFEATURES || nnodes == 0) {
+        LOG(ERRORL) << "The file " << file << " does not contain a valid model";
+        throw 10;
+    }
+    nodes.resize(nnodes);
+    for (size_t idx = 0; idx < nnodes; ++idx) {
+        Node &node = nodes[idx];
+        int qsqr;
+        in >> node.feature >> node.threshold >> node.left >> node.right >> qsqr;
+        node.qsqr = qsqr != 0;
+        //The children are stored after their parent (see build()). Checking
+        //it also rules out the cycles, on which chooseQSQR would not stop
+        if (node.feature < -1 || node.feature >= ALGOSEL_NFEATURES ||
+                (node.feature >= 0 &&
+                 (node.left <= (int) idx || node.left >= (int) nnodes ||
+                  node.right <= (int) idx || node.right >= (int) nnodes))) {
+            in.setstate(std::ios::failbit);
+        }
+    }
+    if (in.fail()) {
+        nodes.clear();
+        LOG(ERRORL) << "The file " << file << " does not contain a valid model";
+        throw 10;
+    }
+}
+
+void AlgoSelector::benchmark(const std::vector<TrainingRecord> &records,
+        const uint64_t threshold, const int folds, const int maxDepth,
+        const size_t minLeaf) {
+    if (records.size() < (size_t) folds || folds < 2) {
+        LOG(ERRORL) << "Not enough records (" << records.size()
+            << ") for a cross-validation with " << folds << " folds";
+        throw 10;
+    }
+    //Assign the records to the folds randomly, with a fixed seed so that
+    //the benchmark can be repeated
+    std::vector<size_t> order(records.size());
+    for (size_t i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::mt19937 gen(0);
+    std::shuffle(order.begin(), order.end(), gen);
+
+    double timeQSQR = 0, timeMagic = 0, timeBest = 0;
+    double timeHeuristic = 0, timeLearned = 0;
+    size_t correctHeuristic = 0, correctLearned = 0;
+    for (int fold = 0; fold < folds; ++fold) {
+        std::vector<TrainingRecord> train;
+        std::vector<const TrainingRecord*> test;
+        for (size_t i = 0; i < order.size(); ++i) {
+            if ((int) (i % folds) == fold) {
+                test.push_back(&records[order[i]]);
+            } else {
+                train.push_back(records[order[i]]);
+            }
+        }
+        AlgoSelector selector;
+        selector.train(train, maxDepth, minLeaf);
+        for (const auto r : test) {
+            const bool qsqrIsBetter = r->timeQSQR <= r->timeMagic;
+            const bool heuristic = r->estimatedCost < threshold;
+            const bool learned = selector.chooseQSQR(r->features);
+            timeQSQR += r->timeQSQR;
+            timeMagic += r->timeMagic;
+            timeBest += std::min(r->timeQSQR, r->timeMagic);
+            timeHeuristic += heuristic ? r->timeQSQR : r->timeMagic;
+            timeLearned += learned ? r->timeQSQR : r->timeMagic;
+            if (heuristic == qsqrIsBetter) {
+                correctHeuristic++;
+            }
+            if (learned == qsqrIsBetter) {
+                correctLearned++;
+            }
+        }
+    }
+    const double n = records.size();
+    LOG(INFOL) << "Queries: " << records.size() << ", folds: " << folds;
+    LOG(INFOL) << "Total runtime always QSQ-R: " << timeQSQR << " msec";
+    LOG(INFOL) << "Total runtime always magic: " << timeMagic << " msec";
+    LOG(INFOL) << "Total runtime best choice: " << timeBest << " msec";
+    LOG(INFOL) << "Total runtime threshold on the cost (" << threshold
+        << "): " << timeHeuristic << " msec, correct choices: "
+        << (correctHeuristic * 100 / n) << "%";
+    LOG(INFOL) << "Total runtime decision tree: " << timeLearned
+        << " msec, correct choices: " << (correctLearned * 100 / n) << "%";
+}
@@ -39,6 +39,13 @@ uint64_t MySQLTable::getSizeFromDB(const std::string &query) {
     return result;
 }
 
+bool MySQLTable::executeUpdate(const std::string &query) {
+    sql::Statement *stmt = con->createStatement();
+    MYSQLCALL(stmt->execute(query));
+    delete stmt;
+    return true;
+}
+
 void MySQLTable::executeQuery(const std::string &query, SegmentInserter *inserter) {
 
     std::chrono::system_clock::time_point start = std::chrono::system_clock::now();
@@ -78,6 +78,14 @@ void ODBCTable::executeQuery(const std::string &query, SegmentInserter *inserter
     LOG(DEBUGL) << "SQL Query: " << query << " took " << sec.count();
 }
 
+bool ODBCTable::executeUpdate(const std::string &query) {
+    SQLHANDLE stmt;
+    check(SQLAllocHandle(SQL_HANDLE_STMT, con, &stmt), "allocate statement handle");
+    check(SQLExecDirectA(stmt, (SQLCHAR *) query.c_str(), SQL_NTS), "execute update");
+    SQLFreeHandle(SQL_HANDLE_STMT, stmt);
+    return true;
+}
+
 ODBCTable::~ODBCTable() {
     SQLDisconnect(con);
     SQLFreeHandle(SQL_HANDLE_DBC, con);
@@ -8,6 +8,7 @@
 #include <vlog/edb.h>
 #include <vlog/qsqquery.h>
 #include <vlog/qsqr.h>
+#include <vlog/ml/algoselector.h>
 
 #include <trident/kb/consts.h>
 #include <trident/model/table.h>
@@ -687,7 +688,7 @@ TupleIterator *Reasoner::getMaterializationIterator(Literal &query,
         std::vector<uint8_t> *posJoins,
         std::vector<Term_t> *possibleValuesJoins,
         EDBLayer &edb, Program &program, bool returnOnlyVars,
-        std::vector<uint8_t> *sortByFields) {
+        std::vector<uint8_t> *sortByFields, std::string snapshot) {
 
     Predicate pred = query.getPredicate();
     VTuple tuple = query.getTuple();
@@ -707,7 +708,11 @@ TupleIterator *Reasoner::getMaterializationIterator(Literal &query,
             edb, &program, true, false,
             false, -1, false, false);
 
-    sn->run();
+    if (!snapshot.empty()) {
+        sn->loadSnapshot(snapshot);
+    } else {
+        sn->run();
+    }
 
     TupleIterator *result = getIteratorWithMaterialization(sn, query, returnOnlyVars, sortByFields);
     delete sn;
@@ -826,6 +831,17 @@ ReasoningMode Reasoner::chooseMostEfficientAlgo(Literal &query,
         cost = estimate(query, NULL, NULL, layer, program);
     }
     ReasoningMode mode = cost < threshold ? TOPDOWN : MAGIC;
+    //The model is trained on queries without bindings, so it is not used
+    //for the others
+    if (selector && selector->isTrained() && posBindings == NULL) {
+        std::vector<double> features = AlgoSelector::getFeatures(query,
+                program, layer, cost);
+        mode = selector->chooseQSQR(features) ? TOPDOWN : MAGIC;
+        LOG(DEBUGL) << "The learned model chooses " <<
+            (mode == TOPDOWN ? "QSQR" : "magic") << " for " <<
+            query.tostring(&program, &layer);
+        return mode;
+    }
     LOG(DEBUGL) << "Deciding whether I should resolve " <<
         query.tostring(&program, &layer) <<
         " with magic or QSQR. Estimated cost: " <<
@@ -878,7 +894,7 @@ TupleIterator *Reasoner::getTopDownIterator(Literal &query,
         std::vector<uint8_t> *posJoins,
         std::vector<Term_t> *possibleValuesJoins,
         EDBLayer &edb, Program &program, bool returnOnlyVars,
-        std::vector<uint8_t> *sortByFields) {
+        std::vector<uint8_t> *sortByFields, int nthreads) {
 
     LOG(DEBUGL) << "Get topdown iterator for query " << query.tostring(&program, &edb);
     std::vector<uint8_t> newPosJoins;
@@ -898,7 +914,7 @@ TupleIterator *Reasoner::getTopDownIterator(Literal &query,
 
     QSQQuery rootQuery(query);
     LOG(DEBUGL) << "QSQQuery = " << rootQuery.tostring();
-    std::unique_ptr<QSQR> evaluator = std::unique_ptr<QSQR>(new QSQR(edb, &program));
+    std::unique_ptr<QSQR> evaluator = std::unique_ptr<QSQR>(new QSQR(edb, &program, nthreads));
     TupleTable *finalTable;
     finalTable = evaluator->evaluateQuery(QSQR_EVAL, &rootQuery, newPosJoins.size() > 0 ? &newPosJoins : NULL,
             possibleValuesJoins, returnOnlyVars);
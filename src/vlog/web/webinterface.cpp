@@ -61,7 +61,18 @@ void WebInterface::processMaterialization() {
         cvMatRunner.wait(lck);
         if (!sn)
             break;
-        sn->run();
+        //The snapshot is only accepted if it was created with the same
+        //rules and EDB. A failure must not stop the server
+        const std::string snapshot = vm["loadmat"].as<std::string>();
+        if (!snapshot.empty()) {
+            try {
+                sn->loadSnapshot(snapshot);
+            } catch (int e) {
+                LOG(ERRORL) << "Cannot load the snapshot in " << snapshot;
+            }
+        } else {
+            sn->run();
+        }
     }
 }
 